@@ -6,16 +6,142 @@
 
 #include "testbinhelper.h"
 
+#include "binfilehelper.h"
+#include "starblock.h"
+#include "starblockfactory.h"
+#include "starblocklist.h"
+#include "skycomponents/deepstarcomponent.h"
+#include "skyobjects/deepstardata.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace
+{
+// Size of the synthetic catalog, similar to a single HTM level 3 deep star file
+constexpr quint32 TRIXELS = 512;
+constexpr quint32 STARS_PER_TRIXEL = 400;
+
+void writeField(QFile &file, const char *name, qint8 size, quint8 type, qint32 scale)
+{
+    dataElement de;
+    strncpy(de.name, name, sizeof(de.name) - 1);
+    de.size  = size;
+    de.type  = type;
+    de.scale = scale;
+    file.write(reinterpret_cast<const char *>(&de), sizeof(dataElement));
+}
+
+// Writes a file in the KStars binary format (see data/README.fileformat) holding DeepStarData records
+bool writeCatalog(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    char preamble[124] = "KStars Star Data v1.0. Synthetic catalog for TestBinHelper";
+    file.write(preamble, sizeof(preamble));
+
+    const qint16 endian_id = 0x4B53;
+    const quint8 version   = 1;
+    const qint16 nfields   = 6;
+    file.write(reinterpret_cast<const char *>(&endian_id), 2);
+    file.write(reinterpret_cast<const char *>(&version), 1);
+    file.write(reinterpret_cast<const char *>(&nfields), 2);
+
+    writeField(file, "RA", 4, 0, 1000000);
+    writeField(file, "Dec", 4, 0, 100000);
+    writeField(file, "dRA", 2, 0, 100);
+    writeField(file, "dDec", 2, 0, 100);
+    writeField(file, "B", 2, 0, 1000);
+    writeField(file, "V", 2, 0, 1000);
+
+    const quint32 indexSize = TRIXELS;
+    file.write(reinterpret_cast<const char *>(&indexSize), 4);
+
+    // Index table is followed by faint magnitude, HTM level and maximum stars per trixel
+    const quint32 dataStart = file.pos() + indexSize * 12 + 5;
+    for (quint32 id = 0; id < indexSize; ++id)
+    {
+        const quint32 offset = dataStart + id * STARS_PER_TRIXEL * sizeof(DeepStarData);
+        const quint32 nrecs  = STARS_PER_TRIXEL;
+        file.write(reinterpret_cast<const char *>(&id), 4);
+        file.write(reinterpret_cast<const char *>(&offset), 4);
+        file.write(reinterpret_cast<const char *>(&nrecs), 4);
+    }
+
+    const qint16 faintmag = 16000;
+    const quint8 htm_level = 3;
+    const quint16 MSpT     = STARS_PER_TRIXEL;
+    file.write(reinterpret_cast<const char *>(&faintmag), 2);
+    file.write(reinterpret_cast<const char *>(&htm_level), 1);
+    file.write(reinterpret_cast<const char *>(&MSpT), 2);
+
+    for (quint32 id = 0; id < indexSize; ++id)
+    {
+        for (quint32 j = 0; j < STARS_PER_TRIXEL; ++j)
+        {
+            DeepStarData data;
+            data.RA   = (id * 1000 + j) % 24000000;
+            data.Dec  = static_cast<qint32>(j) * 100 - 2000000;
+            data.dRA  = j % 100;
+            data.dDec = -static_cast<qint16>(j % 100);
+            // Records are sorted by magnitude within a trixel
+            data.B    = 8000 + j * 20;
+            data.V    = 7500 + j * 20;
+            file.write(reinterpret_cast<const char *>(&data), sizeof(DeepStarData));
+        }
+    }
+
+    return file.error() == QFileDevice::NoError;
+}
+
+// Fills the StarBlockList of every trixel of the catalog through StarBlockList::fillToMag(), as DeepStarComponent
+// does while drawing, returns the number of stars filled
+quint64 fillAll(DeepStarComponent &component)
+{
+    quint64 nStars = 0;
+
+    // Blocks recycled by the StarBlockFactory refer to their list, so every list lives until the factory is emptied
+    std::vector<std::unique_ptr<StarBlockList>> lists;
+    for (Trixel trixel = 0; trixel < TRIXELS; ++trixel)
+    {
+        lists.emplace_back(new StarBlockList(trixel, &component));
+        lists.back()->fillToMag(std::numeric_limits<float>::max());
+        nStars += lists.back()->getStarCount();
+    }
+
+    StarBlockFactory::Instance()->freeAll();
+    return nStars;
+}
+}
+
 TestBinHelper::TestBinHelper(QObject *parent) : QObject(parent)
 {
 }
 
 void TestBinHelper::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled(true);
+
+    QDir dataDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+    QVERIFY(dataDir.mkpath("."));
+
+    m_FileName = "testbinhelper.dat";
+    m_FilePath = dataDir.filePath(m_FileName);
+    QVERIFY(writeCatalog(m_FilePath));
 }
 
 void TestBinHelper::cleanupTestCase()
 {
+    QFile::remove(m_FilePath);
 }
 
 void TestBinHelper::init()
@@ -28,11 +154,117 @@ void TestBinHelper::cleanup()
 
 void TestBinHelper::testLoadBinary_data()
 {
+    QTest::addColumn<bool>("mapped");
+
+    QTest::newRow("stdio") << false;
+    QTest::newRow("mmap") << true;
 }
 
 void TestBinHelper::testLoadBinary()
 {
-    QSKIP("Not implemented yet.");
+    QFETCH(bool, mapped);
+
+    BinFileHelper reader;
+    QVERIFY(BinFileHelper::testFileExists(m_FileName));
+    QVERIFY(reader.openFile(m_FileName) != nullptr);
+    QVERIFY(reader.readHeader());
+
+    QCOMPARE(reader.getFieldCount(), 6);
+    QCOMPARE(reader.guessRecordSize(), static_cast<int>(sizeof(DeepStarData)));
+    QVERIFY(!reader.getByteSwap());
+    QVERIFY(reader.isField("Dec"));
+    QCOMPARE(reader.getField("V").scale, 1000);
+    QCOMPARE(reader.getRecordCount(), static_cast<unsigned long>(TRIXELS * STARS_PER_TRIXEL));
+    QCOMPARE(reader.getRecordCount(TRIXELS - 1), STARS_PER_TRIXEL);
+
+    QVERIFY(!reader.isMapped());
+    QVERIFY(reader.mappedRange(0, 1) == nullptr);
+    if (mapped)
+    {
+        QVERIFY(reader.mapFile());
+        QVERIFY(reader.isMapped());
+        QVERIFY(reader.mappedRange(QFile(m_FilePath).size(), 1) == nullptr);
+    }
+
+    // Mapped records must match what stdio reads from the same offset
+    const long offset = reader.getOffset(42);
+    DeepStarData expected, actual;
+    FILE *f = fopen(m_FilePath.toLatin1().data(), "rb");
+    QVERIFY(f != nullptr);
+    BinFileHelper::unsigned_KDE_fseek(f, offset + 7 * sizeof(DeepStarData), SEEK_SET);
+    QVERIFY(fread(&expected, sizeof(DeepStarData), 1, f) == 1);
+    fclose(f);
+
+    if (mapped)
+    {
+        const uchar *record = reader.mappedRange(offset + 7 * sizeof(DeepStarData), sizeof(DeepStarData));
+        QVERIFY(record != nullptr);
+        memcpy(&actual, record, sizeof(DeepStarData));
+    }
+    else
+    {
+        BinFileHelper::unsigned_KDE_fseek(reader.getFileHandle(), offset + 7 * sizeof(DeepStarData), SEEK_SET);
+        QVERIFY(fread(&actual, sizeof(DeepStarData), 1, reader.getFileHandle()) == 1);
+    }
+    QCOMPARE(memcmp(&expected, &actual, sizeof(DeepStarData)), 0);
+    QCOMPARE(actual.V, static_cast<qint16>(7500 + 7 * 20));
+
+    reader.closeFile();
+    QVERIFY(!reader.isMapped());
+
+    // The catalog fills the same stars through the component, whether it is mapped or not
+    DeepStarComponent component(nullptr, m_FileName, 16);
+    QVERIFY(component.getStarReader()->isMapped());
+    if (!mapped)
+        component.getStarReader()->unmapFile();
+    QCOMPARE(fillAll(component), static_cast<quint64>(TRIXELS * STARS_PER_TRIXEL));
+}
+
+void TestBinHelper::testFillThroughput_data()
+{
+    QTest::addColumn<bool>("mapped");
+    QTest::addColumn<bool>("cold");
+
+    QTest::newRow("stdio-cold") << false << true;
+    QTest::newRow("stdio-warm") << false << false;
+    QTest::newRow("mmap-cold") << true << true;
+    QTest::newRow("mmap-warm") << true << false;
+}
+
+void TestBinHelper::testFillThroughput()
+{
+    QFETCH(bool, mapped);
+    QFETCH(bool, cold);
+
+    // Cold runs open (and map) the catalog again for every iteration, warm runs reuse the open component
+    std::unique_ptr<DeepStarComponent> component;
+    const auto open = [&]()
+    {
+        component.reset(new DeepStarComponent(nullptr, m_FileName, 16));
+        if (!mapped)
+            component->getStarReader()->unmapFile();
+    };
+    if (!cold)
+        open();
+
+    quint64 nStars = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        if (cold)
+            open();
+
+        nStars += fillAll(*component);
+
+        if (cold)
+            component.reset();
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    QVERIFY(nStars > 0);
+    qInfo() << QTest::currentDataTag() << ":" << qRound64(nStars * 1e9 / qMax<qint64>(elapsed, 1)) << "stars/sec";
 }
 
 QTEST_GUILESS_MAIN(TestBinHelper)
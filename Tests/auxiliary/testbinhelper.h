@@ -25,6 +25,13 @@ private slots:
 
     void testLoadBinary_data();
     void testLoadBinary();
+
+    void testFillThroughput_data();
+    void testFillThroughput();
+
+private:
+    QString m_FileName;
+    QString m_FilePath;
 };
 
 #endif // TESTBINHELPER_H
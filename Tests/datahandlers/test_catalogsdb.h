@@ -5,6 +5,7 @@
 */
 
 #include <QTest>
+#include <algorithm>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QTemporaryDir>
 #include <QTemporaryFile>
@@ -85,6 +86,101 @@ class TestCatalogsDB_DBManager : public QObject
         QVERIFY(num_obj > 0);
     }
 
+    void master_snapshot()
+    {
+        const auto snapshot = m_manager.open_master_snapshot();
+        QVERIFY(snapshot);
+
+        const int num_trixels = SkyMesh::Create(m_manager.htmesh_level())->size();
+        std::size_t num_obj   = 0;
+
+        for (int trixel = 0; trixel < num_trixels; trixel++)
+        {
+            const auto &known     = m_manager.get_objects_in_trixel_no_nulls(trixel);
+            const auto &unknown   = m_manager.get_objects_in_trixel_null_mag(trixel);
+            const auto &s_known   = snapshot->objects_in_trixel_no_nulls(trixel);
+            const auto &s_unknown = snapshot->objects_in_trixel_null_mag(trixel);
+
+            QCOMPARE(s_known.size(), known.size());
+            QCOMPARE(s_unknown.size(), unknown.size());
+            QVERIFY(std::is_sorted(s_known.begin(), s_known.end(),
+                                   [](const auto &a, const auto &b)
+                                   { return a.mag() < b.mag(); }));
+
+            for (const auto &obj : known)
+            {
+                const auto found = std::find(s_known.begin(), s_known.end(), obj);
+                QVERIFY(found != s_known.end());
+                QCOMPARE(found->name(), obj.name());
+                QCOMPARE(found->longname(), obj.longname());
+                QCOMPARE(found->mag(), obj.mag());
+                QCOMPARE(found->ra0().Degrees(), obj.ra0().Degrees());
+                QCOMPARE(found->a(), obj.a());
+                QCOMPARE(found->catalogId(), obj.catalogId());
+            }
+
+            for (const auto &obj : unknown)
+                QVERIFY(std::find(s_unknown.begin(), s_unknown.end(), obj) !=
+                        s_unknown.end());
+
+            num_obj += s_known.size() + s_unknown.size();
+        }
+
+        QCOMPARE(num_obj, snapshot->size());
+
+        // The snapshot follows the changes to the master catalog.
+        QVERIFY(m_manager.add_object(0, SkyObject::STAR, dms{ 0 }, dms{ 0 }, "tester")
+                    .first);
+
+        const auto updated = m_manager.open_master_snapshot();
+        QVERIFY(updated);
+        QCOMPARE(updated->size(), num_obj + 1);
+
+        num_obj = 0;
+        QBENCHMARK
+        {
+            for (int trixel = 0; trixel < num_trixels; trixel++)
+            {
+                num_obj += updated->objects_in_trixel_no_nulls(trixel).size();
+                num_obj += updated->objects_in_trixel_null_mag(trixel).size();
+            }
+        }
+
+        QVERIFY(num_obj > 0);
+    }
+
+    void prefetch_trixels()
+    {
+        AsyncDBManager async{ m_manager.db_file_name() };
+        std::vector<TrixelObjects> trixels;
+        const auto collect = [&]()
+        {
+            for (auto &objects : async.take_trixels())
+                trixels.push_back(std::move(objects));
+
+            return trixels.size();
+        };
+
+        const std::vector<int> urgent{ 0, 1 };
+        async.prefetch_trixels(urgent, { 2 }, m_manager.open_master_snapshot());
+        QTRY_COMPARE(collect(), std::size_t(3));
+
+        for (const auto &objects : trixels)
+        {
+            QCOMPARE(objects.known_mag.size(),
+                     m_manager.get_objects_in_trixel_no_nulls(objects.trixel).size());
+            QCOMPARE(objects.null_mag.size(),
+                     m_manager.get_objects_in_trixel_null_mag(objects.trixel).size());
+        }
+
+        // Without a snapshot the trixels are queried
+        trixels.clear();
+        async.prefetch_trixels({ 3 }, {}, nullptr);
+        QTRY_COMPARE(collect(), std::size_t(1));
+        QCOMPARE(trixels.front().known_mag.size(),
+                 m_manager.get_objects_in_trixel_no_nulls(3).size());
+    }
+
     void find_by_name()
     {
         const auto &obj  = some_object();
@@ -6,7 +6,9 @@
 
 
 #include <QTest>
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include <QObject>
 #include "fitsviewer/fitsdata.h"
@@ -28,6 +30,7 @@ class TestDefects : public QObject
 
     private slots:
         void basicTest();
+        void subframeEdgesTest();
 };
 
 #include "testdefects.moc"
@@ -96,4 +99,76 @@ void TestDefects::basicTest()
     }
 }
 
+namespace
+{
+// A width x height 16-bit frame filled with value, with hot pixels at the given coordinates
+QSharedPointer<FITSData> createFrame(uint16_t width, uint16_t height, uint16_t value,
+                                     const QList<QPair<int, int>> &hotPixels)
+{
+    const uint32_t samples = static_cast<uint32_t>(width) * height;
+    FITSImage::Statistic stats;
+    stats.dataType = TUSHORT;
+    stats.bytesPerPixel = sizeof(uint16_t);
+    stats.ndim = 2;
+    stats.width = width;
+    stats.height = height;
+    stats.channels = 1;
+    stats.samples_per_channel = samples;
+    stats.size = samples * sizeof(uint16_t);
+    stats.median[0] = value;
+    stats.stddev[0] = 10;
+
+    uint16_t *buffer = new uint16_t[samples];
+    std::fill(buffer, buffer + samples, value);
+    for (const auto &onePixel : hotPixels)
+        buffer[onePixel.first + onePixel.second * width] = 60000;
+
+    QSharedPointer<FITSData> data(new FITSData(FITS_CALIBRATE), &QObject::deleteLater);
+    data->setImageBuffer(reinterpret_cast<uint8_t *>(buffer));
+    data->restoreStatistics(stats);
+    return data;
+}
+}
+
+// Filter the defects of a subframe, some next to or on its edges.
+void TestDefects::subframeEdgesTest()
+{
+    // The subframe covers x 20..59 and y 30..59 of the 100x100 dark frame
+    const uint16_t offsetX = 20, offsetY = 30, width = 40, height = 30;
+
+    // Defects next to the right and bottom edges of the subframe have all their neighbors in it
+    const QList<QPair<int, int>> inner = {{width - 2, 10}, {10, height - 2}, {width - 2, height - 2}, {15, 12}};
+    // Defects on the edges of the subframe are left as they are
+    const QList<QPair<int, int>> edges = {{width - 1, 12}, {12, height - 1}, {0, 14}, {16, 0}};
+
+    QList<QPair<int, int>> darkPixels;
+    for (const auto &onePixel : inner + edges)
+        darkPixels << qMakePair(onePixel.first + offsetX, onePixel.second + offsetY);
+    // Outside of the subframe
+    darkPixels << qMakePair(70, 70) << qMakePair(10, 10);
+
+    QSharedPointer<DefectMap> map(new DefectMap());
+    map->setDarkData(createFrame(100, 100, 100, darkPixels));
+    QCOMPARE(map->hotCount(), static_cast<uint32_t>(darkPixels.size()));
+
+    std::vector<uint32_t> expected;
+    for (const auto &onePixel : inner)
+        expected.push_back(onePixel.first + onePixel.second * width);
+    std::vector<uint32_t> indexes = *map->defectIndexes(width, height, offsetX, offsetY);
+    std::sort(expected.begin(), expected.end());
+    std::sort(indexes.begin(), indexes.end());
+    QVERIFY(indexes == expected);
+
+    QSharedPointer<FITSData> lightData = createFrame(width, height, 1000, inner + edges);
+    QPointer<Ekos::DarkProcessor> processor = new Ekos::DarkProcessor();
+    processor->normalizeDefects(map, lightData, offsetX, offsetY);
+    delete processor;
+
+    uint16_t const *buffer = reinterpret_cast<uint16_t const *>(lightData->getImageBuffer());
+    for (const auto &onePixel : inner)
+        QCOMPARE(buffer[onePixel.first + onePixel.second * width], static_cast<uint16_t>(1000));
+    for (const auto &onePixel : edges)
+        QCOMPARE(buffer[onePixel.first + onePixel.second * width], static_cast<uint16_t>(60000));
+}
+
 QTEST_GUILESS_MAIN(TestDefects)
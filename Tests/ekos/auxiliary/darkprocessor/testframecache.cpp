@@ -0,0 +1,177 @@
+/*
+    SPDX-FileCopyrightText: 2023
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QTest>
+#include <QTemporaryDir>
+#include <memory>
+
+#include <QObject>
+#include "fitsviewer/fitsdata.h"
+#include "ekos/auxiliary/masterframecache.h"
+
+class TestFrameCache : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestFrameCache();
+        ~TestFrameCache() override = default;
+
+    private slots:
+        void evictionTest();
+        void pinTest();
+        void compactTest();
+
+    private:
+        // 100x100 16-bit master filled with value
+        static QSharedPointer<FITSData> createMaster(uint16_t value);
+};
+
+#include "testframecache.moc"
+
+using Ekos::MasterFrameCache;
+
+namespace
+{
+constexpr uint16_t SIZE = 100;
+constexpr uint64_t MASTER_BYTES = SIZE * SIZE * sizeof(uint16_t);
+}
+
+TestFrameCache::TestFrameCache() : QObject()
+{
+}
+
+QSharedPointer<FITSData> TestFrameCache::createMaster(uint16_t value)
+{
+    FITSImage::Statistic stats;
+    stats.dataType = TUSHORT;
+    stats.bytesPerPixel = sizeof(uint16_t);
+    stats.ndim = 2;
+    stats.width = SIZE;
+    stats.height = SIZE;
+    stats.channels = 1;
+    stats.samples_per_channel = SIZE * SIZE;
+    stats.size = MASTER_BYTES;
+    stats.min[0] = stats.max[0] = stats.mean[0] = stats.median[0] = value;
+
+    uint16_t *buffer = new uint16_t[SIZE * SIZE];
+    std::fill(buffer, buffer + SIZE * SIZE, value);
+
+    QSharedPointer<FITSData> data(new FITSData(FITS_CALIBRATE), &QObject::deleteLater);
+    data->setImageBuffer(reinterpret_cast<uint8_t *>(buffer));
+    data->restoreStatistics(stats);
+    return data;
+}
+
+void TestFrameCache::evictionTest()
+{
+    MasterFrameCache cache(2 * MASTER_BYTES);
+    QCOMPARE(MasterFrameCache::imageBytes(createMaster(0)), MASTER_BYTES);
+
+    cache.insert("a", createMaster(1));
+    cache.insert("b", createMaster(2));
+    // a becomes the most recently used, so c evicts b
+    QVERIFY(cache.find("a"));
+    cache.insert("c", createMaster(3));
+
+    QVERIFY(cache.find("a"));
+    QVERIFY(!cache.find("b"));
+    QVERIFY(cache.find("c"));
+
+    auto stats = cache.statistics();
+    QCOMPARE(stats.hits, uint64_t(3));
+    QCOMPARE(stats.misses, uint64_t(1));
+    QCOMPARE(stats.evictions, uint64_t(1));
+    QCOMPARE(stats.frames, 2u);
+    QCOMPARE(stats.bytes, 2 * MASTER_BYTES);
+
+    cache.trim(0);
+    stats = cache.statistics();
+    QCOMPARE(stats.frames, 0u);
+    QCOMPARE(stats.bytes, uint64_t(0));
+    QCOMPARE(stats.evictions, uint64_t(3));
+}
+
+void TestFrameCache::pinTest()
+{
+    MasterFrameCache cache(MASTER_BYTES);
+
+    auto a = createMaster(1);
+    cache.insert("a", a);
+    {
+        auto pin = cache.pin(a);
+        QVERIFY(pin);
+        QCOMPARE(cache.statistics().pinned, 1u);
+
+        // The pinned master is kept over the limit
+        cache.insert("b", createMaster(2));
+        QVERIFY(cache.find("a"));
+        QVERIFY(cache.find("b"));
+        cache.trim(0);
+        QVERIFY(cache.find("a"));
+        QVERIFY(!cache.find("b"));
+    }
+
+    QCOMPARE(cache.statistics().pinned, 0u);
+    cache.trim(0);
+    QVERIFY(!cache.find("a"));
+    QVERIFY(!cache.pin(a));
+
+    // Masters found or inserted with a pin are pinned before anything else may evict them
+    {
+        MasterFrameCache::Pin insertPin, findPin;
+        cache.insert("c", createMaster(3), &insertPin);
+        QVERIFY(insertPin);
+        QVERIFY(cache.find("c", &findPin));
+        QVERIFY(findPin);
+        insertPin.clear();
+
+        cache.insert("d", createMaster(4));
+        cache.trim(0);
+        QVERIFY(cache.find("c"));
+        QVERIFY(!cache.find("d"));
+        QCOMPARE(cache.statistics().pinned, 1u);
+    }
+    cache.trim(0);
+    QVERIFY(!cache.find("c"));
+}
+
+void TestFrameCache::compactTest()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+
+    // The compact files are only valid for an existing source file
+    const QString source = directory.filePath("master.fits");
+    QFile file(source);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("master");
+    file.close();
+
+    MasterFrameCache cache(MASTER_BYTES, directory.filePath("cache"));
+    cache.insert(source, createMaster(42));
+    cache.trim(0);
+    QVERIFY(!cache.find(source));
+    QCOMPARE(QDir(directory.filePath("cache")).entryList(QDir::Files).size(), 1);
+
+    auto data = cache.load(source);
+    QVERIFY(data);
+    QCOMPARE(cache.statistics().compactLoads, uint64_t(1));
+    QCOMPARE(data->width(), SIZE);
+    QCOMPARE(data->getStatistics().dataType, TUSHORT);
+    QCOMPARE(data->getStatistics().mean[0], 42.0);
+    auto buffer = reinterpret_cast<uint16_t const *>(data->getImageBuffer());
+    QVERIFY(std::all_of(buffer, buffer + SIZE * SIZE, [](uint16_t value)
+    {
+        return value == 42;
+    }));
+
+    cache.remove(source);
+    QVERIFY(!cache.find(source));
+    QCOMPARE(QDir(directory.filePath("cache")).entryList(QDir::Files).size(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestFrameCache)
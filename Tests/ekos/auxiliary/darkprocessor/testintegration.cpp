@@ -0,0 +1,135 @@
+/*
+    SPDX-FileCopyrightText: 2023
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QTest>
+#include <memory>
+
+#include <QObject>
+#include "ekos/auxiliary/masterframeintegrator.h"
+
+class TestIntegration : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestIntegration();
+        ~TestIntegration() override = default;
+
+    private slots:
+        void averageTest();
+        void rejectionTest();
+        void tilingTest();
+        void precisionTest();
+};
+
+#include "testintegration.moc"
+
+using Ekos::MasterFrameIntegrator;
+
+TestIntegration::TestIntegration() : QObject()
+{
+}
+
+void TestIntegration::averageTest()
+{
+    const uint32_t samples = 100;
+    MasterFrameIntegrator integrator;
+    integrator.start(samples);
+
+    for (uint16_t frame = 1; frame <= 4; frame++)
+    {
+        std::vector<uint16_t> buffer(samples);
+        for (uint32_t i = 0; i < samples; i++)
+            buffer[i] = frame * 10 + i;
+        QVERIFY(integrator.addFrame(buffer.data()));
+    }
+    QCOMPARE(integrator.frames(), 4u);
+
+    std::vector<uint16_t> master(samples);
+    QVERIFY(integrator.integrate(master.data()));
+    for (uint32_t i = 0; i < samples; i++)
+        QCOMPARE(master[i], static_cast<uint16_t>(25 + i));
+}
+
+void TestIntegration::rejectionTest()
+{
+    // A cosmic ray in one of the frames
+    const float values[10] = {100, 101, 99, 100, 102, 98, 100, 101, 99, 5000};
+    float buffer[10];
+
+    std::copy(values, values + 10, buffer);
+    QCOMPARE(MasterFrameIntegrator::combine(buffer, 10, MasterFrameIntegrator::AVERAGE, 3.0), 590.0);
+
+    std::copy(values, values + 10, buffer);
+    QCOMPARE(MasterFrameIntegrator::combine(buffer, 10, MasterFrameIntegrator::SIGMA_CLIPPING, 3.0), 100.0);
+
+    std::copy(values, values + 10, buffer);
+    const double winsorized = MasterFrameIntegrator::combine(buffer, 10, MasterFrameIntegrator::WINSORIZED_SIGMA_CLIPPING, 3.0);
+    QVERIFY(winsorized > 100.0 && winsorized < 102.0);
+
+    // Identical values
+    std::fill(buffer, buffer + 10, 7.0f);
+    QCOMPARE(MasterFrameIntegrator::combine(buffer, 10, MasterFrameIntegrator::SIGMA_CLIPPING, 3.0), 7.0);
+    QCOMPARE(MasterFrameIntegrator::combine(buffer, 10, MasterFrameIntegrator::WINSORIZED_SIGMA_CLIPPING, 3.0), 7.0);
+}
+
+void TestIntegration::tilingTest()
+{
+    // With no memory budget the frames are read back one pixel at a time
+    const uint32_t samples = 1000, frames = 12;
+    std::vector<std::vector<float>> buffers(frames, std::vector<float>(samples));
+    for (uint32_t frame = 0; frame < frames; frame++)
+        for (uint32_t i = 0; i < samples; i++)
+            buffers[frame][i] = 1000 + (i % 7) + ((frame * 31 + i) % 5) + ((i % 97 == frame) ? 60000 : 0);
+
+    for (uint32_t budget : {0u, 1u})
+    {
+        MasterFrameIntegrator integrator;
+        integrator.start(samples, MasterFrameIntegrator::SIGMA_CLIPPING, 3.0, budget);
+        for (uint32_t frame = 0; frame < frames; frame++)
+            QVERIFY(integrator.addFrame(buffers[frame].data()));
+
+        std::vector<float> master(samples);
+        QVERIFY2(integrator.integrate(master.data()), integrator.getLastError().toLatin1());
+
+        for (uint32_t i = 0; i < samples; i++)
+        {
+            std::vector<float> values(frames);
+            for (uint32_t frame = 0; frame < frames; frame++)
+                values[frame] = buffers[frame][i];
+            const float expected = MasterFrameIntegrator::combine(values.data(), frames, MasterFrameIntegrator::SIGMA_CLIPPING, 3.0);
+            QCOMPARE(master[i], expected);
+            QVERIFY(master[i] < 2000);
+        }
+    }
+}
+
+void TestIntegration::precisionTest()
+{
+    // 32-bit values a float does not hold exactly
+    const uint32_t samples = 100, frames = 5;
+    const uint32_t base = 1u << 30;
+    MasterFrameIntegrator integrator;
+    integrator.start(samples, MasterFrameIntegrator::WINSORIZED_SIGMA_CLIPPING);
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        std::vector<uint32_t> buffer(samples);
+        for (uint32_t i = 0; i < samples; i++)
+            buffer[i] = base + i;
+        QVERIFY(integrator.addFrame(buffer.data()));
+    }
+
+    std::vector<uint32_t> master(samples);
+    QVERIFY2(integrator.integrate(master.data()), integrator.getLastError().toLatin1());
+    for (uint32_t i = 0; i < samples; i++)
+        QCOMPARE(master[i], base + i);
+
+    // Frames of another data type are not mixed in
+    std::vector<uint16_t> other(samples);
+    QVERIFY(!integrator.addFrame(other.data()));
+}
+
+QTEST_GUILESS_MAIN(TestIntegration)
@@ -5,7 +5,9 @@
 */
 
 #include <QTest>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include <QObject>
 #include "fitsviewer/fitsdata.h"
@@ -21,6 +23,7 @@ class TestSubtraction : public QObject
 
     private slots:
         void basicTest();
+        void saturationTest();
 };
 
 #include "testsubtraction.moc"
@@ -56,5 +59,73 @@ void TestSubtraction::basicTest()
         QCOMPARE(buffer[i], 0);
 }
 
+namespace
+{
+// A width x height frame of the given FITS data type, holding values repeated over its rows
+template <typename T>
+QSharedPointer<FITSData> createFrame(int dataType, uint16_t width, uint16_t height, const std::vector<T> &values)
+{
+    const uint32_t samples = static_cast<uint32_t>(width) * height;
+    FITSImage::Statistic stats;
+    stats.dataType = dataType;
+    stats.bytesPerPixel = sizeof(T);
+    stats.ndim = 2;
+    stats.width = width;
+    stats.height = height;
+    stats.channels = 1;
+    stats.samples_per_channel = samples;
+    stats.size = samples * sizeof(T);
+
+    T *buffer = new T[samples];
+    for (uint32_t i = 0; i < samples; i++)
+        buffer[i] = values[(i % width) % values.size()];
+
+    QSharedPointer<FITSData> data(new FITSData(FITS_CALIBRATE), &QObject::deleteLater);
+    data->setImageBuffer(reinterpret_cast<uint8_t *>(buffer));
+    data->restoreStatistics(stats);
+    return data;
+}
+
+// Subtract the dark values from the light values over a frame large enough to be split in bands,
+// and compare every pixel with the expected values.
+template <typename T>
+void verifySubtraction(int dataType, const std::vector<T> &light, const std::vector<T> &dark, const std::vector<T> &expected)
+{
+    const uint16_t width = 1000, height = 300;
+    QSharedPointer<FITSData> lightData = createFrame(dataType, width, height, light);
+    QSharedPointer<FITSData> darkData = createFrame(dataType, width, height, dark);
+
+    QPointer<Ekos::DarkProcessor> processor = new Ekos::DarkProcessor();
+    processor->subtractDarkData(darkData, lightData, 0, 0);
+    delete processor;
+
+    T const *buffer = reinterpret_cast<T const *>(lightData->getImageBuffer());
+    for (uint32_t i = 0; i < static_cast<uint32_t>(width) * height; i++)
+        QCOMPARE(buffer[i], expected[(i % width) % expected.size()]);
+}
+}
+
+// Differences under zero saturate at zero. Subtracting a negative dark value from a signed light
+// value saturates at the type maximum instead of wrapping around.
+void TestSubtraction::saturationTest()
+{
+    verifySubtraction<uint16_t>(TUSHORT, {5, 3, 65535, 0}, {3, 5, 1, 0}, {2, 0, 65534, 0});
+
+    constexpr int16_t max16 = std::numeric_limits<int16_t>::max();
+    constexpr int16_t min16 = std::numeric_limits<int16_t>::lowest();
+    verifySubtraction<int16_t>(TSHORT,
+    {100, 32000, -5, 10, max16, -100, max16, 0},
+    {50, -1000, -10, 20, -1, min16, min16, min16},
+    {50, max16, 5, 0, max16, 32668, max16, max16});
+
+    constexpr int32_t max32 = std::numeric_limits<int32_t>::max();
+    constexpr int32_t min32 = std::numeric_limits<int32_t>::lowest();
+    verifySubtraction<int32_t>(TLONG,
+    {100, max32 - 10, -5, 10, min32},
+    {50, -11, -10, 20, min32},
+    {50, max32, 5, 0, 0});
+
+    verifySubtraction<float>(TFLOAT, {2.5f, 1.0f, -1.0f}, {1.0f, 2.5f, -3.0f}, {1.5f, 0.0f, 2.0f});
+}
 
 QTEST_GUILESS_MAIN(TestSubtraction)
@@ -9,8 +9,18 @@
 #include "testfitsdata.h"
 #include "Options.h"
 #include "ekos/auxiliary/solverutils.h"
+#include "fitsviewer/bayerdemosaic.h"
+#include "fitsviewer/stretch.h"
 #include "ekos/auxiliary/stellarsolverprofile.h"
 #include <QtGlobal>
+#include <QTemporaryDir>
+#include <QBuffer>
+#include <QImage>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
 
 Q_DECLARE_METATYPE(FITSMode);
 
@@ -313,7 +323,12 @@ void TestFitsData::testCentroidAlgorithmBenchmark()
     QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
     QVERIFY(worker.result());
 
-    QBENCHMARK { d->findStars(ALGORITHM_CENTROID).waitForFinished(); }
+    QBENCHMARK
+    {
+        // Measure the detector rather than the detection cache
+        d->clearStarDetectionCache();
+        d->findStars(ALGORITHM_CENTROID).waitForFinished();
+    }
 #endif
 }
 
@@ -343,7 +358,12 @@ void TestFitsData::testGradientAlgorithmBenchmark()
     QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
     QVERIFY(worker.result());
 
-    QBENCHMARK { d->findStars(ALGORITHM_GRADIENT).waitForFinished(); }
+    QBENCHMARK
+    {
+        // Measure the detector rather than the detection cache
+        d->clearStarDetectionCache();
+        d->findStars(ALGORITHM_GRADIENT).waitForFinished();
+    }
 #endif
 }
 
@@ -375,7 +395,12 @@ void TestFitsData::testThresholdAlgorithmBenchmark()
     QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
     QVERIFY(worker.result());
 
-    QBENCHMARK { d->findStars(ALGORITHM_THRESHOLD).waitForFinished(); }
+    QBENCHMARK
+    {
+        // Measure the detector rather than the detection cache
+        d->clearStarDetectionCache();
+        d->findStars(ALGORITHM_THRESHOLD).waitForFinished();
+    }
 #endif
 }
 
@@ -405,7 +430,80 @@ void TestFitsData::testSEPAlgorithmBenchmark()
     QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
     QVERIFY(worker.result());
 
-    QBENCHMARK { d->findStars(ALGORITHM_SEP).waitForFinished(); }
+    QBENCHMARK
+    {
+        // Measure the detector rather than the detection cache
+        d->clearStarDetectionCache();
+        d->findStars(ALGORITHM_SEP).waitForFinished();
+    }
+#endif
+}
+
+void TestFitsData::testStarDetectionCache_data()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    initGenericDataFixture();
+#endif
+}
+
+void TestFitsData::testStarDetectionCache()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    QFETCH(QString, NAME);
+    QFETCH(QRect, TRACKING_BOX);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping load test because of missing fixture");
+
+    std::unique_ptr<FITSData> d(new FITSData());
+    QVERIFY(d->loadFromFile(NAME).result());
+
+    d->findStars(ALGORITHM_SEP).waitForFinished();
+    const int stars = d->getDetectedStars();
+    QVERIFY(stars > 1);
+    const double background = d->getSkyBackground().mean;
+
+    // The same search on the same frame is served from the cache
+    QFuture<bool> cached = d->findStars(ALGORITHM_SEP);
+    QVERIFY(cached.isFinished());
+    QVERIFY(cached.result());
+    QCOMPARE(d->getDetectedStars(), stars);
+    QCOMPARE(d->getSkyBackground().mean, background);
+
+    // Other search boxes are cached separately
+    d->findStars(ALGORITHM_SEP, TRACKING_BOX).waitForFinished();
+    QCOMPARE(d->getDetectedStars(), 1);
+    QVERIFY(d->findStars(ALGORITHM_SEP).isFinished());
+    QCOMPARE(d->getDetectedStars(), stars);
+
+    // Filtering does not alter the cached detection
+    QSharedPointer<ImageMask> mask(new ImageRingMask(0, 0.1, d->width(), d->height()));
+    QVERIFY(d->filterStars(mask) < stars);
+    QVERIFY(d->findStars(ALGORITHM_SEP).isFinished());
+    QCOMPARE(d->getDetectedStars(), stars);
+
+    // Changing the image data drops the cache
+    d->getWritableImageBuffer();
+    d->findStars(ALGORITHM_SEP).waitForFinished();
+    QCOMPARE(d->getDetectedStars(), stars);
+    QList<QPointF> found;
+    for (const auto &edge : d->getStarCenters())
+        found.append(QPointF(edge->x, edge->y));
+
+    // The stars are cached as found, even if getHFR() prunes or reorders them before the next search
+    d->getHFR(HFR_HIGH);
+    QVERIFY(d->findStars(ALGORITHM_SEP).isFinished());
+    QCOMPARE(d->getDetectedStars(), stars);
+    d->getHFR(HFR_MEDIAN);
+    QVERIFY(d->findStars(ALGORITHM_SEP).isFinished());
+    QList<QPointF> replayed;
+    for (const auto &edge : d->getStarCenters())
+        replayed.append(QPointF(edge->x, edge->y));
+    QCOMPARE(replayed, found);
 #endif
 }
 
@@ -566,6 +664,349 @@ void SolverLoop::startDetect(int index)
     }
 }
 
+void TestFitsData::testStatistics_data()
+{
+    QTest::addColumn<int>("WIDTH");
+    QTest::addColumn<int>("HEIGHT");
+    // Value of the first pixel, or -1 to keep the random one
+    QTest::addColumn<int>("FIRST");
+
+    QTest::newRow("small, odd count") << 301 << 201 << -1;
+    QTest::newRow("small, even count") << 300 << 200 << -1;
+    QTest::newRow("small, saturated first pixel") << 300 << 200 << 65535;
+    QTest::newRow("16 megapixels") << 4656 << 3520 << -1;
+}
+
+void TestFitsData::testStatistics()
+{
+    QFETCH(int, WIDTH);
+    QFETCH(int, HEIGHT);
+    QFETCH(int, FIRST);
+
+    // Synthetic 16-bit frame: a pedestal with noise and a few saturated pixels
+    QRandomGenerator generator(42);
+    std::vector<uint16_t> pixels(static_cast<size_t>(WIDTH) * HEIGHT);
+    for (auto &pixel : pixels)
+        pixel = 1000 + generator.bounded(200) + (generator.bounded(1000) == 0 ? 64535 : 0);
+    // The mean must not depend on the first pixel, which is never zero here
+    if (FIRST >= 0)
+        pixels[0] = FIRST;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("statistics.fits");
+
+    fitsfile *fptr = nullptr;
+    int status = 0;
+    long naxes[2] = { WIDTH, HEIGHT };
+    QVERIFY(fits_create_file(&fptr, filename.toLocal8Bit().constData(), &status) == 0);
+    QVERIFY(fits_create_img(fptr, USHORT_IMG, 2, naxes, &status) == 0);
+    QVERIFY(fits_write_img(fptr, TUSHORT, 1, pixels.size(), pixels.data(), &status) == 0);
+    QVERIFY(fits_close_file(fptr, &status) == 0);
+
+    std::unique_ptr<FITSData> fd(new FITSData());
+    QFuture<bool> worker = fd->loadFromFile(filename);
+    QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
+    QVERIFY(worker.result());
+
+    // Reference values
+    double sum = 0, sumSquares = 0;
+    for (auto pixel : pixels)
+        sum += pixel;
+    const double mean = sum / pixels.size();
+    for (auto pixel : pixels)
+        sumSquares += (pixel - mean) * (pixel - mean);
+    const double stddev = std::sqrt(sumSquares / pixels.size());
+
+    std::vector<uint16_t> sorted = pixels;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t n = sorted.size();
+    const double median = (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+
+    QCOMPARE(fd->getMin(), static_cast<double>(sorted.front()));
+    QCOMPARE(fd->getMax(), static_cast<double>(sorted.back()));
+    QCOMPARE(fd->getMedian(), median);
+    QVERIFY(std::abs(fd->getMean() - mean) < 1e-6);
+    QVERIFY(std::abs(fd->getStdDev() - stddev) < 1e-6);
+
+    QBENCHMARK { fd->calculateStats(true); }
+}
+
+void TestFitsData::testBufferPool()
+{
+    // Room for two 1 MiB buffers
+    FITSBufferPool pool(2 * 1024 * 1024);
+
+    uint8_t *first = pool.acquire(1000000);
+    uint8_t *second = pool.acquire(1000000);
+    QVERIFY(first != nullptr && second != nullptr);
+    QCOMPARE(pool.statistics().misses, static_cast<uint64_t>(2));
+
+    // Released buffers are reused for requests in the same bucket
+    pool.release(first, 1000000);
+    QCOMPARE(pool.statistics().idleBuffers, 1U);
+    uint8_t *reused = pool.acquire(1000100);
+    QCOMPARE(reused, first);
+    QCOMPARE(pool.statistics().hits, static_cast<uint64_t>(1));
+
+    // But not for other sizes
+    pool.release(reused, 1000100);
+    uint8_t *other = pool.acquire(3000000);
+    QVERIFY(other != first);
+    QCOMPARE(pool.statistics().misses, static_cast<uint64_t>(3));
+
+    // Buffers beyond the idle limit are freed
+    pool.release(second, 1000000);
+    pool.release(other, 3000000);
+    QCOMPARE(pool.statistics().discards, static_cast<uint64_t>(1));
+    QCOMPARE(pool.statistics().idleBuffers, 2U);
+
+    // Lowering the limit frees the idle buffers over it
+    pool.setMaxIdleBytes(1024 * 1024);
+    QCOMPARE(pool.statistics().idleBuffers, 1U);
+    QVERIFY(pool.statistics().idleBytes <= 1024 * 1024);
+
+    pool.clear();
+    QCOMPARE(pool.statistics().idleBytes, static_cast<uint64_t>(0));
+
+    // Frames loaded one after the other reuse the buffers of the previous ones
+    QSharedPointer<FITSBufferPool> framePool(new FITSBufferPool());
+    uint64_t firstFrameMisses = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        QImage image(640, 480, QImage::Format_Grayscale8);
+        image.fill(i);
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(image.save(&buffer, "PNG"));
+
+        FITSData data(FITS_NORMAL, framePool);
+        QVERIFY(data.loadFromBuffer(png, "png"));
+        QCOMPARE(data.getMin(), static_cast<double>(i));
+        if (i == 0)
+            firstFrameMisses = framePool->statistics().misses;
+    }
+    QVERIFY(firstFrameMisses > 0);
+    QCOMPARE(framePool->statistics().misses, firstFrameMisses);
+    QVERIFY(framePool->statistics().hits >= 2);
+}
+
+void TestFitsData::testDebayer_data()
+{
+    QTest::addColumn<int>("METHOD");
+    QTest::addColumn<int>("FILTER");
+    QTest::addColumn<int>("OFFSETY");
+    QTest::addColumn<bool>("EXACT");
+
+    const QList<QPair<QString, dc1394bayer_method_t>> methods =
+    {
+        { "nearest", DC1394_BAYER_METHOD_NEAREST }, { "bilinear", DC1394_BAYER_METHOD_BILINEAR },
+        { "vng", DC1394_BAYER_METHOD_VNG }, { "superpixel", DC1394_BAYER_METHOD_DOWNSAMPLE }
+    };
+    const QStringList filters = { "RGGB", "GBRG", "GRBG", "BGGR" };
+
+    for (const auto &method : methods)
+        for (int filter = 0; filter < filters.size(); filter++)
+            for (int offsetY = 0; offsetY < 2; offsetY++)
+                QTest::newRow(qPrintable(QString("%1 %2 %3").arg(method.first, filters[filter]).arg(offsetY)))
+                        << static_cast<int>(method.second) << static_cast<int>(DC1394_COLOR_FILTER_MIN + filter) << offsetY
+                        // Bilinear and VNG interpolate linear gradients exactly
+                        << (method.second == DC1394_BAYER_METHOD_BILINEAR || method.second == DC1394_BAYER_METHOD_VNG);
+}
+
+void TestFitsData::testDebayer()
+{
+    QFETCH(int, METHOD);
+    QFETCH(int, FILTER);
+    QFETCH(int, OFFSETY);
+    QFETCH(bool, EXACT);
+
+    BayerParams params;
+    params.method = static_cast<dc1394bayer_method_t>(METHOD);
+    params.filter = static_cast<dc1394color_filter_t>(FILTER);
+    params.offsetX = 0;
+    params.offsetY = OFFSETY;
+
+    // Colours of the cells of each pattern, red 0, green 1 and blue 2
+    const int patterns[4][2][2] = { {{0, 1}, {1, 2}}, {{1, 2}, {0, 1}}, {{1, 0}, {2, 1}}, {{2, 1}, {1, 0}} };
+    const auto &pattern = patterns[FILTER - DC1394_COLOR_FILTER_MIN];
+
+    // Odd sizes exercise the borders of the Bayer cells
+    const int width = 641, height = 479;
+    BayerDemosaic demosaic(params);
+    const QSize size = demosaic.outputSize(width, height);
+    const int planeSize = size.width() * size.height();
+    std::vector<uint16_t> bayer(width * height);
+    std::vector<uint16_t> planar(3 * planeSize);
+
+    // A flat field of a different level in each colour is reproduced everywhere
+    const uint16_t levels[3] = { 30000, 12000, 500 };
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            bayer[y * width + x] = levels[pattern[(y + OFFSETY) & 1][x & 1]];
+
+    QVERIFY(demosaic.run(bayer.data(), width, height, planar.data()));
+    for (int color = 0; color < 3; color++)
+        QVERIFY(std::all_of(planar.begin() + color * planeSize, planar.begin() + (color + 1) * planeSize,
+                            [&](uint16_t value)
+    {
+        return value == levels[color];
+    }));
+
+    // Linear gradients
+    auto level = [](int color, int x, int y)
+    {
+        return static_cast<uint16_t>(100 * (color + 1) + (color + 2) * x + (3 - color) * y);
+    };
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            bayer[y * width + x] = level(pattern[(y + OFFSETY) & 1][x & 1], x, y);
+
+    QVERIFY(demosaic.run(bayer.data(), width, height, planar.data()));
+    if (EXACT)
+    {
+        // Away from the borders, where the pattern is mirrored
+        for (int color = 0; color < 3; color++)
+            for (int y = 2; y < height - 2; y++)
+                for (int x = 2; x < width - 2; x++)
+                    QCOMPARE(planar[color * planeSize + y * width + x], level(color, x, y));
+    }
+
+    QBENCHMARK
+    {
+        demosaic.run(bayer.data(), width, height, planar.data());
+    }
+}
+
+namespace
+{
+// Stretch of one sample, as computed per pixel by the original implementation of Stretch
+template <typename T>
+uint8_t referenceStretch(T input, const StretchParams1Channel &params, float maxInput)
+{
+    const float hsRangeFactor = params.highlights == params.shadows ? 1.0f : 1.0f / (params.highlights - params.shadows);
+    const T nativeShadows = params.shadows * maxInput;
+    const T nativeHighlights = params.highlights * maxInput;
+    const float k1 = (params.midtones - 1) * hsRangeFactor * 255 / maxInput;
+    const float k2 = ((2 * params.midtones) - 1) * hsRangeFactor / maxInput;
+
+    if (input < nativeShadows) return 0;
+    if (input >= nativeHighlights) return 255;
+    const T inputFloored = (input - nativeShadows);
+    return (inputFloored * k1) / (inputFloored * k2 - params.midtones);
+}
+
+template <typename T>
+void checkStretch(int dataType, int channels, int width, int height, int sampling)
+{
+    std::vector<T> buffer(static_cast<size_t>(width) * height * channels);
+    for (size_t i = 0; i < buffer.size(); i++)
+    {
+        // Integer samples wrap over their whole range, float samples are normalized
+        if (std::is_floating_point<T>::value)
+            buffer[i] = static_cast<T>((i * 7919 % 10007) / 10007.0);
+        else
+            buffer[i] = static_cast<T>(i * 7919);
+    }
+    const float maxInput = std::is_floating_point<T>::value ? 1 : (sizeof(T) == 1 ? 255 : 65535);
+
+    // Shadows and highlights of signed samples must stay within their positive half of the 64K input range
+    const float scale = std::is_signed<T>::value && std::is_integral<T>::value ? 0.5f : 1.0f;
+    StretchParams params;
+    params.grey_red.shadows = 0.05f * scale;
+    params.grey_red.highlights = 0.9f * scale;
+    params.grey_red.midtones = 0.2f;
+    params.green.shadows = 0.1f * scale;
+    params.green.highlights = scale;
+    params.green.midtones = 0.35f;
+    params.blue.highlights = 0.8f * scale;
+    params.blue.midtones = 0.6f;
+
+    Stretch stretch(width, height, channels, dataType);
+    stretch.setParams(params);
+
+    QImage image((width + sampling - 1) / sampling, (height + sampling - 1) / sampling,
+                 channels == 1 ? QImage::Format_Indexed8 : QImage::Format_RGB32);
+    stretch.run(reinterpret_cast<const uint8_t *>(buffer.data()), &image, sampling);
+
+    const StretchParams1Channel *channelParams[3] = { &params.grey_red, &params.green, &params.blue };
+    const size_t size = static_cast<size_t>(width) * height;
+    for (int y = 0; y < image.height(); y++)
+    {
+        for (int x = 0; x < image.width(); x++)
+        {
+            const size_t index = static_cast<size_t>(y) * sampling * width + x * sampling;
+            if (channels == 1)
+                QCOMPARE(image.scanLine(y)[x], referenceStretch(buffer[index], params.grey_red, maxInput));
+            else
+            {
+                const QRgb pixel = reinterpret_cast<const QRgb *>(image.scanLine(y))[x];
+                const int values[3] = { qRed(pixel), qGreen(pixel), qBlue(pixel) };
+                for (int channel = 0; channel < 3; channel++)
+                    QCOMPARE(values[channel], static_cast<int>(referenceStretch(buffer[channel * size + index],
+                             *channelParams[channel], maxInput)));
+            }
+        }
+    }
+
+    QBENCHMARK
+    {
+        stretch.run(reinterpret_cast<const uint8_t *>(buffer.data()), &image, sampling);
+    }
+}
+}
+
+void TestFitsData::testStretch_data()
+{
+    QTest::addColumn<int>("TYPE");
+    QTest::addColumn<int>("CHANNELS");
+    QTest::addColumn<int>("WIDTH");
+    QTest::addColumn<int>("HEIGHT");
+    QTest::addColumn<int>("SAMPLING");
+
+    const QList<QPair<QString, int>> types =
+    {
+        { "uint8", TBYTE }, { "int16", TSHORT }, { "uint16", TUSHORT }, { "float", TFLOAT }
+    };
+
+    // Large frames are stretched through lookup tables, small ones compute the transfer function
+    for (const auto &type : types)
+        for (int channels : { 1, 3 })
+            for (int sampling : { 1, 2 })
+            {
+                QTest::newRow(qPrintable(QString("%1 %2 channel(s) sampling %3").arg(type.first).arg(channels).arg(sampling)))
+                        << type.second << channels << 641 << 479 << sampling;
+                QTest::newRow(qPrintable(QString("%1 %2 channel(s) sampling %3 small").arg(type.first).arg(channels).arg(sampling)))
+                        << type.second << channels << 97 << 61 << sampling;
+            }
+}
+
+void TestFitsData::testStretch()
+{
+    QFETCH(int, TYPE);
+    QFETCH(int, CHANNELS);
+    QFETCH(int, WIDTH);
+    QFETCH(int, HEIGHT);
+    QFETCH(int, SAMPLING);
+
+    switch (TYPE)
+    {
+        case TBYTE:
+            checkStretch<uint8_t>(TYPE, CHANNELS, WIDTH, HEIGHT, SAMPLING);
+            break;
+        case TSHORT:
+            checkStretch<int16_t>(TYPE, CHANNELS, WIDTH, HEIGHT, SAMPLING);
+            break;
+        case TUSHORT:
+            checkStretch<uint16_t>(TYPE, CHANNELS, WIDTH, HEIGHT, SAMPLING);
+            break;
+        case TFLOAT:
+            checkStretch<float>(TYPE, CHANNELS, WIDTH, HEIGHT, SAMPLING);
+            break;
+    }
+}
+
 // This tests how well we can detect stars and/or plate-solve a number of images
 // at the same time. Mostly a memory test--a failure would be a segv.
 // I have not provided the fits files as part of the source code, so you need to
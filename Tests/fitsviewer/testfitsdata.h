@@ -46,12 +46,26 @@ class TestFitsData : public QObject
         void testSEPAlgorithmBenchmark_data();
         void testSEPAlgorithmBenchmark();
 
+        void testStarDetectionCache_data();
+        void testStarDetectionCache();
+
         void testComputeHFR_data();
         void testComputeHFR();
 
         void testBahtinovFocusHFR_data();
         void testBahtinovFocusHFR();
 
+        void testStatistics_data();
+        void testStatistics();
+
+        void testBufferPool();
+
+        void testDebayer_data();
+        void testDebayer();
+
+        void testStretch_data();
+        void testStretch();
+
         void testParallelSolvers();
     private:
         void startGuideDetect(const QString &filename);
@@ -5,13 +5,18 @@
 */
 
 #include "ekos/focus/focusalgorithms.h"
+#include "ekos/focus/focusfwhm.h"
+#include "ekos/focus/focusfourierpower.h"
 
 #include <QTest>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include <QObject>
 
-// At this point, only the methods in focusalgorithms.h are tested.
+// At this point, only the methods in focusalgorithms.h, the star filtering of focusfwhm.h and the
+// spectrum power of focusfourierpower.h are tested.
 
 class TestFocus : public QObject
 {
@@ -30,6 +35,9 @@ class TestFocus : public QObject
         void L1PHyperbolaTest();
         void L1PParabolaTest();
         void L1PQuadraticTest();
+        void overlappingStarsTest();
+        void fourierPowerTest_data();
+        void fourierPowerTest();
 };
 
 #include "testfocus.moc"
@@ -859,4 +867,126 @@ void TestFocus::L1PQuadraticTest()
     QCOMPARE(focuser->doneReason(), "Solution found.");
 }
 
+void TestFocus::overlappingStarsTest()
+{
+    // The grid based filter should exclude exactly the stars that comparing every pair of boxes excludes.
+    std::mt19937 generator(42);
+    for (int trial = 0; trial < 20; trial++)
+    {
+        const int width = 1000, height = 800;
+        std::uniform_int_distribution<int> xDist(0, width - 40), yDist(0, height - 40), sizeDist(2, 40);
+        QVector<Ekos::FocusFWHM::StarBox> stars;
+        for (int s = 0; s < 50 + 20 * trial; s++)
+        {
+            Ekos::FocusFWHM::StarBox star;
+            star.star = s;
+            star.isValid = true;
+            star.start = qMakePair(xDist(generator), yDist(generator));
+            const int size = sizeDist(generator);
+            star.end = qMakePair(star.start.first + size, star.start.second + size);
+            stars.push_back(star);
+        }
+
+        QVector<Ekos::FocusFWHM::StarBox> expected = stars;
+        for (int s1 = 0; s1 < expected.size(); s1++)
+        {
+            if (!expected[s1].isValid)
+                continue;
+            for (int s2 = s1 + 1; s2 < expected.size(); s2++)
+            {
+                if (expected[s2].isValid &&
+                        Ekos::FocusFWHM::boxOverlap(expected[s1].start, expected[s1].end, expected[s2].start, expected[s2].end))
+                {
+                    expected[s1].isValid = false;
+                    expected[s2].isValid = false;
+                }
+            }
+        }
+
+        Ekos::FocusFWHM::excludeOverlappingStars(stars, width, height);
+        for (int s = 0; s < stars.size(); s++)
+            QCOMPARE(stars[s].isValid, expected[s].isValid);
+    }
+}
+
+namespace
+{
+// The power of the spectrum of a real image, computed as FocusFourierPower used to: a complex
+// FFT of every row, then of every column, of the image with a zero imaginary part.
+double complexSpectrumPower(const std::vector<double> &image, int width, int height)
+{
+    std::vector<double> data(2 * image.size(), 0.0);
+    for (size_t i = 0; i < image.size(); i++)
+        data[2 * i] = image[i];
+
+    gsl_fft_complex_wavetable *rowWT = gsl_fft_complex_wavetable_alloc(width);
+    gsl_fft_complex_workspace *rowWS = gsl_fft_complex_workspace_alloc(width);
+    gsl_fft_complex_wavetable *colWT = gsl_fft_complex_wavetable_alloc(height);
+    gsl_fft_complex_workspace *colWS = gsl_fft_complex_workspace_alloc(height);
+
+    for (int j = 0; j < height; j++)
+        gsl_fft_complex_forward(&data[2 * j * width], 1, width, rowWT, rowWS);
+    for (int i = 0; i < width; i++)
+        gsl_fft_complex_forward(&data[2 * i], width, height, colWT, colWS);
+
+    gsl_fft_complex_wavetable_free(rowWT);
+    gsl_fft_complex_workspace_free(rowWS);
+    gsl_fft_complex_wavetable_free(colWT);
+    gsl_fft_complex_workspace_free(colWS);
+
+    double power = 0.0;
+    for (const double value : data)
+        power += value * value;
+    return power;
+}
+}  // namespace
+
+void TestFocus::fourierPowerTest_data()
+{
+    QTest::addColumn<int>("WIDTH");
+    QTest::addColumn<int>("HEIGHT");
+
+    QTest::newRow("even x even") << 16 << 12;
+    QTest::newRow("odd x even") << 15 << 12;
+    QTest::newRow("even x odd") << 16 << 9;
+    QTest::newRow("odd x odd") << 17 << 9;
+    QTest::newRow("two columns") << 2 << 7;
+    QTest::newRow("three columns") << 3 << 8;
+    QTest::newRow("large") << 301 << 200;
+}
+
+// Test that the spectrum power, computed from real FFTs of the rows and the symmetry of the spectrum,
+// matches that of the complex 2D FFT of the image, for odd and even widths.
+void TestFocus::fourierPowerTest()
+{
+    QFETCH(int, WIDTH);
+    QFETCH(int, HEIGHT);
+
+    // A few gaussian stars over noise
+    std::default_random_engine generator(WIDTH * 1000 + HEIGHT);
+    std::uniform_real_distribution<double> noise(0.0, 10.0);
+    std::vector<double> image(static_cast<size_t>(WIDTH) * HEIGHT);
+    for (int y = 0; y < HEIGHT; y++)
+        for (int x = 0; x < WIDTH; x++)
+        {
+            double value = noise(generator);
+            value += 1000.0 * exp(-(pow(x - WIDTH / 3.0, 2) + pow(y - HEIGHT / 2.0, 2)) / 4.0);
+            value += 500.0 * exp(-(pow(x - 2.0 * WIDTH / 3.0, 2) + pow(y - HEIGHT / 4.0, 2)) / 2.0);
+            image[y * WIDTH + x] = value;
+        }
+
+    const double expected = complexSpectrumPower(image, WIDTH, HEIGHT);
+
+    // Twice, to also use the transforms kept from the first frame
+    Ekos::FocusFourierPower fourierPower(Mathematics::RobustStatistics::SCALE_QESTIMATOR);
+    for (int i = 0; i < 2; i++)
+    {
+        std::vector<double> frame = image;
+        double power = 0.0;
+        QVERIFY(fourierPower.spectrumPower(frame, WIDTH, HEIGHT, &power));
+        QVERIFY2(fabs(power - expected) <= 1e-9 * expected,
+                 qPrintable(QString("power %1 expected %2").arg(power, 0, 'g', 17).arg(expected, 0, 'g', 17)));
+    }
+}
+
 QTEST_GUILESS_MAIN(TestFocus)
@@ -15,10 +15,15 @@
 #include "indi/indiproperty.h"
 #include "ekos/capture/sequencejob.h"
 #include "ekos/capture/placeholderpath.h"
+#include "artificialhorizoncomponent.h"
+#include "ksnumbers.h"
+#include "linelist.h"
 #include "Options.h"
 
 #include <QTest>
 #include <memory>
+#include <time.h>
+#include <vector>
 
 #include <QObject>
 
@@ -43,8 +48,12 @@ class TestSchedulerUnit : public QObject
         void loadSequenceQueueTest();
         void estimateJobTimeTest();
         void evaluateJobsTest();
+        void parallelEvaluationTest();
+        void calculateNextTimeTest_data();
+        void calculateNextTimeTest();
 
     private:
+        QDateTime minuteScan(const SchedulerJob &job, const QDateTime &when, bool checkIfConstraintsAreMet);
         void runSetupJob(SchedulerJob &job,
                          GeoLocation *geo, KStarsDateTime *localTime, const QString &name,
                          const dms &ra, const dms &dec, double positionAngle, const QUrl &sequenceUrl,
@@ -607,4 +616,166 @@ void TestSchedulerUnit::evaluateJobsTest()
     jobsToProcess.clear();
 }
 
+// Test that the GreedyScheduler schedules the same jobs at the same times, whether it evaluates their
+// constraints concurrently or one after the other.
+void TestSchedulerUnit::parallelEvaluationTest()
+{
+    auto localTime8pm = midNight.addSecs(-4 * 3600);
+    const QMap<QString, uint16_t> capturedFrames;
+    const bool parallelEvaluation = Options::schedulerParallelEvaluation();
+
+    auto schedule = [&](bool parallel)
+    {
+        Options::setSchedulerParallelEvaluation(parallel);
+        Scheduler::setLocalTime(&localTime8pm);
+
+        // Targets crossing the meridian at different times, some waiting to rise above their minimum altitude
+        const QVector<double> raOffsets = {0, -45, 30, 60, 90, -90};
+        const QVector<double> minAltitudes = {30, 60, 40, 70, 30, 20};
+        std::vector<std::unique_ptr<SchedulerJob>> jobs;
+        QList<SchedulerJob *> jobList;
+        for (int i = 0; i < raOffsets.size(); ++i)
+        {
+            jobs.emplace_back(new SchedulerJob(nullptr));
+            runSetupJob(*jobs.back(), &siliconValley, &localTime8pm, QString("Job%1").arg(i),
+                        dms(midnightRA.Degrees() + raOffsets[i]), testDEC, 0.0,
+                        QUrl(QString("file:%1").arg(seqFile9Filters)), QUrl(""),
+                        SchedulerJob::START_ASAP, QDateTime(),
+                        SchedulerJob::FINISH_REPEAT, QDateTime(), 2,
+                        minAltitudes[i]);
+            jobList.append(jobs.back().get());
+        }
+
+        Ekos::GreedyScheduler scheduler;
+        scheduler.setParams(true, true, true, 3600, 3600);
+        const QList<SchedulerJob *> scheduled = scheduler.scheduleJobs(jobList, localTime8pm, capturedFrames, nullptr);
+
+        QList<QPair<QDateTime, QDateTime>> times;
+        for (const auto job : jobList)
+            times.append(qMakePair(job->getStartupTime(), job->getCompletionTime()));
+        QStringList order;
+        for (const auto job : scheduled)
+            order.append(job->getName());
+        return qMakePair(order, times);
+    };
+
+    const auto serial = schedule(false);
+    const auto concurrent = schedule(true);
+    Options::setSchedulerParallelEvaluation(parallelEvaluation);
+
+    QVERIFY(!serial.first.isEmpty());
+    QCOMPARE(concurrent.first, serial.first);
+    QCOMPARE(concurrent.second, serial.second);
+}
+
+// The search calculateNextTime() replaced, which checked the constraints of the job minute by minute
+// over the next 24 hours, as a reference for it.
+QDateTime TestSchedulerUnit::minuteScan(const SchedulerJob &job, const QDateTime &when, bool checkIfConstraintsAreMet)
+{
+    KStarsDateTime const ltWhen(when);
+    SkyObject o;
+    o.setRA0(job.getTargetCoords().ra0());
+    o.setDec0(job.getTargetCoords().dec0());
+
+    for (int minute = 0; minute < 24 * 60; minute++)
+    {
+        KStarsDateTime const ltOffset(ltWhen.addSecs(minute * 60));
+
+        if (job.getEnforceTwilight() && !job.runsDuringAstronomicalNightTime(ltOffset))
+        {
+            if (checkIfConstraintsAreMet)
+                continue;
+            return ltOffset;
+        }
+
+        KSNumbers numbers(ltOffset.djd());
+        o.updateCoordsNow(&numbers);
+        CachingDms const LST = job.getGeo()->GSTtoLST(job.getGeo()->LTtoUT(ltOffset).gst());
+        o.EquatorialToHorizontal(&LST, job.getGeo()->lat());
+
+        bool const met = job.satisfiesAltitudeConstraint(o.az().Degrees(), o.alt().Degrees()) &&
+                         (job.getMinMoonSeparation() <= 0 || 0 <= job.getMoonSeparationScore(ltOffset));
+        if (met == checkIfConstraintsAreMet)
+            return ltOffset;
+    }
+    return QDateTime();
+}
+
+void TestSchedulerUnit::calculateNextTimeTest_data()
+{
+    QTest::addColumn<QDate>("DATE");
+    QTest::addColumn<bool>("ENFORCE_TWILIGHT");
+    QTest::addColumn<bool>("ARTIFICIAL_HORIZON");
+
+    QTest::newRow("ALTITUDE") << QDate(2021, 4, 16) << false << false;
+    QTest::newRow("TWILIGHT") << QDate(2021, 4, 16) << true << false;
+    QTest::newRow("HORIZON") << QDate(2021, 4, 16) << true << true;
+    // Daylight saving time ends at 2am on the night of November 6th, 2021 in California
+    QTest::newRow("DST") << QDate(2021, 11, 6) << true << false;
+    QTest::newRow("DST_HORIZON") << QDate(2021, 11, 6) << true << true;
+}
+
+// Test SchedulerJob::calculateNextTime() against the minute scan it replaced, looking for the next time
+// the constraints are met and the next time they are not, from times spread over a day and a half.
+void TestSchedulerUnit::calculateNextTimeTest()
+{
+    QFETCH(QDate, DATE);
+    QFETCH(bool, ENFORCE_TWILIGHT);
+    QFETCH(bool, ARTIFICIAL_HORIZON);
+
+    // Local times are in the Californian time zone, whatever the time zone of the test machine
+    QByteArray const previousTZ = qgetenv("TZ");
+    bool const hadTZ = qEnvironmentVariableIsSet("TZ");
+    qputenv("TZ", "America/Los_Angeles");
+    tzset();
+
+    // The target rises in the north-east, the horizon hides it up to 50 degrees there
+    ArtificialHorizon horizon;
+    if (ARTIFICIAL_HORIZON)
+    {
+        std::shared_ptr<LineList> pointList(new LineList);
+        for (double azimuth : {30.0, 90.0})
+        {
+            std::shared_ptr<SkyPoint> point(new SkyPoint);
+            point->setAlt(50.0);
+            point->setAz(azimuth);
+            pointList->append(point);
+        }
+        horizon.addRegion("north-east", true, pointList, false);
+        SchedulerJob::setHorizon(&horizon);
+    }
+
+    KStarsDateTime noon(DATE, QTime(12, 0), Qt::LocalTime);
+    SchedulerJob job(nullptr);
+    runSetupJob(job, &siliconValley, &noon, "Job1",
+                midnightRA, testDEC, 0.0,
+                QUrl(QString("file:%1").arg(seqFile9Filters)), QUrl(""),
+                SchedulerJob::START_ASAP, QDateTime(),
+                SchedulerJob::FINISH_SEQUENCE, QDateTime(), 1,
+                30.0, 0.0, false, ENFORCE_TWILIGHT, ARTIFICIAL_HORIZON);
+
+    for (int minutes = 0; minutes < 36 * 60; minutes += 97)
+    {
+        KStarsDateTime const when = noon.addSecs(minutes * 60);
+        for (bool checkIfConstraintsAreMet : {true, false})
+        {
+            QDateTime const expected = minuteScan(job, when, checkIfConstraintsAreMet);
+            QDateTime const result = job.calculateNextTime(when, checkIfConstraintsAreMet);
+            QVERIFY2(expected.isValid() == result.isValid(),
+                     qPrintable(QString("From %1: %2 instead of %3").arg(when.toString())
+                                .arg(result.toString()).arg(expected.toString())));
+            if (expected.isValid())
+                QVERIFY(compareTimes(result, expected, 120));
+        }
+    }
+
+    SchedulerJob::setHorizon(nullptr);
+    Scheduler::setLocalTime(&midNight);
+    if (hadTZ)
+        qputenv("TZ", previousTZ);
+    else
+        qunsetenv("TZ");
+    tzset();
+}
+
 QTEST_GUILESS_MAIN(TestSchedulerUnit)
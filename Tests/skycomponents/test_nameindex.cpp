@@ -0,0 +1,162 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_nameindex.h"
+
+#include "skycomponents/nameindex.h"
+
+TestNameIndex::TestNameIndex() : QObject()
+{
+}
+
+TestNameIndex::~TestNameIndex()
+{
+}
+
+void TestNameIndex::initTestCase()
+{
+    m_Index.reset(new NameIndex());
+
+    QHash<int, QVector<QPair<QString, const SkyObject *>>> lists;
+    auto add = [&](int type, const QString & name, const QString & longname = QString())
+    {
+        m_Objects.emplace_back(new SkyObject(type, 0.0, 0.0, 0.0, name, QString(), longname));
+        lists[type].append({ name, m_Objects.back().get() });
+        if (!longname.isEmpty())
+            lists[type].append({ longname, m_Objects.back().get() });
+    };
+
+    add(SkyObject::GALAXY, "M 31", "Andromeda Galaxy");
+    add(SkyObject::GALAXY, "M 33", "Triangulum Galaxy");
+    add(SkyObject::GALAXY, "M 81");
+    add(SkyObject::GASEOUS_NEBULA, "M 42", "Orion Nebula");
+    add(SkyObject::STAR, "Betelgeuse");
+    add(SkyObject::STAR, "Bellatrix");
+    add(SkyObject::STAR, "Barnard's Star");
+    add(SkyObject::PLANET, "Mars");
+    add(SkyObject::CONSTELLATION, "Orion");
+
+    for (auto it = lists.constBegin(); it != lists.constEnd(); ++it)
+        m_Index->setNames(it.key(), it.value());
+}
+
+void TestNameIndex::testNormalize_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<QString>("key");
+
+    QTest::newRow("spaces") << "M 31" << "m31";
+    QTest::newRow("case") << "NGC 7000" << "ngc7000";
+    QTest::newRow("punctuation") << "Barnard's Star" << "barnardsstar";
+    QTest::newRow("hyphen") << "IC-434" << "ic434";
+    QTest::newRow("accents") << QString::fromUtf8("Ras Algéthi") << "rasalgethi";
+}
+
+void TestNameIndex::testNormalize()
+{
+    QFETCH(QString, name);
+    QFETCH(QString, key);
+
+    QCOMPARE(NameIndex::normalize(name), key);
+}
+
+void TestNameIndex::testFind()
+{
+    QCOMPARE(m_Index->size(), 13);
+
+    auto matches = m_Index->find("m31");
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches.first().name, QString("M 31"));
+    QCOMPARE(matches.first().type, int(SkyObject::GALAXY));
+    QCOMPARE(matches.first().object->name(), QString("M 31"));
+
+    matches = m_Index->find("andromeda galaxy");
+    QCOMPARE(matches.size(), 1);
+    QCOMPARE(matches.first().object->name(), QString("M 31"));
+
+    // Same name, different types
+    QCOMPARE(m_Index->find("ORION").size(), 1);
+    QCOMPARE(m_Index->find("Orion Nebula").size(), 1);
+
+    QVERIFY(m_Index->find("M 3").isEmpty());
+    QVERIFY(m_Index->find("").isEmpty());
+    QVERIFY(m_Index->find(" - ").isEmpty());
+}
+
+void TestNameIndex::testFindByPrefix()
+{
+    auto matches = m_Index->findByPrefix("m3");
+    QCOMPARE(matches.size(), 2);
+    QCOMPARE(matches.at(0).name, QString("M 31"));
+    QCOMPARE(matches.at(1).name, QString("M 33"));
+
+    matches = m_Index->findByPrefix("M");
+    QCOMPARE(matches.size(), 5);
+    QCOMPARE(matches.first().name, QString("M 31"));
+    QCOMPARE(matches.last().name, QString("Mars"));
+
+    QCOMPARE(m_Index->findByPrefix("M", 2).size(), 2);
+    QVERIFY(m_Index->findByPrefix("Z").isEmpty());
+}
+
+void TestNameIndex::testFindApproximate_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<int>("maxDistance");
+    QTest::addColumn<QString>("closest");
+    QTest::addColumn<int>("distance");
+
+    QTest::newRow("exact") << "Betelgeuse" << 2 << "Betelgeuse" << 0;
+    QTest::newRow("normalized") << "m-81" << 0 << "M 81" << 0;
+    QTest::newRow("substitution") << "Betelgeuze" << 2 << "Betelgeuse" << 1;
+    QTest::newRow("deletion") << "Betelgese" << 2 << "Betelgeuse" << 1;
+    QTest::newRow("insertion") << "Bellatrixx" << 2 << "Bellatrix" << 1;
+    QTest::newRow("typo in a word") << "Orion Nebila" << 2 << "Orion Nebula" << 1;
+    QTest::newRow("too far") << "Bettlejuice" << 2 << "" << 0;
+}
+
+void TestNameIndex::testFindApproximate()
+{
+    QFETCH(QString, name);
+    QFETCH(int, maxDistance);
+    QFETCH(QString, closest);
+    QFETCH(int, distance);
+
+    const auto matches = m_Index->findApproximate(name, maxDistance);
+    if (closest.isEmpty())
+    {
+        QVERIFY(matches.isEmpty());
+        return;
+    }
+
+    QVERIFY(!matches.isEmpty());
+    QCOMPARE(matches.first().name, closest);
+    QCOMPARE(matches.first().distance, distance);
+    for (const auto &match : matches)
+    {
+        QVERIFY(match.distance >= distance);
+        QVERIFY(match.distance <= maxDistance);
+    }
+}
+
+void TestNameIndex::testSetNamesReplaces()
+{
+    NameIndex index;
+    SkyObject mars(SkyObject::PLANET, 0.0, 0.0, 0.0, "Mars");
+    SkyObject venus(SkyObject::PLANET, 0.0, 0.0, 0.0, "Venus");
+
+    index.setNames(SkyObject::PLANET, { { "Mars", &mars } });
+    QCOMPARE(index.find("mars").size(), 1);
+
+    index.setNames(SkyObject::PLANET, { { "Venus", &venus } });
+    QVERIFY(index.find("mars").isEmpty());
+    QCOMPARE(index.find("venus").first().object, static_cast<const SkyObject *>(&venus));
+
+    index.setNames(SkyObject::PLANET, {});
+    QCOMPARE(index.size(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestNameIndex)
@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QTest>
+
+#include "skyobjects/skyobject.h"
+
+#include <memory>
+#include <vector>
+
+class NameIndex;
+
+/**
+ * @class TestNameIndex
+ * @short Tests for the exact, prefix and approximate lookups of NameIndex
+ */
+class TestNameIndex : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestNameIndex();
+        ~TestNameIndex() override;
+
+    private slots:
+        void initTestCase();
+
+        void testNormalize_data();
+        void testNormalize();
+        void testFind();
+        void testFindByPrefix();
+        void testFindApproximate_data();
+        void testFindApproximate();
+        void testSetNamesReplaces();
+
+    private:
+        std::vector<std::unique_ptr<SkyObject>> m_Objects;
+        std::unique_ptr<NameIndex> m_Index;
+};
@@ -0,0 +1,145 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "test_nearestsearch.h"
+
+#include "skycomponents/nearestsearch.h"
+#include "skycomponents/skyquery.h"
+
+#include <algorithm>
+#include <vector>
+
+TestNearestSearch::TestNearestSearch() : QObject()
+{
+}
+
+TestNearestSearch::~TestNearestSearch()
+{
+}
+
+void TestNearestSearch::testAngularDistance_data()
+{
+    QTest::addColumn<double>("ra1");
+    QTest::addColumn<double>("dec1");
+    QTest::addColumn<double>("ra2");
+    QTest::addColumn<double>("dec2");
+
+    QTest::newRow("same point") << 10.0 << 20.0 << 10.0 << 20.0;
+    QTest::newRow("one arcsecond") << 83.8 << -5.4 << 83.8 << -5.4 + 1.0 / 3600.0;
+    QTest::newRow("across RA 0") << 359.5 << 10.0 << 0.5 << 10.0;
+    QTest::newRow("near the pole") << 0.0 << 89.9 << 180.0 << 89.9;
+    QTest::newRow("wide") << 10.0 << -60.0 << 250.0 << 45.0;
+}
+
+void TestNearestSearch::testAngularDistance()
+{
+    QFETCH(double, ra1);
+    QFETCH(double, dec1);
+    QFETCH(double, ra2);
+    QFETCH(double, dec2);
+
+    const SkyPoint p1(dms(ra1), dms(dec1)), p2(dms(ra2), dms(dec2));
+    const double expected = p1.angularDistanceTo(&p2).Degrees();
+
+    QVERIFY(std::fabs(SkyVector(p1).angularDistance(SkyVector(p2)) - expected) < 1e-7);
+    QVERIFY(std::fabs(SkyVector(p1).dot(SkyVector(p2)) - std::cos(expected * dms::DegToRad)) < 1e-9);
+}
+
+void TestNearestSearch::testCone()
+{
+    const SkyCone cone(SkyPoint(dms(100.0), dms(30.0)), 2.0);
+
+    QVERIFY(cone.contains(SkyPoint(dms(100.0), dms(30.0))));
+    QVERIFY(cone.contains(SkyPoint(dms(100.0), dms(31.99))));
+    QVERIFY(!cone.contains(SkyPoint(dms(100.0), dms(32.01))));
+    // 2.2 degrees of RA are less than 2 degrees on the sky at a declination of 30 degrees
+    QVERIFY(cone.contains(SkyPoint(dms(102.2), dms(30.0))));
+    QVERIFY(!cone.contains(SkyPoint(dms(280.0), dms(-30.0))));
+}
+
+void TestNearestSearch::testNearest()
+{
+    const SkyPoint center(dms(50.0), dms(-20.0));
+    std::vector<SkyPoint> points { SkyPoint(dms(50.0), dms(-17.0)), SkyPoint(dms(50.0), dms(-21.0)),
+                                   SkyPoint(dms(50.0), dms(-18.5)), SkyPoint(dms(230.0), dms(20.0)) };
+
+    NearestObjects<SkyPoint> nearest(center, 5.0);
+    for (auto &point : points)
+        nearest.add(&point);
+
+    QCOMPARE(nearest.size(), 1);
+    QCOMPARE(nearest.nearest(), &points[1]);
+    QVERIFY(std::fabs(nearest.distance(0) - 1.0) < 1e-9);
+
+    NearestObjects<SkyPoint> none(center, 0.5);
+    for (auto &point : points)
+        QVERIFY(!none.add(&point));
+    QVERIFY(none.nearest() == nullptr);
+}
+
+void TestNearestSearch::testNearestCount()
+{
+    const SkyPoint center(dms(200.0), dms(60.0));
+    std::vector<SkyPoint> points;
+    for (int i = 10; i > 0; i--)
+        points.emplace_back(dms(200.0), dms(60.0 + i * 0.1));
+
+    NearestObjects<SkyPoint> nearest(center, 0.55, 3);
+    for (auto &point : points)
+        nearest.add(&point);
+
+    const auto objects = nearest.objects();
+    QCOMPARE(objects.size(), 3);
+    QCOMPARE(objects.at(0), &points[9]);
+    QCOMPARE(objects.at(1), &points[8]);
+    QCOMPARE(objects.at(2), &points[7]);
+    QVERIFY(nearest.distance(0) < nearest.distance(1));
+    QVERIFY(nearest.distance(1) < nearest.distance(2));
+    QVERIFY(std::fabs(nearest.distance(2) - 0.3) < 1e-9);
+}
+
+void TestNearestSearch::testRegionCone()
+{
+    const auto region = SkyQueryRegion::cone(SkyPoint(dms(10.0), dms(-80.0)), 3.0);
+
+    QVERIFY(std::fabs(region.boundingRadius() - 3.0) < 1e-9);
+    QVERIFY(region.contains(SkyPoint(dms(10.0), dms(-80.0))));
+    QVERIFY(region.contains(SkyPoint(dms(15.0), dms(-80.0))));
+    QVERIFY(!region.contains(SkyPoint(dms(190.0), dms(-87.5))));
+    QVERIFY(!region.contains(SkyPoint(dms(10.0), dms(-76.9))));
+}
+
+void TestNearestSearch::testRegionPolygon_data()
+{
+    QTest::addColumn<bool>("reversed");
+
+    QTest::newRow("counterclockwise") << false;
+    QTest::newRow("clockwise") << true;
+}
+
+void TestNearestSearch::testRegionPolygon()
+{
+    QFETCH(bool, reversed);
+
+    // A footprint of about 2 by 1 degrees across RA 0
+    QVector<SkyPoint> corners { SkyPoint(dms(359.0), dms(29.5)), SkyPoint(dms(1.0), dms(29.5)),
+                                SkyPoint(dms(1.0), dms(30.5)), SkyPoint(dms(359.0), dms(30.5)) };
+    if (reversed)
+        std::reverse(corners.begin(), corners.end());
+
+    const auto region = SkyQueryRegion::polygon(corners);
+
+    QVERIFY(region.boundingRadius() > 0.9 && region.boundingRadius() < 1.2);
+    QVERIFY(std::fabs(region.boundingCenter().dec0().Degrees() - 30.0) < 0.01);
+    QVERIFY(region.contains(SkyPoint(dms(0.0), dms(30.0))));
+    QVERIFY(region.contains(SkyPoint(dms(359.5), dms(30.3))));
+    QVERIFY(region.contains(SkyPoint(dms(0.8), dms(29.7))));
+    QVERIFY(!region.contains(SkyPoint(dms(0.0), dms(30.7))));
+    QVERIFY(!region.contains(SkyPoint(dms(1.3), dms(30.0))));
+    QVERIFY(!region.contains(SkyPoint(dms(180.0), dms(-30.0))));
+}
+
+QTEST_GUILESS_MAIN(TestNearestSearch)
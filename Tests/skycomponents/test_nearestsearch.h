@@ -0,0 +1,32 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QTest>
+
+/**
+ * @class TestNearestSearch
+ * @short Tests for the dot product based radius and nearest neighbours queries
+ */
+class TestNearestSearch : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestNearestSearch();
+        ~TestNearestSearch() override;
+
+    private slots:
+        void testAngularDistance_data();
+        void testAngularDistance();
+        void testCone();
+        void testNearest();
+        void testNearestCount();
+        void testRegionCone();
+        void testRegionPolygon_data();
+        void testRegionPolygon();
+};
@@ -28,6 +28,7 @@ BinFileHelper::~BinFileHelper()
 
 void BinFileHelper::init()
 {
+    unmapFile();
     if (fileHandle)
         fclose(fileHandle);
 
@@ -73,6 +74,7 @@ FILE *BinFileHelper::openFile(const QString &fileName)
 {
     QString FilePath = KSPaths::locate(QStandardPaths::AppLocalDataLocation, fileName);
     init();
+    filePath             = FilePath;
     QByteArray b         = FilePath.toLatin1();
     const char *filepath = b.data();
 
@@ -275,10 +277,47 @@ bool BinFileHelper::readHeader()
 
 void BinFileHelper::closeFile()
 {
+    unmapFile();
     fclose(fileHandle);
     fileHandle = nullptr;
 }
 
+bool BinFileHelper::mapFile()
+{
+    if (mappedData)
+        return true;
+
+    if (!fileHandle || filePath.isEmpty())
+        return false;
+
+    mappedFile.setFileName(filePath);
+    if (!mappedFile.open(QIODevice::ReadOnly))
+        return false;
+
+    mappedSize = mappedFile.size();
+    mappedData = mappedFile.map(0, mappedSize);
+
+    if (!mappedData)
+    {
+        mappedFile.close();
+        mappedSize = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void BinFileHelper::unmapFile()
+{
+    if (!mappedData)
+        return;
+
+    mappedFile.unmap(mappedData);
+    mappedFile.close();
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+
 int BinFileHelper::getErrorNumber()
 {
     int err = errnum;
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <QFile>
 #include <QString>
 #include <QVector>
 
@@ -66,9 +67,44 @@ class BinFileHelper
 
     /**
      * @short  Close the binary data file
+     * @note   This also releases the memory mapping, if any
      */
     void closeFile();
 
+    /**
+     * @short  Map the currently open file into memory
+     *
+     * Once mapped, records can be accessed directly through mappedRange() without any
+     * seek or read calls. Mapping may fail (e.g. for very large files on 32-bit systems),
+     * in which case callers should keep using the FILE handle.
+     *
+     * @return True if the file is mapped, false if an error occurred
+     */
+    bool mapFile();
+
+    /**
+     * @short  Release the memory mapping of the currently open file, if any
+     */
+    void unmapFile();
+
+    /**
+     * @short  Check whether the currently open file is memory-mapped
+     * @return True if mapFile() succeeded and the mapping is still active
+     */
+    inline bool isMapped() const { return mappedData != nullptr; }
+
+    /**
+     * @short  Returns a pointer into the mapped file
+     * @param  offset Offset in bytes from the beginning of the file
+     * @param  length Number of bytes that the caller intends to read
+     * @return Pointer to the requested range, nullptr if the file is not mapped or the
+     *         range lies beyond the end of the file
+     */
+    inline const uchar *mappedRange(quint64 offset, quint64 length) const
+    {
+        return (mappedData && offset + length <= mappedSize) ? mappedData + offset : nullptr;
+    }
+
     /**
      * @short   Get error number
      * @return  A number corresponding to the error
@@ -229,6 +265,14 @@ class BinFileHelper
 
     /// Handle to the file.
     FILE *fileHandle { nullptr};
+    /// Full path of the currently open file
+    QString filePath;
+    /// File object backing the memory mapping
+    QFile mappedFile;
+    /// Start of the memory mapping, nullptr if the file is not mapped
+    uchar *mappedData { nullptr };
+    /// Size of the memory mapping in bytes
+    quint64 mappedSize { 0 };
     /// Stores offsets corresponding to each index table entry
     QVector<unsigned long> indexOffset;
     /// Stores number of records under each index table entry
@@ -0,0 +1,46 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QFuture>
+#include <QList>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cstdint>
+
+/**
+ * @brief forEachBand Run function(firstRow, lastRow) over bands of rows [firstRow, lastRow) of an image, concurrently
+ * on the global thread pool when the image is large enough to be worth it. Blocks until every band is done.
+ * @param rows number of rows of the image, nothing is run if there are none
+ * @param width number of columns of the image
+ * @param function called once per band, it must only write the rows of its band
+ */
+template <typename Function>
+void forEachBand(int rows, int width, const Function &function)
+{
+    if (rows <= 0 || width <= 0)
+        return;
+
+    // Images under 256k pixels are run in a single band
+    const int bandRows = static_cast<int64_t>(rows) * width < (1 << 18) ? rows : 32;
+    const int nBands = (rows + bandRows - 1) / bandRows;
+
+    QList<QFuture<void>> futures;
+    for (int band = 1; band < nBands; band++)
+    {
+        futures.append(QtConcurrent::run([&function, band, bandRows, rows]()
+        {
+            function(band * bandRows, std::min(rows, (band + 1) * bandRows));
+        }));
+    }
+
+    function(0, std::min(rows, bandRows));
+
+    for (auto &future : futures)
+        future.waitForFinished();
+}
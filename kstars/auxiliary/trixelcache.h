@@ -123,6 +123,12 @@ class TrixelCache
         return _data[index];
     }
 
+    /**
+     * @return wether the element at \p index is set, without marking it
+     * as recently used.
+     */
+    bool is_set(const size_t index) noexcept { return _data[index].is_set(); }
+
     /**
      * Remove excess elements from the cache
      * The capacity can be temporarily readjusted to \p keep.
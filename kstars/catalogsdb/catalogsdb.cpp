@@ -8,6 +8,7 @@
 #include <cmath>
 #include <QSqlDriver>
 #include <QSqlRecord>
+#include <QFileInfo>
 #include <QMutexLocker>
 #include <QTemporaryDir>
 #include <qsqldatabase.h>
@@ -336,27 +337,94 @@ std::pair<bool, QString> DBManager::register_catalog(const Catalog &cat)
 
 bool DBManager::compile_master_catalog()
 {
-    auto _ = gsl::finally([&]() { m_db.commit(); });
-    QSqlQuery query{ m_db };
-    m_db.transaction();
-
-    if (!query.exec(SqlStatements::drop_master))
     {
-        return false;
+        auto _ = gsl::finally([&]() { m_db.commit(); });
+        QSqlQuery query{ m_db };
+        m_db.transaction();
+
+        if (!query.exec(SqlStatements::drop_master))
+        {
+            return false;
+        }
+
+        if (!query.exec(SqlStatements::create_master))
+        {
+            return false;
+        }
+
+        bool success = true;
+        success &= query.exec(SqlStatements::create_master_trixel_index);
+        success &= query.exec(SqlStatements::create_master_mag_index);
+        success &= query.exec(SqlStatements::create_master_type_index);
+        success &= query.exec(SqlStatements::create_master_name_index);
+
+        if (!success)
+            return false;
     }
 
-    if (!query.exec(SqlStatements::create_master))
+    // Not fatal, the objects are then queried from the database.
+    const auto &snapshot = write_master_snapshot();
+    if (!snapshot.first)
+        qCWarning(KSTARS_CATALOGS) << "Could not write the master catalog snapshot:"
+                                   << snapshot.second;
+
+    return true;
+};
+
+std::pair<bool, MasterSnapshot::Stamp> DBManager::get_master_stamp()
+{
+    QSqlQuery query{ m_db };
+    if (!query.exec(SqlStatements::master_snapshot_stamp) || !query.next())
+        return { false, {} };
+
+    // Any other change to the content shows in the database file
+    const QFileInfo db_info{ m_db_file };
+    return { true,
+             { m_htmesh_level, query.value(0).toLongLong(), query.value(1).toLongLong(),
+               db_info.size(), db_info.lastModified().toMSecsSinceEpoch() } };
+}
+
+std::pair<bool, QString> DBManager::write_master_snapshot()
+{
+    QMutexLocker _{ &m_mutex };
+
+    const auto &stamp = get_master_stamp();
+    if (!stamp.first)
+        return { false, m_db.lastError().text() };
+
+    QSqlQuery query{ m_db };
+    query.setForwardOnly(true);
+    if (!query.exec(SqlStatements::master_snapshot))
+        return { false, query.lastError().text() };
+
+    return MasterSnapshot::write(MasterSnapshot::path_for(m_db_file), stamp.second,
+                                 query);
+}
+
+std::unique_ptr<MasterSnapshot> DBManager::open_master_snapshot()
+{
+    const auto &stamp = get_master_stamp();
+    if (!stamp.first)
+        return nullptr;
+
+    const auto &path = MasterSnapshot::path_for(m_db_file);
+    auto snapshot    = MasterSnapshot::open(path, stamp.second, m_db_file);
+    if (snapshot)
+        return snapshot;
+
+    if (QFile::exists(path))
+        qCInfo(KSTARS_CATALOGS) << "The master catalog snapshot is stale, rebuilding it.";
+
+    const auto &written = write_master_snapshot();
+    if (!written.first)
     {
-        return false;
+        qCWarning(KSTARS_CATALOGS) << "Could not write the master catalog snapshot:"
+                                   << written.second;
+        return nullptr;
     }
 
-    bool success = true;
-    success &= query.exec(SqlStatements::create_master_trixel_index);
-    success &= query.exec(SqlStatements::create_master_mag_index);
-    success &= query.exec(SqlStatements::create_master_type_index);
-    success &= query.exec(SqlStatements::create_master_name_index);
-    return success;
-};
+    return MasterSnapshot::open(path, stamp.second, m_db_file);
+}
 
 const Catalog read_catalog(const QSqlQuery &query)
 {
@@ -1215,3 +1283,90 @@ CatalogsDB::DBManager::insert_catalog_colors(const int id, const CatalogColorMap
 
     return { true, "" };
 };
+
+void AsyncDBManager::prefetch_trixels(const std::vector<int> &urgent,
+                                      const std::vector<int> &ahead,
+                                      std::shared_ptr<const MasterSnapshot> snapshot)
+{
+    QMutexLocker _{ &m_trixelMutex };
+
+    m_trixelQueue.assign(urgent.begin(), urgent.end());
+    m_trixelQueue.insert(m_trixelQueue.end(), ahead.begin(), ahead.end());
+    m_urgentTrixels = urgent.size();
+    m_snapshot      = std::move(snapshot);
+
+    if (!m_loadingTrixels && !m_trixelQueue.empty())
+    {
+        m_loadingTrixels = true;
+        QMetaObject::invokeMethod(this, "load_trixels", Qt::QueuedConnection);
+    }
+}
+
+void AsyncDBManager::load_trixels()
+{
+    while (true)
+    {
+        TrixelObjects objects{};
+        std::shared_ptr<const MasterSnapshot> snapshot;
+        quint64 generation;
+        bool urgent;
+
+        {
+            QMutexLocker _{ &m_trixelMutex };
+            if (m_trixelQueue.empty())
+            {
+                m_loadingTrixels = false;
+                return;
+            }
+
+            objects.trixel = m_trixelQueue.front();
+            m_trixelQueue.pop_front();
+            snapshot        = m_snapshot;
+            m_snapshotInUse = bool(snapshot);
+            generation      = m_trixelGeneration;
+            urgent     = m_urgentTrixels > 0;
+            if (urgent)
+                m_urgentTrixels--;
+        }
+
+        bool loaded = true;
+        try
+        {
+            if (snapshot)
+            {
+                objects.known_mag = snapshot->objects_in_trixel_no_nulls(objects.trixel);
+                objects.null_mag  = snapshot->objects_in_trixel_null_mag(objects.trixel);
+            }
+            else
+            {
+                objects.known_mag = m_manager->get_objects_in_trixel_no_nulls(objects.trixel);
+                objects.null_mag  = m_manager->get_objects_in_trixel_null_mag(objects.trixel);
+            }
+        }
+        catch (const DatabaseError &e)
+        {
+            // The trixel will be loaded synchronously when drawn
+            qCWarning(KSTARS_CATALOGS) << "Could not prefetch trixel" << objects.trixel
+                                       << ":" << e.what();
+            loaded = false;
+        }
+
+        bool ready = false;
+        {
+            QMutexLocker _{ &m_trixelMutex };
+            // Done with the snapshot, see clear_trixels()
+            snapshot.reset();
+            m_snapshotInUse = false;
+            m_snapshotReleased.wakeAll();
+
+            if (!loaded || generation != m_trixelGeneration)
+                continue;
+
+            m_trixels.push_back(std::move(objects));
+            ready = urgent && m_urgentTrixels == 0;
+        }
+
+        if (ready)
+            emit trixelsReady();
+    }
+}
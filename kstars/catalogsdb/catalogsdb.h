@@ -17,14 +17,17 @@
 #include <QMutex>
 #include <QObject>
 #include <QThread>
+#include <QWaitCondition>
 
 #include "polyfills/qstring_hash.h"
 #include <unordered_map>
+#include <deque>
 #include <queue>
 
 #include <unordered_set>
 #include <utility>
 #include "catalogobject.h"
+#include "mastersnapshot.h"
 #include "nan.h"
 #include "typedef.h"
 
@@ -507,13 +510,23 @@ class DBManager
     /**
      * Compiles the master catalog by merging the individual catalogs based
      * on `oid` and precedence and creates an index by (trixel, magnitude) on
-     * the master table. **Caution** you may want to call
+     * the master table. A `MasterSnapshot` of the result is written
+     * next to the database. **Caution** you may want to call
      * `update_catalog_views` beforhand.
      *
      * @return true in case of success, false in case of an error
      */
     bool compile_master_catalog();
 
+    /**
+     * \returns the memory mapped snapshot of the master catalog, see
+     * `MasterSnapshot`. It is rebuilt first if it is missing or does
+     * not match the master catalog anymore. Returns `nullptr` if it
+     * can't be built, in which case the objects have to be queried
+     * from the database.
+     */
+    std::unique_ptr<MasterSnapshot> open_master_snapshot();
+
     /**
      * Updates the all_catalog_view so that it includes all known
      * catalogs.
@@ -664,6 +677,20 @@ class DBManager
      */
     std::pair<bool, QString> remove_catalog_force(const int id);
 
+    /**
+     * \returns the stamp identifying the current content of the master
+     * catalog, see `MasterSnapshot::Stamp`.
+     */
+    std::pair<bool, MasterSnapshot::Stamp> get_master_stamp();
+
+    /**
+     * Writes the snapshot of the master catalog next to the database,
+     * see `MasterSnapshot`.
+     *
+     * @return [success, error]
+     */
+    std::pair<bool, QString> write_master_snapshot();
+
     /**
      *
      */
@@ -728,6 +755,19 @@ std::pair<bool, Catalog> read_catalog_meta_from_file(const QString &path);
 
 
 
+/**
+ * The objects of a trixel loaded in the background by \sa
+ * AsyncDBManager::prefetch_trixels, split like \sa
+ * DBManager::get_objects_in_trixel_no_nulls and \sa
+ * DBManager::get_objects_in_trixel_null_mag.
+ */
+struct TrixelObjects
+{
+    int trixel;
+    CatalogObjectVector known_mag;
+    CatalogObjectVector null_mag;
+};
+
 /**
  * A concurrent wrapper around \sa CatalogsDB::DBManager
  *
@@ -747,6 +787,9 @@ std::pair<bool, Catalog> read_catalog_meta_from_file(const QString &path);
  * The void override of \sa AsyncDBManager::init() does the most
  * commonly done thing, which is to open the DSO database
  *
+ * It can also load whole trixels in the background, \sa
+ * AsyncDBManager::prefetch_trixels(), which is used to fetch the sky
+ * around the view before it is drawn.
  */
 class AsyncDBManager : public QObject {
     // Note: Follows the active object pattern described here
@@ -759,6 +802,18 @@ private:
     std::shared_ptr<QThread> m_thread;
     QMutex m_resultMutex;
 
+    // Trixel prefetching, guarded by m_trixelMutex
+    std::shared_ptr<const MasterSnapshot> m_snapshot;
+    std::deque<int> m_trixelQueue;
+    std::vector<TrixelObjects> m_trixels;
+    std::size_t m_urgentTrixels { 0 };
+    quint64 m_trixelGeneration { 0 };
+    bool m_loadingTrixels { false };
+    // Wether a trixel is being sliced from a snapshot, signaled by m_snapshotReleased
+    bool m_snapshotInUse { false };
+    QMutex m_trixelMutex;
+    QWaitCondition m_snapshotReleased;
+
 public:
     template <typename... Args>
     using DBManagerMethod = CatalogObjectList (DBManager::*)(Args...);
@@ -774,7 +829,9 @@ public:
     {
         m_thread.reset(new QThread);
         moveToThread(m_thread.get());
-        connect(m_thread.get(), &QThread::started, [&]() {
+        // The arguments are copied, the thread may only start after
+        // the constructor has returned.
+        connect(m_thread.get(), &QThread::started, [this, args...]() {
             init(args...);
         });
         m_thread->start();
@@ -854,10 +911,65 @@ public:
         emit resultReady();
     }
 
+    /**
+     * Queues \p urgent and then \p ahead for loading in the
+     * background, replacing the trixels queued before that haven't
+     * been loaded yet. The loaded trixels are retrieved with \sa
+     * take_trixels().
+     *
+     * The objects are sliced from \p snapshot if it is set and queried
+     * from the database otherwise. \sa trixelsReady() is emitted once
+     * all of the \p urgent trixels are loaded.
+     *
+     * Can be called from any thread.
+     */
+    void prefetch_trixels(const std::vector<int> &urgent, const std::vector<int> &ahead,
+                          std::shared_ptr<const MasterSnapshot> snapshot);
+
+    /**
+     * \returns the trixels loaded since the last call, can be called
+     * from any thread.
+     */
+    std::vector<TrixelObjects> take_trixels()
+    {
+        QMutexLocker _{&m_trixelMutex};
+        std::vector<TrixelObjects> trixels;
+        trixels.swap(m_trixels);
+        return trixels;
+    }
+
+    /**
+     * Drops the queued and the loaded trixels, to be called when the
+     * master catalog has changed. Trixels being loaded at that time are
+     * discarded as well.
+     *
+     * Waits for the trixel being sliced from the snapshot, if any, so
+     * that this object holds no reference to the snapshot on return.
+     * Must not be called from the thread of this object.
+     */
+    void clear_trixels()
+    {
+        QMutexLocker _{&m_trixelMutex};
+        m_trixelQueue.clear();
+        m_trixels.clear();
+        m_snapshot.reset();
+        m_urgentTrixels = 0;
+        m_trixelGeneration++;
+
+        while (m_snapshotInUse)
+            m_snapshotReleased.wait(&m_trixelMutex);
+    }
+
 signals:
     void resultReady(void);
     void threadReady(void);
 
+    /**
+     * Emitted when the urgent trixels passed to \sa prefetch_trixels()
+     * have been loaded.
+     */
+    void trixelsReady(void);
+
 
 public slots:
 
@@ -927,6 +1039,11 @@ private slots:
         emit threadReady();
     }
 
+    /**
+     * Loads the queued trixels, in the thread of this object.
+     */
+    void load_trixels();
+
 };
 
 } // namespace CatalogsDB
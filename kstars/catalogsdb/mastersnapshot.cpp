@@ -0,0 +1,338 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <cstring>
+#include <limits>
+#include <QSaveFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include "mastersnapshot.h"
+#include "nan.h"
+
+using namespace CatalogsDB;
+
+namespace
+{
+constexpr char snapshot_magic[8]  = { 'K', 'S', 'D', 'S', 'O', 'T', 'R', 'X' };
+constexpr quint32 snapshot_version = 2;
+
+// Written in the native byte order, a file from a machine with another
+// byte order reads back differently and is rebuilt.
+constexpr quint32 byte_order_mark = 0x01020304;
+
+// Offset of the strings that are NULL in the database
+constexpr quint32 null_string = std::numeric_limits<quint32>::max();
+
+quint32 trixel_count_for(const int htmesh_level)
+{
+    return 8u << (2 * htmesh_level);
+}
+
+quint64 align(const quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+} // namespace
+
+struct MasterSnapshot::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 byte_order;
+    qint32 htmesh_level;
+    quint32 trixel_count;
+    qint64 rows;
+    qint64 trixel_sum;
+    qint64 db_size;
+    qint64 db_modified;
+    quint64 object_count;
+    quint64 trixel_begin_offset;
+    quint64 null_mag_begin_offset;
+    quint64 records_offset;
+    quint64 strings_offset;
+    quint64 strings_size;
+};
+
+/**
+ * One object of the master catalog. The strings are offsets into the
+ * pool, where they are stored as a `quint32` length followed by the
+ * UTF-8 data.
+ */
+struct MasterSnapshot::Record
+{
+    double ra;
+    double dec;
+    double position_angle;
+    float magnitude;
+    float major_axis;
+    float minor_axis;
+    float flux;
+    qint32 type;
+    qint32 catalog;
+    quint32 oid;
+    quint32 name;
+    quint32 long_name;
+    quint32 catalog_identifier;
+};
+
+QString MasterSnapshot::path_for(const QString &db_file)
+{
+    return db_file + ".trixels";
+}
+
+std::pair<bool, QString> MasterSnapshot::write(const QString &path, const Stamp &stamp,
+                                               QSqlQuery &query)
+{
+    static_assert(sizeof(Header) % 8 == 0, "The records must stay aligned.");
+    static_assert(sizeof(Record) == 64, "The record layout is part of the file format.");
+
+    if (stamp.htmesh_level < 0 || stamp.htmesh_level > 12)
+        return { false, QString("Unsupported htmesh level %1.").arg(stamp.htmesh_level) };
+
+    const quint32 trixel_count = trixel_count_for(stamp.htmesh_level);
+    std::vector<quint32> trixel_begin(trixel_count + 1, 0);
+    std::vector<quint32> null_mag_begin(trixel_count, null_string);
+    std::vector<Record> records;
+    QByteArray strings;
+
+    records.reserve(stamp.rows);
+
+    const auto add_string = [&](const QVariant &value, const bool utf8) -> quint32 {
+        if (value.isNull())
+            return null_string;
+
+        const QByteArray data =
+            utf8 ? value.toString().toUtf8() : value.toByteArray();
+        const quint32 offset = strings.size();
+        const quint32 length = data.size();
+
+        strings.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        strings.append(data);
+        return offset;
+    };
+
+    qint64 current = -1;
+    while (query.next())
+    {
+        const qint64 trixel = query.value(13).toLongLong();
+        if (trixel < current || trixel >= trixel_count)
+            return { false, QString("Invalid or unordered trixel %1.").arg(trixel) };
+
+        while (current < trixel)
+            trixel_begin[++current] = records.size();
+
+        const bool null_mag = query.isNull(4);
+        if (null_mag && null_mag_begin[trixel] == null_string)
+            null_mag_begin[trixel] = records.size();
+        else if (!null_mag && null_mag_begin[trixel] != null_string)
+            return { false, QString("Unordered magnitudes in trixel %1.").arg(trixel) };
+
+        Record record;
+        record.ra                 = query.value(2).toDouble();
+        record.dec                = query.value(3).toDouble();
+        record.position_angle     = query.value(10).toDouble();
+        record.magnitude          = null_mag ? NaN::f : query.value(4).toFloat();
+        record.major_axis         = query.value(8).toFloat();
+        record.minor_axis         = query.value(9).toFloat();
+        record.flux               = query.value(11).toFloat();
+        record.type               = query.value(1).toInt();
+        record.catalog            = query.value(12).toInt();
+        record.oid                = add_string(query.value(0), false);
+        record.name               = add_string(query.value(5), true);
+        record.long_name          = add_string(query.value(6), true);
+        record.catalog_identifier = add_string(query.value(7), true);
+        records.push_back(record);
+    }
+
+    if (query.lastError().isValid())
+        return { false, query.lastError().text() };
+
+    while (current < qint64(trixel_count))
+        trixel_begin[++current] = records.size();
+
+    for (quint32 trixel = 0; trixel < trixel_count; trixel++)
+    {
+        if (null_mag_begin[trixel] == null_string)
+            null_mag_begin[trixel] = trixel_begin[trixel + 1];
+    }
+
+    Header header;
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version               = snapshot_version;
+    header.byte_order            = byte_order_mark;
+    header.htmesh_level          = stamp.htmesh_level;
+    header.trixel_count          = trixel_count;
+    header.rows                  = stamp.rows;
+    header.trixel_sum            = stamp.trixel_sum;
+    header.db_size               = stamp.db_size;
+    header.db_modified           = stamp.db_modified;
+    header.object_count          = records.size();
+    header.trixel_begin_offset   = sizeof(Header);
+    header.null_mag_begin_offset = header.trixel_begin_offset + trixel_begin.size() * sizeof(quint32);
+    header.records_offset =
+        align(header.null_mag_begin_offset + null_mag_begin.size() * sizeof(quint32));
+    header.strings_offset = header.records_offset + records.size() * sizeof(Record);
+    header.strings_size   = strings.size();
+
+    QSaveFile file{ path };
+    if (!file.open(QIODevice::WriteOnly))
+        return { false, file.errorString() };
+
+    const QByteArray padding(int(header.records_offset - header.null_mag_begin_offset -
+                                 null_mag_begin.size() * sizeof(quint32)),
+                             '\0');
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(trixel_begin.data()),
+               trixel_begin.size() * sizeof(quint32));
+    file.write(reinterpret_cast<const char *>(null_mag_begin.data()),
+               null_mag_begin.size() * sizeof(quint32));
+    file.write(padding);
+    file.write(reinterpret_cast<const char *>(records.data()),
+               records.size() * sizeof(Record));
+    file.write(strings);
+
+    if (!file.commit())
+        return { false, file.errorString() };
+
+    return { true, "" };
+}
+
+MasterSnapshot::MasterSnapshot(const QString &path, const QString &db_file)
+    : m_file{ path }, m_db_file{ db_file }
+{
+}
+
+MasterSnapshot::~MasterSnapshot() = default;
+
+std::unique_ptr<MasterSnapshot> MasterSnapshot::open(const QString &path,
+                                                     const Stamp &stamp,
+                                                     const QString &db_file)
+{
+    std::unique_ptr<MasterSnapshot> snapshot{ new MasterSnapshot{ path, db_file } };
+    auto &file = snapshot->m_file;
+
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(Header)))
+        return nullptr;
+
+    const quint64 size = file.size();
+    const uchar *data  = file.map(0, size);
+    if (!data)
+        return nullptr;
+
+    const auto *header = reinterpret_cast<const Header *>(data);
+    if (std::memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0 ||
+        header->version != snapshot_version || header->byte_order != byte_order_mark)
+        return nullptr;
+
+    const Stamp file_stamp{ header->htmesh_level, header->rows, header->trixel_sum,
+                            header->db_size, header->db_modified };
+    if (!(file_stamp == stamp) || stamp.htmesh_level < 0 || stamp.htmesh_level > 12)
+        return nullptr;
+
+    const quint64 trixel_count = header->trixel_count;
+    const quint64 object_count = header->object_count;
+    if (trixel_count != trixel_count_for(stamp.htmesh_level) ||
+        object_count != quint64(stamp.rows) || header->records_offset % 8 != 0 ||
+        header->trixel_begin_offset + (trixel_count + 1) * sizeof(quint32) > size ||
+        header->null_mag_begin_offset + trixel_count * sizeof(quint32) > size ||
+        header->records_offset + object_count * sizeof(Record) > size ||
+        header->strings_offset + header->strings_size > size)
+        return nullptr;
+
+    const auto *trixel_begin =
+        reinterpret_cast<const quint32 *>(data + header->trixel_begin_offset);
+    const auto *null_mag_begin =
+        reinterpret_cast<const quint32 *>(data + header->null_mag_begin_offset);
+
+    // The ranges are trusted when slicing, so check them once here.
+    if (trixel_begin[0] != 0 || trixel_begin[trixel_count] != object_count)
+        return nullptr;
+
+    for (quint64 trixel = 0; trixel < trixel_count; trixel++)
+    {
+        if (trixel_begin[trixel] > null_mag_begin[trixel] ||
+            null_mag_begin[trixel] > trixel_begin[trixel + 1])
+            return nullptr;
+    }
+
+    snapshot->m_header         = header;
+    snapshot->m_trixel_begin   = trixel_begin;
+    snapshot->m_null_mag_begin = null_mag_begin;
+    snapshot->m_records = reinterpret_cast<const Record *>(data + header->records_offset);
+    snapshot->m_strings = reinterpret_cast<const char *>(data + header->strings_offset);
+
+    return snapshot;
+}
+
+std::vector<CatalogObject> MasterSnapshot::objects_in_trixel_no_nulls(const int trixel) const
+{
+    if (trixel < 0 || quint32(trixel) >= m_header->trixel_count)
+        return {};
+
+    return read_range(m_trixel_begin[trixel], m_null_mag_begin[trixel]);
+}
+
+std::vector<CatalogObject> MasterSnapshot::objects_in_trixel_null_mag(const int trixel) const
+{
+    if (trixel < 0 || quint32(trixel) >= m_header->trixel_count)
+        return {};
+
+    return read_range(m_null_mag_begin[trixel], m_trixel_begin[trixel + 1]);
+}
+
+std::size_t MasterSnapshot::size() const
+{
+    return m_header->object_count;
+}
+
+std::vector<CatalogObject> MasterSnapshot::read_range(const quint32 begin,
+                                                      const quint32 end) const
+{
+    std::vector<CatalogObject> objects;
+    objects.reserve(end - begin);
+
+    for (const Record *record = m_records + begin; record != m_records + end; ++record)
+    {
+        objects.emplace_back(read_bytes(record->oid),
+                             static_cast<SkyObject::TYPE>(record->type), dms(record->ra),
+                             dms(record->dec), record->magnitude,
+                             read_string(record->name), read_string(record->long_name),
+                             read_string(record->catalog_identifier), record->catalog,
+                             record->major_axis, record->minor_axis,
+                             record->position_angle, record->flux, m_db_file.get());
+    }
+
+    return objects;
+}
+
+std::pair<const char *, int> MasterSnapshot::read_data(const quint32 offset) const
+{
+    quint32 length = 0;
+    if (offset == null_string || offset + quint64(sizeof(length)) > m_header->strings_size)
+        return { nullptr, 0 };
+
+    std::memcpy(&length, m_strings + offset, sizeof(length));
+    if (offset + quint64(sizeof(length)) + length > m_header->strings_size)
+        return { nullptr, 0 };
+
+    return { m_strings + offset + sizeof(length), int(length) };
+}
+
+QByteArray MasterSnapshot::read_bytes(const quint32 offset) const
+{
+    const auto &data = read_data(offset);
+
+    // Copied, the objects may outlive the mapping.
+    return data.first ? QByteArray{ data.first, data.second } : QByteArray{};
+}
+
+QString MasterSnapshot::read_string(const quint32 offset) const
+{
+    const auto &data = read_data(offset);
+    return data.first ? QString::fromUtf8(data.first, data.second) : QString{};
+}
@@ -0,0 +1,138 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "catalogobject.h"
+
+class QSqlQuery;
+
+namespace CatalogsDB
+{
+/**
+ * A read only, memory mapped copy of the master catalog sorted by
+ * trixel.
+ *
+ * The objects of all trixels are stored in one flat array of fixed
+ * size records, with the strings in a separate pool, and an offset
+ * table gives the range of each trixel. Within a trixel the objects
+ * with a magnitude come first, sorted by ascending magnitude, followed
+ * by the objects without one.
+ *
+ * Loading the objects of a trixel is thus a slice of the mapping and
+ * needs no query to the database, which makes cache misses while
+ * drawing cheap. The snapshot is written by
+ * `DBManager::compile_master_catalog` and carries a `Stamp` of the
+ * master table it has been made from, so that stale files are detected
+ * and rebuilt by `DBManager::open_master_snapshot`.
+ */
+class MasterSnapshot
+{
+  public:
+    /**
+     * Identifies the content of the master table a snapshot has been
+     * made from.
+     *
+     * The row count and trixel sum miss edits that keep the rows in
+     * place, such as a changed magnitude or precedence, so the size and
+     * modification time of the database file are part of the stamp as
+     * well. Any write to the database thus makes the snapshot stale.
+     */
+    struct Stamp
+    {
+        qint32 htmesh_level = -1;
+        qint64 rows         = 0;
+        qint64 trixel_sum   = 0;
+        qint64 db_size      = 0;
+        qint64 db_modified  = 0; // msecs since epoch
+
+        bool operator==(const Stamp &other) const
+        {
+            return htmesh_level == other.htmesh_level && rows == other.rows &&
+                   trixel_sum == other.trixel_sum && db_size == other.db_size &&
+                   db_modified == other.db_modified;
+        }
+    };
+
+    /**
+     * \returns the path of the snapshot belonging to the database at
+     * \p db_file.
+     */
+    static QString path_for(const QString &db_file);
+
+    /**
+     * Writes a snapshot of the rows of the executed \p query to \p
+     * path, replacing the previous one atomically.
+     *
+     * The columns of \p query must be `SqlStatements::object_fields`
+     * followed by the trixel, and the rows must be ordered by trixel,
+     * with the objects without magnitude last and the others by
+     * ascending magnitude.
+     *
+     * \returns wether the snapshot could be written and an error
+     * message if not.
+     */
+    static std::pair<bool, QString> write(const QString &path, const Stamp &stamp,
+                                          QSqlQuery &query);
+
+    /**
+     * Maps the snapshot at \p path.
+     *
+     * \returns the snapshot, or `nullptr` if the file is missing,
+     * corrupted or was not made from the master table identified by \p
+     * stamp. The objects loaded from it refer to \p db_file, which must
+     * outlive them.
+     */
+    static std::unique_ptr<MasterSnapshot> open(const QString &path, const Stamp &stamp,
+                                                const QString &db_file);
+
+    ~MasterSnapshot();
+
+    /**
+     * \returns the objects in \p trixel which have a magnitude, sorted
+     * by ascending magnitude.
+     */
+    std::vector<CatalogObject> objects_in_trixel_no_nulls(const int trixel) const;
+
+    /**
+     * \returns the objects in \p trixel which have no magnitude.
+     */
+    std::vector<CatalogObject> objects_in_trixel_null_mag(const int trixel) const;
+
+    /**
+     * \returns the number of objects in the snapshot.
+     */
+    std::size_t size() const;
+
+  private:
+    struct Header;
+    struct Record;
+
+    MasterSnapshot(const QString &path, const QString &db_file);
+
+    std::vector<CatalogObject> read_range(const quint32 begin, const quint32 end) const;
+    std::pair<const char *, int> read_data(const quint32 offset) const;
+    QString read_string(const quint32 offset) const;
+    QByteArray read_bytes(const quint32 offset) const;
+
+    QFile m_file;
+    std::reference_wrapper<const QString> m_db_file;
+
+    const Header *m_header          = nullptr;
+    const quint32 *m_trixel_begin   = nullptr;
+    const quint32 *m_null_mag_begin = nullptr;
+    const Record *m_records         = nullptr;
+    const char *m_strings           = nullptr;
+};
+} // namespace CatalogsDB
@@ -335,6 +335,12 @@ const QString _dso_by_trixel_no_nulls = "SELECT %1 FROM master WHERE trixel = "
                                         " BY magnitude DESC";
 const QString dso_by_trixel_no_nulls = QString(_dso_by_trixel_no_nulls).arg(object_fields);
 
+// Ordered the way `MasterSnapshot::write` expects it, the trixel comes last
+const QString _master_snapshot = "SELECT %1, trixel FROM master ORDER BY trixel ASC, "
+                                 "magnitude IS NULL ASC, magnitude ASC";
+const QString master_snapshot  = QString(_master_snapshot).arg(object_fields);
+const QString master_snapshot_stamp = "SELECT COUNT(*), SUM(trixel) FROM master";
+
 const QString _dso_by_oid = "SELECT %1 FROM master WHERE oid = :id LIMIT 1";
 
 const QString dso_by_oid = QString(_dso_by_oid).arg(object_fields);
@@ -234,9 +234,9 @@ void FindDialog::filterByType()
         case 0: // All object types
         {
             QVector<QPair<QString, const SkyObject *>> allObjects;
-            foreach (int type, data->skyComposite()->objectLists().keys())
+            foreach (int type, data->skyComposite()->objectListTypes())
             {
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::TYPE(type)));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::TYPE(type)));
             }
             fModel->setSkyObjectsList(allObjects);
             break;
@@ -244,51 +244,51 @@ void FindDialog::filterByType()
         case 1: //Stars
         {
             QVector<QPair<QString, const SkyObject *>> starObjects;
-            starObjects.append(data->skyComposite()->objectLists(SkyObject::STAR));
-            starObjects.append(data->skyComposite()->objectLists(SkyObject::CATALOG_STAR));
+            starObjects.append(data->skyComposite()->objectList(SkyObject::STAR));
+            starObjects.append(data->skyComposite()->objectList(SkyObject::CATALOG_STAR));
             fModel->setSkyObjectsList(starObjects);
             break;
         }
         case 2: //Solar system
         {
             QVector<QPair<QString, const SkyObject *>> ssObjects;
-            ssObjects.append(data->skyComposite()->objectLists(SkyObject::PLANET));
-            ssObjects.append(data->skyComposite()->objectLists(SkyObject::COMET));
-            ssObjects.append(data->skyComposite()->objectLists(SkyObject::ASTEROID));
-            ssObjects.append(data->skyComposite()->objectLists(SkyObject::MOON));
+            ssObjects.append(data->skyComposite()->objectList(SkyObject::PLANET));
+            ssObjects.append(data->skyComposite()->objectList(SkyObject::COMET));
+            ssObjects.append(data->skyComposite()->objectList(SkyObject::ASTEROID));
+            ssObjects.append(data->skyComposite()->objectList(SkyObject::MOON));
 
             fModel->setSkyObjectsList(ssObjects);
             break;
         }
         case 3: //Open Clusters
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::OPEN_CLUSTER));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::OPEN_CLUSTER));
             break;
         case 4: //Globular Clusters
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::GLOBULAR_CLUSTER));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::GLOBULAR_CLUSTER));
             break;
         case 5: //Gaseous nebulae
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::GASEOUS_NEBULA));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::GASEOUS_NEBULA));
             break;
         case 6: //Planetary nebula
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::PLANETARY_NEBULA));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::PLANETARY_NEBULA));
             break;
         case 7: //Galaxies
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::GALAXY));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::GALAXY));
             break;
         case 8: //Comets
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::COMET));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::COMET));
             break;
         case 9: //Asteroids
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::ASTEROID));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::ASTEROID));
             break;
         case 10: //Constellations
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::CONSTELLATION));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::CONSTELLATION));
             break;
         case 11: //Supernovae
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::SUPERNOVA));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::SUPERNOVA));
             break;
         case 12: //Satellites
-            fModel->setSkyObjectsList(data->skyComposite()->objectLists(SkyObject::SATELLITE));
+            fModel->setSkyObjectsList(data->skyComposite()->objectList(SkyObject::SATELLITE));
             break;
     }
 }
@@ -485,6 +485,15 @@ CatalogObject *FindDialog::resolveAndAdd(CatalogsDB::DBManager &db_manager, cons
 
 void FindDialog::finishProcessing(SkyObject *selObj, bool resolve)
 {
+    SkyMapComposite *composite = KStarsData::Instance()->skyComposite();
+
+    // Names written with another spacing or punctuation than the listed one, like "m31" for "M 31"
+    if (!selObj)
+    {
+        const auto matches = composite->findByNameFuzzy(processSearchText(), 0, 1);
+        if (!matches.isEmpty())
+            selObj = const_cast<SkyObject *>(matches.first().object);
+    }
     if (!selObj && resolve)
     {
         selObj = resolveAndAdd(m_dbManager, processSearchText());
@@ -493,6 +502,16 @@ void FindDialog::finishProcessing(SkyObject *selObj, bool resolve)
     if (selObj == nullptr)
     {
         QString message = i18n("No object named %1 found.", ui->SearchBox->text());
+
+        QStringList suggestions;
+        for (const auto &match : composite->findByNameFuzzy(processSearchText(), 2, 5))
+        {
+            if (!suggestions.contains(match.name))
+                suggestions.append(match.name);
+        }
+        if (!suggestions.isEmpty())
+            message += '\n' + i18n("Did you mean: %1?", suggestions.join(i18nc("separator of a list of names", ", ")));
+
         KSNotification::sorry(message, i18n("Bad object name"));
     }
     else
@@ -127,7 +127,7 @@ void MountModel::generateAlignStarList()
 
     KStarsData *data = KStarsData::Instance();
     QVector<QPair<QString, const SkyObject *>> listStars;
-    listStars.append(data->skyComposite()->objectLists(SkyObject::STAR));
+    listStars.append(data->skyComposite()->objectList(SkyObject::STAR));
     for (int i = 0; i < listStars.size(); i++)
     {
         QPair<QString, const SkyObject *> pair = listStars.value(i);
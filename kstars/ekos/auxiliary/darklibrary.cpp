@@ -16,6 +16,7 @@
 #include "kstars.h"
 #include "kspaths.h"
 #include "kstarsdata.h"
+#include "ekos_debug.h"
 #include "fitsviewer/fitsdata.h"
 #include "fitsviewer/fitsview.h"
 
@@ -38,7 +39,9 @@ DarkLibrary *DarkLibrary::Instance()
     return _DarkLibrary;
 }
 
-DarkLibrary::DarkLibrary(QWidget *parent) : QDialog(parent)
+DarkLibrary::DarkLibrary(QWidget *parent) : QDialog(parent),
+    m_CachedDarkFrames(static_cast<uint64_t>(Options::darkLibraryCacheSize()) * 1024 * 1024,
+                       QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("darks/cache"))
 {
     setupUi(this);
 
@@ -53,6 +56,7 @@ DarkLibrary::DarkLibrary(QWidget *parent) : QDialog(parent)
 
     QDir writableDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
     writableDir.mkpath("darks");
+    writableDir.mkpath("darks/cache");
     writableDir.mkpath("defectmaps");
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -197,7 +201,8 @@ void DarkLibrary::refreshFromDB()
 ///////////////////////////////////////////////////////////////////////////////////////
 ///
 ///////////////////////////////////////////////////////////////////////////////////////
-bool DarkLibrary::findDarkFrame(ISD::CameraChip *m_TargetChip, double duration, QSharedPointer<FITSData> &darkData)
+bool DarkLibrary::findDarkFrame(ISD::CameraChip *m_TargetChip, double duration, QSharedPointer<FITSData> &darkData,
+                                MasterFrameCache::Pin *pin)
 {
     QVariantMap bestCandidate;
     for (auto &map : m_DarkFramesDatabaseList)
@@ -306,21 +311,24 @@ bool DarkLibrary::findDarkFrame(ISD::CameraChip *m_TargetChip, double duration,
         return false;
     }
 
-    if (m_CachedDarkFrames.contains(filename))
-    {
-        darkData = m_CachedDarkFrames[filename];
+    darkData = m_CachedDarkFrames.find(filename, pin);
+    if (darkData)
         return true;
-    }
 
-    // Before adding to cache, clear the cache if memory drops too low.
+    // Before adding to cache, evict all masters not in use if memory drops too low.
     auto memoryMB = KSUtils::getAvailableRAM() / 1e6;
     if (memoryMB < CACHE_MEMORY_LIMIT)
-        m_CachedDarkFrames.clear();
+        m_CachedDarkFrames.trim(0);
+    m_CachedDarkFrames.setMaxBytes(static_cast<uint64_t>(Options::darkLibraryCacheSize()) * 1024 * 1024);
 
-    // Finally we made it, let's put it in the hash
-    if (cacheDarkFrameFromFile(filename))
+    // Finally we made it, let's load it from its compact cache file or from the FITS file
+    darkData = m_CachedDarkFrames.load(filename, pin);
+    if (darkData)
     {
-        darkData = m_CachedDarkFrames[filename];
+        const auto stats = m_CachedDarkFrames.statistics();
+        qCDebug(KSTARS_EKOS) << "Dark frame cache:" << stats.frames << "frames," << stats.bytes / (1024 * 1024)
+                             << "MB. Hits:" << stats.hits << "Misses:" << stats.misses << "Evictions:" << stats.evictions
+                             << "Compact loads:" << stats.compactLoads;
         return true;
     }
 
@@ -457,7 +465,7 @@ bool DarkLibrary::cacheDarkFrameFromFile(const QString &filename)
     rc.waitForFinished();
     if (rc.result())
     {
-        m_CachedDarkFrames[filename] = data;
+        m_CachedDarkFrames.insert(filename, data);
     }
     else
     {
@@ -503,9 +511,11 @@ void DarkLibrary::processNewImage(SequenceJob *job, const QSharedPointer<FITSDat
             metadata["iso"] = isoValue;
 
         metadata["count"] = job->getCoreProperty(SequenceJob::SJ_Count).toInt();
-        generateMasterFrame(m_CurrentDarkFrame, metadata);
-        reloadDarksFromDatabase();
-        populateMasterMetedata();
+        if (generateMasterFrame(m_CurrentDarkFrame, metadata))
+        {
+            reloadDarksFromDatabase();
+            populateMasterMetedata();
+        }
     }
 }
 
@@ -532,8 +542,11 @@ void DarkLibrary::updateProperty(INDI::Property prop)
     }
 
     uint32_t totalElements = m_CurrentDarkFrame->channels() * m_CurrentDarkFrame->samplesPerChannel();
-    if (totalElements != m_DarkMasterBuffer.size())
-        m_DarkMasterBuffer.assign(totalElements, 0);
+    if (m_MasterIntegrator.frames() == 0 || totalElements != m_MasterIntegrator.samples())
+        m_MasterIntegrator.start(totalElements,
+                                 static_cast<MasterFrameIntegrator::Algorithm>(std::max(0, combinAlgorithmCombo->currentIndex())),
+                                 Options::darkLibraryClipSigma(), Options::darkLibraryIntegrationMemory(),
+                                 QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("darks"));
 
     aggregate(m_CurrentDarkFrame);
     darkProgress->setValue(darkProgress->value() + 1);
@@ -617,6 +630,7 @@ void DarkLibrary::clearExpired()
     for (int i = 0; i < darkframe.rowCount(); ++i)
     {
         QString oneFile = darkframe.record(i).value("filename").toString();
+        m_CachedDarkFrames.remove(oneFile);
         QFile::remove(oneFile);
         QString defectMap = darkframe.record(i).value("defectmap").toString();
         if (defectMap.isEmpty() == false)
@@ -669,6 +683,7 @@ void DarkLibrary::clearAll()
     for (int i = 0; i < darkframe.rowCount(); ++i)
     {
         QString oneFile = darkframe.record(i).value("filename").toString();
+        m_CachedDarkFrames.remove(oneFile);
         QFile::remove(oneFile);
         QString defectMap = darkframe.record(i).value("defectmap").toString();
         if (defectMap.isEmpty() == false)
@@ -697,6 +712,7 @@ void DarkLibrary::clearRow(int index)
     QSqlRecord record = darkFramesModel->record(index);
     QString filename = record.value("filename").toString();
     QString defectMap = record.value("defectmap").toString();
+    m_CachedDarkFrames.remove(filename);
     QFile::remove(filename);
     if (!defectMap.isEmpty())
         QFile::remove(defectMap);
@@ -1199,6 +1215,7 @@ void DarkLibrary::generateDarkJobs()
 void DarkLibrary::execute()
 {
     m_DarkImagesCounter = 0;
+    m_MasterIntegrator.clear();
     darkProgress->setValue(0);
     darkProgress->setTextVisible(true);
     connect(m_CaptureModule, &Capture::newImage, this, &DarkLibrary::processNewImage, Qt::UniqueConnection);
@@ -1294,70 +1311,75 @@ template <typename T>
 void DarkLibrary::aggregateInternal(const QSharedPointer<FITSData> &data)
 {
     T const *darkBuffer  = reinterpret_cast<T const*>(data->getImageBuffer());
-    for (uint32_t i = 0; i < m_DarkMasterBuffer.size(); i++)
-        m_DarkMasterBuffer[i] += darkBuffer[i];
+    if (!m_MasterIntegrator.addFrame(darkBuffer))
+        m_FileLabel->setText(i18n("Failed to aggregate dark data: %1", m_MasterIntegrator.getLastError()));
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
 ///
 ///////////////////////////////////////////////////////////////////////////////////////
-void DarkLibrary::generateMasterFrame(const QSharedPointer<FITSData> &data, const QJsonObject &metadata)
+bool DarkLibrary::generateMasterFrame(const QSharedPointer<FITSData> &data, const QJsonObject &metadata)
 {
+    bool generated = false;
     switch (data->dataType())
     {
         case TBYTE:
-            generateMasterFrameInternal<uint8_t>(data, metadata);
+            generated = generateMasterFrameInternal<uint8_t>(data, metadata);
             break;
 
         case TSHORT:
-            generateMasterFrameInternal<int16_t>(data, metadata);
+            generated = generateMasterFrameInternal<int16_t>(data, metadata);
             break;
 
         case TUSHORT:
-            generateMasterFrameInternal<uint16_t>(data, metadata);
+            generated = generateMasterFrameInternal<uint16_t>(data, metadata);
             break;
 
         case TLONG:
-            generateMasterFrameInternal<int32_t>(data, metadata);
+            generated = generateMasterFrameInternal<int32_t>(data, metadata);
             break;
 
         case TULONG:
-            generateMasterFrameInternal<uint32_t>(data, metadata);
+            generated = generateMasterFrameInternal<uint32_t>(data, metadata);
             break;
 
         case TFLOAT:
-            generateMasterFrameInternal<float>(data, metadata);
+            generated = generateMasterFrameInternal<float>(data, metadata);
             break;
 
         case TLONGLONG:
-            generateMasterFrameInternal<int64_t>(data, metadata);
+            generated = generateMasterFrameInternal<int64_t>(data, metadata);
             break;
 
         case TDOUBLE:
-            generateMasterFrameInternal<double>(data, metadata);
+            generated = generateMasterFrameInternal<double>(data, metadata);
             break;
 
         default:
             break;
     }
 
-    emit newImage(data);
-    // Reset Master Buffer
-    m_DarkMasterBuffer.assign(m_DarkMasterBuffer.size(), 0);
+    // Reset Master Integration
+    m_MasterIntegrator.clear();
 
+    if (generated)
+        emit newImage(data);
+    return generated;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
 ///
 ///////////////////////////////////////////////////////////////////////////////////////
-template <typename T>  void DarkLibrary::generateMasterFrameInternal(const QSharedPointer<FITSData> &data,
+template <typename T>  bool DarkLibrary::generateMasterFrameInternal(const QSharedPointer<FITSData> &data,
         const QJsonObject &metadata)
 {
     T *writableBuffer = reinterpret_cast<T *>(data->getWritableImageBuffer());
-    const uint32_t count = metadata["count"].toInt();
-    // Average the values
-    for (uint32_t i = 0; i < m_DarkMasterBuffer.size(); i++)
-        writableBuffer[i] = m_DarkMasterBuffer[i] / count;
+    // Integrate the frames as per the selected algorithm
+    if (!m_MasterIntegrator.integrate(writableBuffer))
+    {
+        m_FileLabel->setText(i18n("Failed to integrate master frame: %1", m_MasterIntegrator.getLastError()));
+        return false;
+    }
 
     QString ts = QDateTime::currentDateTime().toString("yyyy-MM-ddThh-mm-ss");
     QString path = QDir(KSPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("darks/darkframe_" + ts +
@@ -1367,7 +1389,7 @@ template <typename T>  void DarkLibrary::generateMasterFrameInternal(const QShar
     if (!data->saveImage(path))
     {
         m_FileLabel->setText(i18n("Failed to save master frame: %1", data->getLastError()));
-        return;
+        return false;
     }
 
     auto memoryMB = KSUtils::getAvailableRAM() / 1e6;
@@ -1389,6 +1411,7 @@ template <typename T>  void DarkLibrary::generateMasterFrameInternal(const QShar
     m_DarkFramesDatabaseList.append(map);
     m_FileLabel->setText(i18n("Master Dark saved to %1", path));
     KStarsData::Instance()->userdb()->AddDarkFrame(map);
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
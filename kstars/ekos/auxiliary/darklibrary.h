@@ -10,6 +10,8 @@
 #include "indi/indidustcap.h"
 #include "darkview.h"
 #include "defectmap.h"
+#include "masterframecache.h"
+#include "masterframeintegrator.h"
 #include "ekos/ekos.h"
 
 #include <QDialog>
@@ -35,6 +37,7 @@ class SequenceJob;
  *
  * The user can generate dark frames from an average combination of the camera dark frames. By default, 5 dark frames
  * are captured to merged into a single master frame. Frame duration, binning, and temperature are all configurable.
+ * Outliers, such as cosmic rays, can be rejected by sigma clipping the frames, see /class MasterFrameIntegrator.
  * If the user select "Dark" in any of the Ekos module, Dark Library can be queried if a suitable dark frame exists given
  * the current camera settings (binning, temperature..etc). If a suitable frame exists, it is loaded up and send to /class DarkProcessor
  * class along with the light frame to perform subtraction or defect map corrections.
@@ -61,9 +64,12 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
          * @param targetChip Camera chip pointer to lookup for relevant information (binning, ROI..etc).
          * @param duration Duration is second to match it against the database.
          * @param darkData If a frame is found, load it from disk and store it in a shared FITSData pointer.
+         * @param pin If not null and a frame is found, set to a pin keeping the frame in the cache while it is in use.
+         * The frame is pinned as it is found, before any other thread may evict it.
          * @return True if a suitable frame was found the loaded successfully, false otherwise.
          */
-        bool findDarkFrame(ISD::CameraChip *targetChip, double duration, QSharedPointer<FITSData> &darkData);
+        bool findDarkFrame(ISD::CameraChip *targetChip, double duration, QSharedPointer<FITSData> &darkData,
+                           MasterFrameCache::Pin *pin = nullptr);
 
         /**
          * @brief findDefectMap Search for a defect map that matches the passed paramters.
@@ -169,8 +175,9 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
          * @brief generateMasterFrameHelper Calls templated generateMasterFrame with the correct data type.
          * @param data Passed dark frame data to generateMasterFrame
          * @param metadata passed metadata to generateMasterFrame
+         * @return true if the master frame was integrated and saved.
          */
-        void generateMasterFrame(const QSharedPointer<FITSData> &data, const QJsonObject &metadata);
+        bool generateMasterFrame(const QSharedPointer<FITSData> &data, const QJsonObject &metadata);
 
         /**
          * @brief generateMasterFrame After data aggregation is done, the selected stacking algorithm is applied and the master dark
@@ -178,8 +185,9 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
          * @param data last used data. This is not used for reading, but to simply apply the algorithm to the FITSData buffer
          * and then save it to disk.
          * @param metadata information on frame to help in the stacking process.
+         * @return false if the frames could not be integrated or the master frame could not be saved.
          */
-        template <typename T>  void generateMasterFrameInternal(const QSharedPointer<FITSData> &data, const QJsonObject &metadata);
+        template <typename T>  bool generateMasterFrameInternal(const QSharedPointer<FITSData> &data, const QJsonObject &metadata);
 
         /**
          * @brief aggregateHelper Calls tempelated aggregate function with the appropiate data type.
@@ -189,7 +197,7 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
 
         /**
          * @brief aggregate Aggregate the data as per the selected algorithm. Each time a new dark frame is received, this function
-         * adds the frame data to the dark buffer.
+         * adds the frame data to the master frame integration.
          * @param data Dark frame data.
          */
         template <typename T> void aggregateInternal(const QSharedPointer<FITSData> &data);
@@ -273,7 +281,8 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
         ////////////////////////////////////////////////////////////////////////////////////////////////
 
         QList<QVariantMap> m_DarkFramesDatabaseList;
-        QMap<QString, QSharedPointer<FITSData>> m_CachedDarkFrames;
+        // Master dark frames, bounded by DarkLibraryCacheSize and spilled to compact files in darks/cache
+        MasterFrameCache m_CachedDarkFrames;
         QMap<QString, QSharedPointer<DefectMap>> m_CachedDefectMaps;
 
         ISD::Camera *m_Camera {nullptr};
@@ -285,7 +294,7 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
         QSqlTableModel *darkFramesModel = nullptr;
         QSortFilterProxyModel *sortFilter = nullptr;
 
-        std::vector<uint32_t> m_DarkMasterBuffer;
+        MasterFrameIntegrator m_MasterIntegrator;
         uint32_t m_DarkImagesCounter {0};
         bool m_RememberFITSViewer {true};
         bool m_RememberSummaryView {true};
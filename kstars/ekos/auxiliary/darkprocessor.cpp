@@ -7,14 +7,52 @@
 #include "darkprocessor.h"
 #include "darklibrary.h"
 #include "ekos/auxiliary/opticaltrainsettings.h"
+#include "auxiliary/parallelbands.h"
 
 #include <array>
+#include <limits>
+#include <type_traits>
+
+#include <QtConcurrent>
 
 #include "ekos_debug.h"
 
 namespace Ekos
 {
 
+namespace
+{
+// Subtract dark from light, saturating at zero, and for signed types at the type maximum.
+// The loops are kept free of branches other than selections so that the compiler vectorizes them.
+template <typename T>
+void subtractRow(T *light, T const *dark, uint32_t width)
+{
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const T difference = light[x] - dark[x];
+            light[x] = difference > 0 ? difference : 0;
+        }
+    }
+    else if constexpr (std::is_unsigned<T>::value)
+    {
+        for (uint32_t x = 0; x < width; x++)
+            light[x] = light[x] > dark[x] ? light[x] - dark[x] : 0;
+    }
+    else
+    {
+        // Subtracting a negative dark value may overflow
+        constexpr T maximum = std::numeric_limits<T>::max();
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const T l = light[x], d = dark[x];
+            light[x] = l > d ? ((d < 0 && l > maximum + d) ? maximum : static_cast<T>(l - d)) : 0;
+        }
+    }
+}
+}
+
 DarkProcessor::DarkProcessor(QObject *parent) : QObject(parent)
 {
     connect(&m_Watcher, &QFutureWatcher<bool>::finished, this, [this]()
@@ -80,37 +118,11 @@ void DarkProcessor::normalizeDefectsInternal(const QSharedPointer<DefectMap> &de
     T *lightBuffer = reinterpret_cast<T *>(lightData->getWritableImageBuffer());
     const uint32_t width = lightData->width();
 
-    // Account for offset X and Y
-    // e.g. if we send a subframed light frame 100x100 pixels wide
-    // but the source defect map covers 1000x1000 pixels array, then we need to only compensate
-    // for the 100x100 region.
-    for (BadPixelSet::const_iterator onePixel = defectMap->hotThreshold();
-            onePixel != defectMap->hotPixels().cend(); ++onePixel)
-    {
-        const uint16_t x = (*onePixel).x;
-        const uint16_t y = (*onePixel).y;
-
-        if (x <= offsetX || y <= offsetY)
-            continue;
-
-        uint32_t offset = (x - offsetX) + (y - offsetY) * width;
-
-        lightBuffer[offset] = median3x3Filter(x - offsetX, y - offsetY, width, lightBuffer);
-    }
-
-    for (BadPixelSet::const_iterator onePixel = defectMap->coldPixels().cbegin();
-            onePixel != defectMap->coldThreshold(); ++onePixel)
-    {
-        const uint16_t x = (*onePixel).x;
-        const uint16_t y = (*onePixel).y;
-
-        if (x <= offsetX || y <= offsetY)
-            continue;
-
-        uint32_t offset = (x - offsetX) + (y - offsetY) * width;
-
-        lightBuffer[offset] = median3x3Filter(x - offsetX, y - offsetY, width, lightBuffer);
-    }
+    // The defect map keeps the buffer indexes of its defects in the last frame geometry.
+    // The defects are filtered in order as a filtered defect may be the neighbor of the next one.
+    const auto indexes = defectMap->defectIndexes(width, lightData->height(), offsetX, offsetY);
+    for (const uint32_t offset : *indexes)
+        lightBuffer[offset] = median3x3Filter(offset, width, lightBuffer);
 
     lightData->calculateStats(true);
 
@@ -120,11 +132,11 @@ void DarkProcessor::normalizeDefectsInternal(const QSharedPointer<DefectMap> &de
 ///
 ///////////////////////////////////////////////////////////////////////////////////////
 template <typename T>
-T DarkProcessor::median3x3Filter(uint16_t x, uint16_t y, uint32_t width, T *buffer)
+T DarkProcessor::median3x3Filter(uint32_t offset, uint32_t width, T *buffer)
 {
-    T *top = buffer + (y - 1) * width + (x - 1);
-    T *mid = buffer + (y - 0) * width + (x - 1);
-    T *bot = buffer + (y + 1) * width + (x - 1);
+    T *top = buffer + offset - width - 1;
+    T *mid = buffer + offset - 1;
+    T *bot = buffer + offset + width - 1;
 
     std::array<T, 8> elements;
 
@@ -141,8 +153,9 @@ T DarkProcessor::median3x3Filter(uint16_t x, uint16_t y, uint32_t width, T *buff
     elements[6] = *(bot + 1);
     elements[7] = *(bot + 2);
 
-    std::sort(elements.begin(), elements.end());
-    auto median = (elements[3] + elements[4]) / 2;
+    // The median is the mean of the 4th and 5th elements once sorted
+    std::nth_element(elements.begin(), elements.begin() + 4, elements.end());
+    auto median = (*std::max_element(elements.begin(), elements.begin() + 4) + elements[4]) / 2;
     return median;
 }
 
@@ -206,14 +219,11 @@ void DarkProcessor::subtractInternal(const QSharedPointer<FITSData> &darkData, c
     const uint32_t darkoffset = offsetX + offsetY * darkStride;
     T const *darkBuffer  = reinterpret_cast<T const*>(darkData->getImageBuffer()) + darkoffset;
 
-    for (uint32_t y = 0; y < height; y++)
+    forEachBand(height, width, [&](uint32_t first, uint32_t last)
     {
-        for (uint32_t x = 0; x < width; x++)
-            lightBuffer[x] = (lightBuffer[x] > darkBuffer[x]) ? (lightBuffer[x] - darkBuffer[x]) : 0;
-
-        lightBuffer += width;
-        darkBuffer += darkStride;
-    }
+        for (uint32_t y = first; y < last; y++)
+            subtractRow(lightBuffer + static_cast<size_t>(y) * width, darkBuffer + static_cast<size_t>(y) * darkStride, width);
+    });
 
     lightData->calculateStats(true);
 }
@@ -258,7 +268,8 @@ bool DarkProcessor::denoiseInternal(bool useDefect)
 
     // Check if we have valid dark data and then use it.
     QSharedPointer<FITSData> darkData;
-    if (DarkLibrary::Instance()->findDarkFrame(info.targetChip, info.duration, darkData))
+    MasterFrameCache::Pin darkFramePin;
+    if (DarkLibrary::Instance()->findDarkFrame(info.targetChip, info.duration, darkData, &darkFramePin))
     {
         // Make sure it's the same dimension if there is no offset
         if (info.offsetX == 0 && info.offsetY == 0 &&
@@ -268,6 +279,7 @@ bool DarkProcessor::denoiseInternal(bool useDefect)
             emit newLog(i18n("No suitable dark frames or defect maps found. Please run the Dark Library wizard in Capture module."));
             return false;
         }
+        m_DarkFramePin = darkFramePin;
         subtractDarkData(darkData, info.targetData, info.offsetX, info.offsetY);
         qCDebug(KSTARS_EKOS) << "Dark frame subtraction applied";
         return true;
@@ -10,6 +10,7 @@
 #include "indi/indidustcap.h"
 #include "darkview.h"
 #include "defectmap.h"
+#include "masterframecache.h"
 #include "ekos/ekos.h"
 
 #include <QFutureWatcher>
@@ -95,7 +96,7 @@ class DarkProcessor : public QObject
                                       uint16_t offsetX, uint16_t offsetY);
 
         template <typename T>
-        T median3x3Filter(uint16_t x, uint16_t y, uint32_t width, T *buffer);
+        T median3x3Filter(uint32_t offset, uint32_t width, T *buffer);
 
     signals:
         void darkFrameCompleted(bool);
@@ -103,6 +104,8 @@ class DarkProcessor : public QObject
 
     private:
         QFutureWatcher<bool> m_Watcher;
+        // Keeps the last dark frame subtracted in the dark library cache
+        MasterFrameCache::Pin m_DarkFramePin;
         struct
         {
             int trainID;
@@ -6,6 +6,7 @@
 
 #include "defectmap.h"
 #include <QJsonDocument>
+#include <QMutexLocker>
 
 //////////////////////////////////////////////////////////////////////////////
 ///
@@ -74,6 +75,7 @@ bool DefectMap::load(const QString &filename)
     }
 
     m_ColdPixelsCount = m_ColdPixels.size();
+    clearDefectIndexes();
     return true;
 }
 
@@ -264,6 +266,7 @@ void DefectMap::filterPixels()
     else
         m_ColdPixelsCount = std::distance(m_ColdPixels.cbegin(), m_ColdPixelsThreshold);
 
+    clearDefectIndexes();
     emit pixelsUpdated(m_HotPixelsCount, m_ColdPixelsCount);
 }
 
@@ -273,6 +276,7 @@ void DefectMap::filterPixels()
 void DefectMap::setHotEnabled(bool enabled)
 {
     m_HotEnabled = enabled;
+    clearDefectIndexes();
     emit pixelsUpdated(m_HotEnabled ? m_HotPixelsCount : 0, m_ColdPixelsCount);
 }
 
@@ -282,5 +286,60 @@ void DefectMap::setHotEnabled(bool enabled)
 void DefectMap::setColdEnabled(bool enabled)
 {
     m_ColdEnabled = enabled;
+    clearDefectIndexes();
     emit pixelsUpdated(m_HotPixelsCount, m_ColdEnabled ? m_ColdPixelsCount : 0);
 }
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+QSharedPointer<const std::vector<uint32_t>> DefectMap::defectIndexes(uint32_t width, uint32_t height, uint16_t offsetX,
+        uint16_t offsetY)
+{
+    QMutexLocker locker(&m_DefectIndexesMutex);
+
+    if (m_DefectIndexes && width == m_DefectIndexesWidth && height == m_DefectIndexesHeight &&
+            offsetX == m_DefectIndexesOffsetX && offsetY == m_DefectIndexesOffsetY)
+        return m_DefectIndexes;
+
+    auto indexes = QSharedPointer<std::vector<uint32_t>>::create();
+    indexes->reserve((m_HotEnabled ? m_HotPixelsCount : 0) + (m_ColdEnabled ? m_ColdPixelsCount : 0));
+
+    // Account for offset X and Y
+    // e.g. if we send a subframed light frame 100x100 pixels wide
+    // but the source defect map covers 1000x1000 pixels array, then we need to only compensate
+    // for the 100x100 region.
+    auto add = [&](const BadPixel & onePixel)
+    {
+        if (onePixel.x <= offsetX || onePixel.y <= offsetY)
+            return;
+
+        const uint32_t x = onePixel.x - offsetX;
+        const uint32_t y = onePixel.y - offsetY;
+        if (x + 1 >= width || y + 1 >= height)
+            return;
+
+        indexes->push_back(x + y * width);
+    };
+
+    for (auto onePixel = hotThreshold(); onePixel != m_HotPixels.cend(); ++onePixel)
+        add(*onePixel);
+    for (auto onePixel = m_ColdPixels.cbegin(); onePixel != coldThreshold(); ++onePixel)
+        add(*onePixel);
+
+    m_DefectIndexes = indexes;
+    m_DefectIndexesWidth = width;
+    m_DefectIndexesHeight = height;
+    m_DefectIndexesOffsetX = offsetX;
+    m_DefectIndexesOffsetY = offsetY;
+    return m_DefectIndexes;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+void DefectMap::clearDefectIndexes()
+{
+    QMutexLocker locker(&m_DefectIndexesMutex);
+    m_DefectIndexes.clear();
+}
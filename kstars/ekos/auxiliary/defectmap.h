@@ -7,8 +7,10 @@
 #pragma once
 
 #include <set>
+#include <vector>
 #include <QJsonObject>
 #include <QJsonArray>
+#include <QMutex>
 
 #include "fitsviewer/fitsdata.h"
 
@@ -91,6 +93,14 @@ class DefectMap : public QObject
         }
 
         void filterPixels();
+
+        /**
+         * @brief defectIndexes Get the buffer indexes of the enabled hot pixels, then cold pixels, in a width x height frame
+         * whose origin is at offsetX, offsetY of the defect map. Pixels without all their 3x3 neighbors in the frame are left out.
+         * The indexes are kept until the defects or the frame change.
+         */
+        QSharedPointer<const std::vector<uint32_t>> defectIndexes(uint32_t width, uint32_t height, uint16_t offsetX,
+                uint16_t offsetY);
     signals:
         //        void hotPixelsUpdated(const BadPixelSet::const_iterator &start, const BadPixelSet::const_iterator &end);
         //        void coldPixelsUpdated(const BadPixelSet::const_iterator &start, const BadPixelSet::const_iterator &end);
@@ -102,6 +112,7 @@ class DefectMap : public QObject
         double calculateSigma(uint8_t aggressiveness);
         template <typename T>
         void initBadPixelsInternal(double hotPixelThreshold, double coldPixelThreshold);
+        void clearDefectIndexes();
 
         BadPixelSet m_ColdPixels, m_HotPixels;
         BadPixelSet::const_iterator m_ColdPixelsThreshold, m_HotPixelsThreshold;
@@ -114,5 +125,11 @@ class DefectMap : public QObject
 
         QSharedPointer<FITSData> m_DarkData;
 
+        // Defect indexes of the last frame
+        QMutex m_DefectIndexesMutex;
+        QSharedPointer<const std::vector<uint32_t>> m_DefectIndexes;
+        uint32_t m_DefectIndexesWidth {0}, m_DefectIndexesHeight {0};
+        uint16_t m_DefectIndexesOffsetX {0}, m_DefectIndexesOffsetY {0};
+
 };
 
@@ -0,0 +1,340 @@
+/*
+    SPDX-FileCopyrightText: 2023
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "masterframecache.h"
+#include "fitsviewer/fitsdata.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "ekos_debug.h"
+
+namespace Ekos
+{
+
+namespace
+{
+// Header of the compact files, followed by the image buffer at dataOffset
+struct CompactHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t dataOffset;
+    // Size and modification time of the FITS file the compact file was made from
+    int64_t sourceSize;
+    int64_t sourceModified;
+    uint64_t imageBytes;
+    FITSImage::Statistic statistics;
+};
+
+constexpr char COMPACT_MAGIC[8] = { 'K', 'S', 'M', 'A', 'S', 'T', 'E', 'R' };
+constexpr uint32_t COMPACT_VERSION = 1;
+// The image buffer is aligned for any data type
+constexpr uint32_t COMPACT_DATA_OFFSET = (sizeof(CompactHeader) + 63) / 64 * 64;
+
+// Returns true if the header is that of a compact file made from the current source file
+bool isCurrent(const CompactHeader &header, const QString &source, qint64 compactSize)
+{
+    const QFileInfo sourceInfo(source);
+    return std::memcmp(header.magic, COMPACT_MAGIC, sizeof(COMPACT_MAGIC)) == 0 && header.version == COMPACT_VERSION &&
+           header.dataOffset == COMPACT_DATA_OFFSET && sourceInfo.exists() && header.sourceSize == sourceInfo.size() &&
+           header.sourceModified == sourceInfo.lastModified().toMSecsSinceEpoch() &&
+           static_cast<uint64_t>(compactSize) == header.dataOffset + header.imageBytes;
+}
+}
+
+MasterFrameCache::MasterFrameCache(uint64_t maxBytes, const QString &compactDirectory) : m_MaxBytes(maxBytes),
+    m_CompactDirectory(compactDirectory)
+{
+}
+
+void MasterFrameCache::setMaxBytes(uint64_t maxBytes)
+{
+    QList<QPair<QString, QSharedPointer<FITSData>>> evicted;
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_MaxBytes = maxBytes;
+        evicted = evict(m_MaxBytes, QString());
+    }
+    spill(evicted);
+}
+
+QSharedPointer<FITSData> MasterFrameCache::find(const QString &filename, Pin *pin)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    auto entry = m_Entries.find(filename);
+    if (entry == m_Entries.end())
+    {
+        m_Statistics.misses++;
+        return QSharedPointer<FITSData>();
+    }
+
+    m_Statistics.hits++;
+    entry->lastUse = ++m_UseCounter;
+    if (pin)
+        *pin = pinEntry(*entry);
+    return entry->data;
+}
+
+QSharedPointer<FITSData> MasterFrameCache::load(const QString &filename, Pin *pin)
+{
+    auto data = find(filename, pin);
+    if (data)
+        return data;
+
+    data = readCompact(filename);
+    if (data)
+    {
+        QMutexLocker locker(&m_Mutex);
+        m_Statistics.compactLoads++;
+    }
+    else
+    {
+        data.reset(new FITSData(FITS_CALIBRATE), &QObject::deleteLater);
+        QFuture<bool> rc = data->loadFromFile(filename);
+        rc.waitForFinished();
+        if (!rc.result())
+            return QSharedPointer<FITSData>();
+    }
+
+    insert(filename, data, pin);
+    return data;
+}
+
+void MasterFrameCache::insert(const QString &filename, const QSharedPointer<FITSData> &data, Pin *pin)
+{
+    QList<QPair<QString, QSharedPointer<FITSData>>> evicted;
+    {
+        QMutexLocker locker(&m_Mutex);
+
+        auto &entry = m_Entries[filename];
+        m_Bytes -= entry.bytes;
+        entry.data = data;
+        entry.bytes = imageBytes(data);
+        entry.lastUse = ++m_UseCounter;
+        entry.pins.clear();
+        m_Bytes += entry.bytes;
+        if (pin)
+            *pin = pinEntry(entry);
+
+        // The new master is kept even if it alone exceeds the limit
+        evicted = evict(m_MaxBytes, filename);
+    }
+    spill(evicted);
+}
+
+void MasterFrameCache::remove(const QString &filename)
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        auto entry = m_Entries.find(filename);
+        if (entry != m_Entries.end())
+        {
+            m_Bytes -= entry->bytes;
+            m_Entries.erase(entry);
+        }
+    }
+
+    if (!m_CompactDirectory.isEmpty())
+        QFile::remove(compactFilename(filename));
+}
+
+void MasterFrameCache::trim(uint64_t maxBytes)
+{
+    QList<QPair<QString, QSharedPointer<FITSData>>> evicted;
+    {
+        QMutexLocker locker(&m_Mutex);
+        evicted = evict(maxBytes, QString());
+    }
+    spill(evicted);
+}
+
+MasterFrameCache::Pin MasterFrameCache::pin(const QSharedPointer<FITSData> &data)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    for (auto &entry : m_Entries)
+    {
+        if (entry.data == data)
+            return pinEntry(entry);
+    }
+
+    return Pin();
+}
+
+MasterFrameCache::Pin MasterFrameCache::pinEntry(Entry &entry)
+{
+    Pin token(new PinToken());
+    entry.pins.erase(std::remove_if(entry.pins.begin(), entry.pins.end(), [](const QWeakPointer<PinToken> &onePin)
+    {
+        return onePin.isNull();
+    }), entry.pins.end());
+    entry.pins.append(token.toWeakRef());
+    return token;
+}
+
+MasterFrameCache::Statistics MasterFrameCache::statistics() const
+{
+    QMutexLocker locker(&m_Mutex);
+
+    Statistics statistics = m_Statistics;
+    statistics.frames = m_Entries.size();
+    statistics.bytes = m_Bytes;
+    for (const auto &entry : m_Entries)
+    {
+        if (isPinned(entry))
+            statistics.pinned++;
+    }
+    return statistics;
+}
+
+uint64_t MasterFrameCache::imageBytes(const QSharedPointer<FITSData> &data)
+{
+    const auto &stats = data->getStatistics();
+    return static_cast<uint64_t>(stats.samples_per_channel) * stats.channels * stats.bytesPerPixel;
+}
+
+bool MasterFrameCache::isPinned(const Entry &entry)
+{
+    return std::any_of(entry.pins.cbegin(), entry.pins.cend(), [](const QWeakPointer<PinToken> &onePin)
+    {
+        return !onePin.isNull();
+    });
+}
+
+QList<QPair<QString, QSharedPointer<FITSData>>> MasterFrameCache::evict(uint64_t maxBytes, const QString &keep)
+{
+    QList<QPair<QString, QSharedPointer<FITSData>>> evicted;
+
+    while (m_Bytes > maxBytes)
+    {
+        auto oldest = m_Entries.end();
+        for (auto entry = m_Entries.begin(); entry != m_Entries.end(); ++entry)
+        {
+            if (entry.key() == keep || isPinned(entry.value()))
+                continue;
+            if (oldest == m_Entries.end() || entry->lastUse < oldest->lastUse)
+                oldest = entry;
+        }
+
+        if (oldest == m_Entries.end())
+            break;
+
+        m_Bytes -= oldest->bytes;
+        m_Statistics.evictions++;
+        evicted.append(qMakePair(oldest.key(), oldest->data));
+        m_Entries.erase(oldest);
+    }
+
+    if (!evicted.isEmpty())
+        qCDebug(KSTARS_EKOS) << "Evicted" << evicted.size() << "master frames from cache. Cached:" << m_Entries.size()
+                             << "frames," << m_Bytes / (1024 * 1024) << "MB. Hits:" << m_Statistics.hits
+                             << "Misses:" << m_Statistics.misses << "Evictions:" << m_Statistics.evictions;
+
+    return evicted;
+}
+
+void MasterFrameCache::spill(const QList<QPair<QString, QSharedPointer<FITSData>>> &evicted)
+{
+    if (m_CompactDirectory.isEmpty())
+        return;
+
+    for (const auto &oneFrame : evicted)
+    {
+        // Keep the compact file of a master which was reloaded from it
+        QFile compact(compactFilename(oneFrame.first));
+        CompactHeader header {};
+        if (compact.open(QIODevice::ReadOnly) &&
+                compact.read(reinterpret_cast<char *>(&header), sizeof(header)) == sizeof(header) &&
+                isCurrent(header, oneFrame.first, compact.size()))
+            continue;
+        compact.close();
+
+        if (!writeCompact(oneFrame.first, oneFrame.second))
+            qCWarning(KSTARS_EKOS) << "Failed to write compact master frame" << compact.fileName();
+    }
+}
+
+QString MasterFrameCache::compactFilename(const QString &filename) const
+{
+    const QString hash = QString::fromLatin1(QCryptographicHash::hash(filename.toUtf8(), QCryptographicHash::Md5).toHex());
+    return QDir(m_CompactDirectory).filePath(hash + ".master");
+}
+
+bool MasterFrameCache::writeCompact(const QString &filename, const QSharedPointer<FITSData> &data) const
+{
+    const QFileInfo sourceInfo(filename);
+    if (!sourceInfo.exists() || data->getImageBuffer() == nullptr)
+        return false;
+
+    QDir().mkpath(m_CompactDirectory);
+
+    CompactHeader header {};
+    std::memcpy(header.magic, COMPACT_MAGIC, sizeof(COMPACT_MAGIC));
+    header.version = COMPACT_VERSION;
+    header.dataOffset = COMPACT_DATA_OFFSET;
+    header.sourceSize = sourceInfo.size();
+    header.sourceModified = sourceInfo.lastModified().toMSecsSinceEpoch();
+    header.imageBytes = imageBytes(data);
+    header.statistics = data->getStatistics();
+
+    QSaveFile compact(compactFilename(filename));
+    if (!compact.open(QIODevice::WriteOnly))
+        return false;
+
+    const QByteArray padding(COMPACT_DATA_OFFSET - sizeof(header), 0);
+    compact.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    compact.write(padding);
+    compact.write(reinterpret_cast<const char *>(data->getImageBuffer()), header.imageBytes);
+    return compact.commit();
+}
+
+QSharedPointer<FITSData> MasterFrameCache::readCompact(const QString &filename) const
+{
+    if (m_CompactDirectory.isEmpty())
+        return QSharedPointer<FITSData>();
+
+    QFile compact(compactFilename(filename));
+    if (!compact.open(QIODevice::ReadOnly) || compact.size() < static_cast<qint64>(COMPACT_DATA_OFFSET))
+        return QSharedPointer<FITSData>();
+
+    CompactHeader header {};
+    if (compact.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header))
+        return QSharedPointer<FITSData>();
+    if (!isCurrent(header, filename, compact.size()))
+    {
+        // A stale compact file is dropped, it is written again on the next eviction
+        compact.remove();
+        return QSharedPointer<FITSData>();
+    }
+
+    // The image is read straight into the buffer handed over to FITSData, which owns and deletes it
+    uint8_t *buffer = new (std::nothrow) uint8_t[header.imageBytes];
+    if (buffer == nullptr)
+        return QSharedPointer<FITSData>();
+    if (!compact.seek(header.dataOffset) ||
+            compact.read(reinterpret_cast<char *>(buffer), header.imageBytes) != static_cast<qint64>(header.imageBytes))
+    {
+        delete [] buffer;
+        return QSharedPointer<FITSData>();
+    }
+
+    QSharedPointer<FITSData> data(new FITSData(FITS_CALIBRATE), &QObject::deleteLater);
+    data->setImageBuffer(buffer);
+    data->restoreStatistics(header.statistics);
+    return data;
+}
+
+}
@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2023
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSharedPointer>
+#include <QString>
+
+#include <cstdint>
+
+class FITSData;
+
+namespace Ekos
+{
+
+/**
+ * @class MasterFrameCache
+ * @short Least recently used cache of master frames, bounded in bytes.
+ *
+ * Capture, guiding and focusing may each use a different master dark frame. The cache keeps the masters
+ * loaded up to a total image size. Beyond it, the least recently used masters are evicted, except the ones
+ * pinned by their users, e.g. the master a DarkProcessor applies to every frame.
+ *
+ * An evicted master is spilled to a compact file holding its statistics and raw image buffer. The next time it is
+ * needed, it is reloaded by reading that file rather than decoding the FITS file and computing its statistics again.
+ * A compact file is used only as long as the FITS file it was made from is unchanged.
+ *
+ * The cache is thread safe.
+ */
+class MasterFrameCache
+{
+    public:
+        /** Cache usage counters */
+        struct Statistics
+        {
+            /// Requests served by a cached master
+            uint64_t hits { 0 };
+            /// Requests that needed to load the master
+            uint64_t misses { 0 };
+            /// Masters evicted to keep within the size limit
+            uint64_t evictions { 0 };
+            /// Masters reloaded from their compact file
+            uint64_t compactLoads { 0 };
+            /// Number and total image size in bytes of the cached masters
+            uint32_t frames { 0 };
+            uint64_t bytes { 0 };
+            /// Number of cached masters currently pinned
+            uint32_t pinned { 0 };
+        };
+
+        /// A master stays pinned as long as one of its pins exists
+        struct PinToken {};
+        typedef QSharedPointer<PinToken> Pin;
+
+        /**
+         * @param maxBytes maximum total image size of the cached masters
+         * @param compactDirectory directory of the compact files, none are written if empty
+         */
+        explicit MasterFrameCache(uint64_t maxBytes = 1024 * 1024 * 1024, const QString &compactDirectory = QString());
+
+        void setMaxBytes(uint64_t maxBytes);
+
+        /**
+         * @brief find Get a cached master.
+         * @param pin If not null, set to a pin of the master taken before another thread may evict it.
+         * @return the master, or a null pointer if it is not cached.
+         */
+        QSharedPointer<FITSData> find(const QString &filename, Pin *pin = nullptr);
+
+        /**
+         * @brief load Get a master, loading it from its compact file or FITS file if it is not cached.
+         * @param pin If not null, set to a pin of the master taken before another thread may evict it.
+         * @return the master, or a null pointer if it could not be loaded.
+         */
+        QSharedPointer<FITSData> load(const QString &filename, Pin *pin = nullptr);
+
+        /**
+         * @brief insert Add a master loaded by the caller, evicting others as needed.
+         * @param pin If not null, set to a pin of the master taken before another thread may evict it.
+         */
+        void insert(const QString &filename, const QSharedPointer<FITSData> &data, Pin *pin = nullptr);
+
+        /**
+         * @brief remove Drop a master from the cache and delete its compact file.
+         */
+        void remove(const QString &filename);
+
+        /**
+         * @brief trim Evict the least recently used masters which are not pinned until the cached masters take at most
+         * maxBytes, e.g. when memory runs low.
+         */
+        void trim(uint64_t maxBytes);
+
+        /**
+         * @brief pin Keep a cached master from being evicted while the returned pin exists.
+         * @return the pin, or a null pointer if the master is not cached.
+         */
+        Pin pin(const QSharedPointer<FITSData> &data);
+
+        Statistics statistics() const;
+
+        /** @return image size in bytes of a master */
+        static uint64_t imageBytes(const QSharedPointer<FITSData> &data);
+
+    private:
+        struct Entry
+        {
+            QSharedPointer<FITSData> data;
+            uint64_t bytes { 0 };
+            uint64_t lastUse { 0 };
+            QList<QWeakPointer<PinToken>> pins;
+        };
+
+        static bool isPinned(const Entry &entry);
+        // Adds a pin to the entry, with the lock held
+        static Pin pinEntry(Entry &entry);
+        // Evicts entries other than keep, least recently used first, returning them so that they are spilled
+        // without the lock held
+        QList<QPair<QString, QSharedPointer<FITSData>>> evict(uint64_t maxBytes, const QString &keep);
+        void spill(const QList<QPair<QString, QSharedPointer<FITSData>>> &evicted);
+
+        QString compactFilename(const QString &filename) const;
+        bool writeCompact(const QString &filename, const QSharedPointer<FITSData> &data) const;
+        QSharedPointer<FITSData> readCompact(const QString &filename) const;
+
+        mutable QMutex m_Mutex;
+        QHash<QString, Entry> m_Entries;
+        uint64_t m_MaxBytes { 0 };
+        uint64_t m_Bytes { 0 };
+        uint64_t m_UseCounter { 0 };
+        QString m_CompactDirectory;
+        Statistics m_Statistics;
+};
+
+}
@@ -0,0 +1,312 @@
+/*
+    SPDX-FileCopyrightText: 2023
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "masterframeintegrator.h"
+
+#include <QDir>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace Ekos
+{
+
+namespace
+{
+// Number of samples converted and written to the spill file at once
+constexpr uint32_t SPILL_BLOCK_SAMPLES = 1 << 20;
+// Iterations of the rejection algorithms
+constexpr int MAX_REJECTION_ITERATIONS = 10;
+
+// Frames of 8 and 16-bit integers, and of floats, are spilled exactly as float, the others as double
+template <typename T>
+using SpillSample = typename std::conditional<(sizeof(T) <= 2 || std::is_same<T, float>::value), float, double>::type;
+
+template <typename V> double mean(const V *values, uint32_t count)
+{
+    double sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+        sum += values[i];
+    return sum / count;
+}
+
+template <typename V> double median(V *values, uint32_t count)
+{
+    std::nth_element(values, values + count / 2, values + count);
+    double m = values[count / 2];
+    if (count % 2 == 0)
+        m = (m + *std::max_element(values, values + count / 2)) / 2.0;
+    return m;
+}
+
+template <typename V> double standardDeviation(const V *values, uint32_t count)
+{
+    const double m = mean(values, count);
+    double sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+        sum += (values[i] - m) * (values[i] - m);
+    return std::sqrt(sum / (count - 1));
+}
+
+// Converts an integrated value to the data type of the master frame
+template <typename T> T toSample(double value)
+{
+    if constexpr (std::is_integral<T>::value)
+        return static_cast<T>(std::llround(std::min(std::max(value, static_cast<double>(std::numeric_limits<T>::lowest())),
+                                           static_cast<double>(std::numeric_limits<T>::max()))));
+    else
+        return static_cast<T>(value);
+}
+}
+
+MasterFrameIntegrator::MasterFrameIntegrator()
+{
+}
+
+MasterFrameIntegrator::~MasterFrameIntegrator()
+{
+}
+
+void MasterFrameIntegrator::start(uint32_t samples, Algorithm algorithm, double sigma, uint32_t memoryBudgetMB,
+                                  const QString &directory)
+{
+    clear();
+
+    m_Samples = samples;
+    m_Algorithm = algorithm;
+    m_Sigma = sigma;
+    m_MemoryBudget = static_cast<uint64_t>(memoryBudgetMB) * 1024 * 1024;
+    m_Directory = directory.isEmpty() ? QDir::tempPath() : directory;
+}
+
+void MasterFrameIntegrator::clear()
+{
+    m_Frames = 0;
+    m_LastError.clear();
+    std::vector<double>().swap(m_Sum);
+    m_SpillFile.reset();
+}
+
+template <typename T> bool MasterFrameIntegrator::addFrame(const T *buffer)
+{
+    if (m_Algorithm == AVERAGE)
+    {
+        if (m_Sum.size() != m_Samples)
+            m_Sum.assign(m_Samples, 0);
+
+        for (uint32_t i = 0; i < m_Samples; i++)
+            m_Sum[i] += buffer[i];
+
+        m_Frames++;
+        return true;
+    }
+
+    if (!m_SpillFile)
+    {
+        m_SpillFile.reset(new QTemporaryFile(QDir(m_Directory).filePath("integration_XXXXXX.tmp")));
+        if (!m_SpillFile->open())
+        {
+            m_LastError = QString("Failed to create temporary file %1: %2").arg(m_SpillFile->fileTemplate(),
+                          m_SpillFile->errorString());
+            m_SpillFile.reset();
+            return false;
+        }
+    }
+
+    // Frames are stored one after the other, all as the sample type of the first one
+    using S = SpillSample<T>;
+    if (m_Frames == 0)
+        m_SpillSampleSize = sizeof(S);
+    else if (m_SpillSampleSize != sizeof(S))
+    {
+        m_LastError = "Frame data type differs from the previous frames.";
+        return false;
+    }
+
+    std::vector<S> block(std::min(m_Samples, SPILL_BLOCK_SAMPLES));
+    m_SpillFile->seek(static_cast<qint64>(m_Frames) * m_Samples * sizeof(S));
+    for (uint32_t start = 0; start < m_Samples; start += SPILL_BLOCK_SAMPLES)
+    {
+        const uint32_t count = std::min(SPILL_BLOCK_SAMPLES, m_Samples - start);
+        for (uint32_t i = 0; i < count; i++)
+            block[i] = buffer[start + i];
+
+        const qint64 size = static_cast<qint64>(count) * sizeof(S);
+        if (m_SpillFile->write(reinterpret_cast<const char *>(block.data()), size) != size)
+        {
+            m_LastError = QString("Failed to write frame to %1: %2").arg(m_SpillFile->fileName(), m_SpillFile->errorString());
+            return false;
+        }
+    }
+
+    m_Frames++;
+    return true;
+}
+
+template <typename T> bool MasterFrameIntegrator::integrate(T *master)
+{
+    if (m_Frames == 0)
+    {
+        m_LastError = "No frames to integrate.";
+        return false;
+    }
+
+    if (m_Algorithm == AVERAGE)
+    {
+        for (uint32_t i = 0; i < m_Samples; i++)
+            master[i] = toSample<T>(m_Sum[i] / m_Frames);
+        return true;
+    }
+
+    if (!m_SpillFile->flush())
+    {
+        m_LastError = QString("Failed to write frames to %1: %2").arg(m_SpillFile->fileName(), m_SpillFile->errorString());
+        return false;
+    }
+
+    if (m_SpillSampleSize == sizeof(double))
+        return integrateSpilled<T, double>(master);
+    return integrateSpilled<T, float>(master);
+}
+
+template <typename T, typename S> bool MasterFrameIntegrator::integrateSpilled(T *master)
+{
+    // The tile holds the values of its pixels in each frame, frame after frame
+    const uint64_t tileSamples = std::max<uint64_t>(1, std::min<uint64_t>(m_Samples,
+                                 m_MemoryBudget / (static_cast<uint64_t>(m_Frames) * sizeof(S))));
+    std::vector<S> tile(tileSamples * m_Frames);
+
+    // A range of pixels of the tile integrated by one thread
+    struct Range
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+    const int threads = std::max(1, QThread::idealThreadCount());
+
+    for (uint32_t start = 0; start < m_Samples; start += tileSamples)
+    {
+        const uint32_t count = std::min<uint64_t>(tileSamples, m_Samples - start);
+        for (uint32_t frame = 0; frame < m_Frames; frame++)
+        {
+            const qint64 size = static_cast<qint64>(count) * sizeof(S);
+            if (!m_SpillFile->seek((static_cast<qint64>(frame) * m_Samples + start) * sizeof(S)) ||
+                    m_SpillFile->read(reinterpret_cast<char *>(tile.data() + static_cast<size_t>(frame) * count), size) != size)
+            {
+                m_LastError = QString("Failed to read frames from %1: %2").arg(m_SpillFile->fileName(), m_SpillFile->errorString());
+                return false;
+            }
+        }
+
+        QVector<Range> ranges;
+        const uint32_t rangeCount = std::min<uint32_t>(threads, count);
+        for (uint32_t i = 0; i < rangeCount; i++)
+            ranges.push_back({static_cast<uint32_t>(static_cast<uint64_t>(count) * i / rangeCount),
+                              static_cast<uint32_t>(static_cast<uint64_t>(count) * (i + 1) / rangeCount)});
+
+        QtConcurrent::blockingMap(ranges, [&](const Range & range)
+        {
+            std::vector<S> values(m_Frames);
+            for (uint32_t i = range.begin; i < range.end; i++)
+            {
+                for (uint32_t frame = 0; frame < m_Frames; frame++)
+                    values[frame] = tile[static_cast<size_t>(frame) * count + i];
+                master[start + i] = toSample<T>(combine(values.data(), m_Frames, m_Algorithm, m_Sigma));
+            }
+        });
+    }
+
+    return true;
+}
+
+template <typename V> double MasterFrameIntegrator::combine(V *values, uint32_t count, Algorithm algorithm, double sigma)
+{
+    if (count == 0)
+        return 0;
+
+    // Too few values to tell outliers
+    if (algorithm == AVERAGE || count < 3)
+        return mean(values, count);
+
+    if (algorithm == SIGMA_CLIPPING)
+    {
+        uint32_t n = count;
+        for (int iteration = 0; iteration < MAX_REJECTION_ITERATIONS && n >= 3; iteration++)
+        {
+            const double center = median(values, n);
+            const double deviation = standardDeviation(values, n);
+            if (deviation <= 0)
+                break;
+
+            const double low = center - sigma * deviation, high = center + sigma * deviation;
+            const uint32_t kept = std::partition(values, values + n, [low, high](V value)
+            {
+                return value >= low && value <= high;
+            }) - values;
+            if (kept == n)
+                break;
+            n = kept;
+        }
+        return mean(values, n);
+    }
+
+    // Winsorized sigma clipping. The standard deviation is estimated robustly by winsorizing a copy of the values
+    // at 1.5 standard deviations until it converges (Huber's method), then the values further than sigma standard
+    // deviations from the median are replaced by the clipping bounds.
+    thread_local std::vector<V> winsorized;
+    winsorized.assign(values, values + count);
+
+    double center = median(winsorized.data(), count);
+    double deviation = standardDeviation(winsorized.data(), count);
+    for (int iteration = 0; iteration < MAX_REJECTION_ITERATIONS && deviation > 0; iteration++)
+    {
+        const V low = center - 1.5 * deviation, high = center + 1.5 * deviation;
+        for (auto &value : winsorized)
+            value = std::min(std::max(value, low), high);
+
+        center = median(winsorized.data(), count);
+        const double previous = deviation;
+        deviation = 1.134 * standardDeviation(winsorized.data(), count);
+        if (std::abs(deviation - previous) <= 0.0005 * previous)
+            break;
+    }
+
+    if (deviation > 0)
+    {
+        const V low = center - sigma * deviation, high = center + sigma * deviation;
+        for (uint32_t i = 0; i < count; i++)
+            values[i] = std::min(std::max(values[i], low), high);
+    }
+    return mean(values, count);
+}
+
+template double MasterFrameIntegrator::combine<float>(float *values, uint32_t count, Algorithm algorithm, double sigma);
+template double MasterFrameIntegrator::combine<double>(double *values, uint32_t count, Algorithm algorithm, double sigma);
+
+template bool MasterFrameIntegrator::addFrame<uint8_t>(const uint8_t *buffer);
+template bool MasterFrameIntegrator::addFrame<int16_t>(const int16_t *buffer);
+template bool MasterFrameIntegrator::addFrame<uint16_t>(const uint16_t *buffer);
+template bool MasterFrameIntegrator::addFrame<int32_t>(const int32_t *buffer);
+template bool MasterFrameIntegrator::addFrame<uint32_t>(const uint32_t *buffer);
+template bool MasterFrameIntegrator::addFrame<float>(const float *buffer);
+template bool MasterFrameIntegrator::addFrame<int64_t>(const int64_t *buffer);
+template bool MasterFrameIntegrator::addFrame<double>(const double *buffer);
+
+template bool MasterFrameIntegrator::integrate<uint8_t>(uint8_t *master);
+template bool MasterFrameIntegrator::integrate<int16_t>(int16_t *master);
+template bool MasterFrameIntegrator::integrate<uint16_t>(uint16_t *master);
+template bool MasterFrameIntegrator::integrate<int32_t>(int32_t *master);
+template bool MasterFrameIntegrator::integrate<uint32_t>(uint32_t *master);
+template bool MasterFrameIntegrator::integrate<float>(float *master);
+template bool MasterFrameIntegrator::integrate<int64_t>(int64_t *master);
+template bool MasterFrameIntegrator::integrate<double>(double *master);
+
+}
@@ -0,0 +1,122 @@
+/*
+    SPDX-FileCopyrightText: 2023
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QString>
+#include <QTemporaryFile>
+
+#include <memory>
+#include <vector>
+
+namespace Ekos
+{
+
+/**
+ * @class MasterFrameIntegrator
+ * @short Integrates calibration frames, as they are captured, into a master frame.
+ *
+ * The frames are averaged, optionally rejecting outliers, such as cosmic rays or satellite trails, from the frames
+ * of each pixel before they are averaged:
+ *
+ * - Sigma clipping iteratively rejects the values further than sigma standard deviations from the median.
+ * - Winsorized sigma clipping replaces these values by the clipping bounds instead, the standard deviation being
+ *   estimated from iteratively winsorized values.
+ *
+ * Averaging only keeps a running sum. Rejecting outliers needs all the values of each pixel, so the frames are
+ * spilled to a temporary file as they are added and then read back in tiles of pixels, as many as fit in the memory
+ * budget for all the frames. The pixels of each tile are integrated concurrently. Frames of 8 and 16-bit integers,
+ * and of floats, are spilled as float. Frames of 32 and 64-bit integers, and of doubles, are spilled as double, which
+ * is exact for integers up to 2^53.
+ *
+ * @version 1.0
+ */
+class MasterFrameIntegrator
+{
+    public:
+        typedef enum
+        {
+            AVERAGE,
+            SIGMA_CLIPPING,
+            WINSORIZED_SIGMA_CLIPPING
+        } Algorithm;
+
+        MasterFrameIntegrator();
+        ~MasterFrameIntegrator();
+
+        /**
+         * @brief start Start integrating frames, dropping any frame previously added.
+         * @param samples Number of samples in each frame, all channels included.
+         * @param algorithm Integration algorithm.
+         * @param sigma Rejection threshold in standard deviations when rejecting outliers.
+         * @param memoryBudgetMB Memory used to read back the frames when rejecting outliers.
+         * @param directory Directory of the temporary file the frames are spilled to when rejecting outliers.
+         */
+        void start(uint32_t samples, Algorithm algorithm = AVERAGE, double sigma = 3.0, uint32_t memoryBudgetMB = 1024,
+                   const QString &directory = QString());
+
+        /**
+         * @brief clear Drop the frames added and release their memory and temporary file.
+         */
+        void clear();
+
+        /**
+         * @brief addFrame Add a frame of samples() values.
+         * @return True if the frame was added, false otherwise. See getLastError().
+         */
+        template <typename T> bool addFrame(const T *buffer);
+
+        /**
+         * @brief integrate Integrate the frames added into master, which holds samples() values.
+         * @return True if the master frame was integrated, false otherwise. See getLastError().
+         */
+        template <typename T> bool integrate(T *master);
+
+        uint32_t samples() const
+        {
+            return m_Samples;
+        }
+        uint32_t frames() const
+        {
+            return m_Frames;
+        }
+        Algorithm algorithm() const
+        {
+            return m_Algorithm;
+        }
+        const QString &getLastError() const
+        {
+            return m_LastError;
+        }
+
+        /**
+         * @brief combine Integrate the values of one pixel as per the algorithm.
+         * @param values Values of the pixel in each frame, float or double. They are reordered and may be modified.
+         * @param count Number of values.
+         * @return Integrated value.
+         */
+        template <typename V> static double combine(V *values, uint32_t count, Algorithm algorithm, double sigma);
+
+    private:
+        // Integrates the frames spilled as S into master
+        template <typename T, typename S> bool integrateSpilled(T *master);
+
+        uint32_t m_Samples {0};
+        uint32_t m_Frames {0};
+        Algorithm m_Algorithm {AVERAGE};
+        double m_Sigma {3.0};
+        uint64_t m_MemoryBudget {0};
+        QString m_Directory;
+        QString m_LastError;
+
+        // Running sum when averaging
+        std::vector<double> m_Sum;
+        // Frames spilled to disk when rejecting outliers, and the size of their samples
+        std::unique_ptr<QTemporaryFile> m_SpillFile;
+        uint32_t m_SpillSampleSize {sizeof(float)};
+};
+
+}
@@ -1666,21 +1666,21 @@ void Message::processAstronomyCommands(const QString &command, const QJsonObject
             // Stars
             case SkyObject::STAR:
             case SkyObject::CATALOG_STAR:
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::STAR));
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::CATALOG_STAR));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::STAR));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::CATALOG_STAR));
                 break;
             // Planets & Moon
             case SkyObject::PLANET:
             case SkyObject::MOON:
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::PLANET));
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::MOON));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::PLANET));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::MOON));
                 break;
             // Comets & Asteroids
             case SkyObject::COMET:
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::COMET));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::COMET));
                 break;
             case SkyObject::ASTEROID:
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::ASTEROID));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::ASTEROID));
                 break;
             // Clusters
             case SkyObject::OPEN_CLUSTER:
@@ -1712,7 +1712,7 @@ void Message::processAstronomyCommands(const QString &command, const QJsonObject
                     data->setFullTimeUpdate();
                     KStars::Instance()->map()->forceUpdate();
                 }
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::SUPERNOVA));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::SUPERNOVA));
             }
             break;
             case SkyObject::SATELLITE:
@@ -1723,7 +1723,7 @@ void Message::processAstronomyCommands(const QString &command, const QJsonObject
                     data->setFullTimeUpdate();
                     KStars::Instance()->map()->forceUpdate();
                 }
-                allObjects.append(data->skyComposite()->objectLists(SkyObject::SATELLITE));
+                allObjects.append(data->skyComposite()->objectList(SkyObject::SATELLITE));
             }
             break;
             default:
@@ -2,6 +2,10 @@
 #include "ekos/ekos.h"
 #include <ekos_focus_debug.h>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 // Constants used to identify the number of parameters used for different curve types
 constexpr int NUM_HYPERBOLA_PARAMS = 4;
 constexpr int NUM_PARABOLA_PARAMS = 3;
@@ -448,24 +452,58 @@ double gaufxy(double x, double y, double a, double x0, double y0, double A, doub
     return b + a * exp(-(A * (pow(x - x0, 2.0)) + 2.0 * B * (x - x0) * (y - y0) + C * (pow(y - y0, 2.0))));
 }
 
+// The data of a gaussian fit passed to the solver callbacks. The exponential term phi of each data point,
+// the costly part of the gaussian, is kept from the evaluation of f(x,y) for the Jacobian, which the solver
+// evaluates at the same coefficients.
+struct GaussianFitData
+{
+    const CurveFitting::DataPoint3DT *data;
+    std::vector<double> phi;
+    // x0, y0, A, B, C for which phi was computed
+    double phiCoefficients[5];
+    bool phiValid;
+};
+
+// Computes phi = exp-(A((x-x0)^2) + 2B(x-x0)(y-y0) + C((y-y0)^2)) for each data point, unless already done.
+const std::vector<double> &gauPhi(const gsl_vector * X, GaussianFitData *fit)
+{
+    const double coefficients[5] = { gsl_vector_get(X, B_IDX), gsl_vector_get(X, C_IDX), gsl_vector_get(X, D_IDX),
+                                     gsl_vector_get(X, E_IDX), gsl_vector_get(X, F_IDX)
+                                   };
+    if (fit->phiValid && std::equal(coefficients, coefficients + 5, fit->phiCoefficients))
+        return fit->phi;
+
+    const double x0 = coefficients[0], y0 = coefficients[1];
+    const double A = coefficients[2], B = coefficients[3], C = coefficients[4];
+    const auto &dps = fit->data->dps;
+    fit->phi.resize(dps.size());
+    for (int i = 0; i < dps.size(); ++i)
+    {
+        const double xmx0 = dps[i].x - x0;
+        const double ymy0 = dps[i].y - y0;
+        fit->phi[i] = exp(-((A * xmx0 * xmx0) + (2.0 * B * xmx0 * ymy0) + (C * ymy0 * ymy0)));
+    }
+
+    std::copy(coefficients, coefficients + 5, fit->phiCoefficients);
+    fit->phiValid = true;
+    return fit->phi;
+}
+
 // Calculates f(x,y) for each data point in the gaussian.
 int gauFxy(const gsl_vector * X, void * inParams, gsl_vector * outResultVec)
 {
-    CurveFitting::DataPoint3DT * DataPoint = ((struct CurveFitting::DataPoint3DT *)inParams);
+    GaussianFitData * fit = static_cast<GaussianFitData *>(inParams);
+    const auto &dps = fit->data->dps;
 
     double a  = gsl_vector_get (X, A_IDX);
-    double x0  = gsl_vector_get (X, B_IDX);
-    double y0 = gsl_vector_get (X, C_IDX);
-    double A = gsl_vector_get (X, D_IDX);
-    double B  = gsl_vector_get (X, E_IDX);
-    double C  = gsl_vector_get (X, F_IDX);
     double b  = gsl_vector_get (X, G_IDX);
+    const std::vector<double> &phi = gauPhi(X, fit);
 
-    for(int i = 0; i < DataPoint->dps.size(); ++i)
+    for(int i = 0; i < dps.size(); ++i)
     {
         // Gaussian equation
-        double zij = gaufxy(DataPoint->dps[i].x, DataPoint->dps[i].y, a, x0, y0, A, B, C, b);
-        gsl_vector_set(outResultVec, i, (zij - DataPoint->dps[i].z));
+        double zij = b + a * phi[i];
+        gsl_vector_set(outResultVec, i, (zij - dps[i].z));
     }
 
     return GSL_SUCCESS;
@@ -483,7 +521,8 @@ int gauFxy(const gsl_vector * X, void * inParams, gsl_vector * outResultVec)
 // df/dC      = -(y-y0)^2.a.phi
 int gauJxy(const gsl_vector * X, void * inParams, gsl_matrix * J)
 {
-    CurveFitting::DataPointT * DataPoint = ((struct CurveFitting::DataPointT *)inParams);
+    GaussianFitData * fit = static_cast<GaussianFitData *>(inParams);
+    const auto &dps = fit->data->dps;
 
     // Get current coefficients
     const double a  = gsl_vector_get (X, A_IDX);
@@ -493,17 +532,18 @@ int gauJxy(const gsl_vector * X, void * inParams, gsl_matrix * J)
     const double B  = gsl_vector_get (X, E_IDX);
     const double C  = gsl_vector_get (X, F_IDX);
     // b is not used ... const double b  = gsl_vector_get (X, G_IDX);
+    const std::vector<double> &phis = gauPhi(X, fit);
 
-    for(int i = 0; i < DataPoint->dps.size(); ++i)
+    for(int i = 0; i < dps.size(); ++i)
     {
         // Calculate the Jacobian Matrix
-        const double x = DataPoint->dps[i].x;
+        const double x = dps[i].x;
         const double xmx0 = x - x0;
         const double xmx02 = xmx0 * xmx0;
-        const double y = DataPoint->dps[i].y;
+        const double y = dps[i].y;
         const double ymy0 = y - y0;
         const double ymy02 = ymy0 * ymy0;
-        const double phi = exp(-((A * xmx02) + (2.0 * B * xmx0 * ymy0) + (C * ymy02)));
+        const double phi = phis[i];
         const double aphi = a * phi;
 
         gsl_matrix_set(J, i, A_IDX, phi);
@@ -558,7 +598,8 @@ int gauJxy(const gsl_vector * X, void * inParams, gsl_matrix * J)
 //
 int gauFxyxy(const gsl_vector* X,  const gsl_vector* v, void* inParams, gsl_vector* fvv)
 {
-    CurveFitting::DataPointT * DataPoint = ((struct CurveFitting::DataPointT *)inParams);
+    GaussianFitData * fit = static_cast<GaussianFitData *>(inParams);
+    const auto &dps = fit->data->dps;
 
     // Get current coefficients
     const double a  = gsl_vector_get (X, A_IDX);
@@ -576,16 +617,17 @@ int gauFxyxy(const gsl_vector* X,  const gsl_vector* v, void* inParams, gsl_vect
     const double vB  = gsl_vector_get(v, E_IDX);
     const double vC  = gsl_vector_get(v, F_IDX);
     // vb not used ... const double vb  = gsl_vector_get(v, G_IDX);
+    const std::vector<double> &phis = gauPhi(X, fit);
 
-    for(int i = 0; i < DataPoint->dps.size(); ++i)
+    for(int i = 0; i < dps.size(); ++i)
     {
-        double x = DataPoint->dps[i].x;
+        double x = dps[i].x;
         double xmx0 = x - x0;
         double xmx02 = xmx0 * xmx0;
-        double y = DataPoint->dps[i].y;
+        double y = dps[i].y;
         double ymy0 = y - y0;
         double ymy02 = ymy0 * ymy0;
-        double phi = exp(-((A * xmx02) + (2.0 * B * xmx0 * ymy0) + (C * ymy02)));
+        double phi = phis[i];
         double aphi = a * phi;
         double AB = 2.0 * ((A * xmx0) + (B * ymy0));
         double BC = 2.0 * ((B * xmx0) + (C * ymy0));
@@ -628,6 +670,49 @@ int gauFxyxy(const gsl_vector* X,  const gsl_vector* v, void* inParams, gsl_vect
 
     return GSL_SUCCESS;
 }
+
+// The solver workspaces of the gaussian fits, by number of data points. The stars of an image are fitted
+// concurrently, see FocusFWHM, with boxes of only a few different sizes, so each thread keeps the workspaces
+// it allocated for the next stars.
+class GaussianWorkspaces
+{
+    public:
+        ~GaussianWorkspaces()
+        {
+            clear();
+        }
+
+        // Returns the workspace for n data points, or nullptr if the solver can't be set up for them
+        gsl_multifit_nlinear_workspace *get(size_t n)
+        {
+            auto found = m_Workspaces.find(n);
+            if (found != m_Workspaces.end())
+                return found->second;
+
+            if (m_Workspaces.size() >= MAX_WORKSPACES)
+                clear();
+
+            gsl_multifit_nlinear_parameters params = gsl_multifit_nlinear_default_parameters();
+            gsl_multifit_nlinear_workspace *w = gsl_multifit_nlinear_alloc(gsl_multifit_nlinear_trust, &params, n,
+                                                NUM_GAUSSIAN_PARAMS);
+            if (w != nullptr)
+                m_Workspaces[n] = w;
+            return w;
+        }
+
+    private:
+        void clear()
+        {
+            for (auto &workspace : m_Workspaces)
+                gsl_multifit_nlinear_free(workspace.second);
+            m_Workspaces.clear();
+        }
+
+        static constexpr std::size_t MAX_WORKSPACES = 32;
+        std::map<size_t, gsl_multifit_nlinear_workspace *> m_Workspaces;
+};
+
+thread_local GaussianWorkspaces gaussianWorkspaces;
 }  // namespace
 
 CurveFitting::CurveFitting()
@@ -1370,33 +1455,43 @@ void CurveFitting::parMakeGuess(const int attempt, const QVector<double> inX, co
     }
 }
 
-QVector<double> CurveFitting::gaussian_fit(DataPoint3DT data, const StarParams &starParams)
+QVector<double> CurveFitting::gaussian_fit(const DataPoint3DT &data, const StarParams &starParams)
 {
     QVector<double> vc;
 
-    // Set the gsl error handler off as it aborts the program on error.
-    auto const oldErrorHandler = gsl_set_error_handler_off();
+    // The gsl error handler is turned off by the caller, see fitCurve3D().
 
-    // Setup variables to be used by the solver
+    // Setup variables to be used by the solver. The workspace is kept by this thread for the next stars.
     gsl_multifit_nlinear_parameters params = gsl_multifit_nlinear_default_parameters();
-    gsl_multifit_nlinear_workspace* w = gsl_multifit_nlinear_alloc (gsl_multifit_nlinear_trust, &params, data.dps.size(),
-                                        NUM_GAUSSIAN_PARAMS);
+    gsl_multifit_nlinear_workspace* w = gaussianWorkspaces.get(data.dps.size());
+    if (w == nullptr)
+    {
+        qCDebug(KSTARS_EKOS_FOCUS) << QString("LM solver (Gaussian): Cannot solve for %1 datapoints").arg(data.dps.size());
+        return vc;
+    }
+
     gsl_multifit_nlinear_fdf fdf;
     int numIters;
     double xtol, gtol, ftol;
 
+    GaussianFitData fitData;
+    fitData.data = &data;
+    fitData.phiValid = false;
+
     // Fill in function info
     fdf.f = gauFxy;
     fdf.df = gauJxy;
     fdf.fvv = gauFxyxy;
     fdf.n = data.dps.size();
     fdf.p = NUM_GAUSSIAN_PARAMS;
-    fdf.params = &data;
+    fdf.params = &fitData;
 
-    // Allocate the guess vector
-    gsl_vector * guess = gsl_vector_alloc(NUM_GAUSSIAN_PARAMS);
-    // Allocate weights vector
-    auto weights = gsl_vector_alloc(data.dps.size());
+    // The guess vector
+    double guessValues[NUM_GAUSSIAN_PARAMS];
+    gsl_vector_view guessView = gsl_vector_view_array(guessValues, NUM_GAUSSIAN_PARAMS);
+    gsl_vector * guess = &guessView.vector;
+    // Allocate weights vector if used
+    auto weights = data.useWeights ? gsl_vector_alloc(data.dps.size()) : nullptr;
 
     // Setup a timer to see how long the solve takes
     QElapsedTimer timer;
@@ -1490,12 +1585,8 @@ QVector<double> CurveFitting::gaussian_fit(DataPoint3DT data, const StarParams &
     }
 
     // Free GSL memory
-    gsl_multifit_nlinear_free(w);
-    gsl_vector_free(guess);
-    gsl_vector_free(weights);
-
-    // Restore old GSL error handler
-    gsl_set_error_handler(oldErrorHandler);
+    if (weights != nullptr)
+        gsl_vector_free(weights);
 
     return vc;
 }
@@ -113,6 +113,8 @@ class CurveFitting
         // Data is passed in in imageBuffer - a 2D array of width x height
         // Approx star information is passed in to seed the LM solver initial parameters.
         // Start and end define the x,y coordinates of a box around the star start is top left corner, end is bottom right
+        // The gsl error handler, which aborts the program on error, must be turned off by the caller. It is global, so it is
+        // not toggled here by fits running concurrently, see FocusFWHM::processFWHM().
         template <typename T>
         void fitCurve3D(const T *imageBuffer, const int imageWidth, const QPair<int, int> start, const QPair<int, int> end,
                         const StarParams &starParams, const CurveFit curveFit, const bool useWeights)
@@ -222,7 +224,7 @@ class CurveFitting
         QVector<double> parabola_fit(FittingGoal goal, const QVector<double> data_x, const QVector<double> data_y,
                                      const QVector<double> data_weights,
                                      bool useWeights, const OptimisationDirection optDir);
-        QVector<double> gaussian_fit(DataPoint3DT data, const StarParams &starParams);
+        QVector<double> gaussian_fit(const DataPoint3DT &data, const StarParams &starParams);
 
         bool minimumQuadratic(double expected, double minPosition, double maxPosition, double *position, double *value);
         bool minMaxHyperbola(double expected, double minPosition, double maxPosition, double *position, double *value,
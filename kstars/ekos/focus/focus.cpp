@@ -1331,8 +1331,7 @@ void Focus::start()
 
         if (m_FocusAlgorithm == FOCUS_LINEAR1PASS)
         {
-            // Curve fitting for stars and FWHM processing
-            starFitting.reset(new CurveFitting());
+            // FWHM processing, which fits a curve to each star
             focusFWHM.reset(new FocusFWHM(m_ScaleCalc));
             focusFourierPower.reset(new FocusFourierPower(m_ScaleCalc));
         }
@@ -2104,35 +2103,35 @@ void Focus::getFWHM(double *FWHM, double *weight)
     switch (m_ImageData->getStatistics().dataType)
     {
         case TBYTE:
-            focusFWHM->processFWHM(reinterpret_cast<uint8_t const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<uint8_t const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TSHORT: // Don't think short is used as its recorded as unsigned short
-            focusFWHM->processFWHM(reinterpret_cast<short const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<short const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TUSHORT:
-            focusFWHM->processFWHM(reinterpret_cast<unsigned short const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<unsigned short const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TLONG:  // Don't think long is used as its recorded as unsigned long
-            focusFWHM->processFWHM(reinterpret_cast<long const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<long const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TULONG:
-            focusFWHM->processFWHM(reinterpret_cast<unsigned long const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<unsigned long const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TFLOAT:
-            focusFWHM->processFWHM(reinterpret_cast<float const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<float const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TLONGLONG:
-            focusFWHM->processFWHM(reinterpret_cast<long long const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<long long const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         case TDOUBLE:
-            focusFWHM->processFWHM(reinterpret_cast<double const *>(imageBuffer), m_ImageData, starFitting, FWHM, weight);
+            focusFWHM->processFWHM(reinterpret_cast<double const *>(imageBuffer), m_ImageData, FWHM, weight);
             break;
 
         default:
@@ -1053,9 +1053,6 @@ class Focus : public QWidget, public Ui::Focus
         // Curve fitting for focuser movement.
         std::unique_ptr<CurveFitting> curveFitting;
 
-        // Curve fitting for stars.
-        std::unique_ptr<CurveFitting> starFitting;
-
         // FWHM processing.
         std::unique_ptr<FocusFWHM> focusFWHM;
 
@@ -1,5 +1,10 @@
 #include "focusfourierpower.h"
 
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+
 namespace Ekos
 {
 
@@ -10,6 +15,169 @@ FocusFourierPower::FocusFourierPower(Mathematics::RobustStatistics::ScaleCalcula
 
 FocusFourierPower::~FocusFourierPower()
 {
+    freeTransforms();
+}
+
+bool FocusFourierPower::setupTransforms(int width, int height)
+{
+    if (width == m_Width && height == m_Height && m_RowWT != nullptr && m_ColWT != nullptr)
+        return true;
+
+    freeTransforms();
+
+    /* alloc memory for wavetables, and a workspace per concurrent transform */
+    m_RowWT = gsl_fft_real_wavetable_alloc(width);
+    m_ColWT = gsl_fft_complex_wavetable_alloc(height);
+    const int threads = std::max(1, QThread::idealThreadCount());
+    for (int i = 0; i < threads; i++)
+    {
+        m_RowWS.push_back(gsl_fft_real_workspace_alloc(width));
+        m_ColWS.push_back(gsl_fft_complex_workspace_alloc(height));
+    }
+
+    if (m_RowWT == nullptr || m_ColWT == nullptr || m_RowWS.contains(nullptr) || m_ColWS.contains(nullptr))
+    {
+        qCDebug(KSTARS_EKOS_FOCUS) << QString("Unable to allocate FFT for %1x%2 image").arg(width).arg(height);
+        freeTransforms();
+        return false;
+    }
+
+    m_Width = width;
+    m_Height = height;
+    return true;
+}
+
+void FocusFourierPower::freeTransforms()
+{
+    /* free memory */
+    if (m_RowWT != nullptr)
+        gsl_fft_real_wavetable_free(m_RowWT);
+    if (m_ColWT != nullptr)
+        gsl_fft_complex_wavetable_free(m_ColWT);
+    for (auto ws : m_RowWS)
+        if (ws != nullptr)
+            gsl_fft_real_workspace_free(ws);
+    for (auto ws : m_ColWS)
+        if (ws != nullptr)
+            gsl_fft_complex_workspace_free(ws);
+
+    m_RowWT = nullptr;
+    m_ColWT = nullptr;
+    m_RowWS.clear();
+    m_ColWS.clear();
+    m_Width = 0;
+    m_Height = 0;
+}
+
+bool FocusFourierPower::spectrumPower(std::vector<double> &image, int width, int height, double *power)
+{
+    // Set the gsl error handler off as it aborts the program on error.
+    auto const oldErrorHandler = gsl_set_error_handler_off();
+
+    if (!setupTransforms(width, height))
+    {
+        gsl_set_error_handler(oldErrorHandler);
+        return false;
+    }
+
+    // A range of rows or columns transformed by one thread, with its workspace
+    struct Range
+    {
+        int workspace;
+        int begin;
+        int end;
+        int status;
+        double power;
+    };
+    auto ranges = [&](int size)
+    {
+        QVector<Range> r;
+        const int count = std::min(m_RowWS.size(), size);
+        for (int i = 0; i < count; i++)
+            r.push_back({i, static_cast<int>(static_cast<long>(size) * i / count),
+                         static_cast<int>(static_cast<long>(size) * (i + 1) / count), 0, 0.0});
+        return r;
+    };
+
+    // Perform FFT on all the rows. As the rows are real, each transform is done in place in GSL's half-complex
+    // format: the real part of frequency 0, then the real and imaginary parts of frequencies 1 .. (width - 1) / 2,
+    // then for an even width the real part of frequency width / 2.
+    QVector<Range> rows = ranges(height);
+    QtConcurrent::blockingMap(rows, [&](Range & range)
+    {
+        for (int j = range.begin; j < range.end && range.status == 0; j++)
+        {
+            range.status = gsl_fft_real_transform(&image[static_cast<size_t>(j) * width], 1, width, m_RowWT, m_RowWS[range.workspace]);
+            if (range.status != 0)
+                qCDebug(KSTARS_EKOS_FOCUS) << QString("Error %1 [%2] calculating FFT on row %3").arg(range.status)
+                                           .arg(gsl_strerror(range.status)).arg(j);
+        }
+    });
+
+    bool ok = std::all_of(rows.cbegin(), rows.cend(), [](const Range & range)
+    {
+        return range.status == 0;
+    });
+
+    if (ok)
+    {
+        // Perform FFT on the cols of frequencies 0 .. width / 2. The spectrum of a real image is symmetric,
+        // F(-u, -v) being the conjugate of F(u, v), so the power of the cols of negative frequency is that of
+        // the cols of frequencies 1 .. (width - 1) / 2.
+        QVector<Range> cols = ranges(width / 2 + 1);
+        QtConcurrent::blockingMap(cols, [&](Range & range)
+        {
+            std::vector<double> col(2 * static_cast<size_t>(height));
+            for (int i = range.begin; i < range.end && range.status == 0; i++)
+            {
+                const bool isPair = (i > 0 && 2 * i < width);
+                for (int j = 0; j < height; j++)
+                {
+                    const double *row = &image[static_cast<size_t>(j) * width];
+                    if (i == 0)
+                    {
+                        col[2 * j] = row[0];
+                        col[2 * j + 1] = 0.0;
+                    }
+                    else if (isPair)
+                    {
+                        col[2 * j] = row[2 * i - 1];
+                        col[2 * j + 1] = row[2 * i];
+                    }
+                    else
+                    {
+                        col[2 * j] = row[width - 1];
+                        col[2 * j + 1] = 0.0;
+                    }
+                }
+
+                range.status = gsl_fft_complex_forward(col.data(), 1, height, m_ColWT, m_ColWS[range.workspace]);
+                if (range.status != 0)
+                {
+                    qCDebug(KSTARS_EKOS_FOCUS) << QString("Error %1 [%2] calculating FFT on col %3").arg(range.status)
+                                               .arg(gsl_strerror(range.status)).arg(i);
+                    break;
+                }
+
+                double colPower = 0.0;
+                for (int j = 0; j < 2 * height; j++)
+                    colPower += col[j] * col[j];
+                range.power += isPair ? 2.0 * colPower : colPower;
+            }
+        });
+
+        *power = 0.0;
+        for (const auto &range : cols)
+        {
+            ok = ok && range.status == 0;
+            *power += range.power;
+        }
+    }
+
+    // Restore old GSL error handler
+    gsl_set_error_handler(oldErrorHandler);
+
+    return ok;
 }
 
 }  // namespace
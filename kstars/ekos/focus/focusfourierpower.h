@@ -7,6 +7,7 @@
 #pragma once
 
 #include <QList>
+#include <QVector>
 #include "../fitsviewer/fitsstardetector.h"
 #include "fitsviewer/fitsview.h"
 #include "fitsviewer/fitsdata.h"
@@ -15,6 +16,10 @@
 #include "../ekos.h"
 #include <ekos_focus_debug.h>
 #include <gsl/gsl_fft_complex.h>
+#include <gsl/gsl_fft_real.h>
+#include <vector>
+
+class TestFocus;
 
 namespace Ekos
 {
@@ -43,8 +48,11 @@ namespace Ekos
 // information is available here.
 //
 // So we need to perform a 2D FFT on the image. GSL only performs basic 1D FFTs so this
-// routine performs a FFT on each row and then uses the results to perform a FFT on each
-// column. An optimisation would be to use a more sophisticated FFT routine. FFTW3 could,
+// routine performs a real FFT on each row and then uses the results to perform a complex FFT
+// on each column. As the image is real, its spectrum is symmetric, so only the columns of
+// non-negative frequency are transformed and the others are accounted for by symmetry. The rows,
+// then the columns, are transformed concurrently, and the wavetables are kept for the next frame
+// of the same size. An optimisation would be to use a more sophisticated FFT routine. FFTW3 could,
 // for example, be used.
 //
 // Currently just the first channel (if there is more than 1) is used by this routine. It would
@@ -71,20 +79,12 @@ class FocusFourierPower
             const auto width = stats.width;
             const auto height = stats.height;
             const auto N = width * height;
-            double *image = new double[2 * N];
-
-            // Set the gsl error handler off as it aborts the program on error.
-            auto const oldErrorHandler = gsl_set_error_handler_off();
-
-            /* alloc memory for complex wavetables, and workspace */
-            gsl_fft_complex_wavetable *rowWT = gsl_fft_complex_wavetable_alloc(width);
-            gsl_fft_complex_workspace *rowWS = gsl_fft_complex_workspace_alloc(width);
-            gsl_fft_complex_wavetable *colWT = gsl_fft_complex_wavetable_alloc(height);
-            gsl_fft_complex_workspace *colWS = gsl_fft_complex_workspace_alloc(height);
+            if (N <= 0)
+                return;
 
-            // Convert the image to complex double datatype as required by GSL FFT
-            // The real part is just the background subtracted pixel value clipped to zero
-            // The imaginary part is zero.
+            // Convert the image to double datatype as required by GSL FFT
+            // The value is just the background subtracted pixel value clipped to zero
+            std::vector<double> image(N);
 
             auto skyBackground = imageData->getSkyBackground();
             auto bg = skyBackground.mean + 3.0 * skyBackground.sigma;
@@ -93,12 +93,9 @@ class FocusFourierPower
             for (long i = 0; i < N; i++)
             {
                 if (mask.isNull() || mask->active() == false || mask->isVisible(posX, posY))
-                    image[i * 2] = std::max(0.0, (double) imageBuffer[i] - bg);
+                    image[i] = std::max(0.0, (double) imageBuffer[i] - bg);
                 else
-                    image[i * 2] = 0.0;
-
-                // Imaginary value is always zero
-                image[i * 2 + 1] = 0.0;
+                    image[i] = 0.0;
 
                 if (++posX == width)
                 {
@@ -107,61 +104,40 @@ class FocusFourierPower
                 }
             }
 
-            // Perform FFT on all the rows
-            int status = 0;
-            for (int j = 0; j < height; j++)
+            double power = 0.0;
+            if (spectrumPower(image, width, height, &power))
             {
-                status = gsl_fft_complex_forward(&image[j * 2 * width], 1, width, rowWT, rowWS);
-                if (status != 0)
-                {
-                    qCDebug(KSTARS_EKOS_FOCUS) << QString("Error %1 [%2] calculating FFT on row %3").arg(status).arg(gsl_strerror(status)).
-                                               arg(j);
-                    break;
-                }
-            }
-
-            if (status == 0)
-            {
-                // Perform FFT on all the cols
-                for (int i = 0; i < width; i++)
-                {
-                    status = gsl_fft_complex_forward(&image[2 * i], width, height, colWT, colWS);
-                    if (status != 0)
-                    {
-                        qCDebug(KSTARS_EKOS_FOCUS) << QString("Error %1 [%2] calculating FFT on col %3").arg(status).arg(gsl_strerror(status)).arg(
-                                                       i);
-                        break;
-                    }
-                }
-            }
-
-            if (status == 0)
-            {
-                double power = 0.0;
-                for (long i = 0; i < N; i++)
-                    power += pow(image[i * 2], 2.0) + pow(image[i * 2 + 1], 2.0);
-
                 power /= pow(N, 2.0);
 
                 qCDebug(KSTARS_EKOS_FOCUS) << "FFT power=" << power;
 
                 *fourierPower = power;
             }
-
-            /* free memory */
-            gsl_fft_complex_wavetable_free(rowWT);
-            gsl_fft_complex_workspace_free(rowWS);
-            gsl_fft_complex_wavetable_free(colWT);
-            gsl_fft_complex_workspace_free(colWS);
-
-            // Restore old GSL error handler
-            gsl_set_error_handler(oldErrorHandler);
         }
 
         static double constexpr INVALID_STAR_MEASURE = -1.0;
 
     private:
 
+        // Sets up the wavetables and workspaces for a width x height image, unless already done
+        bool setupTransforms(int width, int height);
+        void freeTransforms();
+
+        // Performs the 2D FFT of the width x height image, which is overwritten, and sums the power of its spectrum.
+        // Returns false on a GSL error.
+        bool spectrumPower(std::vector<double> &image, int width, int height, double *power);
+
+        friend TestFocus;
+
         Mathematics::RobustStatistics::ScaleCalculation m_ScaleCalc;
+
+        // FFT wavetables for the rows and the columns of the image size they were set up for, and
+        // the workspaces for each concurrent transform.
+        int m_Width { 0 };
+        int m_Height { 0 };
+        gsl_fft_real_wavetable *m_RowWT { nullptr };
+        gsl_fft_complex_wavetable *m_ColWT { nullptr };
+        QVector<gsl_fft_real_workspace *> m_RowWS;
+        QVector<gsl_fft_complex_workspace *> m_ColWS;
 };
 }
@@ -1,6 +1,8 @@
 #include "focusfwhm.h"
 #include <ekos_focus_debug.h>
 
+#include <algorithm>
+
 namespace Ekos
 {
 
@@ -13,6 +15,67 @@ FocusFWHM::~FocusFWHM()
 {
 }
 
+// Rather than test every pair of stars, the boxes are binned into a grid of cells at least as large as the
+// largest box, so only boxes sharing a cell are tested. Pairs are tested in the same order as a test of every
+// pair would, so the same stars are excluded.
+void FocusFWHM::excludeOverlappingStars(QVector<StarBox> &stars, int width, int height)
+{
+    if (stars.size() < 2)
+        return;
+
+    int cellSize = 1;
+    for (const auto &star : stars)
+        cellSize = std::max(cellSize, std::max(star.end.first - star.start.first, star.end.second - star.start.second) + 1);
+
+    const int columns = std::max(width, 0) / cellSize + 1;
+    const int rows = std::max(height, 0) / cellSize + 1;
+    auto column = [&](int x)
+    {
+        return std::min(std::max(x / cellSize, 0), columns - 1);
+    };
+    auto row = [&](int y)
+    {
+        return std::min(std::max(y / cellSize, 0), rows - 1);
+    };
+
+    QVector<QVector<int>> cells(columns * rows);
+    for (int s = 0; s < stars.size(); s++)
+    {
+        for (int r = row(stars[s].start.second); r <= row(stars[s].end.second); r++)
+            for (int c = column(stars[s].start.first); c <= column(stars[s].end.first); c++)
+                cells[r * columns + c].push_back(s);
+    }
+
+    QVector<int> candidates;
+    for (int s1 = 0; s1 < stars.size(); s1++)
+    {
+        if (!stars[s1].isValid)
+            continue;
+
+        candidates.clear();
+        for (int r = row(stars[s1].start.second); r <= row(stars[s1].end.second); r++)
+            for (int c = column(stars[s1].start.first); c <= column(stars[s1].end.first); c++)
+                for (int s2 : cells[r * columns + c])
+                    if (s2 > s1)
+                        candidates.push_back(s2);
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        for (int s2 : candidates)
+        {
+            if (!stars[s2].isValid)
+                continue;
+
+            if (boxOverlap(stars[s1].start, stars[s1].end, stars[s2].start, stars[s2].end))
+            {
+                stars[s1].isValid = false;
+                stars[s2].isValid = false;
+            }
+        }
+    }
+}
+
 // Returns true if two rectangular boxes (b1, b2) overlap.
 bool FocusFWHM::boxOverlap(const QPair<int, int> b1Start, const QPair<int, int> b1End, const QPair<int, int> b2Start,
                            const QPair<int, int> b2End)
@@ -7,6 +7,8 @@
 #pragma once
 
 #include <QList>
+#include <QtConcurrent>
+#include <gsl/gsl_errno.h>
 #include "../fitsviewer/fitsstardetector.h"
 #include "fitsviewer/fitsview.h"
 #include "fitsviewer/fitsdata.h"
@@ -27,11 +29,25 @@ class FocusFWHM
         FocusFWHM(Mathematics::RobustStatistics::ScaleCalculation scaleCalc);
         ~FocusFWHM();
 
+        // Structure to hold parameters for box around a star for FWHM calcs
+        struct StarBox
+        {
+            int star;
+            bool isValid;
+            QPair<int, int> start; // top left of box. x = first element, y = second element
+            QPair<int, int> end; // bottom right of box. x = first element, y = second element
+        };
+
+        // Marks as invalid the stars whose box overlaps the box of an earlier valid star, and that star.
+        static void excludeOverlappingStars(QVector<StarBox> &stars, int width, int height);
+
+        // Returns true if two rectangular boxes (b1, b2) overlap.
+        static bool boxOverlap(const QPair<int, int> b1Start, const QPair<int, int> b1End, const QPair<int, int> b2Start,
+                               const QPair<int, int> b2End);
+
         template <typename T>
-        void processFWHM(const T imageBuffer, const QSharedPointer<FITSData> &imageData, std::unique_ptr<CurveFitting> &starFitting,
-                         double *FWHM, double *weight)
+        void processFWHM(const T imageBuffer, const QSharedPointer<FITSData> &imageData, double *FWHM, double *weight)
         {
-            CurveFitting::StarParams starParams, starParams2;
             std::vector<double> FWHMs, R2s;
 
             auto focusStars = imageData->getStarCenters();
@@ -74,61 +90,70 @@ class FocusFWHM
 
             // Ideally we would deblend where another star encroaches into this star's box
             // For now we'll just exclude stars in this situation by marking isValid as false
-            for (int s1 = 0; s1 < stars.size(); s1++)
-            {
-                if (!stars[s1].isValid)
-                    continue;
+            excludeOverlappingStars(stars, stats.width, stats.height);
 
-                for (int s2 = s1 + 1; s2 < stars.size(); s2++)
-                {
-                    if (!stars[s2].isValid)
-                        continue;
-
-                    if (boxOverlap(stars[s1].start, stars[s1].end, stars[s2].start, stars[s2].end))
-                    {
-                        stars[s1].isValid = false;
-                        stars[s2].isValid = false;
-                    }
-                }
-            }
-
-            // We have the list of stars to process now so iterate through the list fitting a curve, etc
+            // We have the list of stars to process now so fit a curve to each of them. The fits are independent
+            // so they run concurrently, each with its own CurveFitting, and are gathered in star order afterwards.
+            struct StarFit
+            {
+                int box;
+                CurveFitting::StarParams starParams;
+                bool solved;
+                double R2;
+            };
+            QVector<StarFit> fits;
             for (int s = 0; s < stars.size(); s++)
             {
-                if (!stars[s].isValid)
-                    continue;
+                if (stars[s].isValid)
+                    fits.push_back({s, CurveFitting::StarParams(), false, 0.0});
+            }
 
+            auto fitStar = [&](StarFit & fit)
+            {
+                const StarBox &box = stars[fit.box];
+                CurveFitting::StarParams starParams;
                 starParams.background = skyBackground.mean;
-                starParams.peak = focusStars[stars[s].star]->val;
-                starParams.centroid_x = focusStars[stars[s].star]->x - stars[s].start.first;
-                starParams.centroid_y = focusStars[stars[s].star]->y - stars[s].start.second;
-                starParams.HFR = focusStars[stars[s].star]->HFR;
+                starParams.peak = focusStars[box.star]->val;
+                starParams.centroid_x = focusStars[box.star]->x - box.start.first;
+                starParams.centroid_y = focusStars[box.star]->y - box.start.second;
+                starParams.HFR = focusStars[box.star]->HFR;
                 starParams.theta = 0.0;
                 starParams.FWHMx = -1;
                 starParams.FWHMy = -1;
                 starParams.FWHM = -1;
 
-                starFitting->fitCurve3D(imageBuffer, stats.width, stars[s].start, stars[s].end, starParams, CurveFitting::FOCUS_GAUSSIAN,
-                                        false);
-                if (starFitting->getStarParams(CurveFitting::FOCUS_GAUSSIAN, &starParams2))
+                CurveFitting starFitting;
+                starFitting.fitCurve3D(imageBuffer, stats.width, box.start, box.end, starParams, CurveFitting::FOCUS_GAUSSIAN, false);
+                fit.solved = starFitting.getStarParams(CurveFitting::FOCUS_GAUSSIAN, &fit.starParams);
+                if (fit.solved)
                 {
-                    starParams2.centroid_x += stars[s].start.first;
-                    starParams2.centroid_y += stars[s].start.second;
-                    double R2 = starFitting->calculateR2(CurveFitting::FOCUS_GAUSSIAN);
-                    if (R2 >= 0.25)
-                    {
-                        // Filter stars - 0.25 works OK on Sim
-                        FWHMs.push_back(starParams2.FWHM);
-                        R2s.push_back(R2);
-
-                        qCDebug(KSTARS_EKOS_FOCUS) << "Star" << s << " R2=" << R2
-                                                   << " x=" << focusStars[s]->x << " vs " << starParams2.centroid_x
-                                                   << " y=" << focusStars[s]->y << " vs " << starParams2.centroid_y
-                                                   << " HFR=" << focusStars[s]->HFR << " FWHM=" << starParams2.FWHM
-                                                   << " Background=" << skyBackground.mean << " vs " << starParams2.background
-                                                   << " Peak=" << focusStars[s]->val << "vs" << starParams2.peak;
-                    }
+                    fit.starParams.centroid_x += box.start.first;
+                    fit.starParams.centroid_y += box.start.second;
+                    fit.R2 = starFitting.calculateR2(CurveFitting::FOCUS_GAUSSIAN);
                 }
+            };
+
+            // The gsl error handler is global, so turn it off here rather than have the fits toggle it concurrently
+            auto const oldErrorHandler = gsl_set_error_handler_off();
+            QtConcurrent::blockingMap(fits, fitStar);
+            gsl_set_error_handler(oldErrorHandler);
+
+            for (const auto &fit : fits)
+            {
+                // Filter stars - 0.25 works OK on Sim
+                if (!fit.solved || fit.R2 < 0.25)
+                    continue;
+
+                FWHMs.push_back(fit.starParams.FWHM);
+                R2s.push_back(fit.R2);
+
+                const auto &focusStar = focusStars[stars[fit.box].star];
+                qCDebug(KSTARS_EKOS_FOCUS) << "Star" << fit.box << " R2=" << fit.R2
+                                           << " x=" << focusStar->x << " vs " << fit.starParams.centroid_x
+                                           << " y=" << focusStar->y << " vs " << fit.starParams.centroid_y
+                                           << " HFR=" << focusStar->HFR << " FWHM=" << fit.starParams.FWHM
+                                           << " Background=" << skyBackground.mean << " vs " << fit.starParams.background
+                                           << " Peak=" << focusStar->val << "vs" << fit.starParams.peak;
             }
 
             if (FWHMs.size() == 0)
@@ -164,18 +189,6 @@ class FocusFWHM
 
     private:
 
-        bool boxOverlap(const QPair<int, int> b1Start, const QPair<int, int> b1End, const QPair<int, int> b2Start,
-                        const QPair<int, int> b2End);
-
-        // Structure to hold parameters for box around a star for FWHM calcs
-        struct StarBox
-        {
-            int star;
-            bool isValid;
-            QPair<int, int> start; // top left of box. x = first element, y = second element
-            QPair<int, int> end; // bottom right of box. x = first element, y = second element
-        };
-
         Mathematics::RobustStatistics::ScaleCalculation m_ScaleCalc;
 };
 }
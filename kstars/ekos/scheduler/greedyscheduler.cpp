@@ -13,6 +13,8 @@
 #include "ekos/ekos.h"
 #include "ui_scheduler.h"
 
+#include <QtConcurrent>
+
 #define TEST_PRINT if (false) fprintf
 
 // Can make the scheduling a bit faster by sampling every other minute instead of every minute.
@@ -268,6 +270,49 @@ QDateTime firstPossibleStart(SchedulerJob *job, const QDateTime &now,
 }
 }  // namespace
 
+QDateTime GreedyScheduler::nextPossibleStartTime(SchedulerJob *job, const QDateTime &now, SchedulerJob *currentJob) const
+{
+    // If the job state is abort or error, might have to delay the first possible start time.
+    QDateTime startSearchingtAt = firstPossibleStart(
+                                      job, now, rescheduleAbortsQueue, abortDelaySeconds, rescheduleErrors, errorDelaySeconds);
+
+    // I found that passing in an "until" 4th argument actually hurt performance, as it reduces
+    // the effectiveness of the cache that getNextPossibleStartTime uses.
+    return job->getNextPossibleStartTime(startSearchingtAt, SCHEDULE_RESOLUTION_MINUTES,
+                                         currentJob && (job == currentJob));
+}
+
+QHash<SchedulerJob *, QDateTime> GreedyScheduler::findStartTimes(const QList<SchedulerJob *> &jobs,
+        const QDateTime &now, SchedulerJob *currentJob) const
+{
+    QHash<SchedulerJob *, QDateTime> startTimes;
+    if (!Options::schedulerParallelEvaluation())
+        return startTimes;
+
+    struct Evaluation
+    {
+        SchedulerJob *job;
+        QDateTime startTime;
+    };
+    QVector<Evaluation> evaluations;
+    for (auto job : jobs)
+        if (allowJob(job, rescheduleAbortsImmediate, rescheduleAbortsQueue, rescheduleErrors))
+            evaluations.append({job, QDateTime()});
+    if (evaluations.size() < 2)
+        return startTimes;
+
+    // Each job only updates its own caches, the data shared by the jobs is computed beforehand or locked.
+    SchedulerJob::prepareConcurrentEvaluation();
+    QtConcurrent::blockingMap(evaluations, [&](Evaluation & evaluation)
+    {
+        evaluation.startTime = nextPossibleStartTime(evaluation.job, now, currentJob);
+    });
+
+    for (const auto &evaluation : evaluations)
+        startTimes[evaluation.job] = evaluation.startTime;
+    return startTimes;
+}
+
 // Consider all jobs marked as JOB_EVALUATION/ABORT/ERROR. Assume ordered by highest priority first.
 // - Find the job with the earliest start time (given constraints like altitude, twilight, ...)
 //   that can run for at least 10 minutes before a higher priority job.
@@ -296,6 +341,15 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
     SchedulerJob *nextJob = nullptr;
     QString interruptStr;
 
+    // The start times of the jobs may have been computed concurrently, the jobs are then
+    // selected in priority order exactly as if they were computed one after the other.
+    const QHash<SchedulerJob *, QDateTime> startTimes = findStartTimes(jobs, now, currentJob);
+    auto startTimeOf = [&](SchedulerJob * job)
+    {
+        const auto startTime = startTimes.constFind(job);
+        return startTime != startTimes.constEnd() ? startTime.value() : nextPossibleStartTime(job, now, currentJob);
+    };
+
     for (int i = 0; i < jobs.size(); ++i)
     {
         SchedulerJob *job = jobs[i];
@@ -304,15 +358,8 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
         if (!allowJob(job, rescheduleAbortsImmediate, rescheduleAbortsQueue, rescheduleErrors))
             continue;
 
-        // If the job state is abort or error, might have to delay the first possible start time.
-        QDateTime startSearchingtAt = firstPossibleStart(
-                                          job, now, rescheduleAbortsQueue, abortDelaySeconds, rescheduleErrors, errorDelaySeconds);
-
         // Find the first time this job can meet all its constraints.
-        // I found that passing in an "until" 4th argument actually hurt performance, as it reduces
-        // the effectiveness of the cache that getNextPossibleStartTime uses.
-        const QDateTime startTime = job->getNextPossibleStartTime(startSearchingtAt, SCHEDULE_RESOLUTION_MINUTES,
-                                    evaluatingCurrentJob);
+        const QDateTime startTime = startTimeOf(job);
         if (startTime.isValid())
         {
             if (nextJob == nullptr)
@@ -376,14 +423,9 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
             {
                 if (!allowJob(atJob, rescheduleAbortsImmediate, rescheduleAbortsQueue, rescheduleErrors))
                     continue;
-                // If the job state is abort or error, might have to delay the first possible start time.
-                QDateTime startSearchingtAt = firstPossibleStart(
-                                                  atJob, now, rescheduleAbortsQueue, abortDelaySeconds, rescheduleErrors,
-                                                  errorDelaySeconds);
                 // atTime above is the user-specified start time. atJobStartTime is the time it can
                 // actually start, given all the constraints (altitude, twilight, etc).
-                const QDateTime atJobStartTime = atJob->getNextPossibleStartTime(startSearchingtAt, SCHEDULE_RESOLUTION_MINUTES, currentJob
-                                                 && (atJob == currentJob));
+                const QDateTime atJobStartTime = startTimeOf(atJob);
                 if (atJobStartTime.isValid())
                 {
                     // This difference between the user-specified start time, and the time it can really start.
@@ -446,13 +488,8 @@ SchedulerJob *GreedyScheduler::selectNextJob(const QList<SchedulerJob *> &jobs,
 
                 const bool evaluatingCurrentJob = (currentJob && (job == currentJob));
 
-                // If the job state is abort or error, might have to delay the first possible start time.
-                QDateTime startSearchingtAt = firstPossibleStart(
-                                                  job, now, rescheduleAbortsQueue, abortDelaySeconds, rescheduleErrors, errorDelaySeconds);
-
                 // Find the first time this job can meet all its constraints.
-                const QDateTime startTime = job->getNextPossibleStartTime(startSearchingtAt, SCHEDULE_RESOLUTION_MINUTES,
-                                            evaluatingCurrentJob);
+                const QDateTime startTime = startTimeOf(job);
 
                 // Only consider jobs that can start soon.
                 if (!startTime.isValid() || startTime.secsTo(nextStart) > MAX_INTERRUPT_SECS)
@@ -9,6 +9,7 @@
 #include <QList>
 #include <QMap>
 #include <QDateTime>
+#include <QHash>
 #include <QString>
 #include <QVector>
 #include "schedulerjob.h"
@@ -145,6 +146,15 @@ class GreedyScheduler : public QObject
             SIMULATE_EACH_JOB_ONCE
         } SimulationType;
 
+        // Returns the first time the job can meet all its constraints, from now or the end of its
+        // abort or error delay.
+        QDateTime nextPossibleStartTime(SchedulerJob *job, const QDateTime &now, SchedulerJob *currentJob) const;
+
+        // If the SchedulerParallelEvaluation option is set, computes nextPossibleStartTime() of all the
+        // jobs allowed to run concurrently. Otherwise, returns an empty hash.
+        QHash<SchedulerJob *, QDateTime> findStartTimes(const QList<SchedulerJob *> &jobs, const QDateTime &now,
+                SchedulerJob *currentJob) const;
+
         // If currentJob is nullptr, this is used to find the next job
         // to schedule. It returns a pointer to a job in jobs, or nullptr.
         // If currentJob is a pointer to a job in jobs, then it will return
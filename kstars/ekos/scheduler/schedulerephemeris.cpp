@@ -0,0 +1,107 @@
+/*  Ekos Scheduler Ephemeris
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "schedulerephemeris.h"
+
+#include "geolocation.h"
+#include "ksmoon.h"
+#include "ksnumbers.h"
+
+#include <QList>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// The Moon moves by about 0.1 degree in 10 minutes, interpolating linearly in between is well
+// below the precision of the separation constraints.
+constexpr qint64 MOON_SAMPLING_STEP = 10 * 60;
+constexpr int MAX_NIGHTS = 3;
+
+struct Night
+{
+    QDateTime start;
+    double latitude;
+    double longitude;
+    QVector<SchedulerEphemeris::MoonPosition> moon;
+};
+
+QList<Night> nights;
+
+// Called with SchedulerEphemeris::planetsMutex() held
+const Night &findNight(const KSMoon *moon, const GeoLocation *geo, const KStarsDateTime &ltWhen)
+{
+    // Nights go from a local noon to two days later, so that the searches of the scheduler,
+    // which look at most 24 hours ahead, stay within a night.
+    QDateTime noon = ltWhen;
+    noon.setTime(QTime(12, 0));
+    if (ltWhen < noon)
+        noon = noon.addDays(-1);
+
+    for (const auto &night : nights)
+        if (night.start == noon && night.latitude == geo->lat()->Degrees() && night.longitude == geo->lng()->Degrees())
+            return night;
+
+    Night night;
+    night.start = noon;
+    night.latitude = geo->lat()->Degrees();
+    night.longitude = geo->lng()->Degrees();
+
+    // Sampling the Moon of the sky map would move it to each sample time
+    KSMoon sampledMoon(*moon);
+
+    // An extra hour in case of a daylight saving time change
+    const qint64 span = noon.secsTo(noon.addDays(2)) + 3600;
+    night.moon.reserve(span / MOON_SAMPLING_STEP + 2);
+    for (qint64 t = 0; t <= span + MOON_SAMPLING_STEP; t += MOON_SAMPLING_STEP)
+    {
+        const KStarsDateTime ltSample(noon.addSecs(t));
+        KSNumbers numbers(ltSample.djd());
+        CachingDms LST = geo->GSTtoLST(geo->LTtoUT(ltSample).gst());
+        sampledMoon.updateCoords(&numbers, true, geo->lat(), &LST, true);
+        night.moon.append({ sampledMoon.ra().Degrees(), sampledMoon.dec().Degrees(), sampledMoon.illum() });
+    }
+
+    if (nights.size() >= MAX_NIGHTS)
+        nights.removeFirst();
+    nights.append(night);
+    return nights.last();
+}
+}
+
+SchedulerEphemeris::MoonPosition SchedulerEphemeris::moonPosition(KSMoon *moon, const GeoLocation *geo,
+        const KStarsDateTime &ltWhen)
+{
+    const std::lock_guard<std::mutex> lock(planetsMutex());
+    const Night &night = findNight(moon, geo, ltWhen);
+
+    const double t = night.start.msecsTo(ltWhen) / 1000.0 / MOON_SAMPLING_STEP;
+    const int i = std::max(0, std::min(static_cast<int>(std::floor(t)), night.moon.size() - 2));
+    const double f = t - i;
+    const MoonPosition &a = night.moon[i];
+    const MoonPosition &b = night.moon[i + 1];
+
+    // Right ascension wraps around at 360 degrees
+    double deltaRA = b.ra - a.ra;
+    if (deltaRA > 180)
+        deltaRA -= 360;
+    else if (deltaRA < -180)
+        deltaRA += 360;
+
+    MoonPosition position;
+    position.ra = std::fmod(a.ra + f * deltaRA + 360.0, 360.0);
+    position.dec = a.dec + f * (b.dec - a.dec);
+    position.illumination = a.illumination + f * (b.illumination - a.illumination);
+    return position;
+}
+
+std::mutex &SchedulerEphemeris::planetsMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
@@ -0,0 +1,54 @@
+/*  Ekos Scheduler Ephemeris
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "kstarsdatetime.h"
+
+#include <mutex>
+
+class GeoLocation;
+class KSMoon;
+
+/**
+ * @class SchedulerEphemeris
+ * @short Positions of the Moon over the nights being scheduled, shared by all the scheduler jobs.
+ *
+ * Each job with a Moon separation constraint needs the position of the Moon at the same times, and
+ * computing it is expensive. The position is computed every 10 minutes over the two days following
+ * a local noon, once for all the jobs, and interpolated in between. The dawn and dusk times are shared
+ * the same way by SchedulerJob::calculateDawnDusk().
+ *
+ * The cache may be used by jobs evaluated in several threads. The positions are computed with a private
+ * copy of the Moon, so the Moon shown in the sky map is left untouched.
+ */
+class SchedulerEphemeris
+{
+    public:
+        struct MoonPosition
+        {
+            /// Apparent topocentric coordinates, in degrees
+            double ra { 0 };
+            double dec { 0 };
+            /// Illuminated fraction, between 0 and 1
+            double illumination { 0 };
+        };
+
+        /**
+             * @brief moonPosition get the position of the Moon at a local time.
+             * @param moon the Moon to compute the positions of the night with, if they are not cached yet.
+             * @param geo the location of the observer.
+             * @param ltWhen the local time.
+             */
+        static MoonPosition moonPosition(KSMoon *moon, const GeoLocation *geo, const KStarsDateTime &ltWhen);
+
+        /**
+             * @brief planetsMutex lock to hold while updating solar system bodies for the scheduler.
+             * KSPlanetBase::updateCoords() moves the global Earth to the time being computed, so the Moon
+             * positions above and the almanacs of SchedulerJob::calculateDawnDusk() are computed one at a time.
+             */
+        static std::mutex &planetsMutex();
+};
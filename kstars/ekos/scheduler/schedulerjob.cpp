@@ -12,12 +12,17 @@
 #include "skymapcomposite.h"
 #include "Options.h"
 #include "scheduler.h"
+#include "schedulerephemeris.h"
 #include "ksalmanac.h"
 
 #include <knotification.h>
 
 #include <QTableWidgetItem>
 
+#include <cmath>
+#include <functional>
+#include <mutex>
+
 #include <ekos_scheduler_debug.h>
 
 #define BAD_SCORE -1000
@@ -200,6 +205,18 @@ ArtificialHorizon const *SchedulerJob::getHorizon()
     return &KStarsData::Instance()->skyComposite()->artificialHorizon()->getHorizon();
 }
 
+void SchedulerJob::prepareConcurrentEvaluation()
+{
+    // The artificial horizon precomputes its constraints on first use
+    if (getHorizon() != nullptr)
+        getHorizon()->altitudeConstraint(0);
+
+    // Updating coordinates may look the Sun up on first use
+    SkyObject o;
+    KSNumbers numbers(getLocalTime().djd());
+    o.updateCoordsNow(&numbers);
+}
+
 void SchedulerJob::setStartupCondition(const StartupCondition &value)
 {
     startupCondition = value;
@@ -882,25 +899,31 @@ int16_t SchedulerJob::getMoonSeparationScore(QDateTime const &when) const
     KSNumbers numbers(ltWhen.djd());
     o.updateCoordsNow(&numbers);
 
-    // Update moon
-    //ut = getGeo()->LTtoUT(ltWhen);
-    //KSNumbers ksnum(ut.djd()); // BUG: possibly LT.djd() != UT.djd() because of translation
-    //LST = getGeo()->GSTtoLST(ut.gst());
-    CachingDms LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
-    moon->updateCoords(&numbers, true, getGeo()->lat(), &LST, true);
+    return getMoonSeparationScore(o, ltWhen);
+}
+
+int16_t SchedulerJob::getMoonSeparationScore(SkyPoint const &target, KStarsDateTime const &ltWhen) const
+{
+    if (moon == nullptr) return 100;
+
+    // The Moon is interpolated from positions shared by all jobs, instead of updating it for each job
+    SchedulerEphemeris::MoonPosition const position = SchedulerEphemeris::moonPosition(moon, getGeo(), ltWhen);
+    SkyPoint moonPosition(dms(position.ra), dms(position.dec));
+    CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
+    moonPosition.EquatorialToHorizontal(&LST, getGeo()->lat());
 
-    double const moonAltitude = moon->alt().Degrees();
+    double const moonAltitude = moonPosition.alt().Degrees();
 
     // Lunar illumination %
-    double const illum = moon->illum() * 100.0;
+    double const illum = position.illumination * 100.0;
 
     // Moon/Sky separation p
-    double const separation = moon->angularDistanceTo(&o).Degrees();
+    double const separation = moonPosition.angularDistanceTo(&target).Degrees();
 
     // Zenith distance of the moon
     double const zMoon = (90 - moonAltitude);
     // Zenith distance of target
-    double const zTarget = (90 - o.alt().Degrees());
+    double const zTarget = (90 - target.alt().Degrees());
 
     int16_t score = 0;
 
@@ -968,113 +991,282 @@ double SchedulerJob::getCurrentMoonSeparation() const
     return moon->angularDistanceTo(&o).Degrees();
 }
 
-QDateTime SchedulerJob::calculateNextTime(QDateTime const &when, bool checkIfConstraintsAreMet, int increment,
-        QString *reason, bool runningJob, const QDateTime &until) const
+namespace
 {
-    // FIXME: block calculating target coordinates at a particular time is duplicated in several places
+// Steps at which the constraints are sampled before bisecting their changes, in seconds.
+// The altitude of a target changes by a quarter of a degree per minute at most, the Moon and
+// its separation to a target by a few degrees in a quarter of an hour.
+constexpr qint64 ALTITUDE_SAMPLING_STEP = 60;
+constexpr qint64 MOON_SAMPLING_STEP = 15 * 60;
 
-    // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
-    KStarsDateTime ltWhen(when.isValid() ?
-                          Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
-                          getLocalTime());
+typedef QVector<QPair<qint64, qint64>> Intervals;
 
-    // Create a sky object with the target catalog coordinates
-    SkyPoint const target = getTargetCoords();
-    SkyObject o;
-    o.setRA0(target.ra0());
-    o.setDec0(target.dec0());
+// The intervals of [0, span] during which isMet is true, sampled every step seconds.
+Intervals findIntervals(qint64 span, qint64 step, const std::function<bool(qint64)> &isMet)
+{
+    Intervals intervals;
+    bool previous = isMet(0);
+    qint64 start = 0;
 
-    // Calculate the UT at the argument time
-    KStarsDateTime const ut = getGeo()->LTtoUT(ltWhen);
+    for (qint64 t = 0; t < span; )
+    {
+        qint64 const next = std::min(t + step, span);
+        bool const current = isMet(next);
+        if (current != previous)
+        {
+            // Bisect the change down to the second
+            qint64 low = t, high = next;
+            while (high - low > 1)
+            {
+                qint64 const middle = (low + high) / 2;
+                if (isMet(middle) == previous)
+                    low = middle;
+                else
+                    high = middle;
+            }
 
-    double const SETTING_ALTITUDE_CUTOFF = Options::settingAltitudeCutoff();
+            if (current)
+                start = high;
+            else
+                intervals.append(qMakePair(start, high));
+            previous = current;
+        }
+        t = next;
+    }
 
-    auto maxMinute = 1e8;
-    if (!runningJob && until.isValid())
-        maxMinute = when.secsTo(until) / 60;
+    if (previous)
+        intervals.append(qMakePair(start, span + 1));
 
-    if (maxMinute > 24 * 60)
-        maxMinute = 24 * 60;
+    return intervals;
+}
 
-    // Within the next 24 hours, search when the job target matches the altitude and moon constraints
-    for (unsigned int minute = 0; minute < maxMinute; minute += increment)
+Intervals intersectIntervals(const Intervals &a, const Intervals &b)
+{
+    Intervals intervals;
+    for (int i = 0, j = 0; i < a.size() && j < b.size(); )
     {
-        KStarsDateTime const ltOffset(ltWhen.addSecs(minute * 60));
+        qint64 const first = std::max(a[i].first, b[j].first);
+        qint64 const second = std::min(a[i].second, b[j].second);
+        if (first < second)
+            intervals.append(qMakePair(first, second));
+
+        if (a[i].second < b[j].second)
+            i++;
+        else
+            j++;
+    }
+    return intervals;
+}
+
+bool intervalsContain(const Intervals &intervals, qint64 t)
+{
+    for (const auto &interval : intervals)
+        if (interval.first <= t && t < interval.second)
+            return true;
+    return false;
+}
+
+// Seconds from one local time to another on the wall clock, as KStarsDateTime::addSecs() and the
+// geolocation count them, rather than QDateTime::secsTo() which follows the daylight saving time
+// changes of the system time zone.
+qint64 wallClockSecsTo(const KStarsDateTime &from, const KStarsDateTime &to)
+{
+    return std::llround(static_cast<double>(to.djd() - from.djd()) * 86400.0);
+}
+
+// Smallest integer not less than a / b, for a positive b.
+qint64 divideRoundingUp(qint64 a, qint64 b)
+{
+    return a <= 0 ? -(-a / b) : (a + b - 1) / b;
+}
+
+// Set the horizontal coordinates of the target at t seconds from startLST, return whether it is setting.
+bool updateHorizontalCoords(SkyPoint &target, double startLST, qint64 t, const dms *latitude)
+{
+    CachingDms const LST(std::fmod(startLST + t * SIDEREALSECOND * 15.0 / 3600.0, 360.0));
+    target.EquatorialToHorizontal(&LST, latitude);
 
-        // Is this violating twilight?
-        QDateTime nextSuccess;
-        if (getEnforceTwilight() && !runsDuringAstronomicalNightTime(ltOffset, &nextSuccess))
+    // Hours are reduced to [0,24[, meridian being at 0
+    double offset = LST.Hours() - target.ra().Hours();
+    if (24.0 <= offset)
+        offset -= 24.0;
+    else if (offset < 0.0)
+        offset += 24.0;
+    return 0.0 <= offset && offset < 12.0;
+}
+}
+
+const SchedulerJob::ConstraintWindows &SchedulerJob::getConstraintWindows(const QDateTime &when) const
+{
+    // The windows cover the two days from the local noon before the argument time, so that the
+    // searches of calculateNextTime, up to 24 hours ahead, over a whole night use the same windows.
+    QDateTime noon = when;
+    noon.setTime(QTime(12, 0));
+    if (when < noon)
+        noon = noon.addDays(-1);
+
+    QString const key = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13 %14 %15 %16")
+                        .arg(getTargetCoords().ra0().Degrees()).arg(getTargetCoords().dec0().Degrees())
+                        .arg(getMinAltitude()).arg(getMinMoonSeparation())
+                        .arg(getEnforceTwilight() ? 1 : 0).arg(enforceArtificialHorizon ? 1 : 0)
+                        .arg(reinterpret_cast<quintptr>(getHorizon()))
+                        .arg(getGeo()->lat()->Degrees()).arg(getGeo()->lng()->Degrees())
+                        .arg(Options::enableAltitudeLimits() ? 1 : 0)
+                        .arg(Options::minimumAltLimit()).arg(Options::maximumAltLimit())
+                        .arg(Options::settingAltitudeCutoff()).arg(Options::preDawnTime())
+                        .arg(Options::dawnOffset()).arg(Options::duskOffset());
+
+    for (const auto &cached : constraintWindowsCache)
+        if (cached.start == noon && cached.key == key)
+            return cached;
+
+    // Times are counted on the wall clock like the geolocation does, so that they do not
+    // jump an hour on a daylight saving time change.
+    KStarsDateTime const ltNoon(noon);
+
+    ConstraintWindows windows;
+    windows.start = noon;
+    windows.key = key;
+    // An extra hour of margin for the last search steps
+    windows.span = 2 * 24 * 3600 + 3600;
+
+    // Twilight: from dusk to dawn, walking the dawn and dusk events
+    if (getEnforceTwilight())
+    {
+        for (qint64 t = 0; t <= windows.span; )
         {
-            if (checkIfConstraintsAreMet)
+            QDateTime minDawnDusk, nextSuccess;
+            if (runsDuringAstronomicalNightTimeInternal(ltNoon.addSecs(t), &minDawnDusk, &nextSuccess))
             {
-                // Change the minute to increment-minutes before next success.
-                if (nextSuccess.isValid())
-                {
-                    const int minutesToSuccess = ltOffset.secsTo(nextSuccess) / 60 - increment;
-                    if (minutesToSuccess > 0)
-                        minute += minutesToSuccess;
-                }
-                continue;
+                // Night lasts until the early dawn included
+                qint64 const end = std::max(t + 1, std::min(wallClockSecsTo(ltNoon, KStarsDateTime(minDawnDusk)) + 1,
+                                            windows.span + 1));
+                windows.twilight.append(qMakePair(t, end));
+                t = end;
             }
+            else if (nextSuccess.isValid())
+                t = std::max(t + 1, wallClockSecsTo(ltNoon, KStarsDateTime(nextSuccess)));
             else
-            {
-                if (reason) *reason = "twilight";
-                return ltOffset;
-            }
+                break;
         }
+    }
+    else windows.twilight.append(qMakePair(qint64(0), windows.span + 1));
+
+    // Altitude: the apparent coordinates of the target hardly change over two days, only the
+    // local sidereal time changes.
+    SkyObject o;
+    o.setRA0(getTargetCoords().ra0());
+    o.setDec0(getTargetCoords().dec0());
+    KSNumbers numbers(ltNoon.addSecs(24 * 3600).djd());
+    o.updateCoordsNow(&numbers);
+    windows.target = o;
+    windows.startLST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltNoon).gst()).Degrees();
 
-        // Update RA/DEC of the target for the current fraction of the day
-        KSNumbers numbers(ltOffset.djd());
-        o.updateCoordsNow(&numbers);
+    SkyPoint target = windows.target;
+    double const SETTING_ALTITUDE_CUTOFF = Options::settingAltitudeCutoff();
+
+    windows.altitude = findIntervals(windows.span, ALTITUDE_SAMPLING_STEP, [&](qint64 t)
+    {
+        updateHorizontalCoords(target, windows.startLST, t, getGeo()->lat());
+        return satisfiesAltitudeConstraint(target.az().Degrees(), target.alt().Degrees());
+    });
 
-        // Compute local sidereal time for the current fraction of the day, calculate altitude
-        CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltOffset).gst());
-        o.EquatorialToHorizontal(&LST, getGeo()->lat());
-        double const altitude = o.alt().Degrees();
-        double const azimuth = o.az().Degrees();
+    // Jobs do not start on a setting target under the cutoff
+    Intervals const aboveCutoff = findIntervals(windows.span, ALTITUDE_SAMPLING_STEP, [&](qint64 t)
+    {
+        if (!updateHorizontalCoords(target, windows.startLST, t, getGeo()->lat()))
+            return true;
+        return satisfiesAltitudeConstraint(target.az().Degrees(), target.alt().Degrees() - SETTING_ALTITUDE_CUTOFF);
+    });
 
-        bool const altitudeOK = satisfiesAltitudeConstraint(azimuth, altitude, reason);
-        if (altitudeOK)
+    if (0 < getMinMoonSeparation())
+    {
+        windows.moon = findIntervals(windows.span, MOON_SAMPLING_STEP, [&](qint64 t)
         {
-            // Don't test proximity to dawn in this situation, we only cater for altitude here
+            return 0 <= getMoonSeparationScore(windows.target, ltNoon.addSecs(t));
+        });
+    }
+    else windows.moon.append(qMakePair(qint64(0), windows.span + 1));
 
-            // Continue searching if Moon separation is not good enough
-            if (0 < getMinMoonSeparation() && getMoonSeparationScore(ltOffset) < 0)
-            {
-                if (checkIfConstraintsAreMet)
-                    continue;
-                else
-                {
-                    if (reason) *reason = QString("moon separation");
-                    return ltOffset;
-                }
-            }
+    windows.met = intersectIntervals(intersectIntervals(windows.twilight, windows.altitude), windows.moon);
+    windows.startable = intersectIntervals(windows.met, aboveCutoff);
 
-            // Continue searching if target is setting and under the cutoff
-            if (checkIfConstraintsAreMet)
-            {
-                if (!runningJob)
-                {
-                    double offset = LST.Hours() - o.ra().Hours();
-                    if (24.0 <= offset)
-                        offset -= 24.0;
-                    else if (offset < 0.0)
-                        offset += 24.0;
-                    if (0.0 <= offset && offset < 12.0)
-                    {
-                        bool const settingAltitudeOK = satisfiesAltitudeConstraint(azimuth, altitude - SETTING_ALTITUDE_CUTOFF);
-                        if (!settingAltitudeOK)
-                            continue;
-                    }
-                }
-                return ltOffset;
-            }
+    // The scheduler searches one night at a time, keep the previous one around while it moves to the next.
+    if (constraintWindowsCache.size() > 1)
+        constraintWindowsCache.removeFirst();
+    constraintWindowsCache.append(windows);
+    return constraintWindowsCache.last();
+}
+
+QDateTime SchedulerJob::calculateNextTime(QDateTime const &when, bool checkIfConstraintsAreMet, int increment,
+        QString *reason, bool runningJob, const QDateTime &until) const
+{
+    // Retrieve the argument date/time, or fall back to current time - don't use QDateTime's timezone!
+    KStarsDateTime ltWhen(when.isValid() ?
+                          Qt::UTC == when.timeSpec() ? getGeo()->UTtoLT(KStarsDateTime(when)) : when :
+                          getLocalTime());
+
+    auto maxMinute = 1e8;
+    if (!runningJob && until.isValid())
+        maxMinute = when.secsTo(until) / 60;
+
+    if (maxMinute > 24 * 60)
+        maxMinute = 24 * 60;
+
+    // Within the next 24 hours, search the minutes, every increment minutes, at which the job target
+    // matches the twilight, altitude and moon constraints, or not.
+    increment = std::max(1, increment);
+    qint64 const step = increment * 60;
+    qint64 const steps = static_cast<qint64>(std::ceil(maxMinute / increment));
+    if (steps <= 0)
+        return QDateTime();
+
+    const ConstraintWindows &windows = getConstraintWindows(ltWhen);
+    qint64 const offset = wallClockSecsTo(KStarsDateTime(windows.start), ltWhen);
+
+    if (checkIfConstraintsAreMet)
+    {
+        // Running jobs are not interrupted by the setting cutoff
+        for (const auto &window : runningJob ? windows.met : windows.startable)
+        {
+            qint64 const first = std::max(qint64(0), divideRoundingUp(window.first - offset, step));
+            if (steps <= first)
+                break;
+            if (offset + first * step < window.second)
+                return ltWhen.addSecs(first * step);
         }
-        else if (!checkIfConstraintsAreMet)
-            return ltOffset;
+        return QDateTime();
     }
 
-    return QDateTime();
+    // Search the first minute out of the windows the constraints are met in
+    qint64 next = 0;
+    for (const auto &window : windows.met)
+    {
+        qint64 const t = offset + next * step;
+        if (window.second <= t)
+            continue;
+        if (t < window.first)
+            break;
+        next = divideRoundingUp(window.second - offset, step);
+    }
+    if (steps <= next)
+        return QDateTime();
+
+    qint64 const t = offset + next * step;
+    if (reason)
+    {
+        if (!intervalsContain(windows.twilight, t))
+            *reason = "twilight";
+        else if (intervalsContain(windows.altitude, t) && !intervalsContain(windows.moon, t))
+            *reason = QString("moon separation");
+        else
+        {
+            SkyPoint target = windows.target;
+            updateHorizontalCoords(target, windows.startLST, t, getGeo()->lat());
+            satisfiesAltitudeConstraint(target.az().Degrees(), target.alt().Degrees(), reason);
+        }
+    }
+    return ltWhen.addSecs(next * step);
 }
 
 double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when, bool * is_setting, bool debug)
@@ -1127,6 +1319,10 @@ double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when,
 
 void SchedulerJob::calculateDawnDusk(QDateTime const &when, QDateTime &nDawn, QDateTime &nDusk)
 {
+    // Jobs may be evaluated in several threads, which share the almanacs below. Computing an almanac
+    // updates the global Earth, as does sampling the Moon, hence the lock shared with SchedulerEphemeris.
+    const std::lock_guard<std::mutex> lock(SchedulerEphemeris::planetsMutex());
+
     QDateTime startup = when;
 
     if (!startup.isValid())
@@ -10,6 +10,8 @@
 
 #include <QUrl>
 #include <QMap>
+#include <QPair>
+#include <QVector>
 #include "ksmoon.h"
 #include "kstarsdatetime.h"
 #include <QJsonObject>
@@ -641,12 +643,49 @@ class SchedulerJob
             return(m_UpdateGraphics);
         }
 
-        // Clear the cache that keeps results for getNextPossibleStartTime().
+        /**
+             * @brief prepareConcurrentEvaluation compute the data shared by all jobs that are otherwise computed on first use,
+             * so that jobs can then be evaluated in several threads, see GreedyScheduler.
+             */
+        static void prepareConcurrentEvaluation();
+
+        // Clear the caches that keep results for getNextPossibleStartTime() and calculateNextTime().
         void clearCache()
         {
             startTimeCache.clear();
+            constraintWindowsCache.clear();
         }
     private:
+        // Intervals [first, second[ of seconds from the start of ConstraintWindows.
+        typedef QVector<QPair<qint64, qint64>> Intervals;
+
+        // The times during which each constraint of the job is met, over the two days following
+        // a local noon. The changes of the constraints are found by sampling, then bisection down
+        // to the second.
+        struct ConstraintWindows
+        {
+            // The local noon the intervals are counted from, and the number of seconds they cover
+            QDateTime start;
+            qint64 span { 0 };
+            // The job and option values the windows were computed with
+            QString key;
+            // Apparent coordinates of the target, and local sidereal time in degrees at start
+            SkyPoint target;
+            double startLST { 0 };
+            Intervals twilight, altitude, moon;
+            // Met: twilight, altitude and moon constraints. Startable: also above the setting cutoff.
+            Intervals met, startable;
+        };
+
+        /**
+             * @brief getConstraintWindows get the windows of the night of a time, computing them if not cached.
+             * @param when local time, from which calculateNextTime() searches ahead at most 24 hours.
+             */
+        const ConstraintWindows &getConstraintWindows(const QDateTime &when) const;
+
+        // Moon separation score of the apparent coordinates of the target.
+        int16_t getMoonSeparationScore(SkyPoint const &target, KStarsDateTime const &ltWhen) const;
+
         bool runsDuringAstronomicalNightTimeInternal(const QDateTime &time, QDateTime *minDawnDusk,
                 QDateTime *nextPossibleSuccess = nullptr) const;
 
@@ -803,6 +842,9 @@ class SchedulerJob
         };
         StartTimeCache startTimeCache;
 
+        // The windows of the last nights calculateNextTime() searched, see getConstraintWindows().
+        mutable QList<ConstraintWindows> constraintWindowsCache;
+
         // These are used in testing, instead of KStars::Instance() resources
         static KStarsDateTime *storedLocalTime;
         static GeoLocation *storedGeo;
@@ -0,0 +1,585 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "bayerdemosaic.h"
+#include "auxiliary/parallelbands.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+enum
+{
+    RED = 0,
+    GREEN = 1,
+    BLUE = 2
+};
+
+// Colour of the Bayer cell at (row & 1, column & 1)
+struct Pattern
+{
+    int color[2][2];
+
+    int at(int y, int x) const
+    {
+        return color[y & 1][x & 1];
+    }
+};
+
+bool makePattern(dc1394color_filter_t filter, int offsetY, Pattern &pattern)
+{
+    switch (filter)
+    {
+        case DC1394_COLOR_FILTER_RGGB:
+            pattern = {{{RED, GREEN}, {GREEN, BLUE}}};
+            break;
+        case DC1394_COLOR_FILTER_GBRG:
+            pattern = {{{GREEN, BLUE}, {RED, GREEN}}};
+            break;
+        case DC1394_COLOR_FILTER_GRBG:
+            pattern = {{{GREEN, RED}, {BLUE, GREEN}}};
+            break;
+        case DC1394_COLOR_FILTER_BGGR:
+            pattern = {{{BLUE, GREEN}, {GREEN, RED}}};
+            break;
+        default:
+            return false;
+    }
+
+    // With an odd Y offset the frame starts on the second row of the pattern
+    if (offsetY & 1)
+        std::swap(pattern.color[0], pattern.color[1]);
+
+    return true;
+}
+
+// Mirroring by two samples keeps the Bayer colour of coordinates just outside the frame
+inline int mirror(int i, int n)
+{
+    return i < 0 ? i + 2 : (i >= n ? i - 2 : i);
+}
+
+// Bilinear interpolation of a single pixel, mirroring the neighbours outside the frame
+template <typename T>
+void bilinearPixel(const T *bayer, int width, int height, const Pattern &pattern, int x, int y, T *const planes[3])
+{
+    int sum[3] = { 0, 0, 0 };
+    int count[3] = { 0, 0, 0 };
+
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            if (dx == 0 && dy == 0)
+                continue;
+            const int color = pattern.at(y + dy, x + dx);
+            sum[color] += bayer[mirror(y + dy, height) * width + mirror(x + dx, width)];
+            count[color]++;
+        }
+    }
+
+    const size_t index = static_cast<size_t>(y) * width + x;
+    const int own = pattern.at(y, x);
+    for (int color = 0; color < 3; color++)
+        planes[color][index] = (color == own) ? bayer[index] : static_cast<T>((sum[color] + count[color] / 2) / count[color]);
+}
+
+/*
+ * The row kernels below compute both kinds of sites of a row in a single branch-free loop, selecting
+ * the result with a mask so the compiler can vectorize them. Each row alternates green with one chroma
+ * colour, the rows above and below hold the other chroma colour.
+ */
+template <typename T>
+void bilinearKernel(const T *__restrict up, const T *__restrict row, const T *__restrict down, int first, int last,
+                    int greenParity, T *__restrict green, T *__restrict rowChroma, T *__restrict otherChroma)
+{
+    for (int x = first; x < last; x++)
+    {
+        // All bits set on green sites
+        const int isGreen = -static_cast<int>((x & 1) == greenParity);
+        const int center = row[x];
+        const int horizontal = row[x - 1] + row[x + 1];
+        const int vertical = up[x] + down[x];
+        const int diagonal = up[x - 1] + up[x + 1] + down[x - 1] + down[x + 1];
+        green[x] = (center & isGreen) | (((horizontal + vertical + 2) >> 2) & ~isGreen);
+        rowChroma[x] = (((horizontal + 1) >> 1) & isGreen) | (center & ~isGreen);
+        otherChroma[x] = (((vertical + 1) >> 1) & isGreen) | (((diagonal + 2) >> 2) & ~isGreen);
+    }
+}
+
+// Bilinear interpolation of the interior pixels of row y, i.e. all but the first and last one
+template <typename T>
+void bilinearRow(const T *bayer, int width, const Pattern &pattern, int y, T *const planes[3])
+{
+    const size_t offset = static_cast<size_t>(y) * width;
+    const T *row = bayer + offset;
+    const int greenParity = pattern.at(y, 0) == GREEN ? 0 : 1;
+    const int chroma = pattern.at(y, 1 - greenParity);
+
+    bilinearKernel(row - width, row, row + width, 1, width - 1, greenParity, planes[GREEN] + offset,
+                   planes[chroma] + offset, planes[BLUE - chroma] + offset);
+}
+
+// Each pixel takes its missing colours from the other samples of its 2x2 cell
+template <typename T>
+void nearestPixel(const T *row, const T *pair, int width, int x, int own, int rowChroma, T *const planes[3], size_t offset)
+{
+    const int partner = mirror(x ^ 1, width);
+    if (own == GREEN)
+    {
+        planes[GREEN][offset + x] = row[x];
+        planes[rowChroma][offset + x] = row[partner];
+        planes[BLUE - rowChroma][offset + x] = pair[x];
+    }
+    else
+    {
+        planes[own][offset + x] = row[x];
+        planes[GREEN][offset + x] = row[partner];
+        planes[BLUE - own][offset + x] = pair[partner];
+    }
+}
+
+template <typename T>
+void nearestKernel(const T *__restrict row, const T *__restrict pair, int first, int last, int greenParity,
+                   T *__restrict green, T *__restrict rowChroma, T *__restrict otherChroma)
+{
+    for (int x = first; x < last; x++)
+    {
+        const int isGreen = -static_cast<int>((x & 1) == greenParity);
+        const int isEven = -static_cast<int>((x & 1) == 0);
+        // The other sample of the cell on the same row and on the other row
+        const int partner = (row[x + 1] & isEven) | (row[x - 1] & ~isEven);
+        const int pairPartner = (pair[x + 1] & isEven) | (pair[x - 1] & ~isEven);
+        green[x] = (row[x] & isGreen) | (partner & ~isGreen);
+        rowChroma[x] = (partner & isGreen) | (row[x] & ~isGreen);
+        otherChroma[x] = (pair[x] & isGreen) | (pairPartner & ~isGreen);
+    }
+}
+
+template <typename T>
+void nearestRow(const T *bayer, int width, int height, const Pattern &pattern, int y, T *const planes[3])
+{
+    const size_t offset = static_cast<size_t>(y) * width;
+    const T *row = bayer + offset;
+    // Other row of the cell, mirrored on the last row of frames with an odd height
+    const T *pair = bayer + static_cast<size_t>(mirror(y ^ 1, height)) * width;
+    const int greenParity = pattern.at(y, 0) == GREEN ? 0 : 1;
+    const int chroma = pattern.at(y, 1 - greenParity);
+
+    nearestKernel(row, pair, 1, width - 1, greenParity, planes[GREEN] + offset, planes[chroma] + offset,
+                  planes[BLUE - chroma] + offset);
+    nearestPixel(row, pair, width, 0, pattern.at(y, 0), chroma, planes, offset);
+    nearestPixel(row, pair, width, width - 1, pattern.at(y, width - 1), chroma, planes, offset);
+}
+
+// Merge each 2x2 cell of the Bayer rows 2 * y and 2 * y + 1 into one RGB pixel
+template <typename T>
+void superpixelKernel(const T *__restrict redSamples, const T *__restrict greenSamples, const T *__restrict secondGreenSamples,
+                      const T *__restrict blueSamples, int outWidth, T *__restrict red, T *__restrict green, T *__restrict blue)
+{
+    for (int x = 0; x < outWidth; x++)
+    {
+        red[x] = redSamples[2 * x];
+        green[x] = (greenSamples[2 * x] + secondGreenSamples[2 * x] + 1) >> 1;
+        blue[x] = blueSamples[2 * x];
+    }
+}
+
+template <typename T>
+void superpixelRow(const T *bayer, int width, const Pattern &pattern, int y, int outWidth, T *const planes[3])
+{
+    const T *cellRows[2] = { bayer + static_cast<size_t>(2 * y) * width, bayer + static_cast<size_t>(2 * y + 1) * width };
+    const T *samples[3] = { nullptr, nullptr, nullptr };
+    const T *secondGreen = nullptr;
+
+    for (int cy = 0; cy < 2; cy++)
+    {
+        for (int cx = 0; cx < 2; cx++)
+        {
+            const int color = pattern.at(cy, cx);
+            if (color == GREEN && samples[GREEN] != nullptr)
+                secondGreen = cellRows[cy] + cx;
+            else
+                samples[color] = cellRows[cy] + cx;
+        }
+    }
+
+    const size_t offset = static_cast<size_t>(y) * outWidth;
+    superpixelKernel(samples[RED], samples[GREEN], secondGreen, samples[BLUE], outWidth, planes[RED] + offset,
+                     planes[GREEN] + offset, planes[BLUE] + offset);
+}
+
+/*
+ * Variable Number of Gradients (Chang, Cheung and Pang, 1999).
+ *
+ * For each pixel, gradients are computed in eight directions over a 5x5 neighbourhood as weighted sums
+ * of absolute differences between samples of the same colour. The directions with a gradient below
+ * 1.5 min + 0.5 (max - min) are selected, and each missing colour is estimated as the sample plus the
+ * mean difference between that colour and the colour of the sample along the selected directions.
+ *
+ * Missing colours are numbered per site: on green sites the first one is the chroma colour of the row,
+ * on chroma sites it is green. The second one is always the chroma colour of the rows above and below.
+ */
+struct VNGTable
+{
+    static constexpr int Directions = 8;
+    static constexpr int GradientTerms = 6;
+    static constexpr int DifferenceTerms = 8;
+
+    struct GradientTerm
+    {
+        ptrdiff_t a, b;
+        int weight;
+    };
+
+    // Weighted sum of samples giving the difference between a missing colour and the colour of the site
+    struct Difference
+    {
+        ptrdiff_t offsets[DifferenceTerms];
+        float weights[DifferenceTerms];
+    };
+
+    // Gradients do not depend on the site as every term compares two samples of the same colour
+    GradientTerm gradients[Directions][GradientTerms];
+    // Colour differences for each site of the cell, direction and missing colour
+    Difference differences[2][2][Directions][2];
+
+    VNGTable(int width, const Pattern &pattern);
+};
+
+VNGTable::VNGTable(int width, const Pattern &pattern)
+{
+    struct Offset
+    {
+        int y, x;
+        Offset operator+(const Offset &o) const
+        {
+            return { y + o.y, x + o.x };
+        }
+        Offset operator-() const
+        {
+            return { -y, -x };
+        }
+        Offset operator*(int k) const
+        {
+            return { k * y, k * x };
+        }
+    };
+
+    const Offset directions[Directions] = { {-1, 0}, {-1, 1}, {0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1} };
+    const Offset center { 0, 0 };
+    auto linear = [width](const Offset & o)
+    {
+        return static_cast<ptrdiff_t>(o.y) * width + o.x;
+    };
+
+    for (int dir = 0; dir < Directions; dir++)
+    {
+        const Offset d = directions[dir];
+        // Samples along the direction, then the next ring used for colours missing from the first one
+        std::vector<Offset> rings[2];
+
+        if (d.y == 0 || d.x == 0)
+        {
+            const Offset perp { d.x, d.y };
+            // Weights are doubled so half weights stay integers
+            const std::pair<Offset, Offset> pairs[GradientTerms] =
+            {
+                { d, -d }, { d * 2, center }, { d + perp, -d + perp }, { d + -perp, -d + -perp },
+                { d * 2 + perp, perp }, { d * 2 + -perp, -perp }
+            };
+            for (int t = 0; t < GradientTerms; t++)
+                gradients[dir][t] = { linear(pairs[t].first), linear(pairs[t].second), t < 2 ? 2 : 1 };
+
+            rings[0] = { center, d, d * 2, d + perp, d + -perp };
+            rings[1] = { d * 2 + perp, d * 2 + -perp, perp, -perp };
+        }
+        else
+        {
+            // Diagonal terms all have full weight, so that every direction sums four full weights
+            const Offset a { d.y, 0 };
+            const Offset b { 0, d.x };
+            const std::pair<Offset, Offset> pairs[4] =
+            {
+                { d, -d }, { d * 2, center }, { a * 2 + b, -b }, { a + b * 2, -a }
+            };
+            for (int t = 0; t < GradientTerms; t++)
+                gradients[dir][t] = t < 4 ? GradientTerm { linear(pairs[t].first), linear(pairs[t].second), 2 } : GradientTerm { 0, 0, 0 };
+
+            rings[0] = { center, d, d * 2 };
+            rings[1] = { a * 2 + b, a, a + b * 2, b };
+        }
+
+        for (int cy = 0; cy < 2; cy++)
+        {
+            for (int cx = 0; cx < 2; cx++)
+            {
+                // Mean of the samples of a colour in the nearest ring holding that colour
+                auto estimate = [&](int color, float sign, std::vector<std::pair<ptrdiff_t, float>> &terms)
+                {
+                    for (const auto &ring : rings)
+                    {
+                        std::vector<ptrdiff_t> offsets;
+                        for (const auto &o : ring)
+                        {
+                            if (pattern.at(cy + o.y, cx + o.x) == color)
+                                offsets.push_back(linear(o));
+                        }
+                        for (const auto offset : offsets)
+                            terms.push_back({ offset, sign / offsets.size() });
+                        if (!offsets.empty())
+                            return;
+                    }
+                };
+
+                const int own = pattern.at(cy, cx);
+                const int rowChroma = pattern.at(cy, cx + 1) == GREEN ? own : pattern.at(cy, cx + 1);
+                const int missing[2] = { own == GREEN ? rowChroma : GREEN, BLUE - rowChroma };
+
+                for (int m = 0; m < 2; m++)
+                {
+                    std::vector<std::pair<ptrdiff_t, float>> terms;
+                    estimate(missing[m], 1, terms);
+                    estimate(own, -1, terms);
+
+                    Difference &difference = differences[cy][cx][dir][m];
+                    for (int t = 0; t < DifferenceTerms; t++)
+                    {
+                        difference.offsets[t] = t < static_cast<int>(terms.size()) ? terms[t].first : 0;
+                        difference.weights[t] = t < static_cast<int>(terms.size()) ? terms[t].second : 0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Per band work buffers of the VNG rows
+struct VNGBuffers
+{
+    explicit VNGBuffers(int width) : gradients(VNGTable::Directions * width),
+        differences(2 * VNGTable::Directions * width) {}
+
+    std::vector<int> gradients;
+    std::vector<float> differences;
+};
+
+template <typename T>
+void vngGradientKernel(const T *__restrict row, const VNGTable::GradientTerm *terms, int first, int last, int *__restrict gradient)
+{
+    std::fill(gradient + first, gradient + last, 0);
+    for (int t = 0; t < VNGTable::GradientTerms; t++)
+    {
+        if (terms[t].weight == 0)
+            continue;
+        const T *a = row + terms[t].a;
+        const T *b = row + terms[t].b;
+        const int weight = terms[t].weight;
+        for (int x = first; x < last; x++)
+            gradient[x] += weight * std::abs(static_cast<int>(a[x]) - static_cast<int>(b[x]));
+    }
+}
+
+// Colour differences for the sites of one parity of the row
+template <typename T>
+void vngDifferenceKernel(const T *__restrict row, const VNGTable::Difference &terms, int first, int last,
+                         float *__restrict difference)
+{
+    for (int x = first; x < last; x += 2)
+        difference[x] = 0;
+    for (int t = 0; t < VNGTable::DifferenceTerms; t++)
+    {
+        if (terms.weights[t] == 0)
+            continue;
+        const T *samples = row + terms.offsets[t];
+        const float weight = terms.weights[t];
+        for (int x = first; x < last; x += 2)
+            difference[x] += weight * samples[x];
+    }
+}
+
+template <typename T>
+void vngSelectKernel(const T *__restrict row, const int *__restrict gradients, const float *__restrict differences,
+                     int width, int first, int last, int greenParity,
+                     T *__restrict green, T *__restrict rowChroma, T *__restrict otherChroma)
+{
+    const int maxValue = std::numeric_limits<T>::max();
+    for (int x = first; x < last; x++)
+    {
+        int minGradient = gradients[x], maxGradient = gradients[x];
+        for (int dir = 1; dir < VNGTable::Directions; dir++)
+        {
+            minGradient = std::min(minGradient, gradients[dir * width + x]);
+            maxGradient = std::max(maxGradient, gradients[dir * width + x]);
+        }
+        // g <= 1.5 min + 0.5 (max - min)
+        const int threshold = 2 * minGradient + maxGradient;
+
+        float selected = 0, firstSum = 0, secondSum = 0;
+        for (int dir = 0; dir < VNGTable::Directions; dir++)
+        {
+            const float select = static_cast<float>(2 * gradients[dir * width + x] <= threshold);
+            selected += select;
+            firstSum += select * differences[(2 * dir) * width + x];
+            secondSum += select * differences[(2 * dir + 1) * width + x];
+        }
+
+        const int isGreen = -static_cast<int>((x & 1) == greenParity);
+        const int center = row[x];
+        // Clamping as integers keeps the loop free of branches
+        const int firstMissing = std::max(0, std::min(maxValue, static_cast<int>(center + firstSum / selected + 0.5f)));
+        const int secondMissing = std::max(0, std::min(maxValue, static_cast<int>(center + secondSum / selected + 0.5f)));
+        green[x] = (center & isGreen) | (firstMissing & ~isGreen);
+        rowChroma[x] = (firstMissing & isGreen) | (center & ~isGreen);
+        otherChroma[x] = secondMissing;
+    }
+}
+
+// VNG interpolation of the pixels of row y at least two samples away from the frame borders
+template <typename T>
+void vngRow(const T *bayer, int width, const VNGTable &table, const Pattern &pattern, int y, T *const planes[3],
+            VNGBuffers &buffers)
+{
+    const size_t offset = static_cast<size_t>(y) * width;
+    const T *row = bayer + offset;
+    const int first = 2, last = width - 2;
+
+    for (int dir = 0; dir < VNGTable::Directions; dir++)
+    {
+        vngGradientKernel(row, table.gradients[dir], first, last, buffers.gradients.data() + dir * width);
+        for (int m = 0; m < 2; m++)
+        {
+            float *difference = buffers.differences.data() + (2 * dir + m) * width;
+            vngDifferenceKernel(row, table.differences[y & 1][0][dir][m], first, last, difference);
+            vngDifferenceKernel(row, table.differences[y & 1][1][dir][m], first + 1, last, difference);
+        }
+    }
+
+    const int greenParity = pattern.at(y, 0) == GREEN ? 0 : 1;
+    const int chroma = pattern.at(y, 1 - greenParity);
+    vngSelectKernel(row, buffers.gradients.data(), buffers.differences.data(), width, first, last, greenParity,
+                    planes[GREEN] + offset, planes[chroma] + offset, planes[BLUE - chroma] + offset);
+}
+}
+
+BayerDemosaic::BayerDemosaic(const BayerParams &params) : m_Params(params)
+{
+}
+
+bool BayerDemosaic::isSupported(dc1394bayer_method_t method)
+{
+    switch (method)
+    {
+        case DC1394_BAYER_METHOD_NEAREST:
+        case DC1394_BAYER_METHOD_BILINEAR:
+        case DC1394_BAYER_METHOD_DOWNSAMPLE:
+        case DC1394_BAYER_METHOD_VNG:
+            return true;
+        default:
+            return false;
+    }
+}
+
+QSize BayerDemosaic::outputSize(int width, int height) const
+{
+    if (m_Params.method == DC1394_BAYER_METHOD_DOWNSAMPLE)
+        return QSize(width / 2, height / 2);
+    return QSize(width, height);
+}
+
+bool BayerDemosaic::run(const uint8_t *bayer, int width, int height, uint8_t *planar) const
+{
+    return runInternal(bayer, width, height, planar);
+}
+
+bool BayerDemosaic::run(const uint16_t *bayer, int width, int height, uint16_t *planar) const
+{
+    return runInternal(bayer, width, height, planar);
+}
+
+template <typename T>
+bool BayerDemosaic::runInternal(const T *bayer, int width, int height, T *planar) const
+{
+    Pattern pattern;
+    if (!isSupported(m_Params.method) || m_Params.offsetX != 0 || width < 4 || height < 4 ||
+            !makePattern(m_Params.filter, m_Params.offsetY, pattern))
+        return false;
+
+    const QSize size = outputSize(width, height);
+    const size_t planeSize = static_cast<size_t>(size.width()) * size.height();
+    T *const planes[3] = { planar, planar + planeSize, planar + 2 * planeSize };
+
+    auto borderPixels = [&](int y, int margin)
+    {
+        if (y < margin || y >= height - margin)
+        {
+            for (int x = 0; x < width; x++)
+                bilinearPixel(bayer, width, height, pattern, x, y, planes);
+            return true;
+        }
+        for (int x = 0; x < margin; x++)
+        {
+            bilinearPixel(bayer, width, height, pattern, x, y, planes);
+            bilinearPixel(bayer, width, height, pattern, width - 1 - x, y, planes);
+        }
+        return false;
+    };
+
+    switch (m_Params.method)
+    {
+        case DC1394_BAYER_METHOD_DOWNSAMPLE:
+            forEachBand(size.height(), width, [&](int first, int last)
+            {
+                for (int y = first; y < last; y++)
+                    superpixelRow(bayer, width, pattern, y, size.width(), planes);
+            });
+            break;
+
+        case DC1394_BAYER_METHOD_NEAREST:
+            forEachBand(height, width, [&](int first, int last)
+            {
+                for (int y = first; y < last; y++)
+                    nearestRow(bayer, width, height, pattern, y, planes);
+            });
+            break;
+
+        case DC1394_BAYER_METHOD_BILINEAR:
+            forEachBand(height, width, [&](int first, int last)
+            {
+                for (int y = first; y < last; y++)
+                {
+                    if (!borderPixels(y, 1))
+                        bilinearRow(bayer, width, pattern, y, planes);
+                }
+            });
+            break;
+
+        case DC1394_BAYER_METHOD_VNG:
+        {
+            const VNGTable table(width, pattern);
+            forEachBand(height, width, [&](int first, int last)
+            {
+                VNGBuffers buffers(width);
+                for (int y = first; y < last; y++)
+                {
+                    if (!borderPixels(y, 2))
+                        vngRow(bayer, width, table, pattern, y, planes, buffers);
+                }
+            });
+        }
+        break;
+
+        default:
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "bayer.h"
+
+#include <QSize>
+
+#include <cstdint>
+
+/**
+ * @class BayerDemosaic
+ * @short Multithreaded demosaicing of 8 and 16 bit Bayer frames into planar RGB.
+ *
+ * The frame is split in bands of rows that are demosaiced concurrently, each writing its rows of the
+ * red, green and blue planes directly, so no interleaved intermediate buffer is needed. Interior pixels
+ * go through branch-free row kernels the compiler can vectorize, while the borders are handled by
+ * mirroring the pattern.
+ *
+ * Supported methods are nearest neighbour, bilinear, VNG and superpixel (DC1394_BAYER_METHOD_DOWNSAMPLE),
+ * which merges each 2x2 Bayer cell into one RGB pixel and produces a half resolution image. The other
+ * dc1394 methods are left to dc1394_bayer_decoding_8bit() and dc1394_bayer_decoding_16bit().
+ */
+class BayerDemosaic
+{
+    public:
+        /**
+         * @param params Bayer pattern, offsets and method. Only offsetX == 0 is supported, X offsets should be
+         * folded into the pattern beforehand.
+         */
+        explicit BayerDemosaic(const BayerParams &params);
+
+        /** @return true if the method is implemented by BayerDemosaic */
+        static bool isSupported(dc1394bayer_method_t method);
+
+        /** @return size of the planar output for a width x height frame, which is halved for superpixel */
+        QSize outputSize(int width, int height) const;
+
+        /**
+         * @brief run Demosaic a frame.
+         * @param bayer width x height Bayer samples
+         * @param planar destination holding three planes of outputSize() samples, red, green then blue
+         * @return false if the method or the frame size is not supported
+         */
+        bool run(const uint8_t *bayer, int width, int height, uint8_t *planar) const;
+        bool run(const uint16_t *bayer, int width, int height, uint16_t *planar) const;
+
+    private:
+        template <typename T>
+        bool runInternal(const T *bayer, int width, int height, T *planar) const;
+
+        BayerParams m_Params;
+};
@@ -0,0 +1,114 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitsbufferpool.h"
+
+#include <QMutexLocker>
+
+#include <iterator>
+#include <new>
+
+namespace
+{
+// Sizes within the same 64 KiB share a bucket, which covers ROIs and subframes of about the same size
+constexpr uint32_t BUCKET_GRANULARITY = 64 * 1024;
+}
+
+FITSBufferPool::FITSBufferPool(uint64_t maxIdleBytes) : m_MaxIdleBytes(maxIdleBytes)
+{
+}
+
+FITSBufferPool::~FITSBufferPool()
+{
+    clear();
+}
+
+uint32_t FITSBufferPool::bucketSize(uint32_t size)
+{
+    const uint64_t rounded = (static_cast<uint64_t>(size) + BUCKET_GRANULARITY - 1) / BUCKET_GRANULARITY * BUCKET_GRANULARITY;
+    // Sizes close to the 4 GiB limit are not rounded
+    return rounded > UINT32_MAX ? size : static_cast<uint32_t>(rounded);
+}
+
+uint8_t *FITSBufferPool::acquire(uint32_t size)
+{
+    const uint32_t bucket = bucketSize(size);
+
+    {
+        QMutexLocker locker(&m_Mutex);
+        auto idle = m_Idle.find(bucket);
+        if (idle != m_Idle.end())
+        {
+            uint8_t *buffer = idle.value();
+            m_Idle.erase(idle);
+            m_Statistics.hits++;
+            m_Statistics.idleBuffers--;
+            m_Statistics.idleBytes -= bucket;
+            return buffer;
+        }
+        m_Statistics.misses++;
+    }
+
+    return new (std::nothrow) uint8_t[bucket];
+}
+
+void FITSBufferPool::release(uint8_t *buffer, uint32_t size)
+{
+    if (buffer == nullptr)
+        return;
+
+    const uint32_t bucket = bucketSize(size);
+
+    {
+        QMutexLocker locker(&m_Mutex);
+        if (m_Statistics.idleBytes + bucket <= m_MaxIdleBytes)
+        {
+            m_Idle.insert(bucket, buffer);
+            m_Statistics.idleBuffers++;
+            m_Statistics.idleBytes += bucket;
+            return;
+        }
+        m_Statistics.discards++;
+    }
+
+    delete[] buffer;
+}
+
+void FITSBufferPool::clear()
+{
+    QMutexLocker locker(&m_Mutex);
+    for (auto buffer : m_Idle)
+        delete[] buffer;
+    m_Idle.clear();
+    m_Statistics.idleBuffers = 0;
+    m_Statistics.idleBytes = 0;
+}
+
+void FITSBufferPool::setMaxIdleBytes(uint64_t maxIdleBytes)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_MaxIdleBytes = maxIdleBytes;
+    while (m_Statistics.idleBytes > m_MaxIdleBytes)
+    {
+        auto largest = std::prev(m_Idle.end());
+        delete[] largest.value();
+        m_Statistics.idleBuffers--;
+        m_Statistics.idleBytes -= largest.key();
+        m_Idle.erase(largest);
+    }
+}
+
+uint64_t FITSBufferPool::maxIdleBytes() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_MaxIdleBytes;
+}
+
+FITSBufferPool::Statistics FITSBufferPool::statistics() const
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_Statistics;
+}
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QMultiMap>
+#include <QMutex>
+
+#include <cstdint>
+
+/**
+ * @class FITSBufferPool
+ * @short Pool of image buffers reused by FITSData across frames.
+ *
+ * Capture, guiding and focusing process streams of frames of the same size. Instead of
+ * allocating and freeing large image buffers for every frame, FITSData acquires its buffers
+ * from a pool, typically owned by the camera chip, and releases them back to it.
+ *
+ * Buffers are bucketed by size, rounded up to a multiple of the bucket granularity, so that a
+ * released buffer serves any later request falling in the same bucket. Idle buffers are kept up
+ * to a total size limit, beyond which released buffers are freed.
+ *
+ * Buffers are allocated with new[], so a buffer acquired from a pool may also be freed with
+ * delete[]. The pool is thread safe.
+ */
+class FITSBufferPool
+{
+    public:
+        /** Pool usage counters */
+        struct Statistics
+        {
+            /// Requests served by an idle buffer
+            uint64_t hits { 0 };
+            /// Requests that needed a new allocation
+            uint64_t misses { 0 };
+            /// Released buffers freed because the pool was full
+            uint64_t discards { 0 };
+            /// Number and total size in bytes of the idle buffers
+            uint32_t idleBuffers { 0 };
+            uint64_t idleBytes { 0 };
+        };
+
+        /**
+         * @param maxIdleBytes maximum total size of the buffers kept idle in the pool
+         */
+        explicit FITSBufferPool(uint64_t maxIdleBytes = 512 * 1024 * 1024);
+        ~FITSBufferPool();
+
+        /**
+         * @brief acquire Get a buffer of at least size bytes.
+         * @return the buffer, or nullptr if it could not be allocated. The contents are undefined.
+         */
+        uint8_t *acquire(uint32_t size);
+
+        /**
+         * @brief release Give a buffer back to the pool.
+         * @param buffer buffer returned by acquire(), may be nullptr
+         * @param size the size passed to acquire() for this buffer
+         */
+        void release(uint8_t *buffer, uint32_t size);
+
+        /** @brief clear Free all idle buffers. */
+        void clear();
+
+        /**
+         * @brief setMaxIdleBytes Change the total size limit of the idle buffers, freeing the largest
+         * idle buffers until they fit in it.
+         */
+        void setMaxIdleBytes(uint64_t maxIdleBytes);
+        uint64_t maxIdleBytes() const;
+
+        Statistics statistics() const;
+
+    private:
+        static uint32_t bucketSize(uint32_t size);
+
+        mutable QMutex m_Mutex;
+        // Idle buffers by bucket size
+        QMultiMap<uint32_t, uint8_t *> m_Idle;
+        uint64_t m_MaxIdleBytes { 0 };
+        Statistics m_Statistics;
+};
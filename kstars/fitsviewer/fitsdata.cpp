@@ -8,6 +8,7 @@
 */
 
 #include "fitsdata.h"
+#include "bayerdemosaic.h"
 #include "fitsbahtinovdetector.h"
 #include "fitsthresholddetector.h"
 #include "fitsgradientdetector.h"
@@ -21,13 +22,17 @@
 #include "kspaths.h"
 #include "Options.h"
 #include "skymapcomposite.h"
+#include "skycomponents/catalogscomponent.h"
 #include "auxiliary/ksnotification.h"
 #include "auxiliary/robuststatistics.h"
 
 #include <KFormat>
 #include <QApplication>
+#include <QDataStream>
+#include <QFutureInterface>
 #include <QImage>
 #include <QtConcurrent>
+#include <QThread>
 #include <QImageReader>
 
 #if !defined(KSTARS_LITE) && defined(HAVE_WCSLIB)
@@ -43,8 +48,12 @@
 #include <libxisf.h>
 #endif
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
 #include <fits_debug.h>
 
@@ -72,7 +81,8 @@ bool FITSData::readableFilename(const QString &filename)
            RAWFormats.contains(extension);
 }
 
-FITSData::FITSData(FITSMode fitsMode): m_Mode(fitsMode)
+FITSData::FITSData(FITSMode fitsMode, const QSharedPointer<FITSBufferPool> &bufferPool): m_BufferPool(bufferPool),
+    m_Mode(fitsMode)
 {
     qRegisterMetaType<FITSMode>("FITSMode");
 
@@ -100,9 +110,11 @@ FITSData::FITSData(const QSharedPointer<FITSData> &other)
     this->m_Mode = other->m_Mode;
     this->m_Statistics.channels = other->m_Statistics.channels;
     memcpy(&m_Statistics, &(other->m_Statistics), sizeof(m_Statistics));
-    m_ImageBuffer = new uint8_t[m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel];
-    memcpy(m_ImageBuffer, other->m_ImageBuffer,
-           m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel);
+    m_BufferPool = other->m_BufferPool;
+    m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel;
+    m_ImageBuffer = allocateBuffer(m_ImageBufferSize);
+    if (m_ImageBuffer != nullptr)
+        memcpy(m_ImageBuffer, other->m_ImageBuffer, m_ImageBufferSize);
 }
 
 FITSData::~FITSData()
@@ -146,6 +158,7 @@ void FITSData::loadCommon(const QString &inFilename)
     int status = 0;
     qDeleteAll(starCenters);
     starCenters.clear();
+    clearStarDetectionCache();
 
     if (fptr != nullptr)
     {
@@ -405,7 +418,7 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const bool isCompressed)
         m_Statistics.channels = 1;
 
     m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel;
-    m_ImageBuffer = new uint8_t[m_ImageBufferSize];
+    m_ImageBuffer = allocateBuffer(m_ImageBufferSize);
     if (m_ImageBuffer == nullptr)
     {
         qCWarning(KSTARS_FITS) << "FITSData: Not enough memory for image_buffer channel. Requested: "
@@ -543,7 +556,12 @@ bool FITSData::loadXISFImage(const QByteArray &buffer)
         }
 
         m_ImageBufferSize = image.imageDataSize();
-        m_ImageBuffer = new uint8_t[m_ImageBufferSize];
+        m_ImageBuffer = allocateBuffer(m_ImageBufferSize);
+        if (m_ImageBuffer == nullptr)
+        {
+            logOOMError(m_ImageBufferSize);
+            return false;
+        }
         std::memcpy(m_ImageBuffer, image.imageData(), m_ImageBufferSize);
 
         calculateStats(false, false);
@@ -690,7 +708,7 @@ bool FITSData::loadCanonicalImage(const QByteArray &buffer)
     clearImageBuffers();
     m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * static_cast<uint16_t>
                         (m_Statistics.bytesPerPixel);
-    m_ImageBuffer = new uint8_t[m_ImageBufferSize];
+    m_ImageBuffer = allocateBuffer(m_ImageBufferSize);
     if (m_ImageBuffer == nullptr)
     {
         m_LastError = i18n("FITSData: Not enough memory for image_buffer channel. Requested: %1 bytes ", m_ImageBufferSize);
@@ -802,7 +820,7 @@ bool FITSData::loadRAWImage(const QByteArray &buffer)
     m_Statistics.samples_per_channel = m_Statistics.width * m_Statistics.height;
     clearImageBuffers();
     m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel;
-    m_ImageBuffer = new uint8_t[m_ImageBufferSize];
+    m_ImageBuffer = allocateBuffer(m_ImageBufferSize);
     if (m_ImageBuffer == nullptr)
     {
         m_LastError = i18n("FITSData: Not enough memory for image_buffer channel. Requested: %1 bytes ", m_ImageBufferSize);
@@ -1159,17 +1177,44 @@ bool FITSData::saveImage(const QString &newFilename)
 
 void FITSData::clearImageBuffers()
 {
-    delete[] m_ImageBuffer;
+    clearStarDetectionCache();
+    freeImageBuffer();
     m_ImageBuffer = nullptr;
     if(m_ImageRoiBuffer != nullptr )
     {
-        delete[] m_ImageRoiBuffer;
+        freeBuffer(m_ImageRoiBuffer, m_ImageRoiBufferSize);
         m_ImageRoiBuffer = nullptr;
 
     }
     //m_BayerBuffer = nullptr;
 }
 
+uint8_t *FITSData::allocateBuffer(uint32_t size)
+{
+    if (m_BufferPool)
+        return m_BufferPool->acquire(size);
+    return new (std::nothrow) uint8_t[size];
+}
+
+void FITSData::freeBuffer(uint8_t *buffer, uint32_t size)
+{
+    if (m_BufferPool)
+        m_BufferPool->release(buffer, size);
+    else
+        delete[] buffer;
+}
+
+void FITSData::freeImageBuffer()
+{
+    // Buffers given by setImageBuffer() are not from the pool and may be of any size
+    if (m_ExternalImageBuffer)
+        delete[] m_ImageBuffer;
+    else
+        freeBuffer(m_ImageBuffer, m_ImageBufferSize);
+    m_ImageBuffer = nullptr;
+    m_ExternalImageBuffer = false;
+}
+
 void FITSData::makeRoiBuffer(QRect roi)
 {
     uint32_t channelSize = roi.height() * roi.width();
@@ -1179,13 +1224,20 @@ void FITSData::makeRoiBuffer(QRect roi)
     }
     if(m_ImageRoiBuffer != nullptr )
     {
-        delete[] m_ImageRoiBuffer;
+        freeBuffer(m_ImageRoiBuffer, m_ImageRoiBufferSize);
         m_ImageRoiBuffer = nullptr;
     }
     int xoffset = roi.topLeft().x() - 1;
     int yoffset = roi.topLeft().y() - 1;
     uint32_t bpp = m_Statistics.bytesPerPixel;
-    m_ImageRoiBuffer = new uint8_t[roi.height()*roi.width()*m_Statistics.channels * m_Statistics.bytesPerPixel]();
+    m_ImageRoiBufferSize = roi.height() * roi.width() * m_Statistics.channels * m_Statistics.bytesPerPixel;
+    m_ImageRoiBuffer = allocateBuffer(m_ImageRoiBufferSize);
+    if (m_ImageRoiBuffer == nullptr)
+    {
+        logOOMError(m_ImageRoiBufferSize);
+        return;
+    }
+    memset(m_ImageRoiBuffer, 0, m_ImageRoiBufferSize);
     for(int n = 0 ; n < m_Statistics.channels ; n++)
     {
         for(int i = 0; i < roi.height(); i++)
@@ -1204,374 +1256,301 @@ void FITSData::makeRoiBuffer(QRect roi)
     m_ROIStatistics.height = roi.height();
     calculateStats(false, true);
 }
-void FITSData::calculateStats(bool refresh, bool roi)
+namespace
 {
-    // Calculate min max
-    if(roi == false)
-    {
-        calculateMinMax(refresh);
-        calculateMedian(refresh);
-
-        // Try to read mean/median/stddev if in file
-        if (refresh == false && fptr)
-        {
-            int status = 0;
-            int nfound = 0;
-            if (fits_read_key_dbl(fptr, "MEAN1", &m_Statistics.mean[0], nullptr, &status) == 0)
-                nfound++;
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MEAN2", & m_Statistics.mean[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MEAN3", &m_Statistics.mean[2], nullptr, &status);
-
-            status = 0;
-            if (fits_read_key_dbl(fptr, "STDDEV1", &m_Statistics.stddev[0], nullptr, &status) == 0)
-                nfound++;
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "STDDEV2", &m_Statistics.stddev[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "STDDEV3", &m_Statistics.stddev[2], nullptr, &status);
-
-            // If all is OK, we're done
-            if (nfound == 2)
-                return;
-        }
-
-        // Get standard deviation and mean in one run
-        switch (m_Statistics.dataType)
-        {
-            case TBYTE:
-                runningAverageStdDev<uint8_t>();
-                break;
-
-            case TSHORT:
-                runningAverageStdDev<int16_t>();
-                break;
-
-            case TUSHORT:
-                runningAverageStdDev<uint16_t>();
-                break;
-
-            case TLONG:
-                runningAverageStdDev<int32_t>();
-                break;
+// Statistics of one band of samples of a channel. Bands are computed in parallel and merged.
+struct BandStatistics
+{
+    double min { std::numeric_limits<double>::max() };
+    double max { std::numeric_limits<double>::lowest() };
+    // Sums of (value - shift) and (value - shift)^2
+    double sum { 0 };
+    double sumSquares { 0 };
+    // Histogram of every possible value, only for types with an exact histogram median
+    std::vector<uint32_t> histogram;
+};
+
+// 8 and 16 bit integer images get an exact median from a histogram of all possible values
+template <typename T>
+struct HasExactHistogram
+{
+    static constexpr bool value = std::is_integral<T>::value && sizeof(T) <= 2;
+};
 
-            case TULONG:
-                runningAverageStdDev<uint32_t>();
-                break;
+template <typename T>
+inline uint32_t histogramIndex(T value)
+{
+    return static_cast<uint32_t>(static_cast<int32_t>(value) - static_cast<int32_t>(std::numeric_limits<T>::lowest()));
+}
 
-            case TFLOAT:
-                runningAverageStdDev<float>();
-                break;
+template <typename T>
+BandStatistics bandStatistics(const T *data, uint32_t count, double shift, bool withHistogram)
+{
+    // Small integers are summed exactly, everything else in double relative to the shift
+    using Sum = typename std::conditional<HasExactHistogram<T>::value, int64_t, double>::type;
 
-            case TLONGLONG:
-                runningAverageStdDev<int64_t>();
-                break;
+    // Independent accumulators per lane so that the inner loop can be vectorized by the compiler
+    // without reordering floating point additions.
+    constexpr uint32_t lanes = 8;
+    // Samples are handled in chunks so that the histogram is filled from data still in cache
+    constexpr uint32_t chunkSize = 4096;
 
-            case TDOUBLE:
-                runningAverageStdDev<double>();
-                break;
+    T minimum[lanes], maximum[lanes];
+    Sum sum[lanes], sumSquares[lanes];
+    for (uint32_t l = 0; l < lanes; l++)
+    {
+        minimum[l]    = std::numeric_limits<T>::max();
+        maximum[l]    = std::numeric_limits<T>::lowest();
+        sum[l]        = 0;
+        sumSquares[l] = 0;
+    }
+    const Sum offset = static_cast<Sum>(shift);
 
-            default:
-                return;
-        }
+    BandStatistics result;
+    if (withHistogram)
+        result.histogram.assign(1u << (8 * sizeof(T)), 0);
 
-        // FIXME That's not really SNR, must implement a proper solution for this value
-        m_Statistics.SNR = m_Statistics.mean[0] / m_Statistics.stddev[0];
-    }
-    else
+    for (uint32_t start = 0; start < count; start += chunkSize)
     {
-        calculateMinMax(refresh, roi);
-        calculateMedian(refresh, roi);
+        const T *chunk = data + start;
+        const uint32_t length = std::min(chunkSize, count - start);
+        const uint32_t blocked = length - length % lanes;
 
-        switch (m_ROIStatistics.dataType)
+        for (uint32_t i = 0; i < blocked; i += lanes)
         {
-            case TBYTE:
-                runningAverageStdDev<uint8_t>(roi);
-                break;
-
-            case TSHORT:
-                runningAverageStdDev<int16_t>(roi);
-                break;
-
-            case TUSHORT:
-                runningAverageStdDev<uint16_t>(roi);
-                break;
-
-            case TLONG:
-                runningAverageStdDev<int32_t>(roi);
-                break;
-
-            case TULONG:
-                runningAverageStdDev<uint32_t>(roi);
-                break;
-
-            case TFLOAT:
-                runningAverageStdDev<float>(roi);
-                break;
-
-            case TLONGLONG:
-                runningAverageStdDev<int64_t>(roi);
-                break;
-
-            case TDOUBLE:
-                runningAverageStdDev<double>(roi);
-                break;
-
-            default:
-                return;
+            for (uint32_t l = 0; l < lanes; l++)
+            {
+                const T value = chunk[i + l];
+                minimum[l] = value < minimum[l] ? value : minimum[l];
+                maximum[l] = value > maximum[l] ? value : maximum[l];
+                const Sum delta = static_cast<Sum>(value) - offset;
+                sum[l] += delta;
+                sumSquares[l] += delta * delta;
+            }
         }
-    }
-}
-
-void FITSData::calculateMinMax(bool refresh, bool roi)
-{
-    if(roi == false)
-    {
-        int status, nfound = 0;
-
-        status = 0;
-
-        // Only fetch from header if we have a single channel
-        // Otherwise, calculate manually.
-        if (fptr != nullptr && !refresh)
+        for (uint32_t i = blocked; i < length; i++)
         {
+            const T value = chunk[i];
+            minimum[0] = value < minimum[0] ? value : minimum[0];
+            maximum[0] = value > maximum[0] ? value : maximum[0];
+            const Sum delta = static_cast<Sum>(value) - offset;
+            sum[0] += delta;
+            sumSquares[0] += delta * delta;
+        }
 
-            status = 0;
-
-            if (fits_read_key_dbl(fptr, "DATAMIN", &(m_Statistics.min[0]), nullptr, &status) == 0)
-                nfound++;
-            else if (fits_read_key_dbl(fptr, "MIN1", &(m_Statistics.min[0]), nullptr, &status) == 0)
-                nfound++;
-
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MIN2", &m_Statistics.min[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MIN3", &m_Statistics.min[2], nullptr, &status);
-
-            status = 0;
-
-            if (fits_read_key_dbl(fptr, "DATAMAX", &(m_Statistics.max[0]), nullptr, &status) == 0)
-                nfound++;
-            else if (fits_read_key_dbl(fptr, "MAX1", &(m_Statistics.max[0]), nullptr, &status) == 0)
-                nfound++;
-
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MAX2", &m_Statistics.max[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MAX3", &m_Statistics.max[2], nullptr, &status);
-
-            // If we found both keywords, no need to calculate them, unless they are both zeros
-            if (nfound == 2 && !(m_Statistics.min[0] == 0 && m_Statistics.max[0] == 0))
-                return;
+        if (withHistogram)
+        {
+            uint32_t *histogram = result.histogram.data();
+            for (uint32_t i = 0; i < length; i++)
+                histogram[histogramIndex(chunk[i])]++;
         }
+    }
 
-        m_Statistics.min[0] = 1.0E30;
-        m_Statistics.max[0] = -1.0E30;
+    for (uint32_t l = 0; l < lanes; l++)
+    {
+        result.min = std::min(result.min, static_cast<double>(minimum[l]));
+        result.max = std::max(result.max, static_cast<double>(maximum[l]));
+        result.sum += static_cast<double>(sum[l]);
+        result.sumSquares += static_cast<double>(sumSquares[l]);
+    }
+    return result;
+}
 
-        m_Statistics.min[1] = 1.0E30;
-        m_Statistics.max[1] = -1.0E30;
+// Median of the samples counted in the histogram, averaging the two middle ones for an even count.
+template <typename T>
+double histogramMedian(const std::vector<uint32_t> &histogram, uint64_t count)
+{
+    if (count == 0)
+        return 0;
 
-        m_Statistics.min[2] = 1.0E30;
-        m_Statistics.max[2] = -1.0E30;
+    const uint64_t lowRank = (count - 1) / 2, highRank = count / 2;
+    const int32_t lowest = std::numeric_limits<T>::lowest();
+    double low = 0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < histogram.size(); i++)
+    {
+        const uint64_t next = seen + histogram[i];
+        if (lowRank >= seen && lowRank < next)
+            low = static_cast<double>(lowest + static_cast<int32_t>(i));
+        if (highRank >= seen && highRank < next)
+            return (low + static_cast<double>(lowest + static_cast<int32_t>(i))) / 2;
+        seen = next;
+    }
+    return low;
+}
+}
 
-        switch (m_Statistics.dataType)
-        {
-            case TBYTE:
-                calculateMinMax<uint8_t>();
-                break;
+void FITSData::calculateStats(bool refresh, bool roi)
+{
+    FITSImage::Statistic &stats = roi ? m_ROIStatistics : m_Statistics;
 
-            case TSHORT:
-                calculateMinMax<int16_t>();
-                break;
+    // Try to read min/max/mean/median/stddev if in file
+    FITSImage::Statistic header = stats;
+    bool headerMinMax = false, headerMedian = false, headerMeanStdDev = false;
+    if (roi == false && refresh == false && fptr)
+    {
+        int status = 0, nfound = 0;
+        if (fits_read_key_dbl(fptr, "DATAMIN", &header.min[0], nullptr, &status) == 0)
+            nfound++;
+        else if (fits_read_key_dbl(fptr, "MIN1", &header.min[0], nullptr, &status) == 0)
+            nfound++;
 
-            case TUSHORT:
-                calculateMinMax<uint16_t>();
-                break;
+        // NB. These could fail if missing, which is OK.
+        fits_read_key_dbl(fptr, "MIN2", &header.min[1], nullptr, &status);
+        fits_read_key_dbl(fptr, "MIN3", &header.min[2], nullptr, &status);
 
-            case TLONG:
-                calculateMinMax<int32_t>();
-                break;
+        status = 0;
+        if (fits_read_key_dbl(fptr, "DATAMAX", &header.max[0], nullptr, &status) == 0)
+            nfound++;
+        else if (fits_read_key_dbl(fptr, "MAX1", &header.max[0], nullptr, &status) == 0)
+            nfound++;
 
-            case TULONG:
-                calculateMinMax<uint32_t>();
-                break;
+        // NB. These could fail if missing, which is OK.
+        fits_read_key_dbl(fptr, "MAX2", &header.max[1], nullptr, &status);
+        fits_read_key_dbl(fptr, "MAX3", &header.max[2], nullptr, &status);
 
-            case TFLOAT:
-                calculateMinMax<float>();
-                break;
+        // If we found both keywords, no need to calculate them, unless they are both zeros
+        headerMinMax = (nfound == 2 && !(header.min[0] == 0 && header.max[0] == 0));
 
-            case TLONGLONG:
-                calculateMinMax<int64_t>();
-                break;
+        status = 0;
+        headerMedian = (fits_read_key_dbl(fptr, "MEDIAN1", &header.median[0], nullptr, &status) == 0);
+        fits_read_key_dbl(fptr, "MEDIAN2", &header.median[1], nullptr, &status);
+        fits_read_key_dbl(fptr, "MEDIAN3", &header.median[2], nullptr, &status);
 
-            case TDOUBLE:
-                calculateMinMax<double>();
-                break;
+        status = 0;
+        nfound = 0;
+        if (fits_read_key_dbl(fptr, "MEAN1", &header.mean[0], nullptr, &status) == 0)
+            nfound++;
+        fits_read_key_dbl(fptr, "MEAN2", &header.mean[1], nullptr, &status);
+        fits_read_key_dbl(fptr, "MEAN3", &header.mean[2], nullptr, &status);
 
-            default:
-                break;
-        }
+        status = 0;
+        if (fits_read_key_dbl(fptr, "STDDEV1", &header.stddev[0], nullptr, &status) == 0)
+            nfound++;
+        fits_read_key_dbl(fptr, "STDDEV2", &header.stddev[1], nullptr, &status);
+        fits_read_key_dbl(fptr, "STDDEV3", &header.stddev[2], nullptr, &status);
+        headerMeanStdDev = (nfound == 2);
     }
-    else
-    {
-        m_ROIStatistics.min[0] = 1.0E30;
-        m_ROIStatistics.max[0] = -1.0E30;
 
-        m_ROIStatistics.min[1] = 1.0E30;
-        m_ROIStatistics.max[1] = -1.0E30;
-
-        m_ROIStatistics.min[2] = 1.0E30;
-        m_ROIStatistics.max[2] = -1.0E30;
-
-        switch (m_Statistics.dataType)
+    // Anything missing from the header is computed from the data, all in one pass
+    if (!(headerMinMax && headerMedian && headerMeanStdDev))
+    {
+        switch (stats.dataType)
         {
             case TBYTE:
-                calculateMinMax<uint8_t>(roi);
+                calculateStatsInternal<uint8_t>(roi, !headerMedian);
                 break;
 
             case TSHORT:
-                calculateMinMax<int16_t>(roi);
+                calculateStatsInternal<int16_t>(roi, !headerMedian);
                 break;
 
             case TUSHORT:
-                calculateMinMax<uint16_t>(roi);
+                calculateStatsInternal<uint16_t>(roi, !headerMedian);
                 break;
 
             case TLONG:
-                calculateMinMax<int32_t>(roi);
+                calculateStatsInternal<int32_t>(roi, !headerMedian);
                 break;
 
             case TULONG:
-                calculateMinMax<uint32_t>(roi);
+                calculateStatsInternal<uint32_t>(roi, !headerMedian);
                 break;
 
             case TFLOAT:
-                calculateMinMax<float>(roi);
+                calculateStatsInternal<float>(roi, !headerMedian);
                 break;
 
             case TLONGLONG:
-                calculateMinMax<int64_t>(roi);
+                calculateStatsInternal<int64_t>(roi, !headerMedian);
                 break;
 
             case TDOUBLE:
-                calculateMinMax<double>(roi);
+                calculateStatsInternal<double>(roi, !headerMedian);
                 break;
 
             default:
-                break;
+                return;
         }
-
     }
-}
 
-void FITSData::calculateMedian(bool refresh, bool roi)
-{
-    if(!roi)
+    for (int i = 0; i < 3; i++)
     {
-        int status, nfound = 0;
-
-        status = 0;
-
-        // Only fetch from header if we have a single channel
-        // Otherwise, calculate manually.
-        if (fptr != nullptr && !refresh)
+        if (headerMinMax)
         {
-            status = 0;
-            if (fits_read_key_dbl(fptr, "MEDIAN1", &m_Statistics.median[0], nullptr, &status) == 0)
-                nfound++;
-
-            // NB. These could fail if missing, which is OK.
-            fits_read_key_dbl(fptr, "MEDIAN2", &m_Statistics.median[1], nullptr, &status);
-            fits_read_key_dbl(fptr, "MEDIAN3", &m_Statistics.median[2], nullptr, &status);
-
-            if (nfound == 1)
-                return;
+            stats.min[i] = header.min[i];
+            stats.max[i] = header.max[i];
         }
-
-        m_Statistics.median[RED_CHANNEL] = 0;
-        m_Statistics.median[GREEN_CHANNEL] = 0;
-        m_Statistics.median[BLUE_CHANNEL] = 0;
-
-        switch (m_Statistics.dataType)
+        if (headerMedian)
+            stats.median[i] = header.median[i];
+        if (headerMeanStdDev)
         {
-            case TBYTE:
-                calculateMedian<uint8_t>();
-                break;
-
-            case TSHORT:
-                calculateMedian<int16_t>();
-                break;
-
-            case TUSHORT:
-                calculateMedian<uint16_t>();
-                break;
-
-            case TLONG:
-                calculateMedian<int32_t>();
-                break;
-
-            case TULONG:
-                calculateMedian<uint32_t>();
-                break;
-
-            case TFLOAT:
-                calculateMedian<float>();
-                break;
-
-            case TLONGLONG:
-                calculateMedian<int64_t>();
-                break;
-
-            case TDOUBLE:
-                calculateMedian<double>();
-                break;
-
-            default:
-                break;
+            stats.mean[i] = header.mean[i];
+            stats.stddev[i] = header.stddev[i];
         }
     }
-    else
-    {
-        m_ROIStatistics.median[RED_CHANNEL] = 0;
-        m_ROIStatistics.median[GREEN_CHANNEL] = 0;
-        m_ROIStatistics.median[BLUE_CHANNEL] = 0;
-
-        switch (m_ROIStatistics.dataType)
-        {
-            case TBYTE:
-                calculateMedian<uint8_t>(roi);
-                break;
-
-            case TSHORT:
-                calculateMedian<int16_t>(roi);
-                break;
-
-            case TUSHORT:
-                calculateMedian<uint16_t>(roi);
-                break;
 
-            case TLONG:
-                calculateMedian<int32_t>(roi);
-                break;
+    // FIXME That's not really SNR, must implement a proper solution for this value
+    if (roi == false)
+        m_Statistics.SNR = m_Statistics.mean[0] / m_Statistics.stddev[0];
+}
 
-            case TULONG:
-                calculateMedian<uint32_t>(roi);
-                break;
+template <typename T>
+void FITSData::calculateStatsInternal(bool roi, bool median)
+{
+    FITSImage::Statistic &stats = roi ? m_ROIStatistics : m_Statistics;
+    const T *buffer = reinterpret_cast<const T *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
+    const uint32_t samples = stats.samples_per_channel;
+    const bool withHistogram = median && HasExactHistogram<T>::value;
 
-            case TFLOAT:
-                calculateMedian<float>(roi);
-                break;
+    // Small images are not worth the threading overhead
+    const uint32_t minSamplesPerBand = 1 << 16;
+    const uint32_t nBands = std::max<uint32_t>(1, std::min<uint32_t>(QThread::idealThreadCount(),
+                            samples / minSamplesPerBand));
+    const uint32_t bandSize = samples / nBands;
 
-            case TLONGLONG:
-                calculateMedian<int64_t>(roi);
-                break;
+    for (int n = 0; n < m_Statistics.channels; n++)
+    {
+        const T *channel = buffer + n * samples;
+        // Summing relative to a sample of the image keeps the variance accurate for large offsets.
+        // Small integers are summed exactly, so they need no shift.
+        const double shift = (samples > 0 && !HasExactHistogram<T>::value) ? static_cast<double>(channel[0]) : 0;
 
-            case TDOUBLE:
-                calculateMedian<double>(roi);
-                break;
+        QList<QFuture<BandStatistics>> futures;
+        for (uint32_t i = 0; i < nBands; i++)
+        {
+            const T *band = channel + i * bandSize;
+            const uint32_t count = (i == nBands - 1) ? samples - i * bandSize : bandSize;
+            futures.append(QtConcurrent::run([band, count, shift, withHistogram]()
+            {
+                return bandStatistics<T>(band, count, shift, withHistogram);
+            }));
+        }
 
-            default:
-                break;
+        BandStatistics total = futures[0].result();
+        for (int i = 1; i < futures.size(); i++)
+        {
+            const BandStatistics band = futures[i].result();
+            total.min = std::min(total.min, band.min);
+            total.max = std::max(total.max, band.max);
+            total.sum += band.sum;
+            total.sumSquares += band.sumSquares;
+            for (size_t j = 0; j < total.histogram.size(); j++)
+                total.histogram[j] += band.histogram[j];
         }
 
+        const double meanOffset = samples > 0 ? total.sum / samples : 0;
+        const double variance = samples > 0 ? total.sumSquares / samples - meanOffset * meanOffset : 0;
+        stats.min[n] = samples > 0 ? total.min : 0;
+        stats.max[n] = samples > 0 ? total.max : 0;
+        stats.mean[n] = shift + meanOffset;
+        stats.stddev[n] = sqrt(std::max(0.0, variance));
+        if (withHistogram)
+            stats.median[n] = histogramMedian<T>(total.histogram, samples);
     }
+
+    if (median && !withHistogram)
+        calculateMedian<T>(roi);
 }
 
 template <typename T>
@@ -1595,6 +1574,7 @@ void FITSData::calculateMedian(bool roi)
 
     for (uint8_t n = 0; n < m_Statistics.channels; n++)
     {
+        samples.clear();
         auto *oneChannel = buffer + n * (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
         for (uint32_t upto = 0; upto < (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
                 upto += downsample)
@@ -1604,159 +1584,17 @@ void FITSData::calculateMedian(bool roi)
     }
 }
 
-template <typename T>
-QPair<T, T> FITSData::getParitionMinMax(uint32_t start, uint32_t stride, bool roi)
-{
-    auto * buffer = reinterpret_cast<T *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
-    T min = std::numeric_limits<T>::max();
-    T max = std::numeric_limits<T>::min();
-
-    uint32_t end = start + stride;
-
-    for (uint32_t i = start; i < end; i++)
-    {
-        min = qMin(buffer[i], min);
-        max = qMax(buffer[i], max);
-        //        if (buffer[i] < min)
-        //            min = buffer[i];
-        //        else if (buffer[i] > max)
-        //            max = buffer[i];
-    }
-
-    return qMakePair(min, max);
-}
-
-template <typename T>
-void FITSData::calculateMinMax(bool roi)
-{
-    T min = std::numeric_limits<T>::max();
-    T max = std::numeric_limits<T>::min();
-
-
-    // Create N threads
-    const uint8_t nThreads = 16;
-
-    for (int n = 0; n < m_Statistics.channels; n++)
-    {
-        uint32_t cStart = n * (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-
-        // Calculate how many elements we process per thread
-        uint32_t tStride = (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) / nThreads;
-
-        // Calculate the final stride since we can have some left over due to division above
-        uint32_t fStride = tStride + ((roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) -
-                                      (tStride * nThreads));
-
-        // Start location for inspecting elements
-        uint32_t tStart = cStart;
-
-        // List of futures
-        QList<QFuture<QPair<T, T>>> futures;
-
-        for (int i = 0; i < nThreads; i++)
-        {
-            // Run threads
-            futures.append(QtConcurrent::run(this, &FITSData::getParitionMinMax<T>, tStart, (i == (nThreads - 1)) ? fStride : tStride,
-                                             roi));
-            tStart += tStride;
-        }
-
-        // Now wait for results
-        for (int i = 0; i < nThreads; i++)
-        {
-            QPair<T, T> result = futures[i].result();
-            min = qMin(result.first, min);
-            max = qMax(result.second, max);
-        }
-
-        if(!roi)
-        {
-            m_Statistics.min[n] = min;
-            m_Statistics.max[n] = max;
-        }
-        else
-        {
-            m_ROIStatistics.min[n] = min;
-            m_ROIStatistics.max[n] = max;
-        }
-    }
-
-}
-
-template <typename T>
-QPair<double, double> FITSData::getSquaredSumAndMean(uint32_t start, uint32_t stride, bool roi)
-{
-    uint32_t m_n       = 2;
-    double m_oldM = 0, m_newM = 0, m_oldS = 0, m_newS = 0;
-
-    auto * buffer = reinterpret_cast<T *>(roi ? m_ImageRoiBuffer : m_ImageBuffer);
-    uint32_t end = start + stride;
-
-    for (uint32_t i = start; i < end; i++)
-    {
-        m_newM = m_oldM + (buffer[i] - m_oldM) / m_n;
-        m_newS = m_oldS + (buffer[i] - m_oldM) * (buffer[i] - m_newM);
-
-        m_oldM = m_newM;
-        m_oldS = m_newS;
-        m_n++;
-    }
-
-    return qMakePair<double, double>(m_newM, m_newS);
-}
-
 template <typename T>
 void FITSData::runningAverageStdDev(bool roi )
 {
-    // Create N threads
-    const uint8_t nThreads = 16;
-
-    for (int n = 0; n < m_Statistics.channels; n++)
+    // Same single pass as calculateStats(), keeping only the mean and standard deviation
+    FITSImage::Statistic &stats = roi ? m_ROIStatistics : m_Statistics;
+    const FITSImage::Statistic previous = stats;
+    calculateStatsInternal<T>(roi, false);
+    for (int i = 0; i < 3; i++)
     {
-        uint32_t cStart = n * (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-
-        // Calculate how many elements we process per thread
-        uint32_t tStride = (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) / nThreads;
-
-        // Calculate the final stride since we can have some left over due to division above
-        uint32_t fStride = tStride + ((roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel) -
-                                      (tStride * nThreads));
-
-        // Start location for inspecting elements
-        uint32_t tStart = cStart;
-
-        // List of futures
-        QList<QFuture<QPair<double, double>>> futures;
-
-        for (int i = 0; i < nThreads; i++)
-        {
-            // Run threads
-            futures.append(QtConcurrent::run(this, &FITSData::getSquaredSumAndMean<T>, tStart,
-                                             (i == (nThreads - 1)) ? fStride : tStride, roi));
-            tStart += tStride;
-        }
-
-        double mean = 0, squared_sum = 0;
-
-        // Now wait for results
-        for (int i = 0; i < nThreads; i++)
-        {
-            QPair<double, double> result = futures[i].result();
-            mean += result.first;
-            squared_sum += result.second;
-        }
-
-        double variance = squared_sum / (roi ? m_ROIStatistics.samples_per_channel : m_Statistics.samples_per_channel);
-        if(!roi)
-        {
-            m_Statistics.mean[n]   = mean / nThreads;
-            m_Statistics.stddev[n] = sqrt(variance);
-        }
-        else
-        {
-            m_ROIStatistics.mean[n] = mean / nThreads;
-            m_ROIStatistics.stddev[n] = sqrt(variance);
-        }
+        stats.min[i] = previous.min[i];
+        stats.max[i] = previous.max[i];
     }
 }
 
@@ -2044,24 +1882,44 @@ QFuture<bool> FITSData::findStars(StarAlgorithm algorithm, const QRect &tracking
     starCenters.clear();
     starsSearched = true;
 
+    QRect searchBox = trackingBox;
+    if (algorithm == ALGORITHM_SEP && m_Mode == FITS_NORMAL && trackingBox.isNull() && Options::quickHFR())
+    {
+        //Just finds stars in the center 25% of the image.
+        const int w = getStatistics().width;
+        const int h = getStatistics().height;
+        searchBox = QRect(static_cast<int>(w * 0.25), static_cast<int>(h * 0.25), w / 2, h / 2);
+    }
+
+    const QByteArray key = starDetectionKey(algorithm, searchBox);
+    for (int i = 0; i < m_StarDetectionCache.size(); i++)
+    {
+        if (m_StarDetectionCache[i].key != key)
+            continue;
+
+        m_StarDetectionCache.move(i, 0);
+        const StarDetection &detection = m_StarDetectionCache.first();
+        for (const auto &edge : detection.stars)
+            starCenters.append(edge->clone());
+        if (algorithm == ALGORITHM_SEP)
+            m_SkyBackground = detection.background;
+
+        QFutureInterface<bool> cached(QFutureInterfaceBase::Started);
+        cached.reportResult(true);
+        cached.reportFinished();
+        m_StarFindFuture = cached.future();
+        return m_StarFindFuture;
+    }
+
+    m_PendingStarDetectionKey = key;
+
     switch (algorithm)
     {
         case ALGORITHM_SEP:
         {
             m_StarDetector.reset(new FITSSEPDetector(this));
             m_StarDetector->setSettings(m_SourceExtractorSettings);
-            if (m_Mode == FITS_NORMAL && trackingBox.isNull())
-            {
-                if (Options::quickHFR())
-                {
-                    //Just finds stars in the center 25% of the image.
-                    const int w = getStatistics().width;
-                    const int h = getStatistics().height;
-                    QRect middle(static_cast<int>(w * 0.25), static_cast<int>(h * 0.25), w / 2, h / 2);
-                    return m_StarDetector->findSources(middle);
-                }
-            }
-            m_StarFindFuture = m_StarDetector->findSources(trackingBox);
+            m_StarFindFuture = m_StarDetector->findSources(searchBox);
             return m_StarFindFuture;
         }
 
@@ -2070,7 +1928,7 @@ QFuture<bool> FITSData::findStars(StarAlgorithm algorithm, const QRect &tracking
         {
             m_StarDetector.reset(new FITSGradientDetector(this));
             m_StarDetector->setSettings(m_SourceExtractorSettings);
-            m_StarFindFuture = m_StarDetector->findSources(trackingBox);
+            m_StarFindFuture = m_StarDetector->findSources(searchBox);
             return m_StarFindFuture;
         }
 
@@ -2083,13 +1941,13 @@ QFuture<bool> FITSData::findStars(StarAlgorithm algorithm, const QRect &tracking
             if (!isHistogramConstructed())
                 constructHistogram();
             m_StarDetector->configure("JMINDEX", m_JMIndex);
-            m_StarFindFuture = m_StarDetector->findSources(trackingBox);
+            m_StarFindFuture = m_StarDetector->findSources(searchBox);
             return m_StarFindFuture;
         }
 #else
             {
                 m_StarDetector.reset(new FITSCentroidDetector(this));
-                m_StarFindFuture = starDetector->findSources(trackingBox);
+                m_StarFindFuture = starDetector->findSources(searchBox);
                 return m_StarFindFuture;
             }
 #endif
@@ -2099,7 +1957,7 @@ QFuture<bool> FITSData::findStars(StarAlgorithm algorithm, const QRect &tracking
             m_StarDetector.reset(new FITSThresholdDetector(this));
             m_StarDetector->setSettings(m_SourceExtractorSettings);
             m_StarDetector->configure("THRESHOLD_PERCENTAGE", Options::focusThreshold());
-            m_StarFindFuture =  m_StarDetector->findSources(trackingBox);
+            m_StarFindFuture =  m_StarDetector->findSources(searchBox);
             return m_StarFindFuture;
         }
 
@@ -2108,21 +1966,78 @@ QFuture<bool> FITSData::findStars(StarAlgorithm algorithm, const QRect &tracking
             m_StarDetector.reset(new FITSBahtinovDetector(this));
             m_StarDetector->setSettings(m_SourceExtractorSettings);
             m_StarDetector->configure("NUMBER_OF_AVERAGE_ROWS", Options::focusMultiRowAverage());
-            m_StarFindFuture = m_StarDetector->findSources(trackingBox);
+            m_StarFindFuture = m_StarDetector->findSources(searchBox);
             return m_StarFindFuture;
         }
     }
 }
 
+QByteArray FITSData::starDetectionKey(StarAlgorithm algorithm, const QRect &boundary) const
+{
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream << static_cast<int>(algorithm) << boundary << m_SourceExtractorSettings;
+
+    // Options read by the detectors
+    if (algorithm == ALGORITHM_THRESHOLD)
+        stream << Options::focusThreshold();
+    else if (algorithm == ALGORITHM_BAHTINOV)
+        stream << Options::focusMultiRowAverage();
+
+    return key;
+}
+
+void FITSData::cacheStarDetection()
+{
+    if (m_PendingStarDetectionKey.isEmpty())
+        return;
+
+    StarDetection detection;
+    detection.key = m_PendingStarDetectionKey;
+    m_PendingStarDetectionKey.clear();
+
+    for (const auto &edge : starCenters)
+        detection.stars.append(edge->clone());
+    detection.background = m_SkyBackground;
+    m_StarDetectionCache.prepend(detection);
+
+    // Focus and guiding search a few boxes at most on a frame
+    while (m_StarDetectionCache.size() > 4)
+        qDeleteAll(m_StarDetectionCache.takeLast().stars);
+}
+
+void FITSData::clearStarDetectionCache()
+{
+    // A running detector adds its stars to the cache
+    if (m_StarFindFuture.isRunning())
+        m_StarFindFuture.waitForFinished();
+
+    for (auto &detection : m_StarDetectionCache)
+        qDeleteAll(detection.stars);
+    m_StarDetectionCache.clear();
+    m_PendingStarDetectionKey.clear();
+}
+
+void FITSData::setStarCenters(const QList<Edge*> &centers)
+{
+    qDeleteAll(starCenters);
+    starCenters = centers;
+
+    // Cache the stars as found, before filterStars() or getHFR() prune or reorder them. Detectors only set them on
+    // success, from the thread running the detection, while findStars() waits for it to finish.
+    cacheStarDetection();
+}
+
 int FITSData::filterStars(QSharedPointer<ImageMask> mask)
 {
     if (mask.isNull() == false)
     {
-        starCenters.erase(std::remove_if(starCenters.begin(), starCenters.end(),
-                                         [&](Edge * edge)
+        auto hidden = std::stable_partition(starCenters.begin(), starCenters.end(), [&](Edge * edge)
         {
-            return (mask->isVisible(edge->x, edge->y) == false);
-        }), starCenters.end());
+            return mask->isVisible(edge->x, edge->y);
+        });
+        qDeleteAll(hidden, starCenters.end());
+        starCenters.erase(hidden, starCenters.end());
     }
 
     return starCenters.count();
@@ -2279,6 +2194,10 @@ void FITSData::applyFilter(FITSScale type, uint8_t * image, QVector<double> * mi
     if (type == FITS_NONE)
         return;
 
+    // Filtering the image data itself invalidates its detections
+    if (image == nullptr)
+        clearStarDetectionCache();
+
     QVector<double> dataMin(3);
     QVector<double> dataMax(3);
 
@@ -2888,13 +2807,13 @@ bool FITSData::searchObjects()
 
     m_ObjectsSearched = true;
 
-    SkyPoint startPoint;
-    SkyPoint endPoint;
-
-    pixelToWCS(QPointF(0, 0), startPoint);
-    pixelToWCS(QPointF(width() - 1, height() - 1), endPoint);
+    // The footprint of the image, in order around it
+    QVector<SkyPoint> corners(4);
+    if (!pixelToWCS(QPointF(0, 0), corners[0]) || !pixelToWCS(QPointF(width() - 1, 0), corners[1]) ||
+            !pixelToWCS(QPointF(width() - 1, height() - 1), corners[2]) || !pixelToWCS(QPointF(0, height() - 1), corners[3]))
+        return false;
 
-    return findObjectsInImage(startPoint, endPoint);
+    return findObjectsInImage(corners);
 }
 
 bool FITSData::findWCSBounds(double &minRA, double &maxRA, double &minDec, double &maxDec)
@@ -2963,65 +2882,50 @@ bool FITSData::findWCSBounds(double &minRA, double &maxRA, double &minDec, doubl
 #endif
 
 #if !defined(KSTARS_LITE) && defined(HAVE_WCSLIB)
-bool FITSData::findObjectsInImage(SkyPoint startPoint, SkyPoint endPoint)
+bool FITSData::findObjectsInImage(const QVector<SkyPoint> &corners)
 {
     if (KStarsData::Instance() == nullptr)
         return false;
 
     int w = width();
     int h = height();
-    QVariant date;
-    KSNumbers * num = nullptr;
-
-    if (getRecordValue("DATE-OBS", date))
-    {
-        QString tsString(date.toString());
-        tsString = tsString.remove('\'').trimmed();
-        // Add Zulu time to indicate UTC
-        tsString += "Z";
-
-        QDateTime ts = QDateTime::fromString(tsString, Qt::ISODate);
-
-        if (ts.isValid())
-            num = new KSNumbers(KStarsDateTime(ts).djd());
-    }
-
-    //Set to current time if the above does not work.
-    if (num == nullptr)
-        num = new KSNumbers(KStarsData::Instance()->ut().djd());
-
-    startPoint.updateCoordsNow(num);
-    endPoint.updateCoordsNow(num);
 
+    qDeleteAll(m_SkyObjects);
     m_SkyObjects.clear();
 
-    QList<SkyObject *> list = KStarsData::Instance()->skyComposite()->findObjectsInArea(startPoint, endPoint);
-    list.erase(std::remove_if(list.begin(), list.end(), [](SkyObject * oneObject)
-    {
-        int type = oneObject->type();
-        return (type == SkyObject::STAR || type == SkyObject::PLANET || type == SkyObject::ASTEROID ||
-                type == SkyObject::COMET || type == SkyObject::SUPERNOVA || type == SkyObject::MOON ||
-                type == SkyObject::SATELLITE);
-    }), list.end());
+    // Only the deep sky objects are shown, the catalog coordinates of the corners are those of the image
+    SkyMapComposite *composite = KStarsData::Instance()->skyComposite();
+    if (!composite->catalogsComponent()->selected())
+        return true;
+
+    SkyQueryResults results;
+    composite->objectsInRegion(SkyQueryRegion::polygon(corners), std::numeric_limits<float>::max(), results,
+                               SkyQueryResults::CATALOGS);
 
     double world[2], phi, theta, imgcrd[2], pixcrd[2];
     int stat[2];
-    for (auto &object : list)
+    for (const auto &entry : results)
     {
-        world[0] = object->ra0().Degrees();
-        world[1] = object->dec0().Degrees();
+        int type = entry.type;
+        if (type == SkyObject::STAR || type == SkyObject::PLANET || type == SkyObject::ASTEROID ||
+                type == SkyObject::COMET || type == SkyObject::SUPERNOVA || type == SkyObject::MOON ||
+                type == SkyObject::SATELLITE)
+            continue;
+
+        world[0] = entry.ra0;
+        world[1] = entry.dec0;
 
         if (wcss2p(m_WCSHandle, 1, 2, &world[0], &phi, &theta, &imgcrd[0], &pixcrd[0], &stat[0]) == 0)
         {
             //The X and Y are set to the found position if it does work.
             int x = pixcrd[0];
             int y = pixcrd[1];
+            // The objects of the frame are copies, they are not added to the sky composite
             if (x > 0 && y > 0 && x < w && y < h)
-                m_SkyObjects.append(new FITSSkyObject(object, x, y));
+                m_SkyObjects.append(new FITSSkyObject(std::unique_ptr<SkyObject>(entry.object->clone()), x, y));
         }
     }
 
-    delete (num);
     return true;
 }
 #endif
@@ -3064,6 +2968,8 @@ void FITSData::setRotCounter(int value)
 template <typename T>
 bool FITSData::rotFITS(int rotate, int mirror)
 {
+    clearStarDetectionCache();
+
     int ny, nx;
     int x1, y1, x2, y2;
     uint8_t * rotimage = nullptr;
@@ -3084,7 +2990,7 @@ bool FITSData::rotFITS(int rotate, int mirror)
     int BBP = m_Statistics.bytesPerPixel;
 
     /* Allocate buffer for rotated image */
-    rotimage = new uint8_t[m_Statistics.samples_per_channel * m_Statistics.channels * BBP];
+    rotimage = allocateBuffer(m_Statistics.samples_per_channel * m_Statistics.channels * BBP);
 
     if (rotimage == nullptr)
     {
@@ -3307,8 +3213,9 @@ bool FITSData::rotFITS(int rotate, int mirror)
         }
     }
 
-    delete[] m_ImageBuffer;
+    freeImageBuffer();
     m_ImageBuffer = rotimage;
+    m_ImageBufferSize = m_Statistics.samples_per_channel * m_Statistics.channels * BBP;
 
     return true;
 }
@@ -3598,6 +3505,8 @@ void FITSData::rotWCSFITS(int angle, int mirror)
 
 uint8_t * FITSData::getWritableImageBuffer()
 {
+    // The caller may change the image, e.g. to subtract a dark frame
+    clearStarDetectionCache();
     return m_ImageBuffer;
 }
 
@@ -3608,8 +3517,10 @@ uint8_t const * FITSData::getImageBuffer() const
 
 void FITSData::setImageBuffer(uint8_t * buffer)
 {
-    delete[] m_ImageBuffer;
+    clearStarDetectionCache();
+    freeImageBuffer();
     m_ImageBuffer = buffer;
+    m_ExternalImageBuffer = true;
 }
 
 bool FITSData::checkDebayer()
@@ -3714,10 +3625,34 @@ void FITSData::setBayerParams(BayerParams * param)
 
 bool FITSData::debayer(bool reload)
 {
+    clearStarDetectionCache();
+
     if (reload)
     {
         int anynull = 0, status = 0;
 
+        // Superpixel debayering halves the image, so restore the Bayer frame size
+        long naxes[2] = { 0, 0 };
+        if (fits_get_img_size(fptr, 2, naxes, &status))
+            return false;
+
+        m_Statistics.width = naxes[0];
+        m_Statistics.height = naxes[1];
+        m_Statistics.samples_per_channel = m_Statistics.width * m_Statistics.height;
+
+        const uint32_t bayer_size = m_Statistics.samples_per_channel * m_Statistics.bytesPerPixel;
+        if (m_ImageBufferSize < bayer_size)
+        {
+            freeImageBuffer();
+            m_ImageBuffer = allocateBuffer(bayer_size);
+            if (m_ImageBuffer == nullptr)
+            {
+                logOOMError(bayer_size);
+                return false;
+            }
+            m_ImageBufferSize = bayer_size;
+        }
+
         if (fits_read_img(fptr, m_Statistics.dataType, 1, m_Statistics.samples_per_channel, nullptr, m_ImageBuffer,
                           &anynull, &status))
         {
@@ -3741,24 +3676,52 @@ bool FITSData::debayer(bool reload)
     }
 }
 
-bool FITSData::debayer_8bit()
+template <typename T>
+bool FITSData::debayer()
 {
-    dc1394error_t error_code;
-
-    uint32_t rgb_size = m_Statistics.samples_per_channel * 3 * m_Statistics.bytesPerPixel;
-    uint8_t * destinationBuffer = nullptr;
+    BayerDemosaic demosaic(debayerParams);
+    const QSize size = demosaic.outputSize(m_Statistics.width, m_Statistics.height);
+    const uint32_t rgb_size = size.width() * size.height() * 3 * m_Statistics.bytesPerPixel;
 
-    try
+    // The planes are written directly into the new image buffer
+    uint8_t *destinationBuffer = allocateBuffer(rgb_size);
+    if (destinationBuffer == nullptr)
     {
-        destinationBuffer = new uint8_t[rgb_size];
+        logOOMError(rgb_size);
+        m_LastError = i18n("Unable to allocate memory for temporary bayer buffer.");
+        return false;
     }
-    catch (const std::bad_alloc &e)
+
+    if (!demosaic.run(reinterpret_cast<const T *>(m_ImageBuffer), m_Statistics.width, m_Statistics.height,
+                      reinterpret_cast<T *>(destinationBuffer)))
     {
-        logOOMError(rgb_size);
-        m_LastError = i18n("Unable to allocate memory for temporary bayer buffer: %1", e.what());
+        m_LastError = i18n("Unsupported bayer image size %1x%2.", m_Statistics.width, m_Statistics.height);
+        m_Statistics.channels = 1;
+        freeBuffer(destinationBuffer, rgb_size);
         return false;
     }
 
+    freeImageBuffer();
+    m_ImageBuffer = destinationBuffer;
+    m_ImageBufferSize = rgb_size;
+
+    m_Statistics.width = size.width();
+    m_Statistics.height = size.height();
+    m_Statistics.samples_per_channel = m_Statistics.width * m_Statistics.height;
+    m_Statistics.channels = (m_Mode == FITS_NORMAL || m_Mode == FITS_CALIBRATE) ? 3 : 1;
+    return true;
+}
+
+bool FITSData::debayer_8bit()
+{
+    if (BayerDemosaic::isSupported(debayerParams.method))
+        return debayer<uint8_t>();
+
+    dc1394error_t error_code;
+
+    uint32_t rgb_size = m_Statistics.samples_per_channel * 3 * m_Statistics.bytesPerPixel;
+    uint8_t * destinationBuffer = allocateBuffer(rgb_size);
+
     auto * bayer_source_buffer      = reinterpret_cast<uint8_t *>(m_ImageBuffer);
     auto * bayer_destination_buffer = reinterpret_cast<uint8_t *>(destinationBuffer);
 
@@ -3787,22 +3750,19 @@ bool FITSData::debayer_8bit()
     {
         m_LastError = i18n("Debayer failed (%1)", error_code);
         m_Statistics.channels = 1;
-        delete[] destinationBuffer;
+        freeBuffer(destinationBuffer, rgb_size);
         return false;
     }
 
     if (m_ImageBufferSize != rgb_size)
     {
-        delete[] m_ImageBuffer;
-        try
+        freeImageBuffer();
+        m_ImageBuffer = allocateBuffer(rgb_size);
+        if (m_ImageBuffer == nullptr)
         {
-            m_ImageBuffer = new uint8_t[rgb_size];
-        }
-        catch (const std::bad_alloc &e)
-        {
-            delete[] destinationBuffer;
+            freeBuffer(destinationBuffer, rgb_size);
             logOOMError(rgb_size);
-            m_LastError = i18n("Unable to allocate memory for temporary bayer buffer: %1", e.what());
+            m_LastError = i18n("Unable to allocate memory for temporary bayer buffer.");
             return false;
         }
 
@@ -3830,26 +3790,19 @@ bool FITSData::debayer_8bit()
     // frames
     m_Statistics.channels = (m_Mode == FITS_NORMAL || m_Mode == FITS_CALIBRATE) ? 3 : 1;
     m_Statistics.dataType = TBYTE;
-    delete[] destinationBuffer;
+    freeBuffer(destinationBuffer, rgb_size);
     return true;
 }
 
 bool FITSData::debayer_16bit()
 {
+    if (BayerDemosaic::isSupported(debayerParams.method))
+        return debayer<uint16_t>();
+
     dc1394error_t error_code;
 
     uint32_t rgb_size = m_Statistics.samples_per_channel * 3 * m_Statistics.bytesPerPixel;
-    uint8_t *destinationBuffer = nullptr;
-    try
-    {
-        destinationBuffer = new uint8_t[rgb_size];
-    }
-    catch (const std::bad_alloc &e)
-    {
-        logOOMError(rgb_size);
-        m_LastError = i18n("Unable to allocate memory for temporary bayer buffer: %1", e.what());
-        return false;
-    }
+    uint8_t *destinationBuffer = allocateBuffer(rgb_size);
 
     auto * bayer_source_buffer      = reinterpret_cast<uint16_t *>(m_ImageBuffer);
     auto * bayer_destination_buffer = reinterpret_cast<uint16_t *>(destinationBuffer);
@@ -3879,22 +3832,19 @@ bool FITSData::debayer_16bit()
     {
         m_LastError = i18n("Debayer failed (%1)");
         m_Statistics.channels = 1;
-        delete[] destinationBuffer;
+        freeBuffer(destinationBuffer, rgb_size);
         return false;
     }
 
     if (m_ImageBufferSize != rgb_size)
     {
-        delete[] m_ImageBuffer;
-        try
-        {
-            m_ImageBuffer = new uint8_t[rgb_size];
-        }
-        catch (const std::bad_alloc &e)
+        freeImageBuffer();
+        m_ImageBuffer = allocateBuffer(rgb_size);
+        if (m_ImageBuffer == nullptr)
         {
             logOOMError(rgb_size);
-            delete[] destinationBuffer;
-            m_LastError = i18n("Unable to allocate memory for temporary bayer buffer: %1", e.what());
+            freeBuffer(destinationBuffer, rgb_size);
+            m_LastError = i18n("Unable to allocate memory for temporary bayer buffer.");
             return false;
         }
 
@@ -3919,7 +3869,7 @@ bool FITSData::debayer_16bit()
 
     m_Statistics.channels = (m_Mode == FITS_NORMAL || m_Mode == FITS_CALIBRATE) ? 3 : 1;
     m_Statistics.dataType = TUSHORT;
-    delete[] destinationBuffer;
+    freeBuffer(destinationBuffer, rgb_size);
     return true;
 }
 
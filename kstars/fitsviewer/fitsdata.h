@@ -23,6 +23,7 @@
 #include "skybackground.h"
 #include "fitscommon.h"
 #include "fitsstardetector.h"
+#include "fitsbufferpool.h"
 #include "auxiliary/imagemask.h"
 
 #ifdef WIN32
@@ -79,7 +80,13 @@ class FITSData : public QObject
         Q_PROPERTY(bool hasDebayer READ hasDebayer)
 
     public:
-        explicit FITSData(FITSMode fitsMode = FITS_NORMAL);
+        /**
+         * @param fitsMode mode of the image
+         * @param bufferPool if set, image buffers are acquired from and released to this pool,
+         * e.g. one owned by the camera chip the frames come from.
+         */
+        explicit FITSData(FITSMode fitsMode = FITS_NORMAL,
+                          const QSharedPointer<FITSBufferPool> &bufferPool = QSharedPointer<FITSBufferPool>());
         explicit FITSData(const QSharedPointer<FITSData> &other);
         ~FITSData() override;
 
@@ -297,12 +304,16 @@ class FITSData : public QObject
         }
         QList<Edge *> getStarCentersInSubFrame(QRect subFrame) const;
 
-        void setStarCenters(const QList<Edge*> &centers)
-        {
-            qDeleteAll(starCenters);
-            starCenters = centers;
-        }
+        /** @brief setStarCenters Set the stars found by a detector, caching them for the search findStars() runs. */
+        void setStarCenters(const QList<Edge*> &centers);
+        /**
+         * @brief findStars Detect the stars of the image, or of the tracking box if set.
+         * Detections are cached by algorithm, detector settings and search box until the image data changes,
+         * so a repeated search on the same frame returns an already finished future.
+         */
         QFuture<bool> findStars(StarAlgorithm algorithm = ALGORITHM_CENTROID, const QRect &trackingBox = QRect());
+        /** @brief clearStarDetectionCache Forget the cached detections, forcing the next findStars() to run the detector. */
+        void clearStarDetectionCache();
 
         void setSkyBackground(const SkyBackground &bg)
         {
@@ -325,7 +336,7 @@ class FITSData : public QObject
         void getFloatBuffer(float *buffer, int x, int y, int w, int h) const;
         //int findSEPStars(QList<Edge*> &, const int8_t &boundary = int8_t()) const;
 
-        // filter all stars that are visible through the given mask
+        // filter all stars that are visible through the given mask. The cached detections are not filtered.
         int filterStars(QSharedPointer<ImageMask> mask);
 
         // Half Flux Radius
@@ -430,6 +441,8 @@ class FITSData : public QObject
          * @brief debayer the 1-channel data to 3-channel RGB using the default debayer pattern detected in the FITS header.
          * @param reload If true, it will read the image again from disk before performing debayering. This is necessary to attempt
          * subsequent debayering processes on an already debayered image.
+         * @note The superpixel method (DC1394_BAYER_METHOD_DOWNSAMPLE) bins each 2x2 Bayer cell, halving the image width and
+         * height. The header and WCS still describe the Bayer frame.
          */
         bool debayer(bool reload = false);
         bool debayer_8bit();
@@ -539,7 +552,7 @@ class FITSData : public QObject
 #ifndef KSTARS_LITE
 #ifdef HAVE_WCSLIB
         bool searchObjects();
-        bool findObjectsInImage(SkyPoint startPoint, SkyPoint endPoint);
+        bool findObjectsInImage(const QVector<SkyPoint> &corners);
         bool findWCSBounds(double &minRA, double &maxRA, double &minDec, double &maxDec);
 #endif
 #endif
@@ -605,8 +618,6 @@ class FITSData : public QObject
         bool loadRAWImage(const QByteArray &buffer);
 
         void rotWCSFITS(int angle, int mirror);
-        void calculateMinMax(bool refresh = false, bool roi = false);
-        void calculateMedian(bool refresh = false, bool roi = false);
         bool checkDebayer();
         void readWCSKeys();
 
@@ -614,11 +625,22 @@ class FITSData : public QObject
         void recordLastError(int errorCode);
         void logOOMError(uint32_t requiredMemory = 0);
 
+        // Allocate and free image buffers, through the buffer pool if there is one.
+        uint8_t *allocateBuffer(uint32_t size);
+        void freeBuffer(uint8_t *buffer, uint32_t size);
+        // Free m_ImageBuffer, which may have been given by setImageBuffer()
+        void freeImageBuffer();
+
+        // Star detection cache
+        QByteArray starDetectionKey(StarAlgorithm algorithm, const QRect &boundary) const;
+        void cacheStarDetection();
+
         // FITS Record
         bool parseHeader();
         //int getFITSRecord(QString &recordList, int &nkeys);
 
         // Templated functions
+        // Demosaic into planar RGB with BayerDemosaic, for the methods it supports
         template <typename T>
         bool debayer();
 
@@ -629,14 +651,14 @@ class FITSData : public QObject
         template <typename T>
         void applyFilter(FITSScale type, uint8_t *targetImage, QVector<double> * min = nullptr, QVector<double> * max = nullptr);
 
+        /* Calculate min, max, mean, standard deviation and optionally the median of each channel in one
+           multithreaded pass. The median is exact from a histogram for 8 and 16 bit integer data. */
         template <typename T>
-        void calculateMinMax(bool roi = false);
+        void calculateStatsInternal(bool roi = false, bool median = true);
+        /* Calculate the median from a subsample of the data, for types without a histogram median */
         template <typename T>
         void calculateMedian(bool roi = false);
 
-        template <typename T>
-        QPair<T, T> getParitionMinMax(uint32_t start, uint32_t stride, bool roi);
-
         /* Calculate the Gaussian blur matrix and apply it to the image using the convolution filter */
         QVector<double> createGaussianKernel(int size, double sigma);
         template <typename T>
@@ -644,11 +666,9 @@ class FITSData : public QObject
         template <typename T>
         void gaussianBlur(int kernelSize, double sigma);
 
-        /* Calculate running average & standard deviation using Welford’s method for computing variance */
+        /* Calculate average & standard deviation only, leaving the other statistics untouched */
         template <typename T>
         void runningAverageStdDev( bool roi = false );
-        template <typename T>
-        QPair<double, double> getSquaredSumAndMean(uint32_t start, uint32_t stride, bool roi = false);
 
         template <typename T>
         void convertToQImage(double dataMin, double dataMax, double scale, double zero, QImage &image);
@@ -672,6 +692,10 @@ class FITSData : public QObject
         uint8_t *m_ImageRoiBuffer { nullptr };
         /// Above buffer size in bytes
         uint32_t m_ImageRoiBufferSize { 0 };
+        /// Pool image buffers come from, if any
+        QSharedPointer<FITSBufferPool> m_BufferPool;
+        /// Was m_ImageBuffer given by setImageBuffer() rather than allocated here?
+        bool m_ExternalImageBuffer { false };
         /// Is this a temporary file or one loaded from disk?
         bool m_isTemporary { false };
         /// is this file compress (.fits.fz)?
@@ -759,6 +783,17 @@ class FITSData : public QObject
         QFuture<bool> m_StarFindFuture;
         QScopedPointer<FITSStarDetector, QScopedPointerDeleteLater> m_StarDetector;
 
+        // Detections of the current image data, most recently used first
+        struct StarDetection
+        {
+            QByteArray key;
+            QList<Edge *> stars;
+            SkyBackground background;
+        };
+        QList<StarDetection> m_StarDetectionCache;
+        // Key of the detection m_StarFindFuture is running, cached when its detector sets the stars
+        QByteArray m_PendingStarDetectionKey;
+
         // Cached values for hfr and eccentricity computations
         double cacheHFR { -1 };
         HFRType cacheHFRType { HFR_AVERAGE };
@@ -16,6 +16,8 @@
 #include "kstarsdata.h"
 #include "Options.h"
 #include "skymap.h"
+#include "skycomponents/catalogscomponent.h"
+#include "skycomponents/skymapcomposite.h"
 #include "ksnotification.h"
 #include <QGuiApplication>
 
@@ -26,6 +28,8 @@
 #include "indi/indimount.h"
 #endif
 
+#include <QPainter>
+#include <QPaintEvent>
 #include <QScrollBar>
 #include <QToolTip>
 
@@ -109,6 +113,19 @@ void FITSLabel::leaveEvent(QEvent *e)
     emit mouseOverPixel(-1, -1);
 }
 
+void FITSLabel::paintEvent(QPaintEvent *e)
+{
+    // Large images are drawn by the view from its tiles rather than from a pixmap.
+    if (view->isTiledRendering())
+    {
+        QPainter painter(this);
+        view->drawTiles(&painter, e->rect());
+        return;
+    }
+
+    QLabel::paintEvent(e);
+}
+
 /**
 I added some things to the top of this method to allow panning and Scope slewing to function.
 If you are in the dragMouse mode and the mousebutton is pressed, The method checks the difference
@@ -364,7 +381,10 @@ void FITSLabel::mousePressEvent(QMouseEvent *e)
             {
                 if ((std::abs(listObject->x() - x) < 10 / scale) && (std::abs(listObject->y() - y) < 10 / scale))
                 {
+                    // The objects of the frame are copies, the sky map keeps the clicked one
                     SkyObject *object = listObject->skyObject();
+                    if (auto catalogObject = dynamic_cast<CatalogObject *>(object))
+                        object = &KStarsData::Instance()->skyComposite()->catalogsComponent()->insertStaticObject(*catalogObject);
                     KSPopupMenu *pmenu;
                     pmenu = new KSPopupMenu();
                     object->initPopupMenu(pmenu);
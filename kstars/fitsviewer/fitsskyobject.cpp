@@ -10,6 +10,8 @@
 
 #include "fitsskyobject.h"
 
+#include "skyobjects/skyobject.h"
+
 FITSSkyObject::FITSSkyObject(SkyObject /*const*/ * object, int xPos, int yPos) : QObject()
 {
     skyObjectStored = object;
@@ -17,6 +19,14 @@ FITSSkyObject::FITSSkyObject(SkyObject /*const*/ * object, int xPos, int yPos) :
     yLoc            = yPos;
 }
 
+FITSSkyObject::FITSSkyObject(std::unique_ptr<SkyObject> object, int xPos, int yPos)
+    : FITSSkyObject(object.get(), xPos, yPos)
+{
+    skyObjectOwned = std::move(object);
+}
+
+FITSSkyObject::~FITSSkyObject() = default;
+
 SkyObject /*const*/ * FITSSkyObject::skyObject()
 {
     return skyObjectStored;
@@ -13,6 +13,8 @@
 
 #include <QObject>
 
+#include <memory>
+
 class SkyObject;
 
 class FITSSkyObject : public QObject
@@ -26,6 +28,14 @@ public:
      */
     explicit FITSSkyObject(SkyObject /*const*/ *object, int xPos, int yPos);
 
+    /** @brief Locate a SkyObject owned by this instance at a pixel position.
+     * @param object is the SkyObject to locate in the frame, deleted with this instance.
+     * @param xPos and yPos are the pixel position of the SkyObject in the frame.
+     */
+    explicit FITSSkyObject(std::unique_ptr<SkyObject> object, int xPos, int yPos);
+
+    ~FITSSkyObject() override;
+
 public:
     /** @brief Getting the SkyObject this instance locates.
      */
@@ -47,6 +57,7 @@ public:
 
 protected:
     SkyObject /*const*/ *skyObjectStored { nullptr };
+    std::unique_ptr<SkyObject> skyObjectOwned;
     int xLoc { 0 };
     int yLoc { 0 };
 };
@@ -21,6 +21,10 @@ class Edge
 {
     public:
         virtual ~Edge() = default;
+        virtual Edge *clone() const
+        {
+            return new Edge(*this);
+        }
         void invalidate()
         {
             x = y = val = HFR = -1;
@@ -40,6 +44,10 @@ class BahtinovEdge : public Edge
 {
     public:
         virtual ~BahtinovEdge() = default;
+        Edge *clone() const override
+        {
+            return new BahtinovEdge(*this);
+        }
         QVector<QLineF> line;
         QPointF offset;
 };
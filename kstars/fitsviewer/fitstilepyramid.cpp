@@ -0,0 +1,183 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fitstilepyramid.h"
+
+#include <QPainter>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Levels beyond this one would be smaller than a pixel for any image QImage can hold
+constexpr int MAX_LEVEL = 16;
+// A tile pixel averages at most MAX_SAMPLES x MAX_SAMPLES image pixels, evenly spread over the area it covers
+constexpr int MAX_SAMPLES = 4;
+}
+
+FITSTilePyramid::FITSTilePyramid(qint64 budget, QObject *parent) : QObject(parent)
+{
+    m_Tiles.setMaxCost(static_cast<int>(std::max<qint64>(1, budget / 1024)));
+}
+
+FITSTilePyramid::~FITSTilePyramid()
+{
+    // Tiles still being computed post their result to this object, make sure none is left running.
+    m_Pool.clear();
+    m_Pool.waitForDone();
+}
+
+void FITSTilePyramid::setImage(const QImage &image)
+{
+    m_Pool.clear();
+    m_Generation++;
+    m_Tiles.clear();
+    m_Pending.clear();
+    m_Image = image;
+}
+
+void FITSTilePyramid::clear()
+{
+    setImage(QImage());
+}
+
+int FITSTilePyramid::levelForScale(double scale)
+{
+    if (scale >= 1 || scale <= 0)
+        return 0;
+
+    return std::min(MAX_LEVEL, static_cast<int>(std::floor(std::log2(1.0 / scale))));
+}
+
+quint64 FITSTilePyramid::tileKey(int level, int x, int y)
+{
+    return (static_cast<quint64>(level) << 56) | (static_cast<quint64>(y) << 28) | static_cast<quint64>(x);
+}
+
+QImage FITSTilePyramid::renderTile(const QImage &image, int level, int x, int y)
+{
+    const int factor = 1 << level;
+    const int span = TILE_SIZE * factor;
+    const QRect area = QRect(x * span, y * span, span, span) & image.rect();
+    const int width = (area.width() + factor - 1) / factor;
+    const int height = (area.height() + factor - 1) / factor;
+    const int step = std::max(1, factor / MAX_SAMPLES);
+    const bool grayscale = image.format() == QImage::Format_Indexed8 || image.format() == QImage::Format_Grayscale8;
+
+    // The display image of a mono frame is indexed with an identity grayscale palette, so the indices are the levels.
+    QImage tile(width, height, grayscale ? QImage::Format_Grayscale8 : QImage::Format_RGB32);
+
+    for (int j = 0; j < height; j++)
+    {
+        const int top = area.top() + j * factor;
+        const int bottom = std::min(top + factor, area.bottom() + 1);
+        uint8_t *grayLine = tile.scanLine(j);
+        QRgb *rgbLine = reinterpret_cast<QRgb *>(tile.scanLine(j));
+
+        for (int i = 0; i < width; i++)
+        {
+            const int left = area.left() + i * factor;
+            const int right = std::min(left + factor, area.right() + 1);
+            uint32_t red = 0, green = 0, blue = 0, count = 0;
+
+            for (int row = top; row < bottom; row += step)
+            {
+                if (grayscale)
+                {
+                    const uint8_t *line = image.constScanLine(row);
+                    for (int column = left; column < right; column += step, count++)
+                        red += line[column];
+                }
+                else
+                {
+                    const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(row));
+                    for (int column = left; column < right; column += step, count++)
+                    {
+                        red += qRed(line[column]);
+                        green += qGreen(line[column]);
+                        blue += qBlue(line[column]);
+                    }
+                }
+            }
+
+            if (grayscale)
+                grayLine[i] = (red + count / 2) / count;
+            else
+                rgbLine[i] = qRgb((red + count / 2) / count, (green + count / 2) / count, (blue + count / 2) / count);
+        }
+    }
+
+    return tile;
+}
+
+void FITSTilePyramid::requestTile(int level, int x, int y)
+{
+    const quint64 key = tileKey(level, x, y);
+    if (m_Pending.contains(key))
+        return;
+
+    m_Pending.insert(key);
+
+    const QImage image = m_Image;
+    const quint32 generation = m_Generation;
+    QtConcurrent::run(&m_Pool, [this, image, level, x, y, key, generation]()
+    {
+        const QImage tile = renderTile(image, level, x, y);
+
+        QMetaObject::invokeMethod(this, [this, tile, key, generation]()
+        {
+            // The image changed while the tile was computed
+            if (generation != m_Generation)
+                return;
+
+            m_Pending.remove(key);
+            m_Tiles.insert(key, new QImage(tile), std::max(1, static_cast<int>(tile.sizeInBytes() / 1024)));
+            emit tileReady();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void FITSTilePyramid::draw(QPainter *painter, const QRectF &region, double scale)
+{
+    const QRect area = region.toAlignedRect() & m_Image.rect();
+    if (area.isEmpty())
+        return;
+
+    const int level = levelForScale(scale);
+
+    // At full resolution, tiles would only be copies of the image.
+    if (level == 0)
+    {
+        painter->drawImage(area, m_Image, area);
+        return;
+    }
+
+    const int factor = 1 << level;
+    const int span = TILE_SIZE * factor;
+
+    for (int y = area.top() / span; y <= area.bottom() / span; y++)
+    {
+        for (int x = area.left() / span; x <= area.right() / span; x++)
+        {
+            const QRect tileArea = QRect(x * span, y * span, span, span) & m_Image.rect();
+            const QImage *tile = m_Tiles.object(tileKey(level, x, y));
+
+            if (tile != nullptr)
+                painter->drawImage(QRectF(tileArea), *tile,
+                                   QRectF(0, 0, tileArea.width() / static_cast<double>(factor),
+                                          tileArea.height() / static_cast<double>(factor)));
+            else
+            {
+                // Subsample the image until the tile is ready.
+                const QRect visible = tileArea & area;
+                painter->drawImage(visible, m_Image, visible);
+                requestTile(level, x, y);
+            }
+        }
+    }
+}
@@ -0,0 +1,103 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+class QPainter;
+
+/**
+ * @class FITSTilePyramid
+ * @short Lazily populated multi-resolution tile pyramid of a stretched display image.
+ *
+ * Level 0 is the display image itself and each level above it halves its resolution. A level is cut
+ * in TILE_SIZE x TILE_SIZE tiles which are only computed when a view draws the area they cover, on a
+ * background thread pool, by averaging the display image pixels they cover. Computed tiles are kept in
+ * a least recently used cache bounded by a memory budget.
+ *
+ * While a tile is being computed, its area is drawn directly from the display image, and tileReady()
+ * is emitted once it is available so the view can repaint.
+ *
+ * FITSView uses it to render large images: drawing a zoomed out frame then only reads the tiles in view
+ * instead of scaling the full frame on every zoom or scroll.
+ */
+class FITSTilePyramid : public QObject
+{
+        Q_OBJECT
+
+    public:
+        /// Size of the tiles, in pixels of their level
+        static constexpr int TILE_SIZE = 256;
+
+        /**
+         * @param budget maximum size in bytes of the cached tiles
+         */
+        explicit FITSTilePyramid(qint64 budget = 256 * 1024 * 1024, QObject *parent = nullptr);
+        virtual ~FITSTilePyramid() override;
+
+        /**
+         * @brief setImage Set the display image the pyramid is built from and drop all the tiles.
+         * @param image 8 bit indexed grayscale or 32 bit RGB image. It is shared, not copied, and must
+         * be replaced with a new setImage() call when modified.
+         */
+        void setImage(const QImage &image);
+
+        /** @brief clear Drop the image and all tiles, and cancel pending tiles. */
+        void clear();
+
+        const QImage &image() const
+        {
+            return m_Image;
+        }
+
+        /**
+         * @brief levelForScale Select the level to draw the image at a given scale.
+         * @param scale ratio of the device pixels to the image pixels
+         * @return the coarsest level whose resolution is at least the device resolution
+         */
+        static int levelForScale(double scale);
+
+        /**
+         * @brief draw Draw a region of the image.
+         * @param painter painter whose transform maps image pixels to device pixels
+         * @param region region to draw, in image pixels
+         * @param scale ratio of the device pixels to the image pixels
+         */
+        void draw(QPainter *painter, const QRectF &region, double scale);
+
+        /** @return number of tiles in the cache */
+        int cachedTiles() const
+        {
+            return m_Tiles.count();
+        }
+
+        /** @return number of tiles being computed */
+        int pendingTiles() const
+        {
+            return m_Pending.count();
+        }
+
+    signals:
+        void tileReady();
+
+    private:
+        static quint64 tileKey(int level, int x, int y);
+        static QImage renderTile(const QImage &image, int level, int x, int y);
+        void requestTile(int level, int x, int y);
+
+        QImage m_Image;
+        // Incremented when the image changes, so that tiles of the previous image are dropped
+        quint32 m_Generation { 0 };
+        // Tiles by key, cost in KiB
+        QCache<quint64, QImage> m_Tiles;
+        QSet<quint64> m_Pending;
+        QThreadPool m_Pool;
+};
@@ -10,6 +10,7 @@
 
 #include "fitsdata.h"
 #include "fitslabel.h"
+#include "fitstilepyramid.h"
 #include "hips/hipsfinder.h"
 #include "kstarsdata.h"
 
@@ -220,6 +221,12 @@ FITSView::FITSView(QWidget * parent, FITSMode fitsMode, FITSScale filterType) :
     connect(this, &FITSView::showRubberBand, m_ImageFrame, &FITSLabel::showRubberBand);
     connect(this, &FITSView::zoomRubberBand, m_ImageFrame, &FITSLabel::zoomRubberBand);
 
+    m_TilePyramid.reset(new FITSTilePyramid());
+    connect(m_TilePyramid.get(), &FITSTilePyramid::tileReady, m_ImageFrame, [this]()
+    {
+        m_ImageFrame->update();
+    });
+
     connect(Options::self(), &Options::HIPSOpacityChanged, this, [this]()
     {
         if (showHiPSOverlay)
@@ -398,6 +405,7 @@ void FITSView::clearData()
 
     setWidget(noImageLabel);
 
+    m_TilePyramid->clear();
     m_ImageData.clear();
 }
 
@@ -679,9 +687,12 @@ bool FITSView::rescale(FITSZoom type)
             break;
     }
 
+    // Stop computing tiles of the previous display image while stretching the new one.
+    m_TilePyramid->clear();
     initDisplayImage();
     m_ImageFrame->setScaledContents(true);
     doStretch(&rawImage);
+    m_TilePyramid->setImage(rawImage);
     setWidget(m_ImageFrame);
 
     // This is needed by fitstab, even if the zoom doesn't change, to change the stretch UI.
@@ -881,11 +892,28 @@ bool FITSView::initDisplayPixmap(QImage &image, float scale)
     return true;
 }
 
+// Large images are not converted to a pixmap scaled by the image frame on every zoom change. Instead, the
+// image frame paints the visible area from the tile pyramid of rawImage through drawTiles(), and the overlays
+// are recorded here at the scale of rawImage to be replayed over the tiles.
+// Mosaic masks only show a few small areas of the image, which are still composed into a pixmap.
 void FITSView::updateFrameLargeImage()
 {
-    if (!initDisplayPixmap(rawImage, 1.0 / m_PreviewSampling))
-        return;
-    QPainter painter(&displayPixmap);
+    const bool mosaic = dynamic_cast<ImageMosaicMask *>(m_ImageMask.get()) != nullptr;
+    QPainter painter;
+    if (mosaic)
+    {
+        if (!initDisplayPixmap(rawImage, 1.0 / m_PreviewSampling))
+            return;
+        m_OverlayBounds = displayPixmap.rect();
+        painter.begin(&displayPixmap);
+    }
+    else
+    {
+        m_OverlayBounds = rawImage.rect();
+        m_OverlayPicture = QPicture();
+        painter.begin(&m_OverlayPicture);
+    }
+
     // Possibly scale the fonts as we're drawing on the full image, not just the visible part of the scroll window.
     QFont font = painter.font();
     font.setPixelSize(scaleSize(FONT_SIZE));
@@ -893,15 +921,62 @@ void FITSView::updateFrameLargeImage()
 
     drawStarRingFilter(&painter, 1.0 / m_PreviewSampling, dynamic_cast<ImageRingMask *>(m_ImageMask.get()));
     drawOverlay(&painter, 1.0 / m_PreviewSampling);
-    m_ImageFrame->setPixmap(displayPixmap);
-    m_ImageFrame->resize(((m_PreviewSampling * currentZoom) / 100.0) * displayPixmap.size());
+    painter.end();
+
+    m_TiledRendering = !mosaic;
+    m_DisplayPixmapStale = !mosaic;
+    if (mosaic)
+    {
+        m_ImageFrame->setPixmap(displayPixmap);
+        m_ImageFrame->resize(((m_PreviewSampling * currentZoom) / 100.0) * displayPixmap.size());
+    }
+    else
+    {
+        displayPixmap = QPixmap();
+        m_ImageFrame->clear();
+        m_ImageFrame->resize(((m_PreviewSampling * currentZoom) / 100.0) * rawImage.size());
+        m_ImageFrame->update();
+    }
+}
+
+void FITSView::drawTiles(QPainter *painter, const QRect &exposed)
+{
+    // Ratio of the image frame pixels to the rawImage pixels
+    const double scale = m_PreviewSampling * currentZoom / ZOOM_DEFAULT;
+    if (scale <= 0)
+        return;
+
+    painter->save();
+    painter->scale(scale, scale);
+    const QRectF region(exposed.x() / scale, exposed.y() / scale, exposed.width() / scale, exposed.height() / scale);
+    m_TilePyramid->draw(painter, region, scale);
+    painter->setClipRect(region);
+    painter->drawPicture(0, 0, m_OverlayPicture);
+    painter->restore();
+}
+
+const QPixmap &FITSView::getDisplayPixmap()
+{
+    if (m_DisplayPixmapStale)
+    {
+        m_DisplayPixmapStale = false;
+        if (displayPixmap.convertFromImage(rawImage))
+        {
+            QPainter painter(&displayPixmap);
+            painter.drawPicture(0, 0, m_OverlayPicture);
+        }
+    }
+    return displayPixmap;
 }
 
 void FITSView::updateFrameSmallImage()
 {
+    m_TiledRendering = false;
+    m_DisplayPixmapStale = false;
     QImage scaledImage = rawImage.scaled(currentWidth, currentHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
     if (!initDisplayPixmap(scaledImage, currentZoom / ZOOM_DEFAULT))
         return;
+    m_OverlayBounds = displayPixmap.rect();
 
     QPainter painter(&displayPixmap);
     // Possibly scale the fonts as we're drawing on the full image, not just the visible part of the scroll window.
@@ -1300,7 +1375,7 @@ void FITSView::drawMarker(QPainter * painter, double scale)
 
 bool FITSView::drawHFR(QPainter * painter, const QString &hfr, int x, int y)
 {
-    QRect const boundingRect(0, 0, painter->device()->width(), painter->device()->height());
+    QRect const &boundingRect = m_OverlayBounds;
     QSize const hfrSize = painter->fontMetrics().size(Qt::TextSingleLine, hfr);
 
     // Store the HFR text in a rect
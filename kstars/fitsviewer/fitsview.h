@@ -18,6 +18,7 @@
 #endif
 
 #include <QFutureWatcher>
+#include <QPicture>
 #include <QPixmap>
 #include <QScrollArea>
 #include <QStack>
@@ -44,6 +45,7 @@ class QToolBar;
 
 class FITSData;
 class FITSLabel;
+class FITSTilePyramid;
 
 class FITSView : public QScrollArea
 {
@@ -93,10 +95,12 @@ class FITSView : public QScrollArea
         {
             return rawImage;
         }
-        const QPixmap &getDisplayPixmap() const
-        {
-            return displayPixmap;
-        }
+        /**
+         * @brief getDisplayPixmap Get the displayed image with its overlays.
+         * @note Large images are drawn from a tile pyramid, in which case the full size pixmap is only
+         * composed on demand.
+         */
+        const QPixmap &getDisplayPixmap();
 
         // Tracking square
         void setTrackingBoxEnabled(bool enable);
@@ -136,6 +140,17 @@ class FITSView : public QScrollArea
         void drawPixelGrid(QPainter *painter, double scale);
         void drawMagnifyingGlass(QPainter *painter, double scale);
 
+        /**
+         * @brief drawTiles Draw the image and its overlays from the tile pyramid, used for large images.
+         * @param painter painter on the image frame
+         * @param exposed exposed area of the image frame
+         */
+        void drawTiles(QPainter *painter, const QRect &exposed);
+        bool isTiledRendering() const
+        {
+            return m_TiledRendering;
+        }
+
         bool isImageStretched();
         bool isCrosshairShown();
         bool isClippingShown();
@@ -387,6 +402,14 @@ class FITSView : public QScrollArea
         QImage rawImage;
         // Actual pixmap after all the overlays
         QPixmap displayPixmap;
+        // Large images are drawn from tiles of rawImage, and their overlays are recorded to be replayed over them.
+        std::unique_ptr<FITSTilePyramid> m_TilePyramid;
+        QPicture m_OverlayPicture;
+        bool m_TiledRendering { false };
+        // displayPixmap is out of date while tiled rendering is used
+        bool m_DisplayPixmapStale { false };
+        // Area the overlays are drawn in, in overlay coordinates
+        QRect m_OverlayBounds;
 
         bool firstLoad { true };
         bool markStars { false };
@@ -4,10 +4,13 @@
 */
 
 #include "stretch.h"
+#include "auxiliary/parallelbands.h"
 
 #include <fitsio.h>
 #include <math.h>
-#include <QtConcurrent>
+
+#include <type_traits>
+#include <vector>
 
 namespace
 {
@@ -45,169 +48,204 @@ T median(T const *values, int size, int sampleBy)
     return median(samples);
 }
 
-// This stretches one channel given the input parameters.
+// The stretch of one channel.
 // Based on the spec in section 8.5.6
 // https://pixinsight.com/doc/docs/XISF-1.0-spec/XISF-1.0-spec.html
-// Uses multiple threads, blocks until done.
 // The extension parameters are not used.
-// Sampling is applied to the output (that is, with sampling=2, we compute every other output
-// sample both in width and height, so the output would have about 4X fewer pixels.
 template <typename T>
-void stretchOneChannel(T *input_buffer, QImage *output_image,
-                       const StretchParams &stretch_params,
-                       int input_range, int image_height, int image_width, int sampling)
+struct ChannelStretch
 {
-    QVector<QFuture<void>> futures;
+    // Arithmetic type of the transfer function, float except for double input.
+    using Real = decltype(T() * 1.0f);
 
     // We're outputting uint8, so the max output is 255.
-    constexpr int maxOutput = 255;
+    static constexpr int maxOutput = 255;
 
-    // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
-    const float maxInput = input_range > 1 ? input_range - 1 : input_range;
+    ChannelStretch(const StretchParams1Channel &params, int inputRange)
+    {
+        // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
+        const float maxInput = inputRange > 1 ? inputRange - 1 : inputRange;
+
+        // Precomputed expressions moved out of the loop.
+        // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
+        const float hsRangeFactor = params.highlights == params.shadows ? 1.0f : 1.0f / (params.highlights - params.shadows);
+        // Shadow and highlight values translated to the ADU scale.
+        nativeShadows = params.shadows * maxInput;
+        nativeHighlights = params.highlights * maxInput;
+        // Constants based on above needed for the stretch calculations.
+        k1 = (params.midtones - 1) * hsRangeFactor * maxOutput / maxInput;
+        k2 = ((2 * params.midtones) - 1) * hsRangeFactor / maxInput;
+        midtones = params.midtones;
+    }
 
-    const float midtones   = stretch_params.grey_red.midtones;
-    const float highlights = stretch_params.grey_red.highlights;
-    const float shadows    = stretch_params.grey_red.shadows;
+    uint8_t operator()(T input) const
+    {
+        if (input < nativeShadows) return 0;
+        if (input >= nativeHighlights) return maxOutput;
+        const T inputFloored = (input - nativeShadows);
+        return (inputFloored * k1) / (inputFloored * k2 - midtones);
+    }
 
-    // Precomputed expressions moved out of the loop.
-    // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
-    const float hsRangeFactor = highlights == shadows ? 1.0f : 1.0f / (highlights - shadows);
-    // Shadow and highlight values translated to the ADU scale.
-    const T nativeShadows = shadows * maxInput;
-    const T nativeHighlights = highlights * maxInput;
-    // Constants based on above needed for the stretch calculations.
-    const float k1 = (midtones - 1) * hsRangeFactor * maxOutput / maxInput;
-    const float k2 = ((2 * midtones) - 1) * hsRangeFactor / maxInput;
+    T nativeShadows;
+    T nativeHighlights;
+    float k1;
+    float k2;
+    float midtones;
+};
 
-    // Increment the input index by the sampling, the output index increments by 1.
-    for (int j = 0, jout = 0; j < image_height; j += sampling, jout++)
+// 8 and 16 bit samples are stretched through a lookup table of all their values.
+template <typename T>
+constexpr bool hasLookupTable()
+{
+    return std::is_integral<T>::value && sizeof(T) <= 2;
+}
+
+// Returns the lookup table of the stretch, or an empty table if the samples have no lookup
+// table or the image has too few samples to amortize building it.
+template <typename T>
+std::vector<uint8_t> makeLookupTable(const ChannelStretch<T> &stretch, int outputSamples)
+{
+    std::vector<uint8_t> table;
+    if constexpr (hasLookupTable<T>())
     {
-        futures.append(QtConcurrent::run([ = ]()
+        using Index = typename std::make_unsigned<T>::type;
+        constexpr int tableSize = 1 << (8 * sizeof(T));
+        if (outputSamples >= tableSize)
         {
-            T * inputLine  = input_buffer + j * image_width;
-            auto * scanLine = output_image->scanLine(jout);
+            table.resize(tableSize);
+            for (int i = 0; i < tableSize; i++)
+                table[i] = stretch(static_cast<T>(static_cast<Index>(i)));
+        }
+    }
+    return table;
+}
 
-            for (int i = 0, iout = 0; i < image_width; i += sampling, iout++)
-            {
-                const T input = inputLine[i];
-                if (input < nativeShadows) scanLine[iout] = 0;
-                else if (input >= nativeHighlights) scanLine[iout] = maxOutput;
-                else
-                {
-                    const T inputFloored = (input - nativeShadows);
-                    scanLine[iout] = (inputFloored * k1) / (inputFloored * k2 - midtones);
-                }
-            }
-        }));
+// Stretches count samples, sampling apart, through a lookup table.
+template <typename T>
+void lookupRow(const T * __restrict input, int sampling, int count, const uint8_t * __restrict table,
+               uint8_t * __restrict output)
+{
+    using Index = typename std::make_unsigned<T>::type;
+    for (int i = 0; i < count; i++)
+        output[i] = table[static_cast<Index>(input[i * sampling])];
+}
+
+// Stretches count samples, sampling apart, computing the transfer function.
+// The three cases are blended without branches so that the loop can be vectorized.
+template <typename T>
+void transferRow(const T * __restrict input, int sampling, int count, const ChannelStretch<T> stretch,
+                 uint8_t * __restrict output)
+{
+    using Real = typename ChannelStretch<T>::Real;
+    for (int i = 0; i < count; i++)
+    {
+        const T sample = input[i * sampling];
+        const Real inputFloored = static_cast<T>(sample - stretch.nativeShadows);
+        const Real value = (inputFloored * stretch.k1) / (inputFloored * stretch.k2 - stretch.midtones);
+        const Real result = sample < stretch.nativeShadows ? Real(0) :
+                            (sample >= stretch.nativeHighlights ? Real(ChannelStretch<T>::maxOutput) : value);
+        output[i] = static_cast<uint8_t>(static_cast<int>(result));
     }
-    for(QFuture<void> future : futures)
-        future.waitForFinished();
+}
+
+// Stretches one row of one channel into count uint8 samples.
+template <typename T>
+void stretchRow(const T *input, int sampling, int count, const ChannelStretch<T> &stretch,
+                const std::vector<uint8_t> &table, uint8_t *output)
+{
+    if constexpr (hasLookupTable<T>())
+    {
+        if (!table.empty())
+        {
+            lookupRow(input, sampling, count, table.data(), output);
+            return;
+        }
+    }
+    transferRow(input, sampling, count, stretch, output);
+}
+
+// This stretches one channel given the input parameters.
+// Uses multiple threads, blocks until done.
+// Sampling is applied to the output (that is, with sampling=2, we compute every other output
+// sample both in width and height, so the output would have about 4X fewer pixels.
+template <typename T>
+void stretchOneChannel(const T *input_buffer, QImage *output_image,
+                       const StretchParams &stretch_params,
+                       int input_range, int image_height, int image_width, int sampling)
+{
+    const int outputWidth = (image_width + sampling - 1) / sampling;
+    const int outputHeight = (image_height + sampling - 1) / sampling;
+
+    const ChannelStretch<T> stretch(stretch_params.grey_red, input_range);
+    const std::vector<uint8_t> table = makeLookupTable(stretch, outputWidth * outputHeight);
+
+    // Increment the input index by the sampling, the output index increments by 1.
+    forEachBand(outputHeight, outputWidth, [&](int first, int last)
+    {
+        for (int jout = first; jout < last; jout++)
+        {
+            const T * inputLine  = input_buffer + static_cast<size_t>(jout) * sampling * image_width;
+            stretchRow(inputLine, sampling, outputWidth, stretch, table, output_image->scanLine(jout));
+        }
+    });
 }
 
 // This is like the above 1-channel stretch, but extended for 3 channels.
-// This could have been more modular, but the three channels are combined
-// into a single qRgb value at the end, so it seems the simplest thing is to
-// replicate the code. It is assume the colors are not interleaved--the red image
+// Each channel is stretched to a uint8 row, and the three rows are then combined
+// into qRgb values. It is assume the colors are not interleaved--the red image
 // is stored fully, then the green, then the blue.
 // Sampling is applied to the output (that is, with sampling=2, we compute every other output
 // sample both in width and height, so the output would have about 4X fewer pixels.
 template <typename T>
-void stretchThreeChannels(T *inputBuffer, QImage *outputImage,
+void stretchThreeChannels(const T *inputBuffer, QImage *outputImage,
                           const StretchParams &stretchParams,
                           int inputRange, int imageHeight, int imageWidth, int sampling)
 {
-    QVector<QFuture<void>> futures;
+    const int outputWidth = (imageWidth + sampling - 1) / sampling;
+    const int outputHeight = (imageHeight + sampling - 1) / sampling;
 
-    // We're outputting uint8, so the max output is 255.
-    constexpr int maxOutput = 255;
-
-    // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
-    const float maxInput = inputRange > 1 ? inputRange - 1 : inputRange;
-
-    const float midtonesR   = stretchParams.grey_red.midtones;
-    const float highlightsR = stretchParams.grey_red.highlights;
-    const float shadowsR    = stretchParams.grey_red.shadows;
-    const float midtonesG   = stretchParams.green.midtones;
-    const float highlightsG = stretchParams.green.highlights;
-    const float shadowsG    = stretchParams.green.shadows;
-    const float midtonesB   = stretchParams.blue.midtones;
-    const float highlightsB = stretchParams.blue.highlights;
-    const float shadowsB    = stretchParams.blue.shadows;
-
-    // Precomputed expressions moved out of the loop.
-    // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
-    const float hsRangeFactorR = highlightsR == shadowsR ? 1.0f : 1.0f / (highlightsR - shadowsR);
-    const float hsRangeFactorG = highlightsG == shadowsG ? 1.0f : 1.0f / (highlightsG - shadowsG);
-    const float hsRangeFactorB = highlightsB == shadowsB ? 1.0f : 1.0f / (highlightsB - shadowsB);
-    // Shadow and highlight values translated to the ADU scale.
-    const T nativeShadowsR = shadowsR * maxInput;
-    const T nativeShadowsG = shadowsG * maxInput;
-    const T nativeShadowsB = shadowsB * maxInput;
-    const T nativeHighlightsR = highlightsR * maxInput;
-    const T nativeHighlightsG = highlightsG * maxInput;
-    const T nativeHighlightsB = highlightsB * maxInput;
-    // Constants based on above needed for the stretch calculations.
-    const float k1R = (midtonesR - 1) * hsRangeFactorR * maxOutput / maxInput;
-    const float k1G = (midtonesG - 1) * hsRangeFactorG * maxOutput / maxInput;
-    const float k1B = (midtonesB - 1) * hsRangeFactorB * maxOutput / maxInput;
-    const float k2R = ((2 * midtonesR) - 1) * hsRangeFactorR / maxInput;
-    const float k2G = ((2 * midtonesG) - 1) * hsRangeFactorG / maxInput;
-    const float k2B = ((2 * midtonesB) - 1) * hsRangeFactorB / maxInput;
-
-    const int size = imageWidth * imageHeight;
-
-    for (int j = 0, jout = 0; j < imageHeight; j += sampling, jout++)
+    const ChannelStretch<T> stretches[3] =
+    {
+        ChannelStretch<T>(stretchParams.grey_red, inputRange),
+        ChannelStretch<T>(stretchParams.green, inputRange),
+        ChannelStretch<T>(stretchParams.blue, inputRange)
+    };
+    const std::vector<uint8_t> tables[3] =
+    {
+        makeLookupTable(stretches[0], outputWidth * outputHeight),
+        makeLookupTable(stretches[1], outputWidth * outputHeight),
+        makeLookupTable(stretches[2], outputWidth * outputHeight)
+    };
+
+    const size_t size = static_cast<size_t>(imageWidth) * imageHeight;
+
+    forEachBand(outputHeight, outputWidth, [&](int first, int last)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        std::vector<uint8_t> rows(3 * outputWidth);
+        uint8_t * const red = rows.data();
+        uint8_t * const green = red + outputWidth;
+        uint8_t * const blue = green + outputWidth;
+
+        for (int jout = first; jout < last; jout++)
         {
             // R, G, B input images are stored one after another.
-            T * inputLineR  = inputBuffer + j * imageWidth;
-            T * inputLineG  = inputLineR + size;
-            T * inputLineB  = inputLineG + size;
+            const T * inputLineR  = inputBuffer + static_cast<size_t>(jout) * sampling * imageWidth;
+            const T * inputLineG  = inputLineR + size;
+            const T * inputLineB  = inputLineG + size;
 
-            auto * scanLine = reinterpret_cast<QRgb*>(outputImage->scanLine(jout));
+            stretchRow(inputLineR, sampling, outputWidth, stretches[0], tables[0], red);
+            stretchRow(inputLineG, sampling, outputWidth, stretches[1], tables[1], green);
+            stretchRow(inputLineB, sampling, outputWidth, stretches[2], tables[2], blue);
 
-            for (int i = 0, iout = 0; i < imageWidth; i += sampling, iout++)
-            {
-                const T inputR = inputLineR[i];
-                const T inputG = inputLineG[i];
-                const T inputB = inputLineB[i];
-
-                uint8_t red, green, blue;
-
-                if (inputR < nativeShadowsR) red = 0;
-                else if (inputR >= nativeHighlightsR) red = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputR - nativeShadowsR);
-                    red = (inputFloored * k1R) / (inputFloored * k2R - midtonesR);
-                }
-
-                if (inputG < nativeShadowsG) green = 0;
-                else if (inputG >= nativeHighlightsG) green = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputG - nativeShadowsG);
-                    green = (inputFloored * k1G) / (inputFloored * k2G - midtonesG);
-                }
-
-                if (inputB < nativeShadowsB) blue = 0;
-                else if (inputB >= nativeHighlightsB) blue = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputB - nativeShadowsB);
-                    blue = (inputFloored * k1B) / (inputFloored * k2B - midtonesB);
-                }
-                scanLine[iout] = qRgb(red, green, blue);
-            }
-        }));
-    }
-    for(QFuture<void> future : futures)
-        future.waitForFinished();
+            auto * scanLine = reinterpret_cast<QRgb*>(outputImage->scanLine(jout));
+            for (int iout = 0; iout < outputWidth; iout++)
+                scanLine[iout] = qRgb(red[iout], green[iout], blue[iout]);
+        }
+    });
 }
 
 template <typename T>
-void stretchChannels(T *input_buffer, QImage *output_image,
+void stretchChannels(const T *input_buffer, QImage *output_image,
                      const StretchParams &stretch_params,
                      int input_range, int image_height, int image_width, int num_channels, int sampling)
 {
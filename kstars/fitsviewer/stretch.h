@@ -77,6 +77,8 @@ class Stretch
          * @param sampling The sampling parameter. Applies to both width and height.
          * Sampling is applied to the output (that is, with sampling=2, we compute every other output
          * sample both in width and height, so the output would have about 4X fewer pixels.
+         * @note Bands of rows are stretched in parallel. 8 and 16 bit samples go through a lookup table
+         * of the stretch, other types compute it with a vectorizable kernel.
          */
         void run(uint8_t const *input, QImage *output_image, int sampling=1);
 
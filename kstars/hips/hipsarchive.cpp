@@ -0,0 +1,445 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "hipsarchive.h"
+
+#include "kstars_debug.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QDirIterator>
+#include <QHash>
+#include <QImageReader>
+#include <QNetworkDiskCache>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QScopedPointer>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+constexpr char ARCHIVE_MAGIC[8] = { 'K', 'S', 'H', 'I', 'P', 'S', 'A', 'R' };
+constexpr quint32 ARCHIVE_VERSION = 1;
+
+// Written in the native byte order, an archive from a machine with another byte order is rejected.
+constexpr quint32 BYTE_ORDER_MARK = 0x01020304;
+
+// Orders only go up to 29, so the Allsky image gets an order of its own and sorts last.
+constexpr quint64 ALLSKY_ORDER = 0xFF;
+
+quint64 tileKey(quint64 order, quint64 pix)
+{
+    return (order << 56) | (pix & ((quint64(1) << 56) - 1));
+}
+
+quint64 align(quint64 offset)
+{
+    return (offset + 7) & ~quint64(7);
+}
+
+QString normalizedFormat(const QString &extension)
+{
+    const QString format = extension.toLower();
+    return format == "jpeg" ? QString("jpg") : format;
+}
+
+void copyString(char *destination, std::size_t size, const QString &value)
+{
+    const QByteArray data = value.toLatin1();
+    std::memset(destination, 0, size);
+    std::memcpy(destination, data.constData(), std::min<std::size_t>(data.size(), size - 1));
+}
+
+QString readString(const char *source, std::size_t size)
+{
+    return QString::fromLatin1(source, static_cast<int>(qstrnlen(source, static_cast<uint>(size))));
+}
+
+// Tile path relative to the root of a survey, as in NorderN/DirD/NpixP.ext or Norder3/Allsky.ext
+bool parseTilePath(const QString &path, quint64 &key, QString &format)
+{
+    static const QRegularExpression tileExpression("^Norder(\\d+)/Dir\\d+/Npix(\\d+)\\.(jpg|jpeg|png)$",
+            QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression allskyExpression("^Norder3/Allsky\\.(jpg|jpeg|png)$",
+            QRegularExpression::CaseInsensitiveOption);
+
+    QRegularExpressionMatch match = tileExpression.match(path);
+    if (match.hasMatch())
+    {
+        const quint64 order = match.captured(1).toULongLong();
+        if (order >= ALLSKY_ORDER)
+            return false;
+
+        key = tileKey(order, match.captured(2).toULongLong());
+        format = normalizedFormat(match.captured(3));
+        return true;
+    }
+
+    match = allskyExpression.match(path);
+    if (match.hasMatch())
+    {
+        key = tileKey(ALLSKY_ORDER, 0);
+        format = normalizedFormat(match.captured(1));
+        return true;
+    }
+
+    return false;
+}
+
+QString frameFromProperties(QIODevice &device, const QString &fallback)
+{
+    QTextStream stream(&device);
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine();
+        const int index = line.indexOf('=');
+        if (index > 0 && line.left(index).simplified() == "hips_frame")
+            return line.mid(index + 1).simplified();
+    }
+
+    return fallback;
+}
+}
+
+struct HIPSArchive::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    char format[8];
+    char frame[16];
+    quint32 tileWidth;
+    quint32 tileCount;
+    quint64 indexOffset;
+};
+
+struct HIPSArchive::Entry
+{
+    quint64 key;
+    quint64 offset;
+    quint32 size;
+    quint32 reserved;
+};
+
+struct HIPSArchive::Source
+{
+    quint64 key;
+    QString format;
+    std::function<QByteArray()> read;
+};
+
+HIPSArchive::~HIPSArchive()
+{
+    close();
+}
+
+bool HIPSArchive::isArchive(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    char magic[sizeof(ARCHIVE_MAGIC)];
+    return file.read(magic, sizeof(magic)) == sizeof(magic) && std::memcmp(magic, ARCHIVE_MAGIC, sizeof(magic)) == 0;
+}
+
+bool HIPSArchive::build(const QString &source, const QString &path, QString &error)
+{
+    const QDir root(source);
+    if (!root.exists())
+    {
+        error = QString("HiPS directory %1 does not exist.").arg(source);
+        return false;
+    }
+
+    QString frame = "equatorial";
+    QFile properties(root.filePath("properties"));
+    if (properties.open(QIODevice::ReadOnly | QIODevice::Text))
+        frame = frameFromProperties(properties, frame);
+
+    QList<Source> sources;
+    QDirIterator it(source, QStringList() << "*.jpg" << "*.jpeg" << "*.png", QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        const QString filePath = it.next();
+        Source tile;
+        if (!parseTilePath(root.relativeFilePath(filePath), tile.key, tile.format))
+            continue;
+
+        tile.read = [filePath]()
+        {
+            QFile file(filePath);
+            return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+        };
+        sources.append(tile);
+    }
+
+    return write(path, sources, frame, error);
+}
+
+bool HIPSArchive::buildFromCache(QNetworkDiskCache *cache, const QUrl &url, const QString &frame, const QString &path,
+                                 QString &error)
+{
+    if (cache == nullptr || url.isEmpty())
+    {
+        error = QString("No HiPS source to archive.");
+        return false;
+    }
+
+    const QString prefix = url.toString(QUrl::StripTrailingSlash) + '/';
+
+    // The properties of the survey, if cached, are more reliable than the frame given
+    QString surveyFrame = frame;
+    QScopedPointer<QIODevice> properties(cache->data(QUrl(prefix + "properties")));
+    if (properties)
+        surveyFrame = frameFromProperties(*properties, frame);
+
+    // QNetworkDiskCache has no listing, its metadata files are walked instead to find the cached URLs.
+    QList<Source> sources;
+    QDirIterator it(cache->cacheDirectory(), QStringList() << "*.d", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        const QUrl tileURL = cache->fileMetaData(it.next()).url();
+        const QString tileAddress = tileURL.toString();
+        if (!tileAddress.startsWith(prefix))
+            continue;
+
+        Source tile;
+        if (!parseTilePath(tileAddress.mid(prefix.size()), tile.key, tile.format))
+            continue;
+
+        tile.read = [cache, tileURL]()
+        {
+            QScopedPointer<QIODevice> device(cache->data(tileURL));
+            return device ? device->readAll() : QByteArray();
+        };
+        sources.append(tile);
+    }
+
+    return write(path, sources, surveyFrame, error);
+}
+
+bool HIPSArchive::write(const QString &path, QList<Source> &sources, const QString &frame, QString &error)
+{
+    static_assert(sizeof(Header) % 8 == 0, "The data must stay aligned.");
+    static_assert(sizeof(Entry) == 24, "The index layout is part of the file format.");
+
+    // A survey is served in a single format, keep the one of most tiles.
+    QHash<QString, int> formats;
+    for (const auto &oneSource : sources)
+        formats[oneSource.format]++;
+
+    if (formats.isEmpty())
+    {
+        error = QString("No HiPS tiles found.");
+        return false;
+    }
+
+    QString format = formats.constBegin().key();
+    for (auto it = formats.constBegin(); it != formats.constEnd(); ++it)
+    {
+        if (it.value() > formats.value(format))
+            format = it.key();
+    }
+
+    // Sorted, the tiles of an order and the neighbouring pixels end up next to each other in the file.
+    std::sort(sources.begin(), sources.end(), [](const Source & a, const Source & b)
+    {
+        return a.key < b.key;
+    });
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    copyString(header.format, sizeof(header.format), format);
+    copyString(header.frame, sizeof(header.frame), frame);
+
+    // Written again once the index is known
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    QVector<Entry> index;
+    index.reserve(sources.size());
+    quint64 offset = sizeof(header);
+
+    for (const auto &oneSource : sources)
+    {
+        if (oneSource.format != format || (!index.isEmpty() && index.last().key == oneSource.key))
+            continue;
+
+        const QByteArray data = oneSource.read();
+        if (data.isEmpty())
+        {
+            qCWarning(KSTARS) << "Skipping unreadable HiPS tile" << (oneSource.key >> 56) << (oneSource.key & 0xFFFFFFFFFFFFFF);
+            continue;
+        }
+
+        if (header.tileWidth == 0 && (oneSource.key >> 56) != ALLSKY_ORDER)
+        {
+            QBuffer buffer;
+            buffer.setData(data);
+            const QSize tileSize = QImageReader(&buffer).size();
+            if (tileSize.isValid())
+                header.tileWidth = tileSize.width();
+        }
+
+        if (file.write(data) != data.size())
+        {
+            error = file.errorString();
+            return false;
+        }
+
+        index.append({ oneSource.key, offset, static_cast<quint32>(data.size()), 0 });
+        offset += data.size();
+    }
+
+    // A tile is drawn from a quarter of its parent while it loads, which needs the tile width
+    if (header.tileWidth < 2)
+    {
+        error = QString("The size of the HiPS tiles could not be read.");
+        return false;
+    }
+
+    header.tileCount = index.size();
+    header.indexOffset = align(offset);
+
+    file.write(QByteArray(static_cast<int>(header.indexOffset - offset), '\0'));
+    file.write(reinterpret_cast<const char *>(index.constData()), index.size() * sizeof(Entry));
+
+    if (!file.seek(0) || file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header) ||
+            !file.commit())
+    {
+        error = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool HIPSArchive::open(const QString &path)
+{
+    close();
+
+    m_File.setFileName(path);
+    if (!m_File.open(QIODevice::ReadOnly) || m_File.size() < static_cast<qint64>(sizeof(Header)))
+    {
+        close();
+        return false;
+    }
+
+    const quint64 size = m_File.size();
+    m_Data = m_File.map(0, size);
+    if (m_Data == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const Header *>(m_Data);
+    const quint64 tileCount = header->tileCount;
+    if (std::memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header->version != ARCHIVE_VERSION ||
+            header->byteOrder != BYTE_ORDER_MARK || header->tileWidth < 2 || header->indexOffset % 8 != 0 ||
+            header->indexOffset > size || (size - header->indexOffset) / sizeof(Entry) < tileCount)
+    {
+        qCWarning(KSTARS) << "Invalid HiPS archive" << path;
+        close();
+        return false;
+    }
+
+    // The index is trusted on lookup, so check it once here.
+    const auto *index = reinterpret_cast<const Entry *>(m_Data + header->indexOffset);
+    QList<int> orders;
+    for (quint64 i = 0; i < tileCount; i++)
+    {
+        const Entry &entry = index[i];
+        if ((i > 0 && index[i - 1].key >= entry.key) || entry.offset < sizeof(Header) ||
+                entry.offset > header->indexOffset || entry.size > header->indexOffset - entry.offset)
+        {
+            qCWarning(KSTARS) << "Corrupted HiPS archive index" << path;
+            close();
+            return false;
+        }
+
+        const int order = static_cast<int>(entry.key >> 56);
+        if ((entry.key >> 56) != ALLSKY_ORDER && (orders.isEmpty() || orders.last() != order))
+            orders.append(order);
+    }
+
+    m_FileName = path;
+    m_Header = header;
+    m_Index = index;
+    m_Format = readString(header->format, sizeof(header->format));
+    m_Frame = readString(header->frame, sizeof(header->frame));
+    m_TileWidth = header->tileWidth;
+    m_Orders = orders;
+
+    return true;
+}
+
+void HIPSArchive::close()
+{
+    if (m_Data != nullptr)
+        m_File.unmap(const_cast<uchar *>(m_Data));
+    m_File.close();
+
+    m_FileName.clear();
+    m_Data = nullptr;
+    m_Header = nullptr;
+    m_Index = nullptr;
+    m_Format.clear();
+    m_Frame.clear();
+    m_TileWidth = 0;
+    m_Orders.clear();
+}
+
+int HIPSArchive::tileCount() const
+{
+    return isOpen() ? static_cast<int>(m_Header->tileCount) : 0;
+}
+
+QByteArray HIPSArchive::tile(int order, int pix) const
+{
+    if (order < 0 || pix < 0)
+        return QByteArray();
+
+    return lookup(tileKey(order, pix));
+}
+
+QByteArray HIPSArchive::allsky() const
+{
+    return lookup(tileKey(ALLSKY_ORDER, 0));
+}
+
+QByteArray HIPSArchive::lookup(quint64 key) const
+{
+    if (!isOpen())
+        return QByteArray();
+
+    const Entry *end = m_Index + m_Header->tileCount;
+    const Entry *entry = std::lower_bound(m_Index, end, key, [](const Entry & e, quint64 k)
+    {
+        return e.key < k;
+    });
+
+    if (entry == end || entry->key != key)
+        return QByteArray();
+
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(m_Data + entry->offset), static_cast<int>(entry->size));
+}
@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QUrl>
+
+class QNetworkDiskCache;
+
+/**
+ * @class HIPSArchive
+ * @short Read only, memory mapped store of the tiles of a HiPS survey in a single file.
+ *
+ * The archive holds the encoded tiles (JPEG or PNG, as served) back to back, ordered by HEALPix order
+ * and pixel, followed by an index of (order, pixel) keys to offsets which is binary searched on lookup.
+ * Reading a tile is thus a slice of the mapping, without any file system access, which keeps offline
+ * sources fast on slow storage where hundreds of thousands of tile files are costly to scan and open.
+ *
+ * Archives are built from a HiPS directory tree (NorderN/DirD/NpixP.ext) or from the tiles of a survey
+ * in the HiPS disk cache, see build() and buildFromCache(). From the command line:
+ * @code
+ * kstars --build-hips-archive dss.hipsar --hips-source /path/to/DSSColor
+ * @endcode
+ */
+class HIPSArchive
+{
+    public:
+        /// Suggested file name extension of the archives
+        static constexpr const char *EXTENSION = "hipsar";
+
+        HIPSArchive() = default;
+        ~HIPSArchive();
+
+        /**
+         * @brief isArchive Check the magic of a file, to tell archives from HiPS directories.
+         */
+        static bool isArchive(const QString &path);
+
+        /**
+         * @brief build Pack the tiles of a HiPS directory tree in an archive.
+         * @param source root directory of the survey, with the NorderN directories and optionally the
+         * properties file the frame is read from
+         * @param path archive to write, replaced atomically
+         * @param error set to the reason of the failure, if any
+         * @return true if the archive was written
+         */
+        static bool build(const QString &source, const QString &path, QString &error);
+
+        /**
+         * @brief buildFromCache Pack the tiles of a survey found in a HiPS disk cache in an archive.
+         * @param cache disk cache the tiles were downloaded to
+         * @param url service URL of the survey
+         * @param frame HiPS frame of the survey, "equatorial" or "galactic"
+         * @param path archive to write, replaced atomically
+         * @param error set to the reason of the failure, if any
+         * @return true if the archive was written
+         */
+        static bool buildFromCache(QNetworkDiskCache *cache, const QUrl &url, const QString &frame,
+                                   const QString &path, QString &error);
+
+        /**
+         * @brief open Map an archive, closing the current one first.
+         * @return false if the file is missing or is not a valid archive
+         */
+        bool open(const QString &path);
+        void close();
+
+        bool isOpen() const
+        {
+            return m_Index != nullptr;
+        }
+
+        /**
+         * @return the encoded tile of a pixel, or an empty array if the archive does not have it. The
+         * data is not copied and is only valid while the archive is open.
+         */
+        QByteArray tile(int order, int pix) const;
+
+        /** @return the encoded Allsky image of order 3, or an empty array if the archive does not have it */
+        QByteArray allsky() const;
+
+        /** @return the image format of the tiles, "jpg" or "png" */
+        const QString &format() const
+        {
+            return m_Format;
+        }
+
+        /** @return the HiPS frame of the survey, "equatorial" or "galactic" */
+        const QString &frame() const
+        {
+            return m_Frame;
+        }
+
+        int tileWidth() const
+        {
+            return m_TileWidth;
+        }
+
+        /** @return the orders with at least one tile, in ascending order */
+        const QList<int> &orders() const
+        {
+            return m_Orders;
+        }
+
+        int tileCount() const;
+
+        const QString &fileName() const
+        {
+            return m_FileName;
+        }
+
+    private:
+        struct Header;
+        struct Entry;
+        struct Source;
+
+        static bool write(const QString &path, QList<Source> &sources, const QString &frame, QString &error);
+        QByteArray lookup(quint64 key) const;
+
+        QFile m_File;
+        QString m_FileName;
+        const uchar *m_Data { nullptr };
+        const Header *m_Header { nullptr };
+        const Entry *m_Index { nullptr };
+        QString m_Format;
+        QString m_Frame;
+        int m_TileWidth { 0 };
+        QList<int> m_Orders;
+};
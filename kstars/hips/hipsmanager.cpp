@@ -18,10 +18,12 @@
 
 #include <KConfigDialog>
 
+#include <QFileInfo>
 #include <QTime>
 #include <QHash>
 #include <QNetworkDiskCache>
 #include <QPainter>
+#include <QtConcurrent>
 
 static QNetworkDiskCache *g_discCache = nullptr;
 static UrlFileDownload *g_download = nullptr;
@@ -46,9 +48,7 @@ HIPSManager *HIPSManager::Instance()
         _HIPSManager = new HIPSManager();
 
         // We should read offline sources on startup
-        QDir hipsDirectory(Options::hIPSOfflinePath());
-        auto orders = hipsDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-        HIPSManager::Instance()->setOfflineLevels(orders);
+        _HIPSManager->loadOfflineSource();
 
         if (Options::hIPSUseOfflineSource())
             _HIPSManager->setCurrentSource(Options::hIPSSource());
@@ -114,9 +114,7 @@ void HIPSManager::slotApply()
 {
     if (Options::hIPSUseOfflineSource())
     {
-        QDir hipsDirectory(Options::hIPSOfflinePath());
-        auto orders = hipsDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-        HIPSManager::Instance()->setOfflineLevels(orders);
+        loadOfflineSource();
         _HIPSManager->setCurrentSource(Options::hIPSSource());
     }
 
@@ -222,6 +220,21 @@ QImage *HIPSManager::getPix(bool allsky, int level, int pix, bool &freeImage)
         return cacheImage;
     }
 
+    if (m_failedTiles.contains(key))
+        return nullptr;
+
+    // Offline archive, the tile only needs to be decoded
+    if (Options::hIPSUseOfflineSource() && m_archive)
+    {
+        const QByteArray data = allsky ? m_archive->allsky() : m_archive->tile(level, pix);
+        if (data.isEmpty())
+            return nullptr;
+
+        m_downloadMap.insert(key);
+        decode(key, data, m_archive);
+        return nullptr;
+    }
+
     QString path;
 
     if (!allsky)
@@ -348,22 +361,9 @@ void HIPSManager::slotDone(QNetworkReply::NetworkError error, QByteArray &data,
 {
     if (error == QNetworkReply::NoError)
     {
-        m_downloadMap.remove(key);
-
-        auto *item = new pixCacheItem_t;
-
-        item->image = new QImage();
-        if (item->image->loadFromData(data))
-        {
-            addToMemoryCache(key, item);
-
-            //SkyMap::Instance()->forceUpdate();
-        }
-        else
-        {
-            delete item;
-            qCWarning(KSTARS) << "no image" << data;
-        }
+        // The tile stays in the download map while it is decoded so that
+        // its parent level keeps being drawn instead.
+        decode(key, data);
     }
     else
     {
@@ -380,6 +380,51 @@ void HIPSManager::slotDone(QNetworkReply::NetworkError error, QByteArray &data,
     }
 }
 
+void HIPSManager::decode(const pixCacheKey_t &key, const QByteArray &data, std::shared_ptr<const HIPSArchive> archive)
+{
+    // The archive is held until the tile is decoded, its data points into the mapping.
+    QtConcurrent::run(&m_decodePool, [this, key, data, archive]()
+    {
+        QImage image;
+        if (image.loadFromData(data))
+        {
+            // ScanRender reads 8 bit images as grayscale and anything else as 32 bit pixels
+            const QImage::Format format = image.format();
+            const bool gray = format == QImage::Format_Grayscale8
+                              || (format == QImage::Format_Indexed8 && image.isGrayscale());
+            if (!gray && format != QImage::Format_RGB32 && format != QImage::Format_ARGB32
+                    && format != QImage::Format_ARGB32_Premultiplied)
+                image = image.convertToFormat(QImage::Format_RGB32);
+        }
+        else
+            qCWarning(KSTARS) << "no image" << key.level << key.pix;
+
+        QMetaObject::invokeMethod(this, [this, key, image]()
+        {
+            slotDecoded(key, image);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void HIPSManager::slotDecoded(const pixCacheKey_t &key, const QImage &image)
+{
+    m_downloadMap.remove(key);
+
+    if (image.isNull())
+    {
+        m_failedTiles.insert(key);
+        return;
+    }
+
+    auto *item = new pixCacheItem_t;
+    item->image = new QImage(image);
+
+    pixCacheKey_t tileKey = key;
+    addToMemoryCache(tileKey, item);
+
+    //SkyMap::Instance()->forceUpdate();
+}
+
 void HIPSManager::removeTimer(pixCacheKey_t &key)
 {
     m_downloadMap.remove(key);
@@ -425,11 +470,26 @@ bool HIPSManager::setCurrentSource(const QString &title)
     // Offline DSS
     else if (Options::hIPSUseOfflineSource())
     {
-        m_currentFormat = "jpg";
-        m_currentTileWidth = 512;
-        m_currentFrame = HIPS_EQUATORIAL_FRAME;
-        m_currentURL = QUrl(Options::hIPSOfflinePath());
-        m_currentURL.setScheme("file");
+        if (m_archive)
+        {
+            m_currentFormat = m_archive->format();
+            m_currentTileWidth = m_archive->tileWidth();
+            if (m_archive->frame() == "equatorial")
+                m_currentFrame = HIPS_EQUATORIAL_FRAME;
+            else if (m_archive->frame() == "galactic")
+                m_currentFrame = HIPS_GALACTIC_FRAME;
+            else
+                m_currentFrame = HIPS_OTHER_FRAME;
+            m_currentURL = QUrl::fromLocalFile(m_archive->fileName());
+        }
+        else
+        {
+            m_currentFormat = "jpg";
+            m_currentTileWidth = 512;
+            m_currentFrame = HIPS_EQUATORIAL_FRAME;
+            m_currentURL = QUrl(Options::hIPSOfflinePath());
+            m_currentURL.setScheme("file");
+        }
         m_currentOrder = m_OfflineLevelsMap.lastKey();
         m_uid = qHash(m_currentURL);
         Options::setShowHIPS(true);
@@ -480,16 +540,25 @@ bool HIPSManager::setCurrentSource(const QString &title)
 // Extract which levels are available for offline use.
 void HIPSManager::setOfflineLevels(const QStringList &value)
 {
+    QList<int> orders;
     for (auto oneLevel : value)
     {
         if (oneLevel.startsWith("Norder"))
         {
             oneLevel.remove("Norder");
-            auto level =  oneLevel.toUInt();
-            m_OfflineLevelsMap[level] = level;
+            orders.append(oneLevel.toInt());
         }
     }
 
+    setOfflineOrders(orders);
+}
+
+void HIPSManager::setOfflineOrders(const QList<int> &orders)
+{
+    m_OfflineLevelsMap.clear();
+    for (auto level : orders)
+        m_OfflineLevelsMap[level] = level;
+
     // In case we don't have offline maps, fill all levels with 1
     if (m_OfflineLevelsMap.isEmpty())
     {
@@ -516,6 +585,43 @@ void HIPSManager::setOfflineLevels(const QStringList &value)
     }
 }
 
+void HIPSManager::loadOfflineSource()
+{
+    const QString path = Options::hIPSOfflinePath();
+
+    // Replaced rather than reopened, tiles still being decoded hold the previous one.
+    m_archive.reset();
+    m_failedTiles.clear();
+
+    if (QFileInfo(path).isFile())
+    {
+        auto archive = std::make_shared<HIPSArchive>();
+        if (archive->open(path))
+        {
+            m_archive = archive;
+            setOfflineOrders(m_archive->orders());
+            return;
+        }
+
+        qCWarning(KSTARS) << "Unable to open HiPS archive" << path;
+    }
+
+    QDir hipsDirectory(path);
+    auto orders = hipsDirectory.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
+    setOfflineLevels(orders);
+}
+
+bool HIPSManager::buildArchive(const QString &path, QString &error)
+{
+    if (m_currentSource.isEmpty())
+    {
+        error = i18n("Select an online HiPS source to archive.");
+        return false;
+    }
+
+    return HIPSArchive::buildFromCache(g_discCache, m_currentURL, m_currentSource.value("hips_frame"), path, error);
+}
+
 int HIPSManager::getUsableLevel(int level) const
 {
     return Options::hIPSUseOfflineSource() ? m_OfflineLevelsMap[level] : level;
@@ -9,11 +9,13 @@
 #pragma once
 
 #include "hips.h"
+#include "hipsarchive.h"
 #include "opships.h"
 #include "pixcache.h"
 #include "urlfiledownload.h"
 
 #include <QObject>
+#include <QThreadPool>
 
 #include <memory>
 
@@ -97,6 +99,13 @@ class HIPSManager : public QObject
         }
         void setOfflineLevels(const QStringList &value);
 
+        /**
+         * @brief buildArchive Pack the tiles of the current online source found in the disk cache in a
+         * HiPS archive, which can then be used as offline source.
+         * @return false, with the reason in error, if the archive could not be written
+         */
+        bool buildArchive(const QString &path, QString &error);
+
     public slots:
         bool setCurrentSource(const QString &title);
         void showSettings();
@@ -108,6 +117,7 @@ class HIPSManager : public QObject
         void slotDone(QNetworkReply::NetworkError error, QByteArray &data, pixCacheKey_t &key);
         void slotApply();
         void removeTimer(pixCacheKey_t &key);
+        void slotDecoded(const pixCacheKey_t &key, const QImage &image);
 
     private:
         HIPSManager();
@@ -116,7 +126,19 @@ class HIPSManager : public QObject
 
         // Cache
         PixCache m_cache;
+        // Tiles being downloaded or decoded
         QSet <pixCacheKey_t> m_downloadMap;
+        // Tiles which could not be decoded, not requested again
+        QSet <pixCacheKey_t> m_failedTiles;
+        // Decodes the downloaded tiles off the GUI thread
+        QThreadPool m_decodePool;
+
+        // Decodes a tile on the pool and adds it to the memory cache once done
+        void decode(const pixCacheKey_t &key, const QByteArray &data,
+                    std::shared_ptr<const HIPSArchive> archive = nullptr);
+        // Reads the offline levels from the archive or directory at the offline path
+        void loadOfflineSource();
+        void setOfflineOrders(const QList<int> &orders);
 
         void addToMemoryCache(pixCacheKey_t &key, pixCacheItem_t *item);
         pixCacheItem_t *getCacheItem(pixCacheKey_t &key);
@@ -139,4 +161,6 @@ class HIPSManager : public QObject
         uint16_t m_currentTileWidth { 0 };
         QUrl m_currentURL;
         QMap<int, int> m_OfflineLevelsMap;
+        // Offline source, when the offline path is an archive
+        std::shared_ptr<const HIPSArchive> m_archive;
 };
@@ -15,9 +15,50 @@
 #include "skyqpainter.h"
 #include "projections/projector.h"
 
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+// UV Mapping to apply image unto the destination image
+// 4x4 = 16 points are mapped from the source image unto the destination image.
+// Starting from each grandchild pixel, each pix polygon is mapped accordingly.
+// For example, pixel 357 will have 4 child pixels, each of them will have 4 childs pixels and so
+// on. Each healpix pixel appears roughly as a diamond on the sky map.
+// The corners points for HealPIX moves from NORTH -> EAST -> SOUTH -> WEST
+// Hence first point is 0.25, 0.25 in UV coordinate system.
+// Depending on the selected algorithm, the mapping will either utilize nearest neighbour
+// or bilinear interpolation.
+const QPointF uv[16][4] = {{QPointF(.25, .25), QPointF(0.25, 0), QPointF(0, .0), QPointF(0, .25)},
+    {QPointF(.25, .5), QPointF(0.25, 0.25), QPointF(0, .25), QPointF(0, .5)},
+    {QPointF(.5, .25), QPointF(0.5, 0), QPointF(.25, .0), QPointF(.25, .25)},
+    {QPointF(.5, .5), QPointF(0.5, 0.25), QPointF(.25, .25), QPointF(.25, .5)},
+
+    {QPointF(.25, .75), QPointF(0.25, 0.5), QPointF(0, 0.5), QPointF(0, .75)},
+    {QPointF(.25, 1), QPointF(0.25, 0.75), QPointF(0, .75), QPointF(0, 1)},
+    {QPointF(.5, .75), QPointF(0.5, 0.5), QPointF(.25, .5), QPointF(.25, .75)},
+    {QPointF(.5, 1), QPointF(0.5, 0.75), QPointF(.25, .75), QPointF(.25, 1)},
+
+    {QPointF(.75, .25), QPointF(0.75, 0), QPointF(0.5, .0), QPointF(0.5, .25)},
+    {QPointF(.75, .5), QPointF(0.75, 0.25), QPointF(0.5, .25), QPointF(0.5, .5)},
+    {QPointF(1, .25), QPointF(1, 0), QPointF(.75, .0), QPointF(.75, .25)},
+    {QPointF(1, .5), QPointF(1, 0.25), QPointF(.75, .25), QPointF(.75, .5)},
+
+    {QPointF(.75, .75), QPointF(0.75, 0.5), QPointF(0.5, .5), QPointF(0.5, .75)},
+    {QPointF(.75, 1), QPointF(0.75, 0.75), QPointF(0.5, .75), QPointF(0.5, 1)},
+    {QPointF(1, .75), QPointF(1, 0.5), QPointF(.75, .5), QPointF(.75, .75)},
+    {QPointF(1, 1), QPointF(1, 0.75), QPointF(.75, .75), QPointF(.75, 1)},
+};
+
+// Below this height, a band costs more to schedule than to rasterize
+constexpr int MIN_BAND_ROWS = 64;
+}
+
 HIPSRenderer::HIPSRenderer()
 {
-    m_scanRender.reset(new ScanRender());
     m_HEALpix.reset(new HEALPix());
 }
 
@@ -44,6 +85,7 @@ bool HIPSRenderer::render(uint16_t w, uint16_t h, QImage *hipsImage, const Proje
     level = HIPSManager::Instance()->getUsableLevel(level);
 
     m_renderedMap.clear();
+    m_tiles.clear();
     m_rendered = 0;
     m_blocks = 0;
     m_size = 0;
@@ -92,25 +134,38 @@ bool HIPSRenderer::render(uint16_t w, uint16_t h, QImage *hipsImage, const Proje
     if (size < 0)
         size = HIPSManager::Instance()->getCurrentTileWidth();
 
-    bool old = m_scanRender->isBilinearInterpolationEnabled();
-    m_scanRender->setBilinearInterpolationEnabled(Options::hIPSBiLinearInterpolation()
-            && (size >= HIPSManager::Instance()->getCurrentTileWidth() || allSky));
+    m_bilinear = Options::hIPSBiLinearInterpolation()
+                 && (size >= HIPSManager::Instance()->getCurrentTileWidth() || allSky);
+
+    // The tile cache is only accessed from this thread, so the tiles are collected first
+    collectRec(allSky, level, centerPix);
 
-    renderRec(allSky, level, centerPix, hipsImage);
+    renderTiles(hipsImage);
 
-    m_scanRender->setBilinearInterpolationEnabled(old);
+    if (Options::hIPSShowGrid())
+    {
+        QPainter p(hipsImage);
+        p.setRenderHint(QPainter::Antialiasing);
+        p.setPen(gridColor);
+
+        for (const Tile &tile : m_tiles)
+            renderGrid(p, tile, level);
+    }
+
+    // Release the images, they may be evicted from the cache
+    m_tiles.clear();
 
     return true;
 }
 
-void HIPSRenderer::renderRec(bool allsky, int level, int pix, QImage *pDest)
+void HIPSRenderer::collectRec(bool allsky, int level, int pix)
 {
     if (m_renderedMap.contains(pix))
     {
         return;
     }
 
-    if (renderPix(allsky, level, pix, pDest))
+    if (collectPix(allsky, level, pix))
     {
         m_renderedMap.insert(pix);
         int dirs[8];
@@ -118,132 +173,156 @@ void HIPSRenderer::renderRec(bool allsky, int level, int pix, QImage *pDest)
 
         m_HEALpix->neighbours(nside, pix, dirs);
 
-        renderRec(allsky, level, dirs[0], pDest);
-        renderRec(allsky, level, dirs[2], pDest);
-        renderRec(allsky, level, dirs[4], pDest);
-        renderRec(allsky, level, dirs[6], pDest);
+        collectRec(allsky, level, dirs[0]);
+        collectRec(allsky, level, dirs[2]);
+        collectRec(allsky, level, dirs[4]);
+        collectRec(allsky, level, dirs[6]);
     }
 }
 
-bool HIPSRenderer::renderPix(bool allsky, int level, int pix, QImage *pDest)
+bool HIPSRenderer::collectPix(bool allsky, int level, int pix)
 {
     SkyPoint cornerSkyCoords[4];
-    QPointF cornerScreenCoords[4];
+    Tile tile;
     bool freeImage = false;
 
+    tile.pix = pix;
     m_HEALpix->getCornerPoints(level, pix, cornerSkyCoords);
     bool isVisible = false;
 
     for (int i = 0; i < 4; i++)
     {
-        cornerScreenCoords[i] = m_projector->toScreen(&cornerSkyCoords[i]);
+        tile.corners[i] = m_projector->toScreen(&cornerSkyCoords[i]);
         isVisible |= m_projector->checkVisibility(&cornerSkyCoords[i]);
     }
 
     //if (SKPLANECheckFrustumToPolygon(trfGetFrustum(), pts, 4))
     // Is the right way to do this?
 
-    if (isVisible)
+    if (!isVisible)
+        return false;
+
+    m_blocks++;
+
+    QImage *image = HIPSManager::Instance()->getPix(allsky, level, pix, freeImage);
+
+    if (image)
     {
-        m_blocks++;
+        m_rendered++;
+
+        m_size += image->sizeInBytes();
 
-        /*for (int i = 0; i < 4; i++)
+        tile.image = *image;
+
+        if (freeImage)
         {
-          trfProjectPointNoCheck(&pts[i]);
-        } */
+            delete image;
+        }
+
+        int childPixelID[4];
 
-        QImage *image = HIPSManager::Instance()->getPix(allsky, level, pix, freeImage);
+        // Find all the 4 children of the current pixel
+        m_HEALpix->getPixChilds(pix, childPixelID);
 
-        if (image)
+        tile.top = std::numeric_limits<double>::max();
+        tile.bottom = std::numeric_limits<double>::lowest();
+
+        int j = 0;
+        for (int id : childPixelID)
         {
-            m_rendered++;
-
-            m_size += image->sizeInBytes();
-
-            // UV Mapping to apply image unto the destination image
-            // 4x4 = 16 points are mapped from the source image unto the destination image.
-            // Starting from each grandchild pixel, each pix polygon is mapped accordingly.
-            // For example, pixel 357 will have 4 child pixels, each of them will have 4 childs pixels and so
-            // on. Each healpix pixel appears roughly as a diamond on the sky map.
-            // The corners points for HealPIX moves from NORTH -> EAST -> SOUTH -> WEST
-            // Hence first point is 0.25, 0.25 in UV coordinate system.
-            // Depending on the selected algorithm, the mapping will either utilize nearest neighbour
-            // or bilinear interpolation.
-            QPointF uv[16][4] = {{QPointF(.25, .25), QPointF(0.25, 0), QPointF(0, .0), QPointF(0, .25)},
-                {QPointF(.25, .5), QPointF(0.25, 0.25), QPointF(0, .25), QPointF(0, .5)},
-                {QPointF(.5, .25), QPointF(0.5, 0), QPointF(.25, .0), QPointF(.25, .25)},
-                {QPointF(.5, .5), QPointF(0.5, 0.25), QPointF(.25, .25), QPointF(.25, .5)},
-
-                {QPointF(.25, .75), QPointF(0.25, 0.5), QPointF(0, 0.5), QPointF(0, .75)},
-                {QPointF(.25, 1), QPointF(0.25, 0.75), QPointF(0, .75), QPointF(0, 1)},
-                {QPointF(.5, .75), QPointF(0.5, 0.5), QPointF(.25, .5), QPointF(.25, .75)},
-                {QPointF(.5, 1), QPointF(0.5, 0.75), QPointF(.25, .75), QPointF(.25, 1)},
-
-                {QPointF(.75, .25), QPointF(0.75, 0), QPointF(0.5, .0), QPointF(0.5, .25)},
-                {QPointF(.75, .5), QPointF(0.75, 0.25), QPointF(0.5, .25), QPointF(0.5, .5)},
-                {QPointF(1, .25), QPointF(1, 0), QPointF(.75, .0), QPointF(.75, .25)},
-                {QPointF(1, .5), QPointF(1, 0.25), QPointF(.75, .25), QPointF(.75, .5)},
-
-                {QPointF(.75, .75), QPointF(0.75, 0.5), QPointF(0.5, .5), QPointF(0.5, .75)},
-                {QPointF(.75, 1), QPointF(0.75, 0.75), QPointF(0.5, .75), QPointF(0.5, 1)},
-                {QPointF(1, .75), QPointF(1, 0.5), QPointF(.75, .5), QPointF(.75, .75)},
-                {QPointF(1, 1), QPointF(1, 0.75), QPointF(.75, .75), QPointF(.75, 1)},
-            };
-
-            int childPixelID[4];
-
-            // Find all the 4 children of the current pixel
-            m_HEALpix->getPixChilds(pix, childPixelID);
-
-            int j = 0;
-            for (int id : childPixelID)
+            int grandChildPixelID[4];
+            // Find the children of this child (i.e. grand child)
+            // Then we have 4x4 pixels under the primary pixel
+            // The image is interpolated and rendered over these pixels
+            // coordinate to minimize any distortions due to the projection
+            // system.
+            m_HEALpix->getPixChilds(id, grandChildPixelID);
+
+            for (int id2 : grandChildPixelID)
             {
-                int grandChildPixelID[4];
-                // Find the children of this child (i.e. grand child)
-                // Then we have 4x4 pixels under the primary pixel
-                // The image is interpolated and rendered over these pixels
-                // coordinate to minimize any distortions due to the projection
-                // system.
-                m_HEALpix->getPixChilds(id, grandChildPixelID);
-
-                QPointF fineScreenCoords[4];
+                SkyPoint fineSkyPoints[4];
+                m_HEALpix->getCornerPoints(level + 2, id2, fineSkyPoints);
 
-                for (int id2 : grandChildPixelID)
+                for (int i = 0; i < 4; i++)
                 {
-                    SkyPoint fineSkyPoints[4];
-                    m_HEALpix->getCornerPoints(level + 2, id2, fineSkyPoints);
-
-                    for (int i = 0; i < 4; i++)
-                        fineScreenCoords[i] = m_projector->toScreen(&fineSkyPoints[i]);
-                    m_scanRender->renderPolygon(3, fineScreenCoords, pDest, image, uv[j]);
-                    j++;
+                    tile.fine[j][i] = m_projector->toScreen(&fineSkyPoints[i]);
+                    tile.top = std::min(tile.top, tile.fine[j][i].y());
+                    tile.bottom = std::max(tile.bottom, tile.fine[j][i].y());
                 }
+                j++;
             }
+        }
+    }
 
-            if (freeImage)
+    // Tiles without image are kept for the grid
+    m_tiles.push_back(std::move(tile));
+
+    return true;
+}
+
+void HIPSRenderer::renderTiles(QImage *pDest)
+{
+    const int height = pDest->height();
+    const int bands = std::max(1, std::min(QThread::idealThreadCount(), height / MIN_BAND_ROWS));
+
+    while (static_cast<int>(m_scanRenders.size()) < bands)
+        m_scanRenders.emplace_back(new ScanRender());
+
+    // Make sure the destination is detached before the bands write to it
+    uchar *bits = pDest->bits();
+
+    auto renderBand = [&](int band)
+    {
+        const int top = height * band / bands;
+        const int bottom = height * (band + 1) / bands;
+
+        // The band is rasterized as an image of its own, sharing the rows of the destination
+        QImage bandImage(bits + top * pDest->bytesPerLine(), pDest->width(), bottom - top, pDest->bytesPerLine(),
+                         pDest->format());
+        ScanRender *scanRender = m_scanRenders[band].get();
+        scanRender->setBilinearInterpolationEnabled(m_bilinear);
+
+        for (Tile &tile : m_tiles)
+        {
+            if (tile.image.isNull() || tile.bottom < top || tile.top >= bottom)
+                continue;
+
+            for (int j = 0; j < 16; j++)
             {
-                delete image;
+                QPointF fineScreenCoords[4];
+                QPointF fineUV[4];
+
+                for (int i = 0; i < 4; i++)
+                {
+                    fineScreenCoords[i] = tile.fine[j][i] - QPointF(0, top);
+                    fineUV[i] = uv[j][i];
+                }
+
+                scanRender->renderPolygon(3, fineScreenCoords, &bandImage, &tile.image, fineUV);
             }
         }
+    };
 
-        if (Options::hIPSShowGrid())
-        {
-            QPainter p(pDest);
-            p.setRenderHint(QPainter::Antialiasing);
-            p.setPen(gridColor);
-
-            p.drawLine(cornerScreenCoords[0].x(), cornerScreenCoords[0].y(), cornerScreenCoords[1].x(), cornerScreenCoords[1].y());
-            p.drawLine(cornerScreenCoords[1].x(), cornerScreenCoords[1].y(), cornerScreenCoords[2].x(), cornerScreenCoords[2].y());
-            p.drawLine(cornerScreenCoords[2].x(), cornerScreenCoords[2].y(), cornerScreenCoords[3].x(), cornerScreenCoords[3].y());
-            p.drawLine(cornerScreenCoords[3].x(), cornerScreenCoords[3].y(), cornerScreenCoords[0].x(), cornerScreenCoords[0].y());
-            p.drawText((cornerScreenCoords[0].x() + cornerScreenCoords[1].x() + cornerScreenCoords[2].x() + cornerScreenCoords[3].x()) /
-                       4,
-                       (cornerScreenCoords[0].y() + cornerScreenCoords[1].y() + cornerScreenCoords[2].y() + cornerScreenCoords[3].y()) / 4,
-                       QString::number(pix) + " / " + QString::number(level));
-        }
+    QList<QFuture<void>> futures;
+    for (int band = 1; band < bands; band++)
+        futures.append(QtConcurrent::run(renderBand, band));
 
-        return true;
-    }
+    renderBand(0);
 
-    return false;
+    for (auto &future : futures)
+        future.waitForFinished();
+}
+
+void HIPSRenderer::renderGrid(QPainter &p, const Tile &tile, int level)
+{
+    const QPointF *cornerScreenCoords = tile.corners;
+
+    p.drawLine(cornerScreenCoords[0].x(), cornerScreenCoords[0].y(), cornerScreenCoords[1].x(), cornerScreenCoords[1].y());
+    p.drawLine(cornerScreenCoords[1].x(), cornerScreenCoords[1].y(), cornerScreenCoords[2].x(), cornerScreenCoords[2].y());
+    p.drawLine(cornerScreenCoords[2].x(), cornerScreenCoords[2].y(), cornerScreenCoords[3].x(), cornerScreenCoords[3].y());
+    p.drawLine(cornerScreenCoords[3].x(), cornerScreenCoords[3].y(), cornerScreenCoords[0].x(), cornerScreenCoords[0].y());
+    p.drawText((cornerScreenCoords[0].x() + cornerScreenCoords[1].x() + cornerScreenCoords[2].x() + cornerScreenCoords[3].x()) /
+               4,
+               (cornerScreenCoords[0].y() + cornerScreenCoords[1].y() + cornerScreenCoords[2].y() + cornerScreenCoords[3].y()) / 4,
+               QString::number(tile.pix) + " / " + QString::number(level));
 }
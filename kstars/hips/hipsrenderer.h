@@ -13,9 +13,20 @@
 #include "scanrender.h"
 
 #include <memory>
+#include <vector>
 
 class Projector;
+class QPainter;
 
+/**
+ * @class HIPSRenderer
+ * Renders the HiPS tiles covering the sky map.
+ *
+ * Rendering is done in two passes. The visible HEALPix pixels are first collected on the calling
+ * thread, walking the neighbours of the pixel at the center of the view, together with their tile
+ * images and projected corners. The tiles are then rasterized in horizontal bands of the destination
+ * image, one per worker thread, so no two threads ever write the same pixels.
+ */
 class HIPSRenderer : public QObject
 {
   Q_OBJECT
@@ -23,20 +34,39 @@ public:
   explicit HIPSRenderer();
   //void render(mapView_t *view, CSkPainter *painter, QImage *pDest);
   bool render(uint16_t w, uint16_t h, QImage *hipsImage, const Projector *m_proj);
-  void renderRec(bool allsky, int level, int pix, QImage *pDest);
-  bool renderPix(bool allsky, int level, int pix, QImage *pDest);
 
 signals:
 
 public slots:
 
-private:  
+private:
+  // A visible tile, ready to be rasterized
+  struct Tile
+  {
+    int pix { 0 };
+    // Shallow copy of the cached image, which may be evicted while rendering
+    QImage image;
+    QPointF corners[4];
+    // The 4x4 grandchild pixels the image is mapped onto
+    QPointF fine[16][4];
+    double top { 0 };
+    double bottom { 0 };
+  };
+
+  void collectRec(bool allsky, int level, int pix);
+  bool collectPix(bool allsky, int level, int pix);
+  void renderTiles(QImage *pDest);
+  void renderGrid(QPainter &p, const Tile &tile, int level);
+
   int m_blocks { 0 };
   int m_rendered { 0 };
   int m_size { 0 };
   QSet<int>  m_renderedMap;
+  std::vector<Tile> m_tiles;
   std::unique_ptr<HEALPix> m_HEALpix;
-  std::unique_ptr<ScanRender> m_scanRender;
+  // One per band, as the scan buffers are not shared between threads
+  std::vector<std::unique_ptr<ScanRender>> m_scanRenders;
+  bool m_bilinear { false };
   const Projector *m_projector;
   QColor gridColor;
 };
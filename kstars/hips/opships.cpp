@@ -17,6 +17,7 @@
 
 #include <KConfigDialog>
 
+#include <QApplication>
 #include <QCheckBox>
 #include <QComboBox>
 #include <QFileDialog>
@@ -52,6 +53,38 @@ OpsHIPSCache::OpsHIPSCache() : QFrame(KStars::Instance())
         HIPSManager::Instance()->setOfflineLevels(orders);
         HIPSManager::Instance()->setCurrentSource("DSS Colored");
     });
+
+    // The archive is opened once the settings are applied
+    connect(selectArchiveB, &QPushButton::clicked, this, [this]()
+    {
+        QString file = QFileDialog::getOpenFileName(this, i18nc("@title:window", "HiPS Offline Archive"),
+                       kcfg_HIPSOfflinePath->text(),
+                       i18n("HiPS Archives (*.%1)", QString(HIPSArchive::EXTENSION)));
+
+        if (file.isEmpty())
+            return;
+
+        kcfg_HIPSOfflinePath->setText(file);
+    });
+
+    connect(buildArchiveB, &QPushButton::clicked, this, [this]()
+    {
+        QString file = QFileDialog::getSaveFileName(this, i18nc("@title:window", "Build HiPS Archive"),
+                       QDir::homePath(), i18n("HiPS Archives (*.%1)", QString(HIPSArchive::EXTENSION)));
+
+        if (file.isEmpty())
+            return;
+
+        QString error;
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        const bool built = HIPSManager::Instance()->buildArchive(file, error);
+        QApplication::restoreOverrideCursor();
+
+        if (built)
+            KSNotification::info(i18n("HiPS archive %1 built.", file));
+        else
+            KSNotification::error(i18n("Failed to build HiPS archive: %1", error));
+    });
 }
 
 OpsHIPS::OpsHIPS() : QFrame(KStars::Instance())
@@ -22,6 +22,7 @@
 #endif
 
 #include <KNotifications/KNotification>
+#include <KFormat>
 #include "auxiliary/ksmessagebox.h"
 #include "ksnotification.h"
 #include <QImageReader>
@@ -58,8 +59,6 @@ Camera::~Camera()
         m_ImageViewerWindow->close();
     if (fileWriteThread.isRunning())
         fileWriteThread.waitForFinished();
-    if (fileWriteBuffer != nullptr)
-        delete [] fileWriteBuffer;
 }
 
 void Camera::setBLOBManager(const char *device, INDI::Property prop)
@@ -502,7 +501,8 @@ void Camera::setWSBLOB(const QByteArray &message, const QString &extension)
     bp->setBlob(const_cast<char *>(message.data()));
     bp->setSize(message.size());
     bp->setFormat(extension.toLatin1().constData());
-    processBLOB(primaryCCDBLOB);
+    // The message already owns the frame, so it can be shared as is
+    processBLOB(primaryCCDBLOB, message);
 
     // Disassociate
     bp->setBlob(nullptr);
@@ -572,14 +572,14 @@ bool Camera::generateFilename(bool batch_mode, const QString &extension, QString
     return true;
 }
 
-bool Camera::writeImageFile(const QString &filename, INDI::Property prop, bool is_fits)
+bool Camera::writeImageFile(const QString &filename, const QByteArray &frame, bool transient, bool is_fits)
 {
     // TODO: Not yet threading the writes for non-fits files.
     // Would need to deal with the raw conversion, etc.
     if (is_fits)
     {
         // Check if the last write is still ongoing, and if so wait.
-        // It is using the fileWriteBuffer.
+        // This keeps frames written in order.
         if (fileWriteThread.isRunning())
         {
             fileWriteThread.waitForFinished();
@@ -588,29 +588,24 @@ bool Camera::writeImageFile(const QString &filename, INDI::Property prop, bool i
         // Wait until the file is written before overwritting the filename.
         fileWriteFilename = filename;
 
-        // Will write blob data in a separate thread, and can't depend on the blob
-        // memory, so copy it first.
-
-        auto bp = prop.getBLOB()->at(0);
-        // Check buffer size.
-        if (fileWriteBufferSize != bp->getBlobLen())
+        // Write file on a separate thread. A frame which owns its data is shared with the thread.
+        // A transient frame lives in the BLOB buffer, reused for the next BLOB, so it is copied into
+        // fileWriteBuffer, which keeps its allocation from one frame to the next. The thread only gets
+        // a view of it, the previous write having finished before it is overwritten.
+        // Probably too late to return an error if the file couldn't write.
+        if (transient)
         {
-            if (fileWriteBuffer != nullptr)
-                delete [] fileWriteBuffer;
-            fileWriteBufferSize = bp->getBlobLen();
-            fileWriteBuffer = new char[fileWriteBufferSize];
+            fileWriteBuffer.resize(frame.size());
+            memcpy(fileWriteBuffer.data(), frame.constData(), frame.size());
+            fileWriteThread = QtConcurrent::run(this, &ISD::Camera::WriteImageFileInternal, fileWriteFilename,
+                                                QByteArray::fromRawData(fileWriteBuffer.constData(), fileWriteBuffer.size()));
         }
-
-        // Copy memory, and write file on a separate thread.
-        // Probably too late to return an error if the file couldn't write.
-        memcpy(fileWriteBuffer, bp->getBlob(), bp->getBlobLen());
-        fileWriteThread = QtConcurrent::run(this, &ISD::Camera::WriteImageFileInternal, fileWriteFilename, fileWriteBuffer,
-                                            bp->getBlobLen());
+        else
+            fileWriteThread = QtConcurrent::run(this, &ISD::Camera::WriteImageFileInternal, fileWriteFilename, frame);
     }
     else
     {
-        auto bp = prop.getBLOB()->at(0);
-        if (!WriteImageFileInternal(filename, static_cast<char*>(bp->getBlob()), bp->getBlobLen()))
+        if (!WriteImageFileInternal(filename, frame))
             return false;
     }
     return true;
@@ -660,6 +655,11 @@ QSharedPointer<FITSViewer> Camera::getFITSViewer()
 }
 
 bool Camera::processBLOB(INDI::Property prop)
+{
+    return processBLOB(prop, QByteArray());
+}
+
+bool Camera::processBLOB(INDI::Property prop, const QByteArray &frame)
 {
     auto bvp = prop.getBLOB();
     // Ignore write-only BLOBs since we only receive it for state-change
@@ -730,13 +730,20 @@ bool Camera::processBLOB(INDI::Property prop)
 
     }
 #endif
+    // A BLOB received from INDI lives in the property's buffer, which is reused for the next BLOB.
+    // It is only viewed here, and copied by the file writer if it must outlive this call.
+    const bool batchWrite = targetChip->isBatchMode() && targetChip->getCaptureMode() != FITS_CALIBRATE;
+    const bool transient = frame.isNull();
+    const QByteArray sharedFrame = transient ?
+                                   QByteArray::fromRawData(static_cast<const char *>(bp->getBlob()), bp->getSize()) : frame;
+
     // Create file name for sequences.
-    if (targetChip->isBatchMode() && targetChip->getCaptureMode() != FITS_CALIBRATE)
+    if (batchWrite)
     {
         // If either generating file name or writing the image file fails
         // then return
         if (!generateFilename(targetChip->isBatchMode(), format, &filename) ||
-                !writeImageFile(filename, prop, BType == BLOB_FITS))
+                !writeImageFile(filename, sharedFrame, transient, BType == BLOB_FITS))
         {
             connect(KSMessageBox::Instance(), &KSMessageBox::accepted, this, [ = ]()
             {
@@ -865,15 +872,19 @@ bool Camera::processBLOB(INDI::Property prop)
         return true;
     }
 
-    QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<char *>(bp->getBlob()), bp->getSize());
     QSharedPointer<FITSData> imageData;
-    imageData.reset(new FITSData(targetChip->getCaptureMode()), &QObject::deleteLater);
-    if (!imageData->loadFromBuffer(buffer, shortFormat, filename))
+    imageData.reset(new FITSData(targetChip->getCaptureMode(), targetChip->getBufferPool()), &QObject::deleteLater);
+    if (!imageData->loadFromBuffer(sharedFrame, shortFormat, filename))
     {
         emit error(ERROR_LOAD);
         return true;
     }
 
+    targetChip->updateBufferPool(imageData);
+    const auto poolStatistics = targetChip->getBufferPool()->statistics();
+    qCDebug(KSTARS_INDI) << "Image buffer pool hits:" << poolStatistics.hits << "misses:" << poolStatistics.misses
+                         << "idle:" << KFormat().formatByteSize(poolStatistics.idleBytes);
+
     handleImage(targetChip, filename, prop, imageData);
     return true;
 }
@@ -1806,8 +1817,10 @@ bool Camera::setScopeInfo(double focalLength, double aperture)
 }
 
 // Internal function to write an image blob to disk.
-bool Camera::WriteImageFileInternal(const QString &filename, char *buffer, const size_t size)
+bool Camera::WriteImageFileInternal(const QString &filename, const QByteArray &frame)
 {
+    const char *buffer = frame.constData();
+    const size_t size = frame.size();
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly))
     {
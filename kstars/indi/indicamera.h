@@ -259,9 +259,13 @@ class Camera : public ConcreteDevice
     private:
         void processStream(INDI::Property prop);
         bool generateFilename(bool batch_mode, const QString &extension, QString *filename);
-        // Saves an image to disk on a separate thread.
-        bool writeImageFile(const QString &filename, INDI::Property prop, bool is_fits);
-        bool WriteImageFileInternal(const QString &filename, char *buffer, const size_t size);
+        // Processes a BLOB. A frame received over a websocket owns its contents and is shared with the file writer and
+        // FITSData. For a BLOB received from INDI, frame is null: its buffer belongs to INDI and is only viewed by
+        // FITSData, while the file writer copies it.
+        bool processBLOB(INDI::Property prop, const QByteArray &frame);
+        // Saves an image to disk on a separate thread. A transient frame is copied first, as it does not own its data.
+        bool writeImageFile(const QString &filename, const QByteArray &frame, bool transient, bool is_fits);
+        bool WriteImageFileInternal(const QString &filename, const QByteArray &frame);
         // Creates or finds the FITSViewer.
         // TODO: Need to remove all FITSViewer related functions from INDI::Camera
         QSharedPointer<FITSViewer> getFITSViewer();
@@ -315,8 +319,7 @@ class Camera : public ConcreteDevice
         QPair<double, double> m_ExposurePresetsMinMax;
 
         // Used when writing the image fits file to disk in a separate thread.
-        char *fileWriteBuffer { nullptr };
-        int fileWriteBufferSize { 0 };
+        QByteArray fileWriteBuffer;
         QString fileWriteFilename;
         QFuture<void> fileWriteThread;
 };
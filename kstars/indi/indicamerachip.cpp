@@ -8,6 +8,7 @@
 #include "indicamera.h"
 
 #include "Options.h"
+#include "ksutils.h"
 
 #include "indi_debug.h"
 
@@ -16,6 +17,22 @@ namespace ISD
 
 CameraChip::CameraChip(ISD::Camera *camera, ChipType type): m_Camera(camera), m_Type(type) {}
 
+void CameraChip::updateBufferPool(const QSharedPointer<FITSData> &data)
+{
+    const auto &stats = data->getStatistics();
+    const uint64_t frameBytes = static_cast<uint64_t>(stats.samples_per_channel) * stats.channels * stats.bytesPerPixel;
+
+    // Buffers of another geometry, e.g. after changing binning or subframe, would not be reused
+    if (frameBytes != bufferPoolFrameBytes)
+    {
+        bufferPool->clear();
+        bufferPoolFrameBytes = frameBytes;
+    }
+
+    auto memoryMB = KSUtils::getAvailableRAM() / 1e6;
+    bufferPool->setMaxIdleBytes(memoryMB < BUFFER_POOL_MEMORY_LIMIT ? 0 : BUFFER_POOL_FRAMES * frameBytes);
+}
+
 FITSView *CameraChip::getImageView(FITSMode imageType)
 {
     switch (imageType)
@@ -115,6 +115,15 @@ class CameraChip
             imageData = data;
         }
 
+        // Pool of image buffers reused by the frames of this chip
+        const QSharedPointer<FITSBufferPool> &getBufferPool() const
+        {
+            return bufferPool;
+        }
+        // Sizes the buffer pool to a few frames like data, emptying it if the frame geometry changed
+        // or if system memory runs low.
+        void updateBufferPool(const QSharedPointer<FITSData> &data);
+
         int getISOIndex() const;
         bool getISOValue(QString &value) const;
         bool setISOIndex(int value);
@@ -124,6 +133,9 @@ class CameraChip
     private:
         QPointer<FITSView> normalImage, focusImage, guideImage, calibrationImage, alignImage;
         QSharedPointer<FITSData> imageData { nullptr };
+        // Sized by updateBufferPool() once the first frame is received
+        QSharedPointer<FITSBufferPool> bufferPool { new FITSBufferPool(0) };
+        uint64_t bufferPoolFrameBytes { 0 };
         FITSMode captureMode { FITS_NORMAL };
         FITSScale captureFilter { FITS_NONE };
         bool batchMode { false };
@@ -134,6 +146,11 @@ class CameraChip
 
         ISD::Camera *m_Camera { nullptr };
         ChipType m_Type;
+
+        // Idle buffers are kept for this many frames
+        static constexpr uint8_t BUFFER_POOL_FRAMES {3};
+        // Do not keep idle buffers if system memory falls below 250MB.
+        static constexpr uint16_t BUFFER_POOL_MEMORY_LIMIT {250};
 };
 
 }
@@ -196,6 +196,11 @@ bool KStarsData::initialize()
     //Initialize SkyMapComposite//
     emit progressText(i18n("Loading sky objects"));
     m_SkyComposite.reset(new SkyMapComposite());
+    // Redraw once the updates spread over several frames are done
+    connect(m_SkyComposite.get(), &SkyMapComposite::updateFinished, this, [this]()
+    {
+        emit skyUpdate(false);
+    });
     //Load Image URLs//
     //#ifndef Q_OS_ANDROID
     //On Android these 2 calls produce segfault. WARNING
@@ -264,7 +269,7 @@ void KStarsData::updateTime(GeoLocation *geo, const bool automaticDSTchange)
         LastNumUpdate = KStarsDateTime(ut().djd());
         m_preUpdateNumID++;
         m_preUpdateNum = KSNumbers(num);
-        skyComposite()->update(&num);
+        updateSkyComposite(&num);
     }
 
     if (std::abs(ut().djd() - LastPlanetUpdate.djd()) > 0.01)
@@ -287,12 +292,22 @@ void KStarsData::updateTime(GeoLocation *geo, const bool automaticDSTchange)
         LastSkyUpdate = ut();
         m_preUpdateID++;
         //omit KSNumbers arg == just update Alt/Az coords // <-- Eh? -- asimha. Looks like this behavior / ideology has changed drastically.
-        skyComposite()->update(&num);
+        updateSkyComposite(&num);
 
         emit skyUpdate(clock()->isManualMode());
     }
 }
 
+void KStarsData::updateSkyComposite(KSNumbers *num)
+{
+    // While the clock runs, the update is spread over the next frames so that fast time
+    // scales do not freeze the UI. Manual steps and time changes are applied at once.
+    if (clock()->isActive() && !clock()->isManualMode())
+        skyComposite()->updateIncrementally(num);
+    else
+        skyComposite()->update(num);
+}
+
 void KStarsData::syncUpdateIDs()
 {
     m_updateID = m_preUpdateID;
@@ -539,6 +539,12 @@ class KStarsData : public QObject
          */
         void resetToNewDST(GeoLocation *geo, const bool automaticDSTchange);
 
+        /**
+         * Update the sky composite with @p num, incrementally while the clock runs.
+         * Used by updateTime().
+         */
+        void updateSkyComposite(KSNumbers *num);
+
         /**
          * As KStarsData::getUserData just non-const.
          * @warning This method is not thread safe :) so take care of that when you use it.
@@ -21,6 +21,7 @@
 #if !defined(KSTARS_LITE)
 #include "kstars.h"
 #include "skymap.h"
+#include "hips/hipsarchive.h"
 #endif
 
 #if !defined(KSTARS_LITE)
@@ -33,6 +34,8 @@
 #if !defined(KSTARS_LITE)
 #include <QCommandLineParser>
 #include <QCommandLineOption>
+#include <QFileInfo>
+#include <QNetworkDiskCache>
 #endif
 #include <QDebug>
 #include <QPixmap>
@@ -198,6 +201,11 @@ int main(int argc, char *argv[])
     parser.addOption(QCommandLineOption("height", i18n("Height of sky image."), "value"));
     parser.addOption(QCommandLineOption("date", i18n("Date and time."), "string"));
     parser.addOption(QCommandLineOption("paused", i18n("Start with clock paused.")));
+    parser.addOption(QCommandLineOption("build-hips-archive", i18n("Build a HiPS archive for offline use and exit."),
+                                        "file"));
+    parser.addOption(QCommandLineOption("hips-source",
+                                        i18n("HiPS directory, or service URL of a survey in the HiPS disk cache, to build the archive from."),
+                                        "directory|url"));
 
     // urls to open
     parser.addPositionalArgument(QStringLiteral("urls"), i18n("FITS file(s) to open."),
@@ -206,6 +214,31 @@ int main(int argc, char *argv[])
     parser.process(app);
     aboutData.processCommandLine(&parser);
 
+    if (parser.isSet("build-hips-archive"))
+    {
+        const QString archive = parser.value("build-hips-archive");
+        const QString source  = parser.value("hips-source");
+        QString error;
+        bool built = false;
+
+        if (QFileInfo(source).isDir())
+            built = HIPSArchive::build(source, archive, error);
+        else
+        {
+            QNetworkDiskCache cache;
+            cache.setCacheDirectory(QDir(KSPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("hips"));
+            built = HIPSArchive::buildFromCache(&cache, QUrl(source), "equatorial", archive, error);
+        }
+
+        if (!built)
+        {
+            qCWarning(KSTARS) << "Unable to build HiPS archive" << archive << ":" << error;
+            return 1;
+        }
+
+        return 0;
+    }
+
     if (parser.isSet("dump"))
     {
         qCDebug(KSTARS) << "Dumping sky image";
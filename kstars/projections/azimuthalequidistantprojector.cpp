@@ -35,3 +35,22 @@ double AzimuthalEquidistantProjector::projectionL(double x) const
 {
     return x;
 }
+
+void AzimuthalEquidistantProjector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                                                bool *visible, bool oRefract) const
+{
+    Q_UNUSED(oRefract);
+    projectAnglesWith([this](double c)
+    {
+        return AzimuthalEquidistantProjector::projectionK(c);
+    }, dX, Y, count, screen, visible);
+}
+
+void AzimuthalEquidistantProjector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                                                 ProjectedPoints &out) const
+{
+    projectVectorsWith([this](double c)
+    {
+        return AzimuthalEquidistantProjector::projectionK(c);
+    }, u, v, w, source, count, out);
+}
@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#if __GNUC__ > 5
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+#if __GNUC__ > 6
+#pragma GCC diagnostic ignored "-Wint-in-bool-context"
+#endif
+#include <Eigen/Core>
+#if __GNUC__ > 5
+#pragma GCC diagnostic pop
+#endif
+
+#include <QVector>
+
+/**
+ * @short Points given as J2000.0 unit vectors in separate arrays
+ *
+ * This is the input of Projector::projectCatalog(). The arrays are not owned.
+ */
+struct CatalogVectors
+{
+    const float *x { nullptr };
+    const float *y { nullptr };
+    const float *z { nullptr };
+    /// Proper motion vectors in radians per Julian millennium, may be nullptr
+    const float *pmX { nullptr };
+    const float *pmY { nullptr };
+    const float *pmZ { nullptr };
+    int count { 0 };
+};
+
+/**
+ * @short Transformation from J2000.0 unit vectors to the frame of the current view
+ *
+ * The frame of the view is equatorial of date, or (north, west, zenith) when using Alt/Az.
+ * A point is transformed as normalize(rotation * (v + julianMillenia * pm) + aberration).
+ * @see Projector::catalogTransform()
+ */
+struct CatalogTransform
+{
+    Eigen::Matrix3f rotation { Eigen::Matrix3f::Identity() };
+    Eigen::Vector3f aberration { Eigen::Vector3f::Zero() };
+    /// Row giving sin(altitude) from a vector in the frame of the view
+    Eigen::Vector3f up { Eigen::Vector3f::UnitZ() };
+    float julianMillenia { 0 };
+};
+
+/**
+ * @short Screen positions produced by the batch projection functions
+ *
+ * Only points that survive culling are stored. The buffers grow as needed and are reused
+ * between calls, so keep one instance around instead of creating one per batch.
+ */
+struct ProjectedPoints
+{
+    /// Screen coordinates of the visible points
+    QVector<float> x, y;
+    /// Index of each visible point in the input arrays
+    QVector<int> index;
+    /// Number of visible points
+    int count { 0 };
+
+    /// Scratch space holding the input transformed to the frame of the view
+    QVector<float> u, v, w;
+    QVector<int> source;
+};
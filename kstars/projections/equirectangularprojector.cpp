@@ -60,6 +60,54 @@ Eigen::Vector2f EquirectangularProjector::toScreenVec(const SkyPoint *o, bool oR
     return p;
 }
 
+void EquirectangularProjector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+        bool *visible, bool oRefract) const
+{
+    double Y0;
+    if (m_vp.useAltAz)
+        Y0 = SkyPoint::refract(m_vp.focus->alt(), oRefract).radians();
+    else
+        Y0 = m_vp.focus->dec().radians();
+
+    for (int i = 0; i < count; ++i)
+    {
+        screen[i] = rst(KSUtils::reduceAngle(dX[i], -dms::PI, dms::PI), Y[i] - Y0);
+        if (visible)
+            visible[i] = (screen[i][0] > 0 && screen[i][0] < m_vp.width);
+    }
+}
+
+void EquirectangularProjector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+        ProjectedPoints &out) const
+{
+    const double lon0 = focusLongitude();
+    double Y0;
+    if (m_vp.useAltAz)
+        Y0 = SkyPoint::refract(m_vp.focus->alt(), m_vp.useRefraction).radians();
+    else
+        Y0 = m_vp.focus->dec().radians();
+
+    float *x   = out.x.data(), *y = out.y.data();
+    int *index = out.index.data();
+    int n      = out.count;
+
+    for (int i = 0; i < count; ++i)
+    {
+        const double Y  = asin(qBound(-1.0f, w[i], 1.0f));
+        const double dX = KSUtils::reduceAngle(atan2(v[i], u[i]) - lon0, -dms::PI, dms::PI);
+
+        Eigen::Vector2f p = rst(dX, Y - Y0);
+        if (!onScreen(p))
+            continue;
+
+        x[n]     = p.x();
+        y[n]     = p.y();
+        index[n] = source[i];
+        ++n;
+    }
+    out.count = n;
+}
+
 SkyPoint EquirectangularProjector::fromScreen(const QPointF &p, dms *LST, const dms *lat, bool onlyAltAz) const
 {
     SkyPoint result;
@@ -26,6 +26,12 @@ class EquirectangularProjector : public Projector
         SkyPoint fromScreen(const QPointF &p, dms *LST, const dms *lat, bool onlyAltAz = false) const override;
         QVector<Eigen::Vector2f> groundPoly(SkyPoint *labelpoint = nullptr, bool *drawLabel = nullptr) const override;
         void updateClipPoly() override;
+
+    protected:
+        void projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                           bool *visible, bool oRefract) const override;
+        void projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                            ProjectedPoints &out) const override;
 };
 
 #endif // EQUIRECTANGULARPROJECTOR_H
@@ -36,3 +36,22 @@ double GnomonicProjector::cosMaxFieldAngle() const
     //Don't let things approach infty.
     return 0.02;
 }
+
+void GnomonicProjector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                                    bool *visible, bool oRefract) const
+{
+    Q_UNUSED(oRefract);
+    projectAnglesWith([this](double c)
+    {
+        return GnomonicProjector::projectionK(c);
+    }, dX, Y, count, screen, visible);
+}
+
+void GnomonicProjector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                                     ProjectedPoints &out) const
+{
+    projectVectorsWith([this](double c)
+    {
+        return GnomonicProjector::projectionK(c);
+    }, u, v, w, source, count, out);
+}
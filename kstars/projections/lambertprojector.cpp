@@ -30,3 +30,22 @@ double LambertProjector::projectionL(double x) const
 {
     return 2.0 * asin(0.5 * x);
 }
+
+void LambertProjector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                                   bool *visible, bool oRefract) const
+{
+    Q_UNUSED(oRefract);
+    projectAnglesWith([this](double c)
+    {
+        return LambertProjector::projectionK(c);
+    }, dX, Y, count, screen, visible);
+}
+
+void LambertProjector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                                    ProjectedPoints &out) const
+{
+    projectVectorsWith([this](double c)
+    {
+        return LambertProjector::projectionK(c);
+    }, u, v, w, source, count, out);
+}
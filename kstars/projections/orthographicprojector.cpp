@@ -31,3 +31,22 @@ double OrthographicProjector::projectionL(double x) const
 {
     return asin(x);
 }
+
+void OrthographicProjector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                                        bool *visible, bool oRefract) const
+{
+    Q_UNUSED(oRefract);
+    projectAnglesWith([this](double c)
+    {
+        return OrthographicProjector::projectionK(c);
+    }, dX, Y, count, screen, visible);
+}
+
+void OrthographicProjector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                                         ProjectedPoints &out) const
+{
+    projectVectorsWith([this](double c)
+    {
+        return OrthographicProjector::projectionK(c);
+    }, u, v, w, source, count, out);
+}
@@ -23,6 +23,12 @@ class OrthographicProjector : public Projector
     double radius() const override;
     double projectionK(double x) const override;
     double projectionL(double x) const override;
+
+  protected:
+    void projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                       bool *visible, bool oRefract) const override;
+    void projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                        ProjectedPoints &out) const override;
 };
 
 #endif // ORTHOGRAPHICPROJECTOR_H
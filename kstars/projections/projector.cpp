@@ -6,14 +6,40 @@
 
 #include "projector.h"
 
+#include "ksnumbers.h"
+#include "kstarsdata.h"
 #include "ksutils.h"
 #ifdef KSTARS_LITE
 #include "skymaplite.h"
 #endif
 #include "skycomponents/skylabeler.h"
 
+#include <vector>
+
 namespace
 {
+/** Matrix rotating vectors by @p angle radians about the X axis */
+Eigen::Matrix3d rotationX(double angle)
+{
+    const double c = cos(angle), s = sin(angle);
+    Eigen::Matrix3d m;
+    m << 1, 0, 0,
+      0, c, -s,
+      0, s, c;
+    return m;
+}
+
+/** Matrix rotating vectors by @p angle radians about the Z axis */
+Eigen::Matrix3d rotationZ(double angle)
+{
+    const double c = cos(angle), s = sin(angle);
+    Eigen::Matrix3d m;
+    m << c, -s, 0,
+      s, c, 0,
+      0, 0, 1;
+    return m;
+}
+
 void toXYZ(const SkyPoint *p, double *x, double *y, double *z)
 {
     double sinRa, sinDec, cosRa, cosDec;
@@ -95,6 +121,220 @@ QPointF Projector::toScreen(const SkyPoint *o, bool oRefract, bool *onVisibleHem
     return KSUtils::vecToPoint(toScreenVec(o, oRefract, onVisibleHemisphere));
 }
 
+CatalogTransform Projector::catalogTransform(const KSNumbers *num) const
+{
+    CatalogTransform transform;
+
+    // Nutation as a rotation about the ecliptic pole by delta psi, and about the equinox by
+    // delta epsilon. This agrees with the first-order expressions in SkyPoint::nutate().
+    const double obliquity = num->obliquity()->radians();
+    const Eigen::Matrix3d nutation = rotationX(obliquity + num->dObliq() * dms::DegToRad) *
+                                     rotationZ(num->dEcLong() * dms::DegToRad) * rotationX(-obliquity);
+
+    Eigen::Matrix3d rotation = nutation * num->p2();
+
+    // Aberration as an offset along the Earth's velocity, equivalent to the expressions in
+    // SkyPoint::aberrate() (Meeus 23.3) to first order.
+    double sinL, cosL, sinP, cosP, sinOb, cosOb;
+    num->sunTrueLongitude().SinCos(sinL, cosL);
+    num->earthPerihelionLongitude().SinCos(sinP, cosP);
+    num->obliquity()->SinCos(sinOb, cosOb);
+    const double K = num->constAberr().radians();
+    const double e = num->earthEccentricity();
+    Eigen::Vector3d aberration(K * (sinL - e * sinP), -K * (cosL - e * cosP) * cosOb, -K * (cosL - e * cosP) * sinOb);
+
+    // Equatorial of date to (north, west, zenith)
+    double sinLST, cosLST, sinLat, cosLat;
+    m_data->lst()->SinCos(sinLST, cosLST);
+    m_data->geo()->lat()->SinCos(sinLat, cosLat);
+    Eigen::Matrix3d horizontal;
+    horizontal << -sinLat * cosLST, -sinLat * sinLST, cosLat,
+               sinLST, -cosLST, 0,
+               cosLat * cosLST, cosLat * sinLST, sinLat;
+
+    if (m_vp.useAltAz)
+    {
+        rotation    = horizontal * rotation;
+        aberration  = horizontal * aberration;
+    }
+    else
+        transform.up = horizontal.row(2).transpose().cast<float>();
+
+    transform.rotation       = rotation.cast<float>();
+    transform.aberration     = aberration.cast<float>();
+    transform.julianMillenia = num->julianMillenia();
+    return transform;
+}
+
+int Projector::projectCatalog(const CatalogTransform &transform, const CatalogVectors &points, ProjectedPoints &out) const
+{
+    const int count = points.count;
+    out.count       = 0;
+    if (count <= 0)
+        return 0;
+
+    if (out.u.size() < count)
+    {
+        out.u.resize(count);
+        out.v.resize(count);
+        out.w.resize(count);
+        out.source.resize(count);
+    }
+    if (out.x.size() < count)
+    {
+        out.x.resize(count);
+        out.y.resize(count);
+        out.index.resize(count);
+    }
+
+    float *u = out.u.data(), *v = out.v.data(), *w = out.w.data();
+    const Eigen::Matrix3f &m = transform.rotation;
+    const Eigen::Vector3f &b = transform.aberration;
+    const float t = transform.julianMillenia;
+
+    // Pass 1: proper motion, rotation to the frame of the view and aberration. This loop has
+    // no branches so that the compiler can vectorize it.
+    if (points.pmX && points.pmY && points.pmZ)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const float x = points.x[i] + t * points.pmX[i];
+            const float y = points.y[i] + t * points.pmY[i];
+            const float z = points.z[i] + t * points.pmZ[i];
+            u[i]          = m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + b[0];
+            v[i]          = m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + b[1];
+            w[i]          = m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + b[2];
+        }
+    }
+    else
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            const float x = points.x[i], y = points.y[i], z = points.z[i];
+            u[i]          = m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + b[0];
+            v[i]          = m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + b[1];
+            w[i]          = m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + b[2];
+        }
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        const float norm = 1.0f / std::sqrt(u[i] * u[i] + v[i] * v[i] + w[i] * w[i]);
+        u[i] *= norm;
+        v[i] *= norm;
+        w[i] *= norm;
+    }
+
+    // Pass 2: drop points below the ground, apply refraction and compact the survivors
+    int *source                = out.source.data();
+    int n                      = 0;
+    const bool refract         = m_vp.useAltAz && m_vp.useRefraction;
+    const float sinAltCrit     = sin(SkyPoint::altCrit * dms::DegToRad);
+    const Eigen::Vector3f &up  = transform.up;
+    for (int i = 0; i < count; ++i)
+    {
+        const float sinAlt = up[0] * u[i] + up[1] * v[i] + up[2] * w[i];
+        if (m_vp.fillGround && sinAlt <= sinAltCrit)
+            continue;
+
+        u[n]      = u[i];
+        v[n]      = v[i];
+        w[n]      = w[i];
+        source[n] = i;
+
+        if (refract)
+        {
+            // Refraction only changes the altitude, so rescale the horizontal components
+            const double alt  = asin(qBound(-1.0f, w[n], 1.0f)) / dms::DegToRad;
+            const double altR = SkyPoint::refract(alt) * dms::DegToRad;
+            const double cosAlt = sqrt(u[n] * u[n] + v[n] * v[n]);
+            if (cosAlt > 0)
+            {
+                const double scale = cos(altR) / cosAlt;
+                u[n] *= scale;
+                v[n] *= scale;
+            }
+            w[n] = sin(altR);
+        }
+        ++n;
+    }
+
+    // Pass 3: the projection itself
+    projectVectors(u, v, w, source, n, out);
+    return out.count;
+}
+
+double Projector::focusLongitude() const
+{
+    return m_vp.useAltAz ? -m_vp.focus->az().radians() : m_vp.focus->ra().radians();
+}
+
+void Projector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                               ProjectedPoints &out) const
+{
+    projectVectorsWith([this](double c)
+    {
+        return projectionK(c);
+    }, u, v, w, source, count, out);
+}
+
+void Projector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                              bool *visible, bool oRefract) const
+{
+    Q_UNUSED(oRefract);
+    projectAnglesWith([this](double c)
+    {
+        return projectionK(c);
+    }, dX, Y, count, screen, visible);
+}
+
+void Projector::toScreenVec(const SkyPoint *const *points, int count, Eigen::Vector2f *screen,
+                            bool *onVisibleHemisphere, bool oRefract) const
+{
+    // Reused between calls; each thread painting a sky map gets its own
+    thread_local std::vector<double> dX, Y;
+    dX.resize(count);
+    Y.resize(count);
+
+    oRefract &= m_vp.useRefraction;
+    if (m_vp.useAltAz)
+    {
+        const double az0 = m_vp.focus->az().radians();
+        for (int i = 0; i < count; ++i)
+        {
+            dX[i] = az0 - points[i]->az().radians();
+            Y[i]  = points[i]->alt().radians();
+        }
+        //account for atmospheric refraction
+        if (oRefract)
+        {
+            for (int i = 0; i < count; ++i)
+                Y[i] = SkyPoint::refract(Y[i] / dms::DegToRad) * dms::DegToRad;
+        }
+    }
+    else
+    {
+        const double ra0 = m_vp.focus->ra().radians();
+        for (int i = 0; i < count; ++i)
+        {
+            dX[i] = points[i]->ra().radians() - ra0;
+            Y[i]  = points[i]->dec().radians();
+        }
+    }
+
+    projectAngles(dX.data(), Y.data(), count, screen, onVisibleHemisphere, oRefract);
+
+    // Same as toScreenVec() for points with invalid coordinates
+    for (int i = 0; i < count; ++i)
+    {
+        if (!(std::isfinite(Y[i]) && std::isfinite(dX[i])))
+        {
+            screen[i] = Eigen::Vector2f(0, 0);
+            if (onVisibleHemisphere)
+                onVisibleHemisphere[i] = false;
+        }
+    }
+}
+
 bool Projector::onScreen(const QPointF &p) const
 {
     return (0 <= p.x() && p.x() <= m_vp.width && 0 <= p.y() && p.y() <= m_vp.height);
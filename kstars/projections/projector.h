@@ -12,6 +12,7 @@
 #include "skymap.h"
 #endif
 #include "skyobjects/skypoint.h"
+#include "batchprojection.h"
 
 #if __GNUC__ > 5
 #pragma GCC diagnostic push
@@ -31,6 +32,7 @@
 #include <cmath>
 
 class KStarsData;
+class KSNumbers;
 
 /** This is just a container that holds information needed to do projections. */
 class ViewParams
@@ -133,6 +135,53 @@ class Projector
          */
         QPointF toScreen(const SkyPoint *o, bool oRefract = true, bool *onVisibleHemisphere = nullptr) const;
 
+        /**
+         * @short Project a batch of SkyPoints to screen coordinates.
+         *
+         * This gives the same results as calling toScreenVec() on every point, but the
+         * coordinates are first gathered into packed arrays (with refraction applied in a
+         * separate pass) and projected by a single call to projectAngles(), whose loop is
+         * specialized for each projection.
+         *
+         * @param points the points to project
+         * @param count the number of points
+         * @param screen receives the screen pixel coordinates of each point; must have room
+         *   for @p count entries
+         * @param onVisibleHemisphere if not nullptr, receives for each point whether it is on
+         *   the visible part of the Celestial Sphere; must have room for @p count entries
+         * @param oRefract see toScreenVec()
+         */
+        void toScreenVec(const SkyPoint *const *points, int count, Eigen::Vector2f *screen,
+                         bool *onVisibleHemisphere = nullptr, bool oRefract = true) const;
+
+        /**
+         * @short Compute the transformation of J2000.0 catalog vectors to the frame of the view.
+         *
+         * Precession, nutation and, when using Alt/Az, the conversion to horizontal coordinates
+         * are combined into a single rotation; aberration becomes a constant offset. This is
+         * meant to be computed once per frame and passed to projectCatalog().
+         *
+         * @param num the KSNumbers for the current time
+         * @note Relativistic light bending is not included.
+         */
+        CatalogTransform catalogTransform(const KSNumbers *num) const;
+
+        /**
+         * @short Project a batch of catalog points to screen coordinates.
+         *
+         * This is the batch counterpart of calling SkyPoint::updateCoords(),
+         * SkyPoint::EquatorialToHorizontal() and toScreen() on every point. The per-point work
+         * is a matrix-vector product over packed arrays followed by the projection itself.
+         * Points below the ground (if it is filled), on the back side of the projection, or
+         * off-screen are culled.
+         *
+         * @param transform transformation from catalogTransform()
+         * @param points J2000.0 unit vectors and proper motions of the points
+         * @param out receives the screen positions of the points that were not culled
+         * @return the number of points that were not culled
+         */
+        int projectCatalog(const CatalogTransform &transform, const CatalogVectors &points, ProjectedPoints &out) const;
+
         /**
          * @short Determine RA, Dec coordinates of the pixel at (dx, dy), which are the
          * screen pixel coordinate offsets from the center of the Sky pixmap.
@@ -260,6 +309,108 @@ class Projector
         virtual QPolygonF clipPoly() const;
 
     protected:
+        /**
+         * @short Project packed coordinates to the screen.
+         *
+         * This is the core of the batch toScreenVec(). The default implementation uses
+         * projectionK() and cosMaxFieldAngle(), like toScreenVec() does.
+         *
+         * @param dX offset in longitude of each point from the focus, in radians. This is
+         *   RA - RA0, or Az0 - Az when using Alt/Az.
+         * @param Y latitude of each point in radians, i.e. Dec or (refracted) Alt
+         * @param count number of points
+         * @param screen receives the screen pixel coordinates of each point
+         * @param visible if not nullptr, receives whether each point is on the visible hemisphere
+         * @param oRefract whether refraction was applied to @p Y
+         */
+        virtual void projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                                   bool *visible, bool oRefract) const;
+
+        /**
+         * @short Project unit vectors given in the frame of the view to the screen.
+         *
+         * The frame of the view is equatorial of date, or (north, west, zenith) when using Alt/Az.
+         * Refraction, if any, must already have been applied to the vectors. Points on the
+         * visible hemisphere that land on screen are appended to @p out.
+         *
+         * @param u, v, w components of the unit vectors
+         * @param source index of each vector in the caller's input, stored in ProjectedPoints::index
+         * @param count number of vectors
+         * @param out output buffer
+         */
+        virtual void projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                                    ProjectedPoints &out) const;
+
+        /**
+         * @short Implementation of projectAngles() for azimuthal projections.
+         *
+         * Subclasses pass their projection function as @p projectionK, e.g. a lambda that makes a
+         * qualified, non-virtual call, so that it can be inlined into the loop.
+         */
+        template <typename ProjectionK>
+        void projectAnglesWith(ProjectionK projectionK, const double *dX, const double *Y, int count,
+                               Eigen::Vector2f *screen, bool *visible) const
+        {
+            const double cosMax = cosMaxFieldAngle();
+            for (int i = 0; i < count; ++i)
+            {
+                const double sindX = sin(dX[i]), cosdX = cos(dX[i]);
+                const double sinY = sin(Y[i]), cosY = cos(Y[i]);
+
+                const double c = m_sinY0 * sinY + m_cosY0 * cosY * cosdX;
+                const double k = projectionK(c);
+                screen[i] = rst(k * cosY * sindX, k * (m_cosY0 * sinY - m_sinY0 * cosY * cosdX));
+                if (visible)
+                    visible[i] = c > cosMax;
+            }
+        }
+
+        /**
+         * @short Implementation of projectVectors() for azimuthal projections.
+         * @see projectAnglesWith()
+         */
+        template <typename ProjectionK>
+        void projectVectorsWith(ProjectionK projectionK, const float *u, const float *v, const float *w,
+                                const int *source, int count, ProjectedPoints &out) const
+        {
+            const double lon0    = focusLongitude();
+            const double sinLon0 = sin(lon0), cosLon0 = cos(lon0);
+
+            const double cosMax = cosMaxFieldAngle();
+            float *x = out.x.data(), *y = out.y.data();
+            int *index = out.index.data();
+            int n = out.count;
+
+            for (int i = 0; i < count; ++i)
+            {
+                // Same as toScreenVec(), with cos(Y) cos(dX) and cos(Y) sin(dX) taken directly from the vector
+                const double sinY      = w[i];
+                const double cosYcosdX = cosLon0 * u[i] + sinLon0 * v[i];
+                const double cosYsindX = cosLon0 * v[i] - sinLon0 * u[i];
+
+                const double c = m_sinY0 * sinY + m_cosY0 * cosYcosdX;
+                if (c <= cosMax)
+                    continue;
+
+                const double k = projectionK(c);
+                Eigen::Vector2f p = rst(k * cosYsindX, k * (m_cosY0 * sinY - m_sinY0 * cosYcosdX));
+                if (!onScreen(p))
+                    continue;
+
+                x[n]     = p.x();
+                y[n]     = p.y();
+                index[n] = source[i];
+                ++n;
+            }
+            out.count = n;
+        }
+
+        /**
+         * @return the longitude of the focus in the frame of the view, in radians. This is the RA
+         * of the focus, or minus its azimuth when using Alt/Az.
+         */
+        double focusLongitude() const;
+
         /**
          * Get the radius of this projection's sky circle.
          * @return the radius in radians
@@ -30,3 +30,22 @@ double StereographicProjector::projectionL(double x) const
 {
     return 2.0 * atan2(x, 2.0);
 }
+
+void StereographicProjector::projectAngles(const double *dX, const double *Y, int count, Eigen::Vector2f *screen,
+                                         bool *visible, bool oRefract) const
+{
+    Q_UNUSED(oRefract);
+    projectAnglesWith([this](double c)
+    {
+        return StereographicProjector::projectionK(c);
+    }, dX, Y, count, screen, visible);
+}
+
+void StereographicProjector::projectVectors(const float *u, const float *v, const float *w, const int *source, int count,
+                                          ProjectedPoints &out) const
+{
+    projectVectorsWith([this](double c)
+    {
+        return StereographicProjector::projectionK(c);
+    }, u, v, w, source, count, out);
+}
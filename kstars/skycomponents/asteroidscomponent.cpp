@@ -12,6 +12,7 @@
 #endif
 #include "ksfilereader.h"
 #include "kstarsdata.h"
+#include "nearestsearch.h"
 #include "kstars_debug.h"
 #include "Options.h"
 #include "solarsystemcomposite.h"
@@ -230,25 +231,22 @@ void AsteroidsComponent::draw(SkyPainter *skyp)
 
 SkyObject *AsteroidsComponent::objectNearest(SkyPoint *p, double &maxrad)
 {
-    SkyObject *oBest = nullptr;
-
     if (!selected())
         return nullptr;
 
+    NearestObjects<SkyObject> nearest(*p, maxrad);
+
     for (auto o : m_ObjectList)
     {
         if (!((dynamic_cast<KSAsteroid*>(o)->toDraw())))
             continue;
 
-        double r = o->angularDistanceTo(p).Degrees();
-        if (r < maxrad)
-        {
-            oBest  = o;
-            maxrad = r;
-        }
+        nearest.add(o);
     }
 
-    return oBest;
+    if (nearest.nearest())
+        maxrad = nearest.distance(0);
+    return nearest.nearest();
 }
 
 void AsteroidsComponent::updateDataFile(bool isAutoUpdate)
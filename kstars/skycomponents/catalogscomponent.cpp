@@ -11,6 +11,8 @@
 #include "kstarsdata.h"
 #include "Options.h"
 #include "MeshIterator.h"
+#include "nearestsearch.h"
+#include "skyquery.h"
 #include "projections/projector.h"
 #include "skylabeler.h"
 #include "kstars_debug.h"
@@ -19,6 +21,7 @@
 #include "kspaths.h"
 #include "import_skycomp.h"
 
+#include <QCoreApplication>
 #include <QtConcurrent>
 
 #include <cmath>
@@ -46,6 +49,18 @@ CatalogsComponent::CatalogsComponent(SkyComposite *parent, const QString &db_fil
     }
 
     m_catalog_colors = m_db_manager.get_catalog_colors();
+    m_snapshot       = m_db_manager.open_master_snapshot();
+
+    m_prefetcher = std::make_unique<CatalogsDB::AsyncDBManager>(db_filename);
+
+    // Redraw once the trixels skipped while the view moved are loaded
+    QObject::connect(m_prefetcher.get(), &CatalogsDB::AsyncDBManager::trixelsReady,
+                     QCoreApplication::instance(), []()
+    {
+        if (SkyMap::Instance())
+            SkyMap::Instance()->forceUpdate();
+    });
+
     tryImportSkyComponents();
     qCInfo(KSTARS) << "Loaded DSO catalogs.";
 }
@@ -91,7 +106,30 @@ void CatalogsComponent::draw(SkyPainter *skyp)
     const auto label_padding{ 1 + (1 - (Options::deepSkyLabelDensity() / 100)) * 50 };
     auto &proj = *map.projector();
 
+    // The view moves if the map slews or its focus changed since the
+    // last frame, e.g. while tracking a slewing telescope
+    const SkyPoint *focus = map.focus();
+    std::pair<double, double> motion{ 0, 0 };
+    if (m_hasLastFocus)
+    {
+        double dra = focus->ra().Degrees() - m_lastFocus.ra().Degrees();
+        if (dra > 180.)
+            dra -= 360.;
+        else if (dra < -180.)
+            dra += 360.;
+
+        motion = { dra, focus->dec().Degrees() - m_lastFocus.dec().Degrees() };
+    }
+
+    m_lastFocus       = *focus;
+    m_hasLastFocus    = true;
+    const bool moving = map.isSlewing() || motion.first != 0 || motion.second != 0;
+
     updateSkyMesh(map);
+    takePrefetchedTrixels();
+
+    // Visible trixels that were not loaded yet while moving
+    std::vector<int> missing;
 
     size_t num_trixels{ 0 };
     const auto zoomFactor = Options::zoomFactor();
@@ -129,17 +167,26 @@ void CatalogsComponent::draw(SkyPainter *skyp)
     // galaxies of unknown magnitude, and many of them also of unknown
     // size, remains smooth.
 
-    // Helper lambda to fill the appropriate cache for a given trixel
-    auto fillCache = [&](
+    // Helper lambda to fill the appropriate cache for a given trixel,
+    // returns false if the trixel is left to the prefetcher
+    auto fillDrawCache = [&](
         TrixelCache<ObjectList>::element& cacheElement,
         ObjectList (CatalogsDB::DBManager::*fillFunction)(const int),
+        ObjectList (CatalogsDB::MasterSnapshot::*snapshotFunction)(const int) const,
         Trixel trixel
-        ) -> void {
+        ) -> bool {
         if (!cacheElement.is_set())
         {
+            // Don't block a moving view, the trixel is drawn once loaded
+            if (moving && m_prefetcher)
+            {
+                missing.push_back(trixel);
+                return false;
+            }
+
             try
             {
-                cacheElement = (m_db_manager.*fillFunction)(trixel);
+                fillCache(cacheElement, fillFunction, snapshotFunction, trixel);
             }
             catch (const CatalogsDB::DatabaseError &e)
             {
@@ -154,6 +201,8 @@ void CatalogsComponent::draw(SkyPainter *skyp)
                 throw; // do not silently fail
             }
         }
+
+        return true;
     };
 
     // Helper lambda to JIT update and draw
@@ -198,7 +247,10 @@ void CatalogsComponent::draw(SkyPainter *skyp)
 
         // Fill the cache for this trixel
         auto &objectsKnownMag = m_mainCache[trixel];
-        fillCache(objectsKnownMag, &CatalogsDB::DBManager::get_objects_in_trixel_no_nulls, trixel);
+        if (!fillDrawCache(objectsKnownMag, &CatalogsDB::DBManager::get_objects_in_trixel_no_nulls,
+                           &CatalogsDB::MasterSnapshot::objects_in_trixel_no_nulls, trixel))
+            continue;
+
         drawListKnownMag.clear();
 
         // Filter based on magnitude and size
@@ -243,7 +295,9 @@ void CatalogsComponent::draw(SkyPainter *skyp)
 
             // Fill cache
             auto &objectsUnknownMag = m_unknownMagCache[trixel];
-            fillCache(objectsUnknownMag, &CatalogsDB::DBManager::get_objects_in_trixel_null_mag, trixel);
+            if (!fillDrawCache(objectsUnknownMag, &CatalogsDB::DBManager::get_objects_in_trixel_null_mag,
+                               &CatalogsDB::MasterSnapshot::objects_in_trixel_null_mag, trixel))
+                continue;
 
             // Filter
             QtConcurrent::blockingMap(
@@ -282,6 +336,8 @@ void CatalogsComponent::draw(SkyPainter *skyp)
     // and we are not zooming
     m_mainCache.prune(num_trixels * 1.2);
     m_unknownMagCache.prune(num_trixels * 1.2);
+
+    prefetchTrixels(map, missing, motion);
 };
 
 void CatalogsComponent::updateSkyMesh(SkyMap &map, MeshBufNum_t buf)
@@ -294,6 +350,102 @@ void CatalogsComponent::updateSkyMesh(SkyMap &map, MeshBufNum_t buf)
     m_skyMesh->aperture(focus, radius + 1.0, buf);
 }
 
+void CatalogsComponent::fillCache(
+    TrixelCache<ObjectList>::element &cacheElement,
+    ObjectList (CatalogsDB::DBManager::*fillFunction)(const int),
+    ObjectList (CatalogsDB::MasterSnapshot::*snapshotFunction)(const int) const,
+    Trixel trixel)
+{
+    if (cacheElement.is_set())
+        return;
+
+    // The snapshot serves the same objects without a query
+    if (m_snapshot)
+    {
+        cacheElement = ((*m_snapshot).*snapshotFunction)(trixel);
+        return;
+    }
+
+    cacheElement = (m_db_manager.*fillFunction)(trixel);
+}
+
+void CatalogsComponent::takePrefetchedTrixels()
+{
+    if (!m_prefetcher)
+        return;
+
+    for (auto &objects : m_prefetcher->take_trixels())
+    {
+        auto &known = m_mainCache[objects.trixel];
+        if (!known.is_set())
+            known = std::move(objects.known_mag);
+
+        auto &unknown = m_unknownMagCache[objects.trixel];
+        if (!unknown.is_set())
+            unknown = std::move(objects.null_mag);
+    }
+}
+
+void CatalogsComponent::prefetchTrixels(SkyMap &map, const std::vector<int> &missing,
+                                        const std::pair<double, double> &motion)
+{
+    if (!m_prefetcher)
+        return;
+
+    // Fetching more than the caches hold would only evict what is drawn
+    const std::size_t limit = std::min(m_mainCache.size(), m_unknownMagCache.size());
+
+    // A trixel missing from both caches is reported twice
+    std::vector<bool> queued(m_skyMesh->size(), false);
+    std::vector<int> urgent;
+    for (const int trixel : missing)
+    {
+        if (!queued[trixel])
+            urgent.push_back(trixel);
+
+        queued[trixel] = true;
+    }
+
+    std::vector<int> ahead;
+    auto queueRegion = [&](SkyPoint *center, double radius)
+    {
+        m_skyMesh->aperture(center, radius, PREFETCH_BUF);
+
+        MeshIterator region(m_skyMesh, PREFETCH_BUF);
+        while (region.hasNext() && urgent.size() + ahead.size() < limit)
+        {
+            const Trixel trixel = region.next();
+            if (queued[trixel] ||
+                (m_mainCache.is_set(trixel) && m_unknownMagCache.is_set(trixel)))
+                continue;
+
+            queued[trixel] = true;
+            ahead.push_back(trixel);
+        }
+    };
+
+    SkyPoint *focus = map.focus();
+    const double radius = std::min(180.0, double(map.projector()->fov()));
+
+    // The sky the view moves into first, one view radius ahead
+    const double cosDec = std::cos(focus->dec().radians());
+    const double speed  = std::hypot(motion.first * cosDec, motion.second);
+    if (speed > 0)
+    {
+        const double dec = std::max(-90.0, std::min(90.0, focus->dec().Degrees() +
+                                                          motion.second * radius / speed));
+        SkyPoint lead(dms(focus->ra().Degrees() + motion.first * radius / speed).reduce(),
+                      dms(dec));
+        queueRegion(&lead, radius + 1.0);
+    }
+
+    // Then a ring around the view
+    queueRegion(focus, 1.5 * radius + 1.0);
+
+    if (!urgent.empty() || !ahead.empty())
+        m_prefetcher->prefetch_trixels(urgent, ahead, m_snapshot);
+}
+
 CatalogObject &CatalogsComponent::insertStaticObject(const CatalogObject &obj)
 {
     auto trixel     = m_skyMesh->index(&obj);
@@ -368,6 +520,52 @@ void CatalogsComponent::objectsInArea(QList<SkyObject *> &list, const SkyRegion
     }
 }
 
+void CatalogsComponent::objectsInRegion(const SkyQueryRegion &region, float maglim,
+                                        SkyQueryResults &results)
+{
+    const SkyPoint &center = region.boundingCenter();
+    m_skyMesh->intersect(center.ra0().Degrees(), center.dec0().Degrees(),
+                         region.boundingRadius(), static_cast<BufNum>(OBJ_NEAREST_BUF));
+
+    MeshIterator trixels(m_skyMesh, OBJ_NEAREST_BUF);
+    while (trixels.hasNext())
+    {
+        Trixel trixel = trixels.next();
+
+        auto &objectsKnownMag   = m_mainCache[trixel];
+        auto &objectsUnknownMag = m_unknownMagCache[trixel];
+        try
+        {
+            fillCache(objectsKnownMag, &CatalogsDB::DBManager::get_objects_in_trixel_no_nulls,
+                      &CatalogsDB::MasterSnapshot::objects_in_trixel_no_nulls, trixel);
+            fillCache(objectsUnknownMag, &CatalogsDB::DBManager::get_objects_in_trixel_null_mag,
+                      &CatalogsDB::MasterSnapshot::objects_in_trixel_null_mag, trixel);
+        }
+        catch (const CatalogsDB::DatabaseError &e)
+        {
+            // A query reports no objects from the trixel rather than interrupting the user
+            qCWarning(KSTARS) << "Could not load catalog objects in trixel: " << trixel
+                              << ", " << e.what();
+            continue;
+        }
+
+        for (const auto &object : objectsKnownMag.data())
+        {
+            if (object.mag() > maglim)
+                break; // sorted by magnitude
+
+            if (region.contains(object))
+                results.addCatalogObject(object);
+        }
+
+        for (const auto &object : objectsUnknownMag.data())
+        {
+            if (region.contains(object))
+                results.addCatalogObject(object);
+        }
+    }
+}
+
 SkyObject *CatalogsComponent::objectNearest(SkyPoint *p, double &maxrad)
 {
     if (!selected())
@@ -375,7 +573,8 @@ SkyObject *CatalogsComponent::objectNearest(SkyPoint *p, double &maxrad)
 
     m_skyMesh->aperture(p, maxrad, OBJ_NEAREST_BUF);
     MeshIterator region(m_skyMesh, OBJ_NEAREST_BUF);
-    double smallest_r{ 360 };
+    const SkyVector center(*p);
+    double largest_cos{ -2 };
     CatalogObject nearest{};
     bool found{ false };
 
@@ -392,11 +591,11 @@ SkyObject *CatalogsComponent::objectNearest(SkyPoint *p, double &maxrad)
             {
                 obj.JITupdate();
 
-                double r = obj.angularDistanceTo(p).Degrees();
-                if (r < smallest_r)
+                const double cos_r = center.dot(SkyVector(obj));
+                if (cos_r > largest_cos)
                 {
-                    smallest_r = r;
-                    nearest    = obj;
+                    largest_cos = cos_r;
+                    nearest     = obj;
                 }
             }
         }
@@ -412,7 +611,7 @@ SkyObject *CatalogsComponent::objectNearest(SkyPoint *p, double &maxrad)
     if (!found)
         return nullptr;
 
-    maxrad = smallest_r;
+    maxrad = center.angularDistance(SkyVector(nearest));
 
     return &insertStaticObject(nearest);
 }
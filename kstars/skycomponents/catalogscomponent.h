@@ -19,6 +19,8 @@
 
 class SkyMesh;
 class SkyMap;
+class SkyQueryRegion;
+class SkyQueryResults;
 
 /**
  * \brief Represents objects loaded from an sqlite backed, trixel
@@ -60,6 +62,11 @@ class CatalogsComponent : public SkyComponent
         /**
          * Draws the objects in the currently visible trixels by
          * dynamically loading them from the database.
+         *
+         * The trixels around the view and in the direction it moves to
+         * are loaded in the background. While the view moves, visible
+         * trixels which are not loaded yet are skipped for a frame
+         * instead of blocking the drawing.
          */
         void draw(SkyPainter *skyp) override;
 
@@ -92,6 +99,19 @@ class CatalogsComponent : public SkyComponent
 
         void objectsInArea(QList<SkyObject *> &list, const SkyRegion &region) override;
 
+        /**
+         * Add to the \p results the objects in \p region which are
+         * brighter than \p maglim or of unknown magnitude.
+         *
+         * Unlike `objectsInArea`, this neither allocates the objects
+         * into `m_static_objects` nor registers them, the trixels are
+         * read from the caches, or loaded into them.
+         *
+         * \sa SkyMapComposite::objectsInRegion
+         */
+        void objectsInRegion(const SkyQueryRegion &region, float maglim,
+                             SkyQueryResults &results);
+
         SkyObject *objectNearest(SkyPoint *p, double &maxrad) override;
 
         /**
@@ -113,6 +133,15 @@ class CatalogsComponent : public SkyComponent
             m_mainCache.clear();
             m_unknownMagCache.clear();
             m_catalog_colors = m_db_manager.get_catalog_colors();
+
+            // Unmap the old snapshot first, it may have to be rewritten. The
+            // prefetcher releases its references once the trixel it may be
+            // slicing is done.
+            if (m_prefetcher)
+                m_prefetcher->clear_trixels();
+            m_snapshot.reset();
+
+            m_snapshot = m_db_manager.open_master_snapshot();
         };
 
         /**
@@ -129,6 +158,25 @@ class CatalogsComponent : public SkyComponent
          */
         CatalogsDB::DBManager m_db_manager;
 
+        /**
+         * The memory mapped snapshot of the master catalog the caches
+         * are filled from, if available. Otherwise the objects are
+         * queried from `m_db_manager`.
+         */
+        std::shared_ptr<const CatalogsDB::MasterSnapshot> m_snapshot;
+
+        /**
+         * Loads the trixels around the view in the background.
+         */
+        std::unique_ptr<CatalogsDB::AsyncDBManager> m_prefetcher;
+
+        /**
+         * The focus of the previous frame, to tell if and where the
+         * view moves.
+         */
+        SkyPoint m_lastFocus;
+        bool m_hasLastFocus { false };
+
         /**
          * A pointer to a SkyMesh of the appropriate level.
          *
@@ -181,6 +229,31 @@ class CatalogsComponent : public SkyComponent
         /** Helpers */
 
         void updateSkyMesh(SkyMap &map, MeshBufNum_t buf = DRAW_BUF);
+
+        /**
+         * Load the objects in \p trixel into \p cacheElement unless it
+         * is set already, slicing them from the snapshot if there is one
+         * and querying them with \p fillFunction otherwise.
+         *
+         * \throws CatalogsDB::DatabaseError if the query fails.
+         */
+        void fillCache(TrixelCache<ObjectList>::element &cacheElement,
+                       ObjectList (CatalogsDB::DBManager::*fillFunction)(const int),
+                       ObjectList (CatalogsDB::MasterSnapshot::*snapshotFunction)(const int) const,
+                       Trixel trixel);
+
+        /**
+         * Move the trixels loaded in the background into the caches.
+         */
+        void takePrefetchedTrixels();
+
+        /**
+         * Queue the \p missing visible trixels, the trixels ahead of the
+         * view moving by \p motion degrees per frame and a ring around
+         * the view for loading in the background.
+         */
+        void prefetchTrixels(SkyMap &map, const std::vector<int> &missing,
+                             const std::pair<double, double> &motion);
         size_t calculateCacheSize(const unsigned int percentage)
         {
             return m_skyMesh->size() * percentage / 100.f;
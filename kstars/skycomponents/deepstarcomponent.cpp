@@ -8,6 +8,8 @@
 
 #include "byteorder.h"
 #include "kstarsdata.h"
+#include "nearestsearch.h"
+#include "skyquery.h"
 #include "Options.h"
 #ifndef KSTARS_LITE
 #include "skymap.h"
@@ -23,6 +25,8 @@
 #include <QtConcurrent>
 #include <QElapsedTimer>
 
+#include <cstring>
+
 #include <kstars_debug.h>
 
 #ifdef _WIN32
@@ -96,6 +100,16 @@ bool DeepStarComponent::loadStaticStars()
     if (htm_level != m_skyMesh->level())
         qCWarning(KSTARS) << "HTM Level in shallow star data file and HTM Level in m_skyMesh do not match. EXPECT TROUBLE!";
 
+    // If the file is mapped, read all records straight from the mapping instead of one fread() per star
+    const uchar *record = nullptr;
+    if (starReader.isMapped())
+    {
+        quint64 dataStart = QT_FTELL(dataFile);
+        record = starReader.mappedRange(dataStart, quint64(starReader.getRecordCount()) * recordSize);
+        if (!record)
+            qCWarning(KSTARS) << "Mapped catalog file " << dataFileName << " is truncated, falling back to buffered reads";
+    }
+
     // JM 2012-12-05: Breaking into 2 loops instead of one previously with multiple IF checks for recordSize
     // While the CPU branch prediction might not suffer any penalties since the branch prediction after a few times
     // should always gets it right. It's better to do it this way to avoid any chances since the compiler might not optimize it.
@@ -115,7 +129,14 @@ bool DeepStarComponent::loadStaticStars()
 
             for (quint64 j = 0; j < records; ++j)
             {
-                bool fread_success = fread(&stardata, sizeof(StarData), 1, dataFile);
+                bool fread_success = true;
+                if (record)
+                {
+                    memcpy(&stardata, record, sizeof(StarData));
+                    record += sizeof(StarData);
+                }
+                else
+                    fread_success = fread(&stardata, sizeof(StarData), 1, dataFile);
 
                 if (!fread_success)
                 {
@@ -166,8 +187,14 @@ bool DeepStarComponent::loadStaticStars()
 
             for (quint64 j = 0; j < records; ++j)
             {
-                bool fread_success = false;
-                fread_success      = fread(&deepstardata, sizeof(DeepStarData), 1, dataFile);
+                bool fread_success = true;
+                if (record)
+                {
+                    memcpy(&deepstardata, record, sizeof(DeepStarData));
+                    record += sizeof(DeepStarData);
+                }
+                else
+                    fread_success = fread(&deepstardata, sizeof(DeepStarData), 1, dataFile);
 
                 if (!fread_success)
                 {
@@ -302,6 +329,13 @@ void DeepStarComponent::draw(SkyPainter *skyp)
 
     t.start();
 
+    // Stars are projected in batches straight from the packed copy in each StarBlock, unless
+    // relativistic corrections must be applied per star or the painter cannot take screen positions.
+    bool batchDraw = !Options::useRelativistic();
+    CatalogTransform transform;
+    if (batchDraw)
+        transform = map->projector()->catalogTransform(data->updateNum());
+
     // Mark used blocks in the LRU Cache. Not required for static stars
     if (!staticStars)
     {
@@ -357,6 +391,44 @@ void DeepStarComponent::draw(SkyPainter *skyp)
         //        qDebug() << Q_FUNC_INFO << "Drawing SBL for trixel " << currentRegion << ", SBL has "
         //                 <<  m_starBlockList[ currentRegion ]->getBlockCount() << " blocks";
 
+        if (batchDraw)
+        {
+            for (int i = 0; batchDraw && i < m_starBlockList.at(currentRegion)->getBlockCount(); ++i)
+            {
+                std::shared_ptr<StarBlock> block     = m_starBlockList.at(currentRegion)->block(i);
+                const StarBlock::PackedStars &packed = block->packed();
+
+                // Stars in a block are sorted by magnitude
+                int count = 0;
+                while (count < block->getStarCount() && packed.mag[count] <= maglim)
+                    ++count;
+
+                CatalogVectors vectors;
+                vectors.x     = packed.x.constData();
+                vectors.y     = packed.y.constData();
+                vectors.z     = packed.z.constData();
+                vectors.pmX   = packed.pmX.constData();
+                vectors.pmY   = packed.pmY.constData();
+                vectors.pmZ   = packed.pmZ.constData();
+                vectors.count = count;
+
+                map->projector()->projectCatalog(transform, vectors, m_ProjectedStars);
+                if (skyp->drawPointSources(m_ProjectedStars, packed.mag.constData(), packed.spType.constData()))
+                    visibleStarCount += m_ProjectedStars.count;
+                else
+                    batchDraw = false;
+
+                if (count < block->getStarCount())
+                    break;
+            }
+
+            if (batchDraw)
+            {
+                t_drawUnnamed += t.restart();
+                continue;
+            }
+        }
+
         // REMARK: The following should never carry state, except for const parameters like updateID and maglim
         std::function<void(std::shared_ptr<StarBlock>)> mapFunction = [&updateID, &maglim](std::shared_ptr<StarBlock> myBlock)
         {
@@ -461,6 +533,9 @@ bool DeepStarComponent::openDataFile()
         ret = fread(&MSpT, 2, 1, starReader.getFileHandle());
         if (starReader.getByteSwap())
             MSpT = bswap_16(MSpT);
+        // Trixel blocks are read straight from the mapped file when possible, buffered reads are kept as a fallback
+        if (!starReader.mapFile())
+            qCInfo(KSTARS) << "Could not memory-map " << dataFileName << ", using buffered reads.";
         fileOpened = true;
         qCInfo(KSTARS) << "  Sky Mesh Size: " << m_skyMesh->size();
         for (long int i = 0; i < m_skyMesh->size(); i++)
@@ -493,7 +568,7 @@ StarObject *DeepStarComponent::findByHDIndex(int HDnum)
 
 SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
 {
-    StarObject *oBest = nullptr;
+    NearestObjects<StarObject> nearest(*p, maxrad);
 
 #ifdef KSTARS_LITE
     m_zoomMagLimit = StarComponent::zoomMagnitudeLimit();
@@ -505,6 +580,9 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
 
     MeshIterator region(m_skyMesh, OBJ_NEAREST_BUF);
 
+    // Stars drawn in batches do not have their coordinates updated, so do it just in time here
+    UpdateID updateID = KStarsData::Instance()->updateID();
+
     while (region.hasNext())
     {
         Trixel currentRegion = region.next();
@@ -527,13 +605,10 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
                     continue;
                 if (star->mag() > m_zoomMagLimit)
                     continue;
+                if (star->updateID != updateID)
+                    star->JITupdate();
 
-                double r = star->angularDistanceTo(p).Degrees();
-                if (r < maxrad)
-                {
-                    oBest  = star;
-                    maxrad = r;
-                }
+                nearest.add(star);
             }
         }
     }
@@ -546,7 +621,10 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
     // candidates (eg: DeepSkyObject::objectNearest()) have been
     // called.
 
-    return oBest;
+    if (nearest.nearest())
+        maxrad = nearest.distance(0);
+
+    return nearest.nearest();
 }
 
 bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoint &center, float radius, float maglim)
@@ -570,6 +648,9 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
     if (maglim < -28)
         maglim = m_FaintMagnitude;
 
+    UpdateID updateID = KStarsData::Instance()->updateID();
+    const SkyCone cone(center, radius);
+
     while (region.hasNext())
     {
         Trixel currentRegion = region.next();
@@ -589,7 +670,9 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
 #endif
                 if (star->mag() > maglim)
                     break; // Stars are organized by magnitude, so this should work
-                if (star->angularDistanceTo(&center).Degrees() <= radius)
+                if (star->updateID != updateID)
+                    star->JITupdate();
+                if (cone.contains(*star))
                     list.append(star);
             }
         }
@@ -598,6 +681,47 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
     return true;
 }
 
+bool DeepStarComponent::objectsInRegion(const SkyQueryRegion &region, float maglim, SkyQueryResults &results)
+{
+    if (maglim < triggerMag || !fileOpened)
+        return false;
+
+    const SkyPoint &center = region.boundingCenter();
+    m_skyMesh->intersect(center.ra0().Degrees(), center.dec0().Degrees(), region.boundingRadius(),
+                         static_cast<BufNum>(OBJ_NEAREST_BUF));
+
+    MeshIterator trixels(m_skyMesh, OBJ_NEAREST_BUF);
+    while (trixels.hasNext())
+    {
+        Trixel currentRegion = trixels.next();
+        if ((int)currentRegion >= m_starBlockList.size())
+            continue;
+
+        std::shared_ptr<StarBlockList> sbl = m_starBlockList[currentRegion];
+        sbl->fillToMag(maglim);
+        for (int i = 0; i < sbl->getBlockCount(); ++i)
+        {
+            std::shared_ptr<StarBlock> block = sbl->block(i);
+            for (int j = 0; j < block->getStarCount(); ++j)
+            {
+#ifdef KSTARS_LITE
+                StarObject *star = &(block->star(j)->star);
+#else
+                StarObject *star = block->star(j);
+#endif
+                if (star->mag() > maglim)
+                    break; // Stars are organized by magnitude
+
+                // Only the catalog coordinates are needed, which do not need a JIT update
+                if (region.contains(*star))
+                    results.addStar(star, SkyQueryResults::DEEP_STARS);
+            }
+        }
+    }
+
+    return true;
+}
+
 void DeepStarComponent::byteSwap(DeepStarData *stardata)
 {
     stardata->RA   = bswap_32(stardata->RA);
@@ -19,11 +19,14 @@
 #include "ksnumbers.h"
 #include "listcomponent.h"
 #include "starblockfactory.h"
+#include "projections/batchprojection.h"
 #include "skyobjects/deepstardata.h"
 #include "skyobjects/stardata.h"
 
 class SkyLabeler;
 class SkyMesh;
+class SkyQueryRegion;
+class SkyQueryResults;
 class StarBlockFactory;
 class StarBlockList;
 class StarObject;
@@ -95,6 +98,14 @@ class DeepStarComponent : public ListComponent
      */
     bool starsInAperture(QList<StarObject *> &list, const SkyPoint &center, float radius, float maglim = -29);
 
+    /**
+     * @short Add to the results the stars from this component that lie within the region and are
+     * brighter than @p maglim.
+     * @return false if the limiting magnitude is brighter than the trigger magnitude of the
+     * DeepStarComponent
+     */
+    bool objectsInRegion(const SkyQueryRegion &region, float maglim, SkyQueryResults &results);
+
     // TODO: Find the right place for this method
     static void byteSwap(DeepStarData *stardata);
     static void byteSwap(StarData *stardata);
@@ -121,6 +132,9 @@ class DeepStarComponent : public ListComponent
     long unsigned t_drawUnnamed { 0 };
     long unsigned t_updateCache { 0 };
 
+    /// Screen positions of the stars in the block being drawn, reused across blocks
+    ProjectedPoints m_ProjectedStars;
+
     QVector<std::shared_ptr<StarBlockList>> m_starBlockList;
     QHash<int, StarObject *> m_CatalogNumber;
 
@@ -7,6 +7,7 @@
 #include "listcomponent.h"
 
 #include "kstarsdata.h"
+#include "nearestsearch.h"
 #ifndef KSTARS_LITE
 #include "skymap.h"
 #endif
@@ -69,15 +70,11 @@ SkyObject *ListComponent::objectNearest(SkyPoint *p, double &maxrad)
     if (!selected())
         return nullptr;
 
-    SkyObject *oBest = nullptr;
-    foreach (SkyObject *o, m_ObjectList)
-    {
-        double r = o->angularDistanceTo(p).Degrees();
-        if (r < maxrad)
-        {
-            oBest  = o;
-            maxrad = r;
-        }
-    }
-    return oBest;
+    NearestObjects<SkyObject> nearest(*p, maxrad);
+    for (SkyObject *o : m_ObjectList)
+        nearest.add(o);
+
+    if (nearest.nearest())
+        maxrad = nearest.distance(0);
+    return nearest.nearest();
 }
@@ -0,0 +1,181 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "nameindex.h"
+
+#include <algorithm>
+
+namespace
+{
+bool matchOrder(const NameIndex::Match &a, const NameIndex::Match &b)
+{
+    if (a.distance != b.distance)
+        return a.distance < b.distance;
+    return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
+}
+}
+
+QString NameIndex::normalize(const QString &name)
+{
+    const QString decomposed = name.normalized(QString::NormalizationForm_KD);
+
+    QString key;
+    key.reserve(decomposed.size());
+    for (const QChar &c : decomposed)
+    {
+        if (c.isMark() || c.isSpace() || c == '-' || c == '_' || c == '.' || c == '\'')
+            continue;
+        key.append(c.toCaseFolded());
+    }
+
+    return key;
+}
+
+void NameIndex::setNames(int type, const QVector<QPair<QString, const SkyObject *>> &names)
+{
+    Table &table = m_Tables[type];
+    table.clear();
+    table.reserve(names.size());
+
+    for (const auto &oneName : names)
+    {
+        QString key = normalize(oneName.first);
+        if (!key.isEmpty())
+            table.push_back({ std::move(key), oneName.first, oneName.second });
+    }
+
+    std::sort(table.begin(), table.end(), [](const Record & a, const Record & b)
+    {
+        return a.key < b.key;
+    });
+
+    if (table.empty())
+        m_Tables.remove(type);
+}
+
+void NameIndex::clear()
+{
+    m_Tables.clear();
+}
+
+int NameIndex::size() const
+{
+    std::size_t count = 0;
+    for (const auto &table : m_Tables)
+        count += table.size();
+
+    return static_cast<int>(count);
+}
+
+QVector<NameIndex::Match> NameIndex::find(const QString &name) const
+{
+    QVector<Match> matches;
+    const QString key = normalize(name);
+    if (key.isEmpty())
+        return matches;
+
+    for (auto it = m_Tables.constBegin(); it != m_Tables.constEnd(); ++it)
+    {
+        const Table &table = it.value();
+        auto first = std::lower_bound(table.begin(), table.end(), key, [](const Record & r, const QString & k)
+        {
+            return r.key < k;
+        });
+
+        for (; first != table.end() && first->key == key; ++first)
+            matches.append({ first->name, first->object, it.key(), 0 });
+    }
+
+    return matches;
+}
+
+QVector<NameIndex::Match> NameIndex::findByPrefix(const QString &prefix, int limit) const
+{
+    QVector<Match> matches;
+    const QString key = normalize(prefix);
+    if (key.isEmpty() || limit <= 0)
+        return matches;
+
+    for (auto it = m_Tables.constBegin(); it != m_Tables.constEnd(); ++it)
+    {
+        const Table &table = it.value();
+        auto first = std::lower_bound(table.begin(), table.end(), key, [](const Record & r, const QString & k)
+        {
+            return r.key < k;
+        });
+
+        // Only the first names of each table can be among the first ones overall
+        for (int count = 0; first != table.end() && first->key.startsWith(key) && count < limit; ++first, ++count)
+            matches.append({ first->name, first->object, it.key(), 0 });
+    }
+
+    std::sort(matches.begin(), matches.end(), matchOrder);
+    if (matches.size() > limit)
+        matches.resize(limit);
+
+    return matches;
+}
+
+QVector<NameIndex::Match> NameIndex::findApproximate(const QString &name, int maxDistance, int limit) const
+{
+    QVector<Match> matches;
+    const QString key = normalize(name);
+    if (key.isEmpty() || limit <= 0 || maxDistance < 0)
+        return matches;
+
+    // Edit distances from the empty prefix to the prefixes of the key
+    QVector<int> row(key.size() + 1);
+    for (int i = 0; i < row.size(); i++)
+        row[i] = i;
+
+    for (auto it = m_Tables.constBegin(); it != m_Tables.constEnd(); ++it)
+        findApproximate(it.value(), it.key(), key, maxDistance, 0, it.value().size(), 0, row, matches);
+
+    std::sort(matches.begin(), matches.end(), matchOrder);
+    if (matches.size() > limit)
+        matches.resize(limit);
+
+    return matches;
+}
+
+void NameIndex::findApproximate(const Table &table, int type, const QString &key, int maxDistance,
+                                std::size_t begin, std::size_t end, int depth, const QVector<int> &previousRow,
+                                QVector<Match> &matches)
+{
+    // All the keys in [begin, end) share their first depth characters, the shorter ones come first.
+    while (begin < end && table[begin].key.size() == depth)
+    {
+        if (previousRow.last() <= maxDistance)
+            matches.append({ table[begin].name, table[begin].object, type, previousRow.last() });
+        begin++;
+    }
+
+    QVector<int> row(previousRow.size());
+    while (begin < end)
+    {
+        const QChar c = table[begin].key.at(depth);
+        const auto last = std::upper_bound(table.begin() + begin, table.begin() + end, c,
+                                           [depth](const QChar & value, const Record & r)
+        {
+            return value < r.key.at(depth);
+        });
+        const std::size_t next = last - table.begin();
+
+        // Levenshtein row of the prefix extended with c
+        row[0] = previousRow[0] + 1;
+        int best = row[0];
+        for (int i = 1; i < row.size(); i++)
+        {
+            row[i] = std::min({ row[i - 1] + 1, previousRow[i] + 1, previousRow[i - 1] + (key.at(i - 1) == c ? 0 : 1) });
+            best = std::min(best, row[i]);
+        }
+
+        if (best <= maxDistance)
+            findApproximate(table, type, key, maxDistance, begin, next, depth + 1, row, matches);
+
+        begin = next;
+    }
+}
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+class SkyObject;
+
+/**
+ * @class NameIndex
+ * @short Sorted table of the names of the sky objects, for exact, prefix and typo tolerant lookups.
+ *
+ * The names are stored in a normalized form (see normalize()) so that "M31", "m 31" and "M 31" are the
+ * same key, in one sorted table per object type. Exact and prefix lookups are binary searches. The sorted
+ * table is also an implicit trie, since the keys sharing a prefix are contiguous, which approximate lookups
+ * walk while computing the edit distance to the searched name, pruning the branches that are already too
+ * far from it.
+ *
+ * SkyMapComposite keeps one built from its object lists, see SkyMapComposite::findByName().
+ */
+class NameIndex
+{
+    public:
+        struct Match
+        {
+            /// Name of the object, as listed
+            QString name;
+            const SkyObject *object { nullptr };
+            int type { 0 };
+            /// Edit distance between the normalized names
+            int distance { 0 };
+        };
+
+        /**
+         * @short Normalized form of a name.
+         *
+         * Case folded, without accents, spaces and the punctuation which designations are written with
+         * or without, like in "Barnard's Loop" or "NGC 2070-1".
+         */
+        static QString normalize(const QString &name);
+
+        /** @short Replace the names of the objects of a type. */
+        void setNames(int type, const QVector<QPair<QString, const SkyObject *>> &names);
+
+        void clear();
+
+        /** @return number of names in the index */
+        int size() const;
+
+        /** @return the objects whose normalized name is the same as @p name */
+        QVector<Match> find(const QString &name) const;
+
+        /** @return at most @p limit objects whose normalized name starts with @p prefix, sorted by name */
+        QVector<Match> findByPrefix(const QString &prefix, int limit = 50) const;
+
+        /**
+         * @return at most @p limit objects whose normalized name is within @p maxDistance insertions,
+         * deletions or substitutions of the one of @p name, the closest first
+         */
+        QVector<Match> findApproximate(const QString &name, int maxDistance = 2, int limit = 10) const;
+
+    private:
+        struct Record
+        {
+            QString key;
+            QString name;
+            const SkyObject *object;
+        };
+        using Table = std::vector<Record>;
+
+        static void findApproximate(const Table &table, int type, const QString &key, int maxDistance,
+                                    std::size_t begin, std::size_t end, int depth, const QVector<int> &previousRow,
+                                    QVector<Match> &matches);
+
+        QHash<int, Table> m_Tables;
+};
@@ -0,0 +1,192 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "skyobjects/skypoint.h"
+
+#include <QList>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @class SkyVector
+ * @short Unit vector of the current (RA, Dec) of a point, to compare angular distances with dot products.
+ *
+ * The vector is made of the sines and cosines the CachingDms coordinates of SkyPoint already hold, so
+ * unlike SkyPoint::angularDistanceTo() it does not cost any trigonometric function call.
+ */
+struct SkyVector
+{
+    explicit SkyVector(const SkyPoint &p)
+        : x(p.dec().cos() * p.ra().cos()), y(p.dec().cos() * p.ra().sin()), z(p.dec().sin())
+    {
+    }
+
+    SkyVector(double x, double y, double z) : x(x), y(y), z(z)
+    {
+    }
+
+    /** @return the unit vector of the catalog (J2000) coordinates of @p p */
+    static SkyVector catalog(const SkyPoint &p)
+    {
+        return SkyVector(p.dec0().cos() * p.ra0().cos(), p.dec0().cos() * p.ra0().sin(), p.dec0().sin());
+    }
+
+    /** @return the cross product, normal to the great circle through this and @p v */
+    SkyVector cross(const SkyVector &v) const
+    {
+        return SkyVector(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x);
+    }
+
+    /** @return the cosine of the angular distance to @p v */
+    double dot(const SkyVector &v) const
+    {
+        return x * v.x + y * v.y + z * v.z;
+    }
+
+    /** @return the angular distance to @p v in degrees, accurate for small distances too */
+    double angularDistance(const SkyVector &v) const
+    {
+        const double dx = x - v.x, dy = y - v.y, dz = z - v.z;
+        const double chord = std::sqrt(dx * dx + dy * dy + dz * dz);
+        return 2.0 * std::asin(std::min(1.0, chord / 2.0)) / dms::DegToRad;
+    }
+
+    double x, y, z;
+};
+
+/**
+ * @class SkyCone
+ * @short Radius query: tells the points within an angular distance of a center, with a dot product each.
+ */
+class SkyCone
+{
+    public:
+        /** @p radius in degrees */
+        SkyCone(const SkyPoint &center, double radius)
+            : m_Center(center), m_CosRadius(std::cos(radius * dms::DegToRad))
+        {
+        }
+
+        bool contains(const SkyPoint &p) const
+        {
+            return m_Center.dot(SkyVector(p)) >= m_CosRadius;
+        }
+
+        const SkyVector &center() const
+        {
+            return m_Center;
+        }
+
+    private:
+        SkyVector m_Center;
+        double m_CosRadius;
+};
+
+/**
+ * @class NearestObjects
+ * @short k nearest neighbours query over the objects it is given, typically those of the trixels around a point.
+ *
+ * Objects farther than the search radius, or than the k-th nearest one found so far, are rejected with a
+ * single dot product, the angular distances are only computed for the results.
+ * @code
+ * NearestObjects<StarObject> nearest(*p, maxrad);
+ * for (auto &star : *starList)
+ *     nearest.add(star);
+ * if (nearest.nearest())
+ *     maxrad = nearest.distance(0);
+ * @endcode
+ */
+template <typename T>
+class NearestObjects
+{
+    public:
+        /**
+         * @param center point to find the objects nearest to
+         * @param maxRadius objects must be strictly nearer than this, in degrees
+         * @param count number of objects to find
+         */
+        NearestObjects(const SkyPoint &center, double maxRadius, int count = 1)
+            : m_Center(center), m_Threshold(std::cos(maxRadius * dms::DegToRad)), m_Count(std::max(1, count))
+        {
+            m_Best.reserve(m_Count + 1);
+        }
+
+        /**
+         * @short Consider an object, whose current (RA, Dec) must be up to date.
+         * @return true if the object is among the nearest ones so far. Of objects at the same distance,
+         * the first one added is kept.
+         */
+        bool add(T *object)
+        {
+            return add(object, SkyVector(*object));
+        }
+
+        bool add(T *object, const SkyVector &v)
+        {
+            const double cosDistance = m_Center.dot(v);
+            if (cosDistance <= m_Threshold)
+                return false;
+
+            auto position = std::upper_bound(m_Best.begin(), m_Best.end(), cosDistance,
+                                             [](double value, const Candidate & c)
+            {
+                return value > c.cosDistance;
+            });
+            m_Best.insert(position, { cosDistance, object, v });
+
+            if (static_cast<int>(m_Best.size()) > m_Count)
+                m_Best.pop_back();
+            if (static_cast<int>(m_Best.size()) == m_Count)
+                m_Threshold = m_Best.back().cosDistance;
+
+            return true;
+        }
+
+        int size() const
+        {
+            return static_cast<int>(m_Best.size());
+        }
+
+        /** @return the nearest object, or nullptr if none was within the search radius */
+        T *nearest() const
+        {
+            return m_Best.empty() ? nullptr : m_Best.front().object;
+        }
+
+        /** @return the objects found, the nearest first */
+        QList<T *> objects() const
+        {
+            QList<T *> list;
+            list.reserve(size());
+            for (const auto &candidate : m_Best)
+                list.append(candidate.object);
+            return list;
+        }
+
+        /** @return the angular distance of the @p i th nearest object, in degrees */
+        double distance(int i) const
+        {
+            return m_Center.angularDistance(m_Best[i].vector);
+        }
+
+    private:
+        struct Candidate
+        {
+            double cosDistance;
+            T *object;
+            SkyVector vector;
+        };
+
+        SkyVector m_Center;
+        double m_Threshold;
+        int m_Count;
+        // Sorted by decreasing cosine, that is nearest first
+        std::vector<Candidate> m_Best;
+};
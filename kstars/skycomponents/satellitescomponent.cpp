@@ -9,6 +9,7 @@
 #include "ksfilereader.h"
 #include "ksnotification.h"
 #include "kstarsdata.h"
+#include "nearestsearch.h"
 #include "Options.h"
 #include "skylabeler.h"
 #include "skymap.h"
@@ -20,6 +21,8 @@
 #include <QProgressDialog>
 #include <QtConcurrent>
 
+#include <algorithm>
+
 SatellitesComponent::SatellitesComponent(SkyComposite *parent) : SkyComponent(parent)
 {
     QtConcurrent::run(this, &SatellitesComponent::loadData);
@@ -87,6 +90,40 @@ void SatellitesComponent::update(KSNumbers *)
     }
 }
 
+int SatellitesComponent::updateStepCount()
+{
+    if (!selected())
+        return 0;
+
+    int count = 0;
+    for (const auto group : m_groups)
+        count += group->size();
+
+    return count;
+}
+
+void SatellitesComponent::updateSteps(KSNumbers *, int begin, int end)
+{
+    if (!selected())
+        return;
+
+    // The steps run over the satellites of all groups, one after the other
+    int offset = 0;
+    for (auto group : m_groups)
+    {
+        const int size = group->size();
+        const int first = std::max(begin - offset, 0);
+        const int last = std::min(end - offset, size);
+
+        if (first < last)
+            group->updateSatellitesPos(first, last);
+
+        offset += size;
+        if (offset >= end)
+            break;
+    }
+}
+
 void SatellitesComponent::draw(SkyPainter *skyp)
 {
 #ifndef KSTARS_LITE
@@ -215,9 +252,7 @@ SkyObject *SatellitesComponent::objectNearest(SkyPoint *p, double &maxrad)
 
     //KStarsData* data = KStarsData::Instance();
 
-    SkyObject *oBest = nullptr;
-    double rBest     = maxrad;
-    double r;
+    NearestObjects<SkyObject> nearest(*p, maxrad);
 
     foreach (SatelliteGroup *group, m_groups)
     {
@@ -227,20 +262,13 @@ SkyObject *SatellitesComponent::objectNearest(SkyPoint *p, double &maxrad)
             if (!sat->selected())
                 continue;
 
-            r = sat->angularDistanceTo(p).Degrees();
-            //qDebug() << Q_FUNC_INFO << sat->name();
-            //qDebug() << Q_FUNC_INFO << "r = " << r << " - max = " << rBest;
-            //qDebug() << Q_FUNC_INFO << "ra2=" << sat->ra().Degrees() << " - dec2=" << sat->dec().Degrees();
-            if (r < rBest)
-            {
-                rBest = r;
-                oBest = sat;
-            }
+            nearest.add(sat);
         }
     }
 
-    maxrad = rBest;
-    return oBest;
+    if (nearest.nearest())
+        maxrad = nearest.distance(0);
+    return nearest.nearest();
 }
 
 SkyObject *SatellitesComponent::findByName(const QString &name, bool exact)
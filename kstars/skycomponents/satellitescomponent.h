@@ -51,6 +51,10 @@ class SatellitesComponent : public SkyComponent
          */
         void update(KSNumbers *num) override;
 
+        int updateStepCount() override;
+
+        void updateSteps(KSNumbers *num, int begin, int end) override;
+
         /**
          * Download new TLE files
          */
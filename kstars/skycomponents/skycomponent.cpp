@@ -62,6 +62,13 @@ QHash<int, QVector<QPair<QString, const SkyObject *>>> &SkyComponent::getObjectL
     return parent()->objectLists();
 }
 
+QVector<QPair<QString, const SkyObject *>> &SkyComponent::getObjectList(int type)
+{
+    if (!parent())
+        return getObjectLists()[type];
+    return parent()->objectLists(type);
+}
+
 void SkyComponent::removeFromNames(const SkyObject *obj)
 {
     QStringList &names = getObjectNames()[obj->type()];
@@ -77,7 +84,7 @@ void SkyComponent::removeFromNames(const SkyObject *obj)
 
 void SkyComponent::removeFromLists(const SkyObject *obj)
 {
-    QVector<QPair<QString, const SkyObject *>> &names = getObjectLists()[obj->type()];
+    QVector<QPair<QString, const SkyObject *>> &names = getObjectList(obj->type());
     int i;
     i = names.indexOf(QPair<QString, const SkyObject *>(obj->name(), obj));
     if (i >= 0)
@@ -124,6 +124,31 @@ class SkyComponent
          * @sa ConstellationBoundaryComponent::update()
          */
         virtual void update(KSNumbers *) {}
+
+        /**
+         * @short Number of steps update() can be split in, see updateSteps().
+         *
+         * SkyMapComposite::updateIncrementally() spreads the update of the
+         * large components over several time slices. Other components keep
+         * the default of a single step.
+         * @return 0 if there is nothing to update
+         */
+        virtual int updateStepCount()
+        {
+            return 1;
+        }
+
+        /**
+         * @short Run the steps [begin, end) of update().
+         * @sa updateStepCount()
+         */
+        virtual void updateSteps(KSNumbers *num, int begin, int end)
+        {
+            Q_UNUSED(begin)
+            Q_UNUSED(end)
+            update(num);
+        }
+
         virtual void updateSolarSystemBodies(KSNumbers *) {}
         virtual void updateMoons(KSNumbers *) {}
 
@@ -202,7 +227,7 @@ class SkyComponent
 
         inline QVector<QPair<QString, const SkyObject *>> &objectLists(int type)
         {
-            return getObjectLists()[type];
+            return getObjectList(type);
         }
 
         void removeFromNames(const SkyObject *obj);
@@ -211,6 +236,7 @@ class SkyComponent
     private:
         virtual QHash<int, QStringList> &getObjectNames();
         virtual QHash<int, QVector<QPair<QString, const SkyObject *>>> &getObjectLists();
+        virtual QVector<QPair<QString, const SkyObject *>> &getObjectList(int type);
 
         // Disallow copying and assignment
         SkyComponent(const SkyComponent &);
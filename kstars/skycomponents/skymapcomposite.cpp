@@ -52,6 +52,10 @@
 #endif
 
 #include <QApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <algorithm>
 
 #include <kstars_debug.h>
 
@@ -185,6 +189,11 @@ SkyMapComposite::SkyMapComposite(SkyComposite *parent)
 
 void SkyMapComposite::update(KSNumbers *num)
 {
+    // Supersedes any update in progress
+    m_UpdateInProgress = false;
+    m_UpdateAgain = false;
+    m_NextUpdateNum.reset();
+
     //printf("updating SkyMapComposite\n");
     //1. Milky Way
     //m_MilkyWay->update( data, num );
@@ -225,6 +234,98 @@ void SkyMapComposite::update(KSNumbers *num)
 #endif
 }
 
+QList<SkyComponent *> SkyMapComposite::updateQueue() const
+{
+    // Rebuilt on each slice, the constellation names are replaced when the culture changes.
+    QList<SkyComponent *> queue;
+    queue << m_Horizon << m_HorizontalCoordinateGrid;
+#ifndef KSTARS_LITE
+    queue << m_LocalMeridianComponent;
+#endif
+    if (m_CNames)
+        queue << m_CNames;
+    queue << m_SolarSystem;
+#ifndef KSTARS_LITE
+    queue << m_Flags;
+#endif
+    queue << m_Supernovae << m_Satellites;
+
+    return queue;
+}
+
+void SkyMapComposite::updateIncrementally(KSNumbers *num)
+{
+    if (m_UpdateInProgress)
+    {
+        m_UpdateAgain = true;
+        m_NextUpdateNum.reset(num ? new KSNumbers(*num) : nullptr);
+        return;
+    }
+
+    m_UpdateNum.reset(num ? new KSNumbers(*num) : nullptr);
+    m_UpdateInProgress = true;
+    m_UpdateComponent = 0;
+    m_UpdateStep = 0;
+
+    updateSlice();
+}
+
+void SkyMapComposite::updateSlice()
+{
+    if (!m_UpdateInProgress)
+        return;
+
+    // Steps run between two checks of the time budget
+    constexpr int chunk = 256;
+
+    const QList<SkyComponent *> queue = updateQueue();
+    QElapsedTimer timer;
+    timer.start();
+
+    while (timer.elapsed() < UPDATE_SLICE_MS)
+    {
+        if (m_UpdateComponent >= queue.size())
+        {
+            if (!m_UpdateAgain)
+            {
+                m_UpdateInProgress = false;
+                m_UpdateNum.reset();
+                emit updateFinished();
+                return;
+            }
+
+            m_UpdateAgain = false;
+            m_UpdateNum = std::move(m_NextUpdateNum);
+            m_UpdateComponent = 0;
+            m_UpdateStep = 0;
+        }
+
+        SkyComponent *component = queue.at(m_UpdateComponent);
+        const int count = component->updateStepCount();
+        if (m_UpdateStep >= count)
+        {
+            m_UpdateComponent++;
+            m_UpdateStep = 0;
+            continue;
+        }
+
+        const int end = std::min(count, m_UpdateStep + chunk);
+        component->updateSteps(m_UpdateNum.get(), m_UpdateStep, end);
+        m_UpdateStep = end;
+    }
+
+    // A slice may still be queued from an update which was superseded
+    if (!m_UpdateSliceQueued)
+    {
+        m_UpdateSliceQueued = true;
+        QTimer::singleShot(0, this, [this]()
+        {
+            m_UpdateSliceQueued = false;
+            updateSlice();
+        });
+    }
+}
+
 void SkyMapComposite::updateSolarSystemBodies(KSNumbers *num)
 {
     m_SolarSystem->updateSolarSystemBodies(num);
@@ -301,7 +402,7 @@ void SkyMapComposite::draw(SkyPainter *skyp)
             {
                 // Find the "original" obj
                 SkyObject *o = findByName(
-                                   obj_clone->name()); // FIXME: This is slow.... and can also fail!!!
+                                   obj_clone->name()); // FIXME: This can fail for objects which are not loaded
                 if (!o)
                     continue;
                 SkyLabeler::AddLabel(o, SkyLabeler::RUDE_LABEL);
@@ -538,9 +639,78 @@ QHash<int, QStringList> &SkyMapComposite::getObjectNames()
 
 QHash<int, QVector<QPair<QString, const SkyObject *>>> &SkyMapComposite::getObjectLists()
 {
+    QMutexLocker locker(&m_NameIndexLock);
+    m_NameIndexDirty = true;
     return m_ObjectLists;
 }
 
+QVector<QPair<QString, const SkyObject *>> &SkyMapComposite::getObjectList(int type)
+{
+    QMutexLocker locker(&m_NameIndexLock);
+    m_NameIndexDirtyTypes.insert(type);
+    return m_ObjectLists[type];
+}
+
+const NameIndex &SkyMapComposite::nameIndex()
+{
+    if (m_NameIndexDirty)
+    {
+        m_NameIndex.clear();
+        for (auto it = m_ObjectLists.constBegin(); it != m_ObjectLists.constEnd(); ++it)
+            m_NameIndex.setNames(it.key(), it.value());
+    }
+    else
+    {
+        for (int type : m_NameIndexDirtyTypes)
+            m_NameIndex.setNames(type, m_ObjectLists.value(type));
+    }
+
+    m_NameIndexDirty = false;
+    m_NameIndexDirtyTypes.clear();
+    return m_NameIndex;
+}
+
+namespace
+{
+// Order in which findByName() prefers the types of objects having the same name, the order of its
+// search of the components, as solar system bodies, deep sky objects, constellations, stars, supernovae
+// then satellites
+int findByNameRank(int type)
+{
+    switch (type)
+    {
+        case SkyObject::PLANET:
+        case SkyObject::MOON:
+        case SkyObject::COMET:
+        case SkyObject::ASTEROID:
+            return 0;
+        case SkyObject::CONSTELLATION:
+            return 2;
+        case SkyObject::STAR:
+        case SkyObject::CATALOG_STAR:
+            return 3;
+        case SkyObject::SUPERNOVA:
+            return 4;
+        case SkyObject::SATELLITE:
+            return 5;
+        default:
+            return 1;
+    }
+}
+}
+
+QVector<NameIndex::Match> SkyMapComposite::findByNamePrefix(const QString &prefix, int limit)
+{
+    QMutexLocker locker(&m_NameIndexLock);
+    return nameIndex().findByPrefix(prefix, limit);
+}
+
+QVector<NameIndex::Match> SkyMapComposite::findByNameFuzzy(const QString &name, int maxDistance, int limit)
+{
+    QMutexLocker locker(&m_NameIndexLock);
+    return nameIndex().findApproximate(name, maxDistance, limit);
+}
+
 QList<SkyObject *> SkyMapComposite::findObjectsInArea(const SkyPoint &p1,
         const SkyPoint &p2)
 {
@@ -555,6 +725,28 @@ QList<SkyObject *> SkyMapComposite::findObjectsInArea(const SkyPoint &p1,
     return list;
 }
 
+void SkyMapComposite::objectsInRegion(const SkyQueryRegion &region, float maglim, SkyQueryResults &results,
+                                      int sources)
+{
+    results.clear();
+
+    if (sources & (SkyQueryResults::STARS | SkyQueryResults::DEEP_STARS))
+        m_Stars->objectsInRegion(region, maglim, results, sources);
+    if (sources & SkyQueryResults::CATALOGS)
+        m_Catalogs->objectsInRegion(region, maglim, results);
+
+    results.finish();
+}
+
+SkyObject *SkyMapComposite::persistentObject(const SkyQueryResults::Entry &entry)
+{
+    if (entry.source == SkyQueryResults::CATALOGS)
+        return &m_Catalogs->insertStaticObject(*static_cast<const CatalogObject *>(entry.object));
+
+    // Stars are owned by their components
+    return const_cast<SkyObject *>(entry.object);
+}
+
 SkyObject *SkyMapComposite::findByName(const QString &name, bool exact)
 {
 #ifndef KSTARS_LITE
@@ -562,6 +754,44 @@ SkyObject *SkyMapComposite::findByName(const QString &name, bool exact)
         return nullptr;
 #endif
 
+    // Look the loaded objects up first. Names which only differ by their case are preferred to the
+    // ones which only match once normalized, then the objects are ranked by type.
+    const SkyObject *indexed = nullptr;
+    int indexedRank          = 0;
+    {
+        QMutexLocker locker(&m_NameIndexLock);
+        for (const auto &match : nameIndex().find(name))
+        {
+            const bool sameName = QString::compare(match.name, name, Qt::CaseInsensitive) == 0;
+            if (exact && !sameName)
+                continue;
+
+            const int rank = 2 * findByNameRank(match.type) + (sameName ? 0 : 1);
+            if (!indexed || rank < indexedRank)
+            {
+                indexed     = match.object;
+                indexedRank = rank;
+            }
+        }
+    }
+
+    if (indexed)
+    {
+        // Solar system bodies and deep sky objects take precedence, but most of the latter are only
+        // in the catalog database
+        if (indexedRank / 2 > findByNameRank(SkyObject::GALAXY))
+        {
+            SkyObject *o = m_SolarSystem->findByName(name);
+            if (!o)
+                o = m_Catalogs->findByName(name, exact);
+            if (o)
+                return o;
+        }
+
+        // The object lists only hold const pointers to the objects of the components
+        return const_cast<SkyObject *>(indexed);
+    }
+
     //We search the children in an "intelligent" order (most-used
     //object types first), in order to avoid wasting too much time
     //looking for a match.  The most important part of this ordering
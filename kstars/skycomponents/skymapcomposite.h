@@ -12,8 +12,12 @@
 #include "skylabeler.h"
 #include "skymesh.h"
 #include "skyobject.h"
+#include "nameindex.h"
+#include "skyquery.h"
 #include "config-kstars.h"
 #include <QList>
+#include <QMutex>
+#include <QSet>
 
 #include <memory>
 
@@ -75,6 +79,30 @@ class SkyMapComposite : public QObject, public SkyComposite
 
         void update(KSNumbers *num = nullptr) override;
 
+        /**
+             * @short Same as update(), in time slices run from the event loop
+             *
+             * Updating all components at once freezes the UI when the clock runs
+             * fast, so the update is split in slices of at most UPDATE_SLICE_MS
+             * milliseconds and the sky map is drawn in between. The first slice
+             * runs before returning and starts with the components which are most
+             * likely on screen and cheap to update: the horizon, the grid and the
+             * solar system, while the satellites come last.
+             *
+             * An update started while another one is in progress does not restart
+             * it, so that all components keep being updated when updates are
+             * started faster than they complete, but runs once it is finished.
+             * updateFinished() is emitted when no update is left.
+             * @p num Pointer to the KSNumbers object, copied
+             */
+        void updateIncrementally(KSNumbers *num);
+
+        /** @return true if an update started by updateIncrementally() is in progress */
+        bool isUpdating() const
+        {
+            return m_UpdateInProgress;
+        }
+
         /**
              * @short Delegate planet position updates to the SolarSystemComposite
              *
@@ -136,8 +164,12 @@ class SkyMapComposite : public QObject, public SkyComposite
              *
              * The objects' primary, secondary and long-form names will
              * all be checked for a match.
-             * @note Overloaded from SkyComposite.  In this version, we search
-             * the most likely object classes first to be more efficient.
+             * @note Overloaded from SkyComposite.  In this version, the names
+             * of the loaded objects are looked up in a sorted index first, which
+             * also matches names written with a different case, spacing or
+             * punctuation ("m31" for "M 31"), then the children are searched,
+             * the most likely object classes first, for the objects which are
+             * not loaded yet, like most of the deep sky objects of the catalogs.
              * @p name the name to be matched
              * @p exact If true, it will return an exact match (default), otherwise it can return
              * a partial match.
@@ -146,6 +178,36 @@ class SkyMapComposite : public QObject, public SkyComposite
              */
         SkyObject *findByName(const QString &name, bool exact = true) override;
 
+        /**
+             * @return at most @p limit loaded objects whose name starts with @p prefix,
+             * ignoring case, spaces and punctuation, sorted by name
+             */
+        QVector<NameIndex::Match> findByNamePrefix(const QString &prefix, int limit = 50);
+
+        /**
+             * @return at most @p limit loaded objects whose name is within @p maxDistance
+             * typos (insertions, deletions or substitutions) of @p name, the closest first
+             */
+        QVector<NameIndex::Match> findByNameFuzzy(const QString &name, int maxDistance = 2, int limit = 10);
+
+        /**
+             * @return the types which have named objects
+             * @note Unlike objectLists(), this does not invalidate the name index
+             */
+        QList<int> objectListTypes() const
+        {
+            return m_ObjectLists.keys();
+        }
+
+        /**
+             * @return a read only copy of the names of the objects of a type
+             * @note Unlike objectLists(), this does not invalidate the name index
+             */
+        QVector<QPair<QString, const SkyObject *>> objectList(int type) const
+        {
+            return m_ObjectLists.value(type);
+        }
+
         /**
              * @return the list of objects in the region defined by skypoints
              * @param p1 first sky point (top-left vertex of rectangular region)
@@ -153,6 +215,31 @@ class SkyMapComposite : public QObject, public SkyComposite
              */
         QList<SkyObject *> findObjectsInArea(const SkyPoint &p1, const SkyPoint &p2);
 
+        /**
+             * @short Gather the stars and deep sky objects in a region, a cone or the
+             * footprint of an image, into compact results sorted by magnitude.
+             *
+             * Unlike findObjectsInArea(), the objects are neither allocated nor
+             * registered, and the results reuse their storage from a query to the
+             * next. The sources are searched whether they are shown or not.
+             * @param region the region, in catalog coordinates
+             * @param maglim faintest magnitude, deep sky objects of unknown magnitude
+             * are always included
+             * @param results cleared, then filled
+             * @param sources combination of SkyQueryResults::Source
+             */
+        void objectsInRegion(const SkyQueryRegion &region, float maglim, SkyQueryResults &results,
+                             int sources = SkyQueryResults::ALL_SOURCES);
+
+        /**
+             * @return the object of an entry of SkyQueryResults, valid for the lifetime
+             * of the sky components, except the stars of the deep star catalogs which are
+             * only valid until the sky is drawn again. The deep sky objects are registered
+             * like the ones found by name, so this should only be called for the entries
+             * which are used.
+             */
+        SkyObject *persistentObject(const SkyQueryResults::Entry &entry);
+
         bool addNameLabel(SkyObject *o);
         bool removeNameLabel(SkyObject *o);
 
@@ -271,10 +358,22 @@ class SkyMapComposite : public QObject, public SkyComposite
         }
     signals:
         void progressText(const QString &message);
+        void updateFinished();
 
     private:
+        /// Time budget of a slice of updateIncrementally()
+        static constexpr int UPDATE_SLICE_MS = 10;
+
+        /** @return the components updated by update(), in the order of updateIncrementally() */
+        QList<SkyComponent *> updateQueue() const;
+        void updateSlice();
+
         QHash<int, QStringList> &getObjectNames() override;
         QHash<int, QVector<QPair<QString, const SkyObject *>>> &getObjectLists() override;
+        QVector<QPair<QString, const SkyObject *>> &getObjectList(int type) override;
+
+        /** @return the name index, brought up to date with the object lists. Call with m_NameIndexLock held. */
+        const NameIndex &nameIndex();
 
         std::unique_ptr<CultureList> m_Cultures;
         ConstellationBoundaryLines *m_CBoundLines{ nullptr };
@@ -311,10 +410,25 @@ class SkyMapComposite : public QObject, public SkyComposite
 
         KSNumbers m_reindexNum;
 
+        // State of updateIncrementally(), the position is a component of updateQueue() and one of its steps
+        bool m_UpdateInProgress { false };
+        bool m_UpdateAgain { false };
+        bool m_UpdateSliceQueued { false };
+        int m_UpdateComponent { 0 };
+        int m_UpdateStep { 0 };
+        std::unique_ptr<KSNumbers> m_UpdateNum;
+        // Update to run once the current one is finished, see m_UpdateAgain
+        std::unique_ptr<KSNumbers> m_NextUpdateNum;
+
         QList<DeepStarComponent *> m_DeepStars;
 
         QList<SkyObject *> m_LabeledObjects;
         QHash<int, QStringList> m_ObjectNames;
         QHash<int, QVector<QPair<QString, const SkyObject *>>> m_ObjectLists;
+        // The object lists are handed out by reference, so any access for writing marks them to be reindexed
+        NameIndex m_NameIndex;
+        QSet<int> m_NameIndexDirtyTypes;
+        bool m_NameIndexDirty { true };
+        QMutex m_NameIndexLock;
         QHash<QString, QString> m_ConstellationNames;
 };
@@ -0,0 +1,126 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "skyquery.h"
+
+#include "skyobjects/starobject.h"
+
+#include <cmath>
+
+namespace
+{
+// Trixels are searched with some margin for the rounding of the bounds
+constexpr double BOUNDING_MARGIN = 1.0 / 3600.0;
+
+SkyPoint toSkyPoint(const SkyVector &v)
+{
+    dms ra, dec;
+    ra.setRadians(std::atan2(v.y, v.x));
+    dec.setRadians(std::asin(std::max(-1.0, std::min(1.0, v.z))));
+    return SkyPoint(ra.reduce(), dec);
+}
+}
+
+SkyQueryRegion::SkyQueryRegion(const SkyVector &center, double radius)
+    : m_BoundingCenter(toSkyPoint(center)), m_BoundingRadius(radius), m_Center(center),
+      m_CosRadius(std::cos(radius * dms::DegToRad))
+{
+}
+
+SkyQueryRegion SkyQueryRegion::cone(const SkyPoint &center, double radius)
+{
+    return SkyQueryRegion(SkyVector::catalog(center), radius);
+}
+
+SkyQueryRegion SkyQueryRegion::polygon(const QVector<SkyPoint> &vertices)
+{
+    std::vector<SkyVector> corners;
+    corners.reserve(vertices.size());
+    double x = 0, y = 0, z = 0;
+    for (const auto &vertex : vertices)
+    {
+        corners.push_back(SkyVector::catalog(vertex));
+        x += corners.back().x;
+        y += corners.back().y;
+        z += corners.back().z;
+    }
+
+    const double norm = std::sqrt(x * x + y * y + z * z);
+    if (corners.size() < 3 || norm == 0)
+        return cone(vertices.isEmpty() ? SkyPoint() : vertices.first(), 0);
+
+    // The farthest point of a convex polygon from its centroid is one of its vertices
+    const SkyVector center(x / norm, y / norm, z / norm);
+    double radius = 0;
+    for (const auto &corner : corners)
+        radius = std::max(radius, center.angularDistance(corner));
+
+    SkyQueryRegion region(center, radius + BOUNDING_MARGIN);
+
+    // Normals of the edges, pointing inside whichever way around the vertices are given
+    region.m_Edges.reserve(corners.size());
+    for (std::size_t i = 0; i < corners.size(); i++)
+        region.m_Edges.push_back(corners[i].cross(corners[(i + 1) % corners.size()]));
+    if (region.m_Edges.front().dot(center) < 0)
+    {
+        for (auto &edge : region.m_Edges)
+            edge = SkyVector(-edge.x, -edge.y, -edge.z);
+    }
+
+    return region;
+}
+
+bool SkyQueryRegion::contains(const SkyVector &v) const
+{
+    if (m_Center.dot(v) < m_CosRadius)
+        return false;
+
+    for (const auto &edge : m_Edges)
+    {
+        if (edge.dot(v) < 0)
+            return false;
+    }
+
+    return true;
+}
+
+void SkyQueryResults::clear()
+{
+    m_Entries.clear();
+    m_CatalogObjects.clear();
+}
+
+void SkyQueryResults::addStar(const StarObject *star, Source source)
+{
+    m_Entries.push_back({ star->ra0().Degrees(), star->dec0().Degrees(), star->mag(),
+                          static_cast<qint16>(star->type()), static_cast<quint8>(source), star });
+}
+
+void SkyQueryResults::addCatalogObject(const CatalogObject &object)
+{
+    // The object is pointed to once the copies are done, see finish()
+    m_Entries.push_back({ object.ra0().Degrees(), object.dec0().Degrees(), object.mag(),
+                          static_cast<qint16>(object.type()), static_cast<quint8>(CATALOGS), nullptr });
+    m_CatalogObjects.push_back(object);
+}
+
+void SkyQueryResults::finish()
+{
+    // The copies are in the order of the entries until these are sorted
+    std::size_t catalogObject = 0;
+    for (auto &entry : m_Entries)
+    {
+        if (entry.source == CATALOGS)
+            entry.object = &m_CatalogObjects[catalogObject++];
+    }
+
+    std::stable_sort(m_Entries.begin(), m_Entries.end(), [](const Entry & a, const Entry & b)
+    {
+        if (std::isnan(a.mag))
+            return false;
+        return std::isnan(b.mag) || a.mag < b.mag;
+    });
+}
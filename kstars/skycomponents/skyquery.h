@@ -0,0 +1,143 @@
+/*
+    SPDX-FileCopyrightText: 2026 KStars Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#pragma once
+
+#include "nearestsearch.h"
+#include "skyobjects/catalogobject.h"
+
+#include <QVector>
+
+#include <vector>
+
+class StarObject;
+
+/**
+ * @class SkyQueryRegion
+ * @short Region of the sky for SkyMapComposite::objectsInRegion(), in catalog (J2000) coordinates.
+ *
+ * Either a cone or a convex polygon, such as the footprint of an image. Components search the trixels
+ * of the cone bounding the region, then test each object with dot products only.
+ */
+class SkyQueryRegion
+{
+    public:
+        /** @short The points within @p radius degrees of @p center */
+        static SkyQueryRegion cone(const SkyPoint &center, double radius);
+
+        /**
+         * @short The points inside a convex polygon
+         * @param vertices at least three vertices, in order either way around, of a polygon smaller than
+         * a hemisphere
+         */
+        static SkyQueryRegion polygon(const QVector<SkyPoint> &vertices);
+
+        bool contains(const SkyVector &v) const;
+
+        /** @short Test the catalog coordinates of @p p */
+        bool contains(const SkyPoint &p) const
+        {
+            return contains(SkyVector::catalog(p));
+        }
+
+        /** @return the center of the cone bounding the region */
+        const SkyPoint &boundingCenter() const
+        {
+            return m_BoundingCenter;
+        }
+
+        /** @return the radius of the cone bounding the region, in degrees */
+        double boundingRadius() const
+        {
+            return m_BoundingRadius;
+        }
+
+    private:
+        SkyQueryRegion(const SkyVector &center, double radius);
+
+        SkyPoint m_BoundingCenter;
+        double m_BoundingRadius { 0 };
+        SkyVector m_Center;
+        double m_CosRadius { 1 };
+        // Inward normals of the edges of a polygon, empty for a cone
+        std::vector<SkyVector> m_Edges;
+};
+
+/**
+ * @class SkyQueryResults
+ * @short Compact results of SkyMapComposite::objectsInRegion(), sorted by magnitude.
+ *
+ * Each entry gives the catalog position, magnitude and type of an object without any allocation, the
+ * storage of the results is kept from a query to the next so that repeated queries reuse it.
+ *
+ * The objects of the entries are only valid until the next query, or the next time the sky is drawn
+ * for the stars of the deep star catalogs. The deep sky objects of the catalogs are copies held by the
+ * results. To keep an object, use SkyMapComposite::persistentObject().
+ */
+class SkyQueryResults
+{
+    public:
+        enum Source
+        {
+            STARS          = 1 << 0, ///< The stars always in memory, brighter than magnitude 8
+            DEEP_STARS     = 1 << 1, ///< The stars of the deep star catalogs
+            CATALOGS       = 1 << 2, ///< The deep sky objects of the catalogs
+            ALL_SOURCES    = STARS | DEEP_STARS | CATALOGS
+        };
+
+        struct Entry
+        {
+            /// Catalog coordinates, in degrees
+            double ra0;
+            double dec0;
+            /// Magnitude, NaN if unknown
+            float mag;
+            qint16 type;
+            quint8 source;
+            const SkyObject *object;
+        };
+
+        /** @short Empty the results, keeping their storage */
+        void clear();
+
+        int size() const
+        {
+            return static_cast<int>(m_Entries.size());
+        }
+
+        bool isEmpty() const
+        {
+            return m_Entries.empty();
+        }
+
+        const Entry &at(int i) const
+        {
+            return m_Entries[i];
+        }
+
+        std::vector<Entry>::const_iterator begin() const
+        {
+            return m_Entries.begin();
+        }
+
+        std::vector<Entry>::const_iterator end() const
+        {
+            return m_Entries.end();
+        }
+
+        /** @name Filling, for the sky components */
+        /** @{ */
+        void addStar(const StarObject *star, Source source);
+        void addCatalogObject(const CatalogObject &object);
+
+        /** @short Sort the entries by magnitude, the objects of unknown magnitude last, once all are added */
+        void finish();
+        /** @} */
+
+    private:
+        std::vector<Entry> m_Entries;
+        std::vector<CatalogObject> m_CatalogObjects;
+};
@@ -20,6 +20,8 @@
 #include "skyobjects/kssun.h"
 #include "skyobjects/ksearthshadow.h"
 
+#include <algorithm>
+
 SolarSystemComposite::SolarSystemComposite(SkyComposite *parent) : SkyComposite(parent)
 {
     emitProgressText(i18n("Loading solar system"));
@@ -121,6 +123,41 @@ void SolarSystemComposite::update(KSNumbers *num)
     }
 }
 
+int SolarSystemComposite::updateStepCount()
+{
+    // The Sun and the Moon, then the steps of the sub components
+    int count = 1;
+    for (SkyComponent *comp : components())
+        count += comp->updateStepCount();
+
+    return count;
+}
+
+void SolarSystemComposite::updateSteps(KSNumbers *num, int begin, int end)
+{
+    if (begin == 0)
+    {
+        KStarsData *data = KStarsData::Instance();
+        m_Sun->EquatorialToHorizontal(data->lst(), data->geo()->lat());
+        m_Moon->EquatorialToHorizontal(data->lst(), data->geo()->lat());
+    }
+
+    int offset = 1;
+    for (SkyComponent *comp : components())
+    {
+        const int count = comp->updateStepCount();
+        const int first = std::max(begin - offset, 0);
+        const int last = std::min(end - offset, count);
+
+        if (first < last)
+            comp->updateSteps(num, first, last);
+
+        offset += count;
+        if (offset >= end)
+            break;
+    }
+}
+
 void SolarSystemComposite::updateSolarSystemBodies(KSNumbers *num)
 {
     m_Earth->findPosition(num);
@@ -48,6 +48,10 @@ class SolarSystemComposite : public SkyComposite
 
     void update(KSNumbers *num) override;
 
+    int updateStepCount() override;
+
+    void updateSteps(KSNumbers *num, int begin, int end) override;
+
     void updateSolarSystemBodies(KSNumbers *num) override;
 
     void updateMoons(KSNumbers *num) override;
@@ -19,6 +19,8 @@
 
 #include <QPen>
 
+#include <algorithm>
+
 SolarSystemListComponent::SolarSystemListComponent(SolarSystemComposite *p) : ListComponent(p), m_Earth(p->earth())
 {
 }
@@ -28,15 +30,26 @@ SolarSystemListComponent::~SolarSystemListComponent()
     //Object deletes handled by parent class (ListComponent)
 }
 
-void SolarSystemListComponent::update(KSNumbers *)
+void SolarSystemListComponent::update(KSNumbers *num)
+{
+    updateSteps(num, 0, m_ObjectList.size());
+}
+
+int SolarSystemListComponent::updateStepCount()
+{
+    return selected() ? m_ObjectList.size() : 0;
+}
+
+void SolarSystemListComponent::updateSteps(KSNumbers *, int begin, int end)
 {
     if (selected())
     {
         KStarsData *data = KStarsData::Instance();
 
-        foreach (SkyObject *o, m_ObjectList)
+        end = std::min(end, m_ObjectList.size());
+        for (int i = begin; i < end; i++)
         {
-            KSPlanetBase *p = dynamic_cast<KSPlanetBase*>(o);
+            KSPlanetBase *p = dynamic_cast<KSPlanetBase*>(m_ObjectList.at(i));
 
             if (p)
                 p->EquatorialToHorizontal(data->lst(), data->geo()->lat());
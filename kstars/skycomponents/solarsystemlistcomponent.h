@@ -26,6 +26,10 @@ class SolarSystemListComponent : public ListComponent
 
     void update(KSNumbers *num) override;
 
+    int updateStepCount() override;
+
+    void updateSteps(KSNumbers *num, int begin, int end) override;
+
     /**
      * @short Update the coordinates of the solar system bodies in this component.
      *
@@ -38,6 +38,35 @@ StarBlock::StarBlock(int nstars)
       stars(nstars, StarObject())
 #endif
 {
+    m_Packed.x.resize(nstars);
+    m_Packed.y.resize(nstars);
+    m_Packed.z.resize(nstars);
+    m_Packed.pmX.resize(nstars);
+    m_Packed.pmY.resize(nstars);
+    m_Packed.pmZ.resize(nstars);
+    m_Packed.mag.resize(nstars);
+    m_Packed.spType.resize(nstars);
+}
+
+void StarBlock::pack(int i, const StarObject &star)
+{
+    double sinRa, cosRa, sinDec, cosDec;
+    star.ra0().SinCos(sinRa, cosRa);
+    star.dec0().SinCos(sinDec, cosDec);
+
+    // Proper motion in milliarcsec per year is numerically equal to arcsec per millennium.
+    // The vector form matches StarObject::getIndexCoords(), with pmRA already scaled by cos(dec)
+    const double scale = M_PI / (180.0 * 3600.0);
+    const double pmRA = star.pmRA() * scale, pmDec = star.pmDec() * scale;
+
+    m_Packed.x[i]      = cosDec * cosRa;
+    m_Packed.y[i]      = cosDec * sinRa;
+    m_Packed.z[i]      = sinDec;
+    m_Packed.pmX[i]    = -pmRA * sinRa - pmDec * sinDec * cosRa;
+    m_Packed.pmY[i]    = pmRA * cosRa - pmDec * sinDec * sinRa;
+    m_Packed.pmZ[i]    = pmDec * cosDec;
+    m_Packed.mag[i]    = star.mag();
+    m_Packed.spType[i] = star.spchar();
 }
 
 void StarBlock::reset()
@@ -60,6 +89,7 @@ StarNode *StarBlock::addStar(const StarData &data)
     StarObject &star = node.star;
 
     star.init(&data);
+    pack(nStars - 1, star);
     if (star.mag() > faintMag)
         faintMag = star.mag();
     if (star.mag() < brightMag)
@@ -75,6 +105,7 @@ StarNode *StarBlock::addStar(const DeepStarData &data)
     StarObject &star = node.star;
 
     star.init(&data);
+    pack(nStars - 1, star);
     if (star.mag() > faintMag)
         faintMag = star.mag();
     if (star.mag() < brightMag)
@@ -89,6 +120,7 @@ StarObject *StarBlock::addStar(const StarData &data)
     StarObject &star = stars[nStars++];
 
     star.init(&data);
+    pack(nStars - 1, star);
     if (star.mag() > faintMag)
         faintMag = star.mag();
     if (star.mag() < brightMag)
@@ -103,6 +135,7 @@ StarObject *StarBlock::addStar(const DeepStarData &data)
     StarObject &star = stars[nStars++];
 
     star.init(&data);
+    pack(nStars - 1, star);
     if (star.mag() > faintMag)
         faintMag = star.mag();
     if (star.mag() < brightMag)
@@ -132,6 +132,24 @@ class StarBlock
     /** @short  Reset this StarBlock's data, for reuse of the StarBlock */
     void reset();
 
+    /**
+     * @short Compact structure-of-arrays copy of the stars in this block
+     *
+     * Holds only what is needed to draw the stars: J2000.0 unit vectors, proper motion vectors
+     * in radians per Julian millennium, magnitudes and spectral classes. The i-th entry of each
+     * array describes star(i); entries are written by addStar().
+     */
+    struct PackedStars
+    {
+        QVector<float> x, y, z;
+        QVector<float> pmX, pmY, pmZ;
+        QVector<float> mag;
+        QVector<char> spType;
+    };
+
+    /** @return the packed copy of the stars in this StarBlock, used for batch drawing */
+    inline const PackedStars &packed() const { return m_Packed; }
+
     float faintMag { 0 };
     float brightMag { 0 };
     StarBlockList *parent;
@@ -144,8 +162,13 @@ class StarBlock
     StarBlock(const StarBlock &);
     StarBlock &operator=(const StarBlock &);
 
+    /** @short Write the packed entry of the i-th star from its StarObject */
+    void pack(int i, const StarObject &star);
+
     /** Number of initialized stars in StarBlock. */
     int nStars { 0 };
     /** Array of stars. */
     QVector<StarBlockEntry> stars;
+    /** Packed copy of the stars, same capacity as stars. */
+    PackedStars m_Packed;
 };
@@ -18,6 +18,8 @@
 
 #include <QDebug>
 
+#include <cstring>
+
 StarBlockList::StarBlockList(const Trixel &tr, DeepStarComponent *parent)
 {
     trixel       = tr;
@@ -92,7 +94,23 @@ bool StarBlockList::fillToMag(float maglim)
 
     Q_ASSERT(nBlocks == (unsigned int)blocks.size());
 
-    BinFileHelper::unsigned_KDE_fseek(dataFile, readOffset, SEEK_SET);
+    const int recordSize = dSReader->guessRecordSize();
+
+    // When the catalog is memory-mapped, the remaining records of this trixel are read straight
+    // from the mapping; otherwise we fall back to seeking and reading records one at a time.
+    const uchar *record = nullptr;
+    if (dSReader->isMapped())
+    {
+        quint64 remaining = dSReader->getRecordCount(trixelId) - nStars;
+        record            = dSReader->mappedRange(readOffset, remaining * recordSize);
+        if (!record)
+        {
+            qWarning() << "ERROR: Trixel" << trixel << "lies beyond the end of the mapped star catalog";
+            return false;
+        }
+    }
+    else
+        BinFileHelper::unsigned_KDE_fseek(dataFile, readOffset, SEEK_SET);
 
     /*
     qDebug() << Q_FUNC_INFO << "Reading trixel" << trixel << ", id on disk =" << trixelId << ", currently nStars =" << nStars
@@ -124,9 +142,15 @@ bool StarBlockList::fillToMag(float maglim)
             ++nBlocks;
         }
         // TODO: Make this more general
-        if (dSReader->guessRecordSize() == 32)
+        if (recordSize == 32)
         {
-            ret = fread(&stardata, sizeof(StarData), 1, dataFile);
+            if (record)
+            {
+                memcpy(&stardata, record, sizeof(StarData));
+                record += sizeof(StarData);
+            }
+            else
+                ret = fread(&stardata, sizeof(StarData), 1, dataFile);
             if (dSReader->getByteSwap())
                 DeepStarComponent::byteSwap(&stardata);
             readOffset += sizeof(StarData);
@@ -134,7 +158,13 @@ bool StarBlockList::fillToMag(float maglim)
         }
         else
         {
-            ret = fread(&deepstardata, sizeof(DeepStarData), 1, dataFile);
+            if (record)
+            {
+                memcpy(&deepstardata, record, sizeof(DeepStarData));
+                record += sizeof(DeepStarData);
+            }
+            else
+                ret = fread(&deepstardata, sizeof(DeepStarData), 1, dataFile);
             if (dSReader->getByteSwap())
                 DeepStarComponent::byteSwap(&deepstardata);
             readOffset += sizeof(DeepStarData);
@@ -14,6 +14,8 @@
 #endif
 #include "kstarsdata.h"
 #include "kstarssplash.h"
+#include "nearestsearch.h"
+#include "skyquery.h"
 #include "Options.h"
 #include "skylabeler.h"
 #include "skymap.h"
@@ -307,6 +309,7 @@ void StarComponent::draw(SkyPainter *skyp)
     m_StarBlockFactory->drawID = m_skyMesh->drawID();
 
     int nTrixels = 0;
+    bool batchDraw = true;
 
     while (region.hasNext())
     {
@@ -314,6 +317,7 @@ void StarComponent::draw(SkyPainter *skyp)
         Trixel currentRegion = region.next();
         StarList *starList   = m_starIndex->at(currentRegion);
 
+        m_drawStars.clear();
         for (auto &star : *starList)
         {
             if (!star)
@@ -328,11 +332,25 @@ void StarComponent::draw(SkyPainter *skyp)
             if (star->updateID != updateID)
                 star->JITupdate();
 
-            bool drawn = skyp->drawPointSource(star, mag, star->spchar());
+            //Check if it's even visible before doing anything
+            if (proj->checkVisibility(star))
+                m_drawStars.append(star);
+        }
+
+        if (batchDraw)
+            batchDraw = drawStarBatch(skyp, labelMagLim);
 
-            //FIXME_SKYPAINTER: find a better way to do this.
-            if (drawn && !(m_hideLabels || mag > labelMagLim))
-                addLabel(proj->toScreen(star), star);
+        if (!batchDraw)
+        {
+            for (auto &star : m_drawStars)
+            {
+                float mag  = star->mag();
+                bool drawn = skyp->drawPointSource(star, mag, star->spchar());
+
+                //FIXME_SKYPAINTER: find a better way to do this.
+                if (drawn && !(m_hideLabels || mag > labelMagLim))
+                    addLabel(proj->toScreen(star), star);
+            }
         }
     }
 
@@ -355,6 +373,64 @@ void StarComponent::draw(SkyPainter *skyp)
 #endif
 }
 
+#ifndef KSTARS_LITE
+bool StarComponent::drawStarBatch(SkyPainter *skyp, double labelMagLim)
+{
+    const Projector *proj = SkyMap::Instance()->projector();
+    const int count       = m_drawStars.size();
+    if (count == 0)
+        return true;
+
+    m_drawPoints.resize(count);
+    m_drawScreen.resize(count);
+    m_drawVisible.resize(count);
+    m_drawMag.resize(count);
+    m_drawSp.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        m_drawPoints[i] = m_drawStars[i];
+        m_drawMag[i]    = m_drawStars[i]->mag();
+        m_drawSp[i]     = m_drawStars[i]->spchar();
+    }
+
+    proj->toScreenVec(m_drawPoints.constData(), count, m_drawScreen.data(), m_drawVisible.data());
+
+    ProjectedPoints &out = m_drawProjected;
+    if (out.x.size() < count)
+    {
+        out.x.resize(count);
+        out.y.resize(count);
+        out.index.resize(count);
+    }
+    out.count = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        // FIXME: onScreen here should use canvas size rather than SkyMap size, especially while printing in portrait mode!
+        if (!m_drawVisible[i] || !proj->onScreen(m_drawScreen[i]))
+            continue;
+        out.x[out.count]     = m_drawScreen[i].x();
+        out.y[out.count]     = m_drawScreen[i].y();
+        out.index[out.count] = i;
+        ++out.count;
+    }
+
+    if (!skyp->drawPointSources(out, m_drawMag.constData(), m_drawSp.constData()))
+        return false;
+
+    if (m_hideLabels)
+        return true;
+
+    for (int i = 0; i < out.count; ++i)
+    {
+        const int j = out.index[i];
+        //FIXME_SKYPAINTER: find a better way to do this.
+        if (m_drawMag[j] <= labelMagLim)
+            addLabel(QPointF(out.x[i], out.y[i]), m_drawStars[j]);
+    }
+    return true;
+}
+#endif
+
 void StarComponent::addLabel(const QPointF &p, StarObject *star)
 {
     int idx = int(star->mag() * 10.0);
@@ -668,7 +744,7 @@ SkyObject *StarComponent::objectNearest(SkyPoint *p, double &maxrad)
 {
     m_zoomMagLimit = zoomMagnitudeLimit();
 
-    SkyObject *oBest = nullptr;
+    NearestObjects<StarObject> nearest(*p, maxrad);
 
     MeshIterator region(m_skyMesh, OBJ_NEAREST_BUF);
 
@@ -684,16 +760,14 @@ SkyObject *StarComponent::objectNearest(SkyPoint *p, double &maxrad)
             if (star->mag() > m_zoomMagLimit)
                 continue;
 
-            double r = star->angularDistanceTo(p).Degrees();
-
-            if (r < maxrad)
-            {
-                oBest  = star;
-                maxrad = r;
-            }
+            nearest.add(star);
         }
     }
 
+    SkyObject *oBest = nearest.nearest();
+    if (oBest)
+        maxrad = nearest.distance(0);
+
     // Check up with our Deep Star Components too!
     double rTry, rBest;
     SkyObject *oTry;
@@ -727,6 +801,8 @@ void StarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoint &c
     if (maglim < -28)
         maglim = m_FaintMagnitude;
 
+    const SkyCone cone(center, radius);
+
     while (region.hasNext())
     {
         Trixel currentRegion = region.next();
@@ -738,7 +814,7 @@ void StarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoint &c
                 continue;
             if (star->mag() > m_FaintMagnitude)
                 continue;
-            if (star->angularDistanceTo(&center).Degrees() <= radius)
+            if (cone.contains(*star))
                 list.append(star);
         }
     }
@@ -750,6 +826,36 @@ void StarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoint &c
     }
 }
 
+void StarComponent::objectsInRegion(const SkyQueryRegion &region, float maglim, SkyQueryResults &results, int sources)
+{
+    if (sources & SkyQueryResults::STARS)
+    {
+        const SkyPoint &center = region.boundingCenter();
+        m_skyMesh->intersect(center.ra0().Degrees(), center.dec0().Degrees(), region.boundingRadius(),
+                             static_cast<BufNum>(OBJ_NEAREST_BUF));
+
+        MeshIterator trixels(m_skyMesh, OBJ_NEAREST_BUF);
+        while (trixels.hasNext())
+        {
+            StarList *starList = m_starIndex->at(trixels.next());
+
+            for (auto &star : *starList)
+            {
+                if (!star || star->mag() > maglim)
+                    continue;
+                if (region.contains(*star))
+                    results.addStar(star, SkyQueryResults::STARS);
+            }
+        }
+    }
+
+    if (sources & SkyQueryResults::DEEP_STARS)
+    {
+        for (auto &component : m_DeepStarComponents)
+            component->objectsInRegion(region, maglim, results);
+    }
+}
+
 void StarComponent::byteSwap(StarData *stardata)
 {
     stardata->RA       = bswap_32(stardata->RA);
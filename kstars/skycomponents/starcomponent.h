@@ -11,6 +11,7 @@
 #include "skylabel.h"
 #include "stardata.h"
 #include "skyobjects/starobject.h"
+#include "projections/batchprojection.h"
 
 #include <memory>
 
@@ -25,6 +26,8 @@ class HighPMStarList;
 class MeshIterator;
 class SkyLabeler;
 class SkyMesh;
+class SkyQueryRegion;
+class SkyQueryResults;
 class StarObject;
 class StarBlockFactory;
 
@@ -121,6 +124,14 @@ class StarComponent : public ListComponent
      */
     void starsInAperture(QList<StarObject *> &list, const SkyPoint &center, float radius, float maglim = -29);
 
+    /**
+     * @short Add to the results the stars of this component, and of the deep star catalogs if
+     * @p sources has SkyQueryResults::DEEP_STARS, that lie within the region and are brighter than
+     * @p maglim.
+     * @see SkyMapComposite::objectsInRegion()
+     */
+    void objectsInRegion(const SkyQueryRegion &region, float maglim, SkyQueryResults &results, int sources);
+
     // TODO: Make byteSwap a template method and put it in byteorder.h
     // It should ideally handle 32-bit, 16-bit fields and StarData and
     // DeepStarData fields
@@ -147,6 +158,13 @@ class StarComponent : public ListComponent
     /** Adds a label to the lists of labels to be drawn prioritized by magnitude. */
     void addLabel(const QPointF &p, StarObject *star);
 
+    /**
+     * @short Draw the stars gathered in m_drawStars, projecting them in one batch.
+     * @return false if the painter does not support drawing point sources in batches, in
+     * which case nothing was drawn
+     */
+    bool drawStarBatch(SkyPainter *skyp, double labelMagLim);
+
     void reindexAll(KSNumbers *num);
 
     /** Load available deep star catalogs */
@@ -183,6 +201,15 @@ class StarComponent : public ListComponent
     QHash<int, StarObject *> m_HDHash;
     QVector<DeepStarComponent *> m_DeepStarComponents;
 
+    // Buffers for drawStarBatch(), reused between trixels and frames
+    QVector<StarObject *> m_drawStars;
+    QVector<const SkyPoint *> m_drawPoints;
+    QVector<Eigen::Vector2f> m_drawScreen;
+    QVector<bool> m_drawVisible;
+    QVector<float> m_drawMag;
+    QVector<char> m_drawSp;
+    ProjectedPoints m_drawProjected;
+
     /**
      * @struct starName
      * @brief Structure that holds star name information, to be read as-is from the
@@ -18,6 +18,7 @@
 #include "kstars_debug.h"
 #include "ksnotification.h"
 #include "kstarsdata.h"
+#include "nearestsearch.h"
 #include "Options.h"
 #include "skylabeler.h"
 #include "skymesh.h"
@@ -148,21 +149,14 @@ SkyObject *SupernovaeComponent::objectNearest(SkyPoint *p, double &maxrad)
     if (!selected() || !m_DataLoaded)
         return nullptr;
 
-    SkyObject *oBest = nullptr;
-    double rBest     = maxrad;
+    NearestObjects<SkyObject> nearest(*p, maxrad);
 
     for (auto &so : m_ObjectList)
-    {
-        double r = so->angularDistanceTo(p).Degrees();
-        //qDebug()<<r;
-        if (r < rBest)
-        {
-            oBest = so;
-            rBest = r;
-        }
-    }
-    maxrad = rBest;
-    return oBest;
+        nearest.add(so);
+
+    if (nearest.nearest())
+        maxrad = nearest.distance(0);
+    return nearest.nearest();
 }
 
 float SupernovaeComponent::zoomMagnitudeLimit()
@@ -12,6 +12,8 @@
 
 #include <QTextStream>
 
+#include <algorithm>
+
 SatelliteGroup::SatelliteGroup(const QString& name, const QString& tle_filename, const QUrl& update_url)
 {
     m_name     = name;
@@ -30,6 +32,7 @@ void SatelliteGroup::readTLE()
     // Delete all satellites
     qDeleteAll(*this);
     clear();
+    m_failed_satellites.clear();
 
     // Read TLE file
     if (KSUtils::openDataFile(file, m_tle_file))
@@ -51,19 +54,27 @@ void SatelliteGroup::readTLE()
 
 void SatelliteGroup::updateSatellitesPos()
 {
-    QMutableListIterator<Satellite *> sats(*this);
+    updateSatellitesPos(0, size());
+}
 
-    while (sats.hasNext())
+void SatelliteGroup::updateSatellitesPos(int begin, int end)
+{
+    end = std::min(end, size());
+    for (int i = begin; i < end; i++)
     {
-        Satellite *sat = sats.next();
+        Satellite *sat = at(i);
 
-        if (sat->selected())
-        {
-            int rc = sat->updatePos();
-            // If position cannot be calculated, remove it from list
-            if (rc != 0)
-                sats.remove();
-        }
+        // If position cannot be calculated, remove it from list once the last satellite is updated,
+        // so that the following ones keep their index until then.
+        if (sat->selected() && sat->updatePos() != 0)
+            m_failed_satellites.append(sat);
+    }
+
+    if (end == size())
+    {
+        for (auto sat : m_failed_satellites)
+            removeOne(sat);
+        m_failed_satellites.clear();
     }
 }
 
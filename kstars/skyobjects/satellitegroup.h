@@ -37,6 +37,13 @@ class SatelliteGroup : public QList<Satellite *>
      */
     void updateSatellitesPos();
 
+    /**
+     * Compute current position of the satellites [begin, end) of the group.
+     * Satellites whose position cannot be calculated are removed once the last satellite of the group
+     * is updated, so that the indexes stay valid while the group is updated in several steps.
+     */
+    void updateSatellitesPos(int begin, int end);
+
     /**
      * @return TLE filename
      */
@@ -59,4 +66,6 @@ class SatelliteGroup : public QList<Satellite *>
     QString m_tle_file;
     /// URL used to update TLE file
     QUrl m_tle_url;
+    /// Satellites to remove once the last satellite of the group is updated
+    QList<Satellite *> m_failed_satellites;
 };
@@ -27,6 +27,11 @@ void SkyPainter::setSizeMagLimit(float sizeMagLim)
     m_sizeMagLim = sizeMagLim;
 }
 
+bool SkyPainter::drawPointSources(const ProjectedPoints &, const float *, const char *)
+{
+    return false;
+}
+
 float SkyPainter::starWidth(float mag) const
 {
     //adjust maglimit for ZoomLevel
@@ -30,6 +30,7 @@ class SkyPoint;
 class Supernova;
 class CatalogObject;
 class ImageOverlay;
+struct ProjectedPoints;
 
 /**
  * @short Draws things on the sky, without regard to backend.
@@ -128,6 +129,16 @@ class SkyPainter
          */
         virtual bool drawPointSource(const SkyPoint *loc, float mag, char sp = 'A') = 0;
 
+        /**
+         * @short Draw a batch of point sources whose screen positions are already known.
+         * @param points screen positions, as computed by Projector::projectCatalog()
+         * @param mag magnitudes of the sources, indexed by ProjectedPoints::index
+         * @param sp spectral classes of the sources, indexed by ProjectedPoints::index
+         * @return true if the sources were drawn, false if this painter does not support
+         * drawing pre-projected sources and drawPointSource() must be used instead.
+         */
+        virtual bool drawPointSources(const ProjectedPoints &points, const float *mag, const char *sp);
+
         /**
         * @short Draw a deep sky object (loaded from the new implementation)
         * @param obj the object to draw
@@ -298,92 +298,96 @@ void SkyQPainter::drawSkyLine(SkyPoint *a, SkyPoint *b)
     //    } //FIXME: what if both are offscreen but the line isn't?
 }
 
+void SkyQPainter::projectSkyList(const SkyList &points, bool oRefract, bool checkVisibility)
+{
+    const int count = points.size();
+    m_skyListPoints.resize(count);
+    m_screenPoints.resize(count);
+    m_visiblePoints.resize(count);
+
+    for (int i = 0; i < count; ++i)
+        m_skyListPoints[i] = points[i].get();
+
+    m_proj->toScreenVec(m_skyListPoints.constData(), count, m_screenPoints.data(), m_visiblePoints.data(), oRefract);
+
+    // & with the result of checkVisibility to clip away things below horizon
+    if (checkVisibility)
+    {
+        for (int i = 0; i < count; ++i)
+            m_visiblePoints[i] = m_visiblePoints[i] && m_proj->checkVisibility(m_skyListPoints[i]);
+    }
+}
+
 void SkyQPainter::drawSkyPolyline(LineList *list, SkipHashList *skipList,
                                   LineListLabel *label)
 {
     SkyList *points = list->points();
-    bool isVisible, isVisibleLast;
 
     if (points->size() == 0)
         return;
-    QPointF oLast = m_proj->toScreen(points->first().get(), true, &isVisibleLast);
-    // & with the result of checkVisibility to clip away things below horizon
-    isVisibleLast &= m_proj->checkVisibility(points->first().get());
-    QPointF oThis, oThis2;
+
+    projectSkyList(*points, true, true);
+
+    //Temporary solution to avoid random lines in Gnomonic projection and draw lines up to horizon
+    const bool bothVisible = (SkyMap::Instance()->projector()->type() == Projector::Gnomonic);
 
     for (int j = 1; j < points->size(); j++)
     {
-        SkyPoint *pThis = points->at(j).get();
+        const bool isVisible     = m_visiblePoints[j];
+        const bool isVisibleLast = m_visiblePoints[j - 1];
 
-        oThis2 = oThis = m_proj->toScreen(pThis, true, &isVisible);
-        // & with the result of checkVisibility to clip away things below horizon
-        isVisible &= m_proj->checkVisibility(pThis);
-        bool doSkip = false;
-        if (skipList)
-        {
-            doSkip = skipList->skip(j);
-        }
-
-        bool pointsVisible = false;
-        //Temporary solution to avoid random lines in Gnomonic projection and draw lines up to horizon
-        if (SkyMap::Instance()->projector()->type() == Projector::Gnomonic)
-        {
-            if (isVisible && isVisibleLast)
-                pointsVisible = true;
-        }
-        else
-        {
-            if (isVisible || isVisibleLast)
-                pointsVisible = true;
-        }
+        if (skipList && skipList->skip(j))
+            continue;
 
-        if (!doSkip)
+        const bool pointsVisible = bothVisible ? (isVisible && isVisibleLast) : (isVisible || isVisibleLast);
+        if (pointsVisible)
         {
-            if (pointsVisible)
-            {
-                drawLine(oLast, oThis);
-                if (label)
-                    label->updateLabelCandidates(oThis.x(), oThis.y(), list, j);
-            }
+            const Eigen::Vector2f &oLast = m_screenPoints[j - 1];
+            const Eigen::Vector2f &oThis = m_screenPoints[j];
+            drawLine(QPointF(oLast.x(), oLast.y()), QPointF(oThis.x(), oThis.y()));
+            if (label)
+                label->updateLabelCandidates(oThis.x(), oThis.y(), list, j);
         }
-
-        oLast         = oThis2;
-        isVisibleLast = isVisible;
     }
 }
 
 void SkyQPainter::drawSkyPolygon(LineList *list, bool forceClip)
 {
-    bool isVisible  = false, isVisibleLast;
     SkyList *points = list->points();
     QPolygonF polygon;
 
+    if (points->size() == 0)
+        return;
+
     if (forceClip == false)
     {
-        for (const auto &point : *points)
+        projectSkyList(*points, false, false);
+
+        bool isVisible = false;
+        polygon.reserve(points->size());
+        for (int i = 0; i < points->size(); ++i)
         {
-            polygon << m_proj->toScreen(point.get(), false, &isVisibleLast);
-            isVisible |= isVisibleLast;
+            polygon << QPointF(m_screenPoints[i].x(), m_screenPoints[i].y());
+            isVisible |= m_visiblePoints[i];
         }
 
         // If 1+ points are visible, draw it
-        if (polygon.size() && isVisible)
+        if (isVisible)
             drawPolygon(polygon);
 
         return;
     }
 
-    SkyPoint *pLast = points->last().get();
-    QPointF oLast   = m_proj->toScreen(pLast, true, &isVisibleLast);
-    // & with the result of checkVisibility to clip away things below horizon
-    isVisibleLast &= m_proj->checkVisibility(pLast);
+    projectSkyList(*points, true, true);
 
-    for (const auto &point : *points)
+    int last = points->size() - 1;
+    for (int i = 0; i < points->size(); ++i)
     {
-        SkyPoint *pThis = point.get();
-        QPointF oThis   = m_proj->toScreen(pThis, true, &isVisible);
-        // & with the result of checkVisibility to clip away things below horizon
-        isVisible &= m_proj->checkVisibility(pThis);
+        SkyPoint *pLast = points->at(last).get();
+        SkyPoint *pThis = points->at(i).get();
+        const QPointF oThis(m_screenPoints[i].x(), m_screenPoints[i].y());
+        const bool isVisible     = m_visiblePoints[i];
+        const bool isVisibleLast = m_visiblePoints[last];
 
         if (isVisible && isVisibleLast)
         {
@@ -401,9 +405,7 @@ void SkyQPainter::drawSkyPolygon(LineList *list, bool forceClip)
             polygon << oThis;
         }
 
-        pLast         = pThis;
-        oLast         = oThis;
-        isVisibleLast = isVisible;
+        last = i;
     }
 
     if (polygon.size())
@@ -617,6 +619,16 @@ bool SkyQPainter::drawPointSource(const SkyPoint *loc, float mag, char sp)
     }
 }
 
+bool SkyQPainter::drawPointSources(const ProjectedPoints &points, const float *mag, const char *sp)
+{
+    for (int i = 0; i < points.count; ++i)
+    {
+        const int j = points.index[i];
+        drawPointSource(QPointF(points.x[i], points.y[i]), starWidth(mag[j]), sp[j]);
+    }
+    return true;
+}
+
 void SkyQPainter::drawPointSource(const QPointF &pos, float size, char sp)
 {
     int isize = qMin(static_cast<int>(size), 14);
@@ -9,6 +9,7 @@
 #include "ksasteroid.h"
 #include "skypainter.h"
 #include "config-kstars.h"
+#include "projections/batchprojection.h"
 
 #include <QColor>
 #include <QMap>
@@ -88,6 +89,7 @@ class SkyQPainter : public SkyPainter, public QPainter
                              LineListLabel *label = nullptr) override;
         void drawSkyPolygon(LineList *list, bool forceClip = true) override;
         bool drawPointSource(const SkyPoint *loc, float mag, char sp = 'A') override;
+        bool drawPointSources(const ProjectedPoints &points, const float *mag, const char *sp) override;
         bool drawCatalogObject(const CatalogObject &obj) override;
         void drawCatalogObjectImage(const QPointF &pos, const CatalogObject &obj,
                                     float positionAngle);
@@ -114,6 +116,13 @@ class SkyQPainter : public SkyPainter, public QPainter
         bool drawImageOverlay(const QList<ImageOverlay> *imageOverlays, bool useCache = false) override;
 
     private:
+        /**
+         * @short Project all the points of a LineList with one batch call.
+         * The results are stored in m_screenPoints and m_visiblePoints. Points failing
+         * Projector::checkVisibility() are marked as not visible if @p checkVisibility is true.
+         */
+        void projectSkyList(const SkyList &points, bool oRefract, bool checkVisibility);
+
         QPaintDevice *m_pd{ nullptr };
         const Projector *m_proj{ nullptr };
         bool m_vectorStars{ false };
@@ -121,6 +130,10 @@ class SkyQPainter : public SkyPainter, public QPainter
         TerrainRenderer *m_terrainRender{ nullptr };
         QSize m_size;
         QScopedPointer<QImage> m_HiPSImage;
+        // Buffers for projectSkyList(), reused between calls
+        QVector<const SkyPoint *> m_skyListPoints;
+        QVector<Eigen::Vector2f> m_screenPoints;
+        QVector<bool> m_visiblePoints;
         static int starColorMode;
         static QColor m_starColor;
         static QMap<char, QColor> ColorMap;